@@ -50,11 +50,11 @@ static inline u32 nvgpu_ce_get_valid_launch_flags(struct gk20a *g,
 	return launch_flags;
 }
 
-int nvgpu_ce_execute_ops(struct gk20a *g,
+static int nvgpu_ce_submit_ops(struct gk20a *g,
 		u32 ce_ctx_id,
 		u64 src_paddr,
-		u64 dst_paddr,
-		u64 size,
+		const struct nvgpu_ce_range *ranges,
+		u32 num_ranges,
 		u32 payload,
 		u32 launch_flags,
 		u32 request_operation,
@@ -68,8 +68,10 @@ int nvgpu_ce_execute_ops(struct gk20a *g,
 	u32 *cmd_buf_cpu_va;
 	u64 cmd_buf_gpu_va = 0UL;
 	u32 method_size;
+	u32 range_method_size;
 	u32 cmd_buf_read_offset;
 	u32 dma_copy_class;
+	u32 i;
 	struct nvgpu_gpfifo_entry gpfifo;
 	struct nvgpu_channel_fence fence = {0U, 0U};
 	struct nvgpu_fence_type *ce_cmd_buf_fence_out = NULL;
@@ -78,12 +80,6 @@ int nvgpu_ce_execute_ops(struct gk20a *g,
 		goto end;
 	}
 
-	/* This shouldn't happen */
-	if (size == 0ULL) {
-		ret = -EINVAL;
-		goto end;
-	}
-
 	if (request_operation != NVGPU_CE_PHYS_MODE_TRANSFER &&
 	    request_operation != NVGPU_CE_MEMSET) {
 		ret = -EINVAL;
@@ -95,9 +91,17 @@ int nvgpu_ce_execute_ops(struct gk20a *g,
 		goto end;
 	}
 
-	if (dst_paddr > NVGPU_CE_MAX_ADDRESS) {
-		ret = -EINVAL;
-		goto end;
+	for (i = 0U; i < num_ranges; i++) {
+		/* This shouldn't happen */
+		if (ranges[i].size == 0ULL) {
+			ret = -EINVAL;
+			goto end;
+		}
+
+		if (ranges[i].dst_paddr > NVGPU_CE_MAX_ADDRESS) {
+			ret = -EINVAL;
+			goto end;
+		}
 	}
 
 	nvgpu_mutex_acquire(&ce_app->app_mutex);
@@ -150,15 +154,24 @@ int nvgpu_ce_execute_ops(struct gk20a *g,
 			(u64)(cmd_buf_read_offset * sizeof(u32)));
 
 	dma_copy_class = g->ops.get_litter_value(g, GPU_LIT_DMA_COPY_CLASS);
-	method_size = nvgpu_ce_prepare_submit(src_paddr,
-			dst_paddr,
-			size,
-			&cmd_buf_cpu_va[cmd_buf_read_offset],
-			payload,
-			nvgpu_ce_get_valid_launch_flags(g, launch_flags),
-			request_operation,
-			dma_copy_class);
-	nvgpu_assert(method_size <= NVGPU_CE_MAX_COMMAND_BUFF_BYTES_PER_SUBMIT);
+	method_size = 0U;
+	for (i = 0U; i < num_ranges; i++) {
+		range_method_size = nvgpu_ce_prepare_submit(src_paddr,
+				ranges[i].dst_paddr,
+				ranges[i].size,
+				&cmd_buf_cpu_va[cmd_buf_read_offset + method_size],
+				payload,
+				nvgpu_ce_get_valid_launch_flags(g, launch_flags),
+				request_operation,
+				dma_copy_class);
+		if (range_method_size == 0U) {
+			method_size = 0U;
+			break;
+		}
+		method_size += range_method_size;
+	}
+	nvgpu_assert(method_size <= NVGPU_CE_MAX_COMMAND_BUFF_BYTES_PER_SUBMIT /
+				    U32(sizeof(u32)));
 
 	if (method_size != 0U) {
 		/* store the element into gpfifo */
@@ -196,6 +209,42 @@ end:
 	return ret;
 }
 
+int nvgpu_ce_execute_ops(struct gk20a *g,
+		u32 ce_ctx_id,
+		u64 src_paddr,
+		u64 dst_paddr,
+		u64 size,
+		u32 payload,
+		u32 launch_flags,
+		u32 request_operation,
+		u32 submit_flags,
+		struct nvgpu_fence_type **fence_out)
+{
+	struct nvgpu_ce_range range = { dst_paddr, size };
+
+	return nvgpu_ce_submit_ops(g, ce_ctx_id, src_paddr, &range, 1U,
+			payload, launch_flags, request_operation,
+			submit_flags, fence_out);
+}
+
+int nvgpu_ce_execute_memset_ranges(struct gk20a *g,
+		u32 ce_ctx_id,
+		const struct nvgpu_ce_range *ranges,
+		u32 num_ranges,
+		u32 payload,
+		u32 launch_flags,
+		u32 submit_flags,
+		struct nvgpu_fence_type **fence_out)
+{
+	if (num_ranges == 0U || num_ranges > NVGPU_CE_MAX_RANGES_PER_SUBMIT) {
+		return -EINVAL;
+	}
+
+	return nvgpu_ce_submit_ops(g, ce_ctx_id, 0ULL, ranges, num_ranges,
+			payload, launch_flags, NVGPU_CE_MEMSET,
+			submit_flags, fence_out);
+}
+
 /* static CE app api */
 static void nvgpu_ce_put_fences(struct nvgpu_ce_gpu_ctx *ce_ctx)
 {
@@ -196,6 +196,20 @@ int nvgpu_channel_disable_tsg(struct gk20a *g, struct nvgpu_channel *ch)
 	}
 }
 
+/*
+ * Make the reason for waking up the channel visible before the bit; see
+ * nvgpu_channel_semaphore_wakeup_retire().
+ */
+static void nvgpu_channel_semaphore_wakeup_add(struct nvgpu_channel *c)
+{
+	struct nvgpu_fifo *f = &c->g->fifo;
+
+	if (f->sema_wakeup_chs != NULL) {
+		nvgpu_smp_mb();
+		nvgpu_set_bit(c->chid, f->sema_wakeup_chs);
+	}
+}
+
 #ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
 void nvgpu_channel_abort_clean_up(struct nvgpu_channel *ch)
 {
@@ -483,9 +497,9 @@ int nvgpu_channel_add_job(struct nvgpu_channel *c,
 
 	nvgpu_channel_launch_wdt(c);
 
-	nvgpu_channel_joblist_lock(c);
 	nvgpu_channel_joblist_add(c, job);
-	nvgpu_channel_joblist_unlock(c);
+
+	nvgpu_channel_semaphore_wakeup_add(c);
 
 	return 0;
 }
@@ -513,9 +527,7 @@ static void nvgpu_channel_finalize_job(struct nvgpu_channel *c,
 
 	nvgpu_channel_free_job(c, job);
 
-	nvgpu_channel_joblist_lock(c);
 	nvgpu_channel_joblist_delete(c, job);
-	nvgpu_channel_joblist_unlock(c);
 }
 
 /**
@@ -549,9 +561,7 @@ void nvgpu_channel_clean_up_jobs(struct nvgpu_channel *c)
 	while (true) {
 		bool completed;
 
-		nvgpu_channel_joblist_lock(c);
 		job = nvgpu_channel_joblist_peek(c);
-		nvgpu_channel_joblist_unlock(c);
 
 		if (job == NULL) {
 			/*
@@ -629,9 +639,7 @@ void nvgpu_channel_clean_up_deterministic_job(struct nvgpu_channel *c)
 
 	nvgpu_assert(nvgpu_channel_is_deterministic(c));
 
-	nvgpu_channel_joblist_lock(c);
 	job = nvgpu_channel_joblist_peek(c);
-	nvgpu_channel_joblist_unlock(c);
 
 	if (job == NULL) {
 		/* Nothing queued */
@@ -1024,6 +1032,12 @@ unbind:
 	g->ops.channel.unbind(ch);
 	g->ops.channel.free_inst(g, ch);
 
+	ch->semaphore_untracked = false;
+	nvgpu_atomic_set(&ch->semaphore_waiters, 0);
+	if (f->sema_wakeup_chs != NULL) {
+		nvgpu_clear_bit(ch->chid, f->sema_wakeup_chs);
+	}
+
 	nvgpu_channel_wdt_destroy(ch->wdt);
 	ch->wdt = NULL;
 
@@ -1367,6 +1381,7 @@ static int nvgpu_channel_setup_usermode(struct nvgpu_channel *c,
 		c->userd_offset = 0U;
 		c->userd_iova = nvgpu_mem_get_addr(g, c->userd_mem);
 		c->usermode_submit_enabled = true;
+		nvgpu_channel_semaphore_set_untracked(c);
 	} else {
 		nvgpu_err(g, "Usermode submit not supported");
 		err = -EINVAL;
@@ -1734,9 +1749,6 @@ void nvgpu_channel_deterministic_unidle(struct gk20a *g)
 static void nvgpu_channel_destroy(struct nvgpu_channel *c)
 {
 	nvgpu_mutex_destroy(&c->ioctl_lock);
-#ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
-	nvgpu_mutex_destroy(&c->joblist.pre_alloc.read_lock);
-#endif
 	nvgpu_mutex_destroy(&c->sync_lock);
 #if defined(CONFIG_NVGPU_CYCLESTATS)
 	nvgpu_mutex_destroy(&c->cyclestate.cyclestate_buffer_mutex);
@@ -1747,6 +1759,139 @@ static void nvgpu_channel_destroy(struct nvgpu_channel *c)
 #endif
 }
 
+static u32 nvgpu_channel_inst_hash_bucket(struct nvgpu_fifo *f, u64 inst_ptr)
+{
+	/* instance blocks are at least 4K aligned */
+	u64 key = inst_ptr >> 12U;
+
+	key ^= key >> 17U;
+	key ^= key >> 31U;
+
+	return u64_lo32(key) & (f->inst_hash_size - 1U);
+}
+
+static int nvgpu_channel_inst_hash_init(struct gk20a *g)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+
+	f->inst_hash_size = (u32)roundup_pow_of_two(
+			max(f->num_channels, 1U));
+	f->inst_hash = nvgpu_kzalloc(g, nvgpu_safe_mult_u64(
+			sizeof(*f->inst_hash), f->inst_hash_size));
+	if (f->inst_hash == NULL) {
+		f->inst_hash_size = 0U;
+		return -ENOMEM;
+	}
+
+	nvgpu_spinlock_init(&f->inst_hash_lock);
+	nvgpu_atomic_set(&f->inst_hash_seq, 0);
+
+	return 0;
+}
+
+static void nvgpu_channel_inst_hash_deinit(struct gk20a *g)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+
+	nvgpu_kfree(g, f->inst_hash);
+	f->inst_hash = NULL;
+	f->inst_hash_size = 0U;
+}
+
+static void nvgpu_channel_inst_hash_write_begin(struct nvgpu_fifo *f)
+{
+	nvgpu_spinlock_acquire(&f->inst_hash_lock);
+	nvgpu_atomic_inc(&f->inst_hash_seq);
+	nvgpu_smp_wmb();
+}
+
+static void nvgpu_channel_inst_hash_write_end(struct nvgpu_fifo *f)
+{
+	nvgpu_smp_wmb();
+	nvgpu_atomic_inc(&f->inst_hash_seq);
+	nvgpu_spinlock_release(&f->inst_hash_lock);
+}
+
+static void nvgpu_channel_inst_hash_add(struct gk20a *g,
+		struct nvgpu_channel *ch)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	u64 inst_ptr = nvgpu_inst_block_addr(g, &ch->inst_block);
+	u32 bucket;
+
+	if (f->inst_hash == NULL) {
+		return;
+	}
+
+	bucket = nvgpu_channel_inst_hash_bucket(f, inst_ptr);
+
+	nvgpu_channel_inst_hash_write_begin(f);
+	ch->inst_hash_addr = inst_ptr;
+	ch->inst_hash_next = f->inst_hash[bucket];
+	f->inst_hash[bucket] = nvgpu_safe_add_u32(ch->chid, 1U);
+	nvgpu_channel_inst_hash_write_end(f);
+}
+
+static void nvgpu_channel_inst_hash_remove(struct gk20a *g,
+		struct nvgpu_channel *ch)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	u32 *link;
+
+	if (f->inst_hash == NULL) {
+		return;
+	}
+
+	nvgpu_channel_inst_hash_write_begin(f);
+	link = &f->inst_hash[nvgpu_channel_inst_hash_bucket(f,
+			ch->inst_hash_addr)];
+	while (*link != 0U) {
+		if (*link == nvgpu_safe_add_u32(ch->chid, 1U)) {
+			*link = ch->inst_hash_next;
+			break;
+		}
+		link = &f->channel[*link - 1U].inst_hash_next;
+	}
+	ch->inst_hash_addr = 0ULL;
+	ch->inst_hash_next = 0U;
+	nvgpu_channel_inst_hash_write_end(f);
+}
+
+/*
+ * Find the chid for inst_ptr without taking inst_hash_lock; this runs in the
+ * fault and interrupt paths. Chains may be relinked while walking them, so
+ * the walk is bounded and retried if an update raced with it.
+ */
+static u32 nvgpu_channel_inst_hash_find(struct nvgpu_fifo *f, u64 inst_ptr)
+{
+	u32 bucket = nvgpu_channel_inst_hash_bucket(f, inst_ptr);
+	u32 chid, next, steps;
+	int seq;
+
+	do {
+		seq = nvgpu_atomic_read(&f->inst_hash_seq);
+		nvgpu_smp_rmb();
+
+		chid = NVGPU_INVALID_CHANNEL_ID;
+		next = NV_READ_ONCE(f->inst_hash[bucket]);
+		for (steps = 0U; (next != 0U) && (steps < f->num_channels);
+				steps++) {
+			struct nvgpu_channel *ch = &f->channel[next - 1U];
+
+			if (NV_READ_ONCE(ch->inst_hash_addr) == inst_ptr) {
+				chid = next - 1U;
+				break;
+			}
+			next = NV_READ_ONCE(ch->inst_hash_next);
+		}
+
+		nvgpu_smp_rmb();
+	} while (((seq & 1) != 0) ||
+		 (seq != nvgpu_atomic_read(&f->inst_hash_seq)));
+
+	return chid;
+}
+
 void nvgpu_channel_cleanup_sw(struct gk20a *g)
 {
 	struct nvgpu_fifo *f = &g->fifo;
@@ -1771,6 +1916,9 @@ void nvgpu_channel_cleanup_sw(struct gk20a *g)
 
 	nvgpu_vfree(g, f->channel);
 	f->channel = NULL;
+	nvgpu_kfree(g, f->sema_wakeup_chs);
+	f->sema_wakeup_chs = NULL;
+	nvgpu_channel_inst_hash_deinit(g);
 	nvgpu_mutex_destroy(&f->free_chs_mutex);
 }
 
@@ -1798,9 +1946,6 @@ int nvgpu_channel_init_support(struct gk20a *g, u32 chid)
 #endif
 #ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
 	nvgpu_init_list_node(&c->worker_item);
-
-	nvgpu_mutex_init(&c->joblist.pre_alloc.read_lock);
-
 #endif /* CONFIG_NVGPU_KERNEL_MODE_SUBMIT */
 	nvgpu_mutex_init(&c->ioctl_lock);
 	nvgpu_mutex_init(&c->sync_lock);
@@ -1837,6 +1982,20 @@ int nvgpu_channel_setup_sw(struct gk20a *g)
 
 	nvgpu_init_list_node(&f->free_chs);
 
+	err = nvgpu_channel_inst_hash_init(g);
+	if (err != 0) {
+		nvgpu_err(g, "no mem for channel inst hash");
+		goto clean_up_channels;
+	}
+
+	f->sema_wakeup_chs = nvgpu_kcalloc(g, BITS_TO_LONGS(f->num_channels),
+			sizeof(*f->sema_wakeup_chs));
+	if (f->sema_wakeup_chs == NULL) {
+		nvgpu_err(g, "no mem for semaphore wakeup bitmap");
+		err = -ENOMEM;
+		goto clean_up_inst_hash;
+	}
+
 	for (chid = 0; chid < f->num_channels; chid++) {
 		err = nvgpu_channel_init_support(g, chid);
 		if (err != 0) {
@@ -1853,6 +2012,13 @@ clean_up:
 
 		nvgpu_channel_destroy(ch);
 	}
+	nvgpu_kfree(g, f->sema_wakeup_chs);
+	f->sema_wakeup_chs = NULL;
+
+clean_up_inst_hash:
+	nvgpu_channel_inst_hash_deinit(g);
+
+clean_up_channels:
 	nvgpu_vfree(g, f->channel);
 	f->channel = NULL;
 
@@ -1990,10 +2156,71 @@ static void nvgpu_channel_semaphore_signal(struct nvgpu_channel *c,
 #endif
 }
 
+static bool nvgpu_channel_semaphore_wakeup_needed(struct nvgpu_channel *c)
+{
+	if (c->semaphore_untracked ||
+	    (nvgpu_atomic_read(&c->semaphore_waiters) != 0)) {
+		return true;
+	}
+
+#ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
+	/* completed jobs also count until they have been cleaned up */
+	if (!nvgpu_channel_joblist_is_empty(c)) {
+		return true;
+	}
+#endif
+
+	return false;
+}
+
+/*
+ * Drop the channel from the wakeup set if nothing on it can be waiting. The
+ * bit is cleared before checking again, and setters make their state visible
+ * before setting the bit, so a channel that just got a job or a waiter is
+ * never left out.
+ */
+static void nvgpu_channel_semaphore_wakeup_retire(struct nvgpu_channel *c)
+{
+	struct nvgpu_fifo *f = &c->g->fifo;
+
+	if (nvgpu_channel_semaphore_wakeup_needed(c)) {
+		return;
+	}
+
+	nvgpu_clear_bit(c->chid, f->sema_wakeup_chs);
+	nvgpu_smp_mb();
+
+	if (nvgpu_channel_semaphore_wakeup_needed(c)) {
+		nvgpu_set_bit(c->chid, f->sema_wakeup_chs);
+	}
+}
+
+void nvgpu_channel_semaphore_set_untracked(struct nvgpu_channel *ch)
+{
+	/* never dropped from the wakeup set once set */
+	if (ch->semaphore_untracked) {
+		return;
+	}
+
+	ch->semaphore_untracked = true;
+	nvgpu_channel_semaphore_wakeup_add(ch);
+}
+
+void nvgpu_channel_semaphore_wait_begin(struct nvgpu_channel *ch)
+{
+	nvgpu_atomic_inc(&ch->semaphore_waiters);
+	nvgpu_channel_semaphore_wakeup_add(ch);
+}
+
+void nvgpu_channel_semaphore_wait_end(struct nvgpu_channel *ch)
+{
+	nvgpu_atomic_dec(&ch->semaphore_waiters);
+}
+
 void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events)
 {
 	struct nvgpu_fifo *f = &g->fifo;
-	u32 chid;
+	unsigned long chid;
 
 	nvgpu_log_fn(g, " ");
 
@@ -2003,12 +2230,17 @@ void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events)
 	 */
 	nvgpu_assert(g->ops.mm.cache.fb_flush(g) == 0);
 
-	for (chid = 0; chid < f->num_channels; chid++) {
+	if (f->sema_wakeup_chs == NULL) {
+		return;
+	}
+
+	for_each_set_bit(chid, f->sema_wakeup_chs, f->num_channels) {
 		struct nvgpu_channel *c = &g->fifo.channel[chid];
 		if (nvgpu_channel_get(c) != NULL) {
 			if (nvgpu_atomic_read(&c->bound) != 0) {
 				nvgpu_channel_semaphore_signal(c, post_events);
 			}
+			nvgpu_channel_semaphore_wakeup_retire(c);
 			nvgpu_channel_put(c);
 		}
 	}
@@ -2019,13 +2251,32 @@ struct nvgpu_channel *nvgpu_channel_refch_from_inst_ptr(struct gk20a *g,
 			u64 inst_ptr)
 {
 	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_channel *ch;
 	unsigned int ci;
+	u32 chid;
 
 	if (unlikely(f->channel == NULL)) {
 		return NULL;
 	}
+
+	if ((f->inst_hash != NULL) && (f->num_channels != 0U)) {
+		chid = nvgpu_channel_inst_hash_find(f, inst_ptr);
+		if (chid == NVGPU_INVALID_CHANNEL_ID) {
+			return NULL;
+		}
+
+		/* only alive channels are returned */
+		ch = nvgpu_channel_from_id(g, chid);
+		if ((ch != NULL) &&
+		    (nvgpu_inst_block_addr(g, &ch->inst_block) != inst_ptr)) {
+			/* closed and reopened after the lookup */
+			nvgpu_channel_put(ch);
+			ch = NULL;
+		}
+		return ch;
+	}
+
 	for (ci = 0; ci < f->num_channels; ci++) {
-		struct nvgpu_channel *ch;
 		u64 ch_inst_ptr;
 
 		ch = nvgpu_channel_from_id(g, ci);
@@ -2055,6 +2306,8 @@ int nvgpu_channel_alloc_inst(struct gk20a *g, struct nvgpu_channel *ch)
 		return err;
 	}
 
+	nvgpu_channel_inst_hash_add(g, ch);
+
 	nvgpu_log_info(g, "channel %d inst block physical addr: 0x%16llx",
 		ch->chid, nvgpu_inst_block_addr(g, &ch->inst_block));
 
@@ -2064,6 +2317,7 @@ int nvgpu_channel_alloc_inst(struct gk20a *g, struct nvgpu_channel *ch)
 
 void nvgpu_channel_free_inst(struct gk20a *g, struct nvgpu_channel *ch)
 {
+	nvgpu_channel_inst_hash_remove(g, ch);
 	nvgpu_free_inst_block(g, &ch->inst_block);
 }
 
@@ -21,29 +21,87 @@
  */
 
 #include <nvgpu/log.h>
-#include <nvgpu/lock.h>
 #include <nvgpu/kmem.h>
 #include <nvgpu/barrier.h>
-#include <nvgpu/circ_buf.h>
+#include <nvgpu/bug.h>
+#include <nvgpu/utils.h>
 #include <nvgpu/channel.h>
 #include <nvgpu/job.h>
 #include <nvgpu/priv_cmdbuf.h>
 #include <nvgpu/fence.h>
 #include <nvgpu/string.h>
 
+#define NVGPU_CHANNEL_JOB_CHUNK_JOBS	32U
+
+struct nvgpu_channel_job_chunk {
+	struct nvgpu_channel_job_chunk *next;
+	struct nvgpu_channel_job jobs[NVGPU_CHANNEL_JOB_CHUNK_JOBS];
+};
+
+/*
+ * Move the producer to the next chunk of the ring. The jobs in flight are the
+ * last ones written in ring order, so the next chunk can be reused if it is
+ * further behind the tail than the jobs in flight reach. Otherwise a new
+ * chunk is spliced in right after the tail; the consumer is somewhere past
+ * that link and only follows it once it has drained the tail chunk.
+ */
+static int nvgpu_channel_joblist_next_chunk(struct nvgpu_channel *c, u32 get)
+{
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+	struct nvgpu_channel_job_chunk *chunk;
+	u32 in_flight = nvgpu_wrapping_sub_u32(joblist->put, get);
+	u32 free_slots = nvgpu_safe_mult_u32(
+			nvgpu_safe_sub_u32(joblist->num_chunks, 1U),
+			NVGPU_CHANNEL_JOB_CHUNK_JOBS);
+
+	if (in_flight <= free_slots) {
+		joblist->tail = joblist->tail->next;
+		joblist->tail_idx = 0U;
+		return 0;
+	}
+
+	/* deterministic channels are sized for all jobs at init */
+	nvgpu_assert(!nvgpu_channel_is_deterministic(c));
+
+	chunk = nvgpu_kzalloc(c->g, sizeof(*chunk));
+	if (chunk == NULL) {
+		return -ENOMEM;
+	}
+
+	chunk->next = joblist->tail->next;
+	NV_WRITE_ONCE(joblist->tail->next, chunk);
+	joblist->tail = chunk;
+	joblist->tail_idx = 0U;
+	joblist->num_chunks = nvgpu_safe_add_u32(joblist->num_chunks, 1U);
+
+	return 0;
+}
+
 int nvgpu_channel_alloc_job(struct nvgpu_channel *c,
 		struct nvgpu_channel_job **job_out)
 {
-	unsigned int put = c->joblist.pre_alloc.put;
-	unsigned int get = c->joblist.pre_alloc.get;
-	unsigned int next = (put + 1) % c->joblist.pre_alloc.length;
-	bool full = next == get;
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+	u32 get = NV_READ_ONCE(joblist->get);
+	int err;
 
-	if (full) {
+	if (nvgpu_wrapping_sub_u32(joblist->put, get) >= joblist->capacity) {
 		return -EAGAIN;
 	}
 
-	*job_out = &c->joblist.pre_alloc.jobs[put];
+	/*
+	 * Order the read of get before the writes to the slot it freed; pairs
+	 * with the barrier in nvgpu_channel_joblist_delete().
+	 */
+	nvgpu_smp_mb();
+
+	if (joblist->tail_idx == NVGPU_CHANNEL_JOB_CHUNK_JOBS) {
+		err = nvgpu_channel_joblist_next_chunk(c, get);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	*job_out = &joblist->tail->jobs[joblist->tail_idx];
 	(void) memset(*job_out, 0, sizeof(**job_out));
 
 	return 0;
@@ -55,93 +113,129 @@ void nvgpu_channel_free_job(struct nvgpu_channel *c,
 	(void)c;
 	(void)job;
 	/*
-	 * Nothing needed for now. The job contents are preallocated. The
+	 * Nothing needed for now. The job memory belongs to the joblist. The
 	 * completion fence may briefly outlive the job, but the job memory is
-	 * reclaimed only when a new submit comes in and the ringbuffer has ran
-	 * out of space.
+	 * reused only after the job has been deleted from the joblist and a new
+	 * submit has gone around the whole ring.
 	 */
 }
 
-void nvgpu_channel_joblist_lock(struct nvgpu_channel *c)
-{
-	nvgpu_mutex_acquire(&c->joblist.pre_alloc.read_lock);
-}
-
-void nvgpu_channel_joblist_unlock(struct nvgpu_channel *c)
+bool nvgpu_channel_joblist_is_empty(struct nvgpu_channel *c)
 {
-	nvgpu_mutex_release(&c->joblist.pre_alloc.read_lock);
+	return NV_READ_ONCE(c->joblist.put) == NV_READ_ONCE(c->joblist.get);
 }
 
 struct nvgpu_channel_job *nvgpu_channel_joblist_peek(struct nvgpu_channel *c)
 {
-	unsigned int get = c->joblist.pre_alloc.get;
-	unsigned int put = c->joblist.pre_alloc.put;
-	bool empty = get == put;
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+
+	if (NV_READ_ONCE(joblist->put) == joblist->get) {
+		return NULL;
+	}
 
-	return empty ? NULL : &c->joblist.pre_alloc.jobs[get];
+	/* see the job as it was when added; pairs with joblist_add() */
+	nvgpu_smp_rmb();
+
+	/*
+	 * The consumer leaves a drained chunk only here, once a job after it
+	 * exists, so that the producer is done choosing the next chunk.
+	 */
+	if (joblist->head_idx == NVGPU_CHANNEL_JOB_CHUNK_JOBS) {
+		joblist->head = NV_READ_ONCE(joblist->head->next);
+		joblist->head_idx = 0U;
+	}
+
+	return &joblist->head->jobs[joblist->head_idx];
 }
 
 void nvgpu_channel_joblist_add(struct nvgpu_channel *c,
 		struct nvgpu_channel_job *job)
 {
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+
 	(void)job;
-	c->joblist.pre_alloc.put = (c->joblist.pre_alloc.put + 1U) %
-			(c->joblist.pre_alloc.length);
+
+	/* publish the job contents before the job itself */
+	nvgpu_smp_wmb();
+
+	joblist->tail_idx = nvgpu_safe_add_u32(joblist->tail_idx, 1U);
+	NV_WRITE_ONCE(joblist->put,
+			nvgpu_wrapping_add_u32(joblist->put, 1U));
 }
 
 void nvgpu_channel_joblist_delete(struct nvgpu_channel *c,
 		struct nvgpu_channel_job *job)
 {
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+
 	(void)job;
-	c->joblist.pre_alloc.get = (c->joblist.pre_alloc.get + 1U) %
-			(c->joblist.pre_alloc.length);
+
+	/* be done with the job before the producer may reuse its slot */
+	nvgpu_smp_mb();
+
+	joblist->head_idx = nvgpu_safe_add_u32(joblist->head_idx, 1U);
+	NV_WRITE_ONCE(joblist->get,
+			nvgpu_wrapping_add_u32(joblist->get, 1U));
 }
 
 int nvgpu_channel_joblist_init(struct nvgpu_channel *c, u32 num_jobs)
 {
-	int err;
-	u32 size;
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+	struct nvgpu_channel_job_chunk *chunk;
+	u32 num_chunks = 1U;
+	u32 i;
 
-	size = (u32)sizeof(struct nvgpu_channel_job);
-	if (num_jobs > nvgpu_safe_sub_u32(U32_MAX / size, 1U)) {
-		err = -ERANGE;
-		goto clean_up;
-	}
+	(void) memset(joblist, 0, sizeof(*joblist));
 
 	/*
-	 * The max capacity of this ring buffer is the alloc size minus one (in
-	 * units of item slot), so allocate a size of (num_jobs + 1) * size
-	 * bytes.
+	 * Deterministic channels must not allocate in the submit path, so give
+	 * them one chunk more than num_jobs needs: the chunk after the tail is
+	 * then always drained when the producer moves on. Others start with a
+	 * single chunk and grow as jobs pile up.
 	 */
-	c->joblist.pre_alloc.jobs = nvgpu_vzalloc(c->g,
-			nvgpu_safe_mult_u32(
-				nvgpu_safe_add_u32(num_jobs, 1U),
-				size));
-	if (c->joblist.pre_alloc.jobs == NULL) {
-		err = -ENOMEM;
-		goto clean_up;
+	if (nvgpu_channel_is_deterministic(c)) {
+		num_chunks = nvgpu_safe_add_u32(
+				DIV_ROUND_UP(num_jobs,
+					NVGPU_CHANNEL_JOB_CHUNK_JOBS), 1U);
 	}
 
-	/*
-	 * length is the allocation size of the ringbuffer; the number of jobs
-	 * that fit is one less.
-	 */
-	c->joblist.pre_alloc.length = nvgpu_safe_add_u32(num_jobs, 1U);
-	c->joblist.pre_alloc.put = 0;
-	c->joblist.pre_alloc.get = 0;
+	for (i = 0U; i < num_chunks; i++) {
+		chunk = nvgpu_kzalloc(c->g, sizeof(*chunk));
+		if (chunk == NULL) {
+			nvgpu_channel_joblist_deinit(c);
+			return -ENOMEM;
+		}
+
+		if (joblist->tail == NULL) {
+			joblist->head = chunk;
+		} else {
+			joblist->tail->next = chunk;
+		}
+		chunk->next = joblist->head;
+		joblist->tail = chunk;
+		joblist->num_chunks = nvgpu_safe_add_u32(joblist->num_chunks,
+				1U);
+	}
 
-	return 0;
+	/* start at the first chunk with no jobs */
+	joblist->tail = joblist->head;
+	joblist->capacity = num_jobs;
 
-clean_up:
-	nvgpu_vfree(c->g, c->joblist.pre_alloc.jobs);
-	(void) memset(&c->joblist.pre_alloc, 0, sizeof(c->joblist.pre_alloc));
-	return err;
+	return 0;
 }
 
 void nvgpu_channel_joblist_deinit(struct nvgpu_channel *c)
 {
-	if (c->joblist.pre_alloc.jobs != NULL) {
-		nvgpu_vfree(c->g, c->joblist.pre_alloc.jobs);
-		c->joblist.pre_alloc.jobs = NULL;
+	struct nvgpu_channel_joblist *joblist = &c->joblist;
+	struct nvgpu_channel_job_chunk *chunk = joblist->head;
+	struct nvgpu_channel_job_chunk *next;
+	u32 i;
+
+	for (i = 0U; i < joblist->num_chunks; i++) {
+		next = chunk->next;
+		nvgpu_kfree(c->g, chunk);
+		chunk = next;
 	}
+
+	(void) memset(joblist, 0, sizeof(*joblist));
 }
@@ -37,6 +37,7 @@
 #include <nvgpu/pmu/mutex.h>
 #endif
 #include <nvgpu/nvgpu_init.h>
+#include <nvgpu/nvs.h>
 
 void nvgpu_runlist_lock_active_runlists(struct gk20a *g)
 {
@@ -64,6 +65,113 @@ void nvgpu_runlist_unlock_active_runlists(struct gk20a *g)
 	}
 }
 
+/*
+ * The entries of a TSG only depend on its timeslice, its active channel count
+ * and which of its channels are active. Keep the entries last rendered for
+ * each TSG and copy them in one go as long as none of those has changed.
+ */
+struct nvgpu_runlist_tsg_cache {
+	/** #nvgpu_tsg.ch_gen the entries were rendered for. */
+	u32 ch_gen;
+	/** #nvgpu_tsg.timeslice_us the entries were rendered for. */
+	u32 timeslice_us;
+	/** #nvgpu_tsg.num_active_channels the entries were rendered for. */
+	u32 num_active_channels;
+	/** Number of entries, TSG entry included. 0 if not valid. */
+	u32 count;
+	/** Size of #entries in entries. */
+	u32 capacity;
+	/** The rendered entries. */
+	u32 *entries;
+	/** Active channels of the TSG the entries were rendered for. */
+	unsigned long channels[];
+};
+
+void nvgpu_runlist_free_tsg_cache(struct gk20a *g, struct nvgpu_tsg *tsg)
+{
+	if (tsg->rl_cache == NULL) {
+		return;
+	}
+
+	nvgpu_kfree(g, tsg->rl_cache->entries);
+	nvgpu_kfree(g, tsg->rl_cache);
+	tsg->rl_cache = NULL;
+}
+
+static bool nvgpu_runlist_tsg_cache_hit(struct nvgpu_fifo *f,
+		struct nvgpu_runlist_domain *domain, struct nvgpu_tsg *tsg)
+{
+	struct nvgpu_runlist_tsg_cache *cache = tsg->rl_cache;
+	u32 words = (u32)BITS_TO_LONGS(f->num_channels);
+	u32 w;
+
+	if ((cache == NULL) || (cache->count == 0U) ||
+	    (cache->ch_gen != tsg->ch_gen) ||
+	    (cache->timeslice_us != tsg->timeslice_us) ||
+	    (cache->num_active_channels != tsg->num_active_channels)) {
+		return false;
+	}
+
+	for (w = 0U; w < words; w++) {
+		if ((tsg->ch_bitmap[w] & domain->active_channels[w]) !=
+				cache->channels[w]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Remember count entries just rendered at entries for the TSG. Failing to
+ * allocate only means the next append renders them again.
+ */
+static void nvgpu_runlist_tsg_cache_store(struct nvgpu_fifo *f,
+		struct nvgpu_runlist_domain *domain, struct nvgpu_tsg *tsg,
+		const u32 *entries, u32 count)
+{
+	struct gk20a *g = f->g;
+	struct nvgpu_runlist_tsg_cache *cache = tsg->rl_cache;
+	u32 words = (u32)BITS_TO_LONGS(f->num_channels);
+	u32 w;
+
+	if (cache == NULL) {
+		cache = nvgpu_kzalloc(g, sizeof(*cache) +
+				(size_t)words * sizeof(cache->channels[0]));
+		if (cache == NULL) {
+			return;
+		}
+		tsg->rl_cache = cache;
+	}
+
+	cache->count = 0U;
+
+	if (count > cache->capacity) {
+		u32 capacity = round_up(count, 8U);
+
+		nvgpu_kfree(g, cache->entries);
+		cache->capacity = 0U;
+		cache->entries = nvgpu_kmalloc(g, (size_t)capacity *
+				f->runlist_entry_size);
+		if (cache->entries == NULL) {
+			return;
+		}
+		cache->capacity = capacity;
+	}
+
+	nvgpu_memcpy((u8 *)cache->entries, (const u8 *)entries,
+			(size_t)count * f->runlist_entry_size);
+
+	for (w = 0U; w < words; w++) {
+		cache->channels[w] = tsg->ch_bitmap[w] &
+			domain->active_channels[w];
+	}
+	cache->ch_gen = tsg->ch_gen;
+	cache->timeslice_us = tsg->timeslice_us;
+	cache->num_active_channels = tsg->num_active_channels;
+	cache->count = count;
+}
+
 static u32 nvgpu_runlist_append_tsg(struct gk20a *g,
 		struct nvgpu_runlist_domain *domain,
 		u32 **runlist_entry,
@@ -72,9 +180,11 @@ static u32 nvgpu_runlist_append_tsg(struct gk20a *g,
 {
 	struct nvgpu_fifo *f = &g->fifo;
 	u32 runlist_entry_words = f->runlist_entry_size / (u32)sizeof(u32);
-	struct nvgpu_channel *ch;
+	u32 words = (u32)BITS_TO_LONGS(f->num_channels);
+	u32 *tsg_entry = *runlist_entry;
 	u32 count = 0;
 	u32 timeslice;
+	u32 w;
 	int err;
 
 	nvgpu_log_fn(f->g, " ");
@@ -83,6 +193,29 @@ static u32 nvgpu_runlist_append_tsg(struct gk20a *g,
 		return RUNLIST_APPEND_FAILURE;
 	}
 
+	domain->tsg_levels[tsg->tsgid] =
+		nvgpu_safe_cast_u32_to_u8(tsg->interleave_level);
+
+	nvgpu_rwsem_down_read(&tsg->ch_list_lock);
+
+	if (nvgpu_runlist_tsg_cache_hit(f, domain, tsg)) {
+		count = tsg->rl_cache->count;
+		if (count > *entries_left) {
+			nvgpu_rwsem_up_read(&tsg->ch_list_lock);
+			return RUNLIST_APPEND_FAILURE;
+		}
+
+		nvgpu_log_info(g, "add TSG %d to runlist, %u cached entries",
+				tsg->tsgid, count);
+		nvgpu_memcpy((u8 *)*runlist_entry,
+				(const u8 *)tsg->rl_cache->entries,
+				(size_t)count * f->runlist_entry_size);
+		*runlist_entry += (size_t)count * runlist_entry_words;
+		*entries_left -= count;
+		nvgpu_rwsem_up_read(&tsg->ch_list_lock);
+		return count;
+	}
+
 	/* add TSG entry */
 	nvgpu_log_info(g, "add TSG %d to runlist", tsg->tsgid);
 
@@ -92,6 +225,7 @@ static u32 nvgpu_runlist_append_tsg(struct gk20a *g,
 	 */
 	err = nvgpu_ptimer_scale(g, tsg->timeslice_us, &timeslice);
 	if (err != 0) {
+		nvgpu_rwsem_up_read(&tsg->ch_list_lock);
 		return RUNLIST_APPEND_FAILURE;
 	}
 
@@ -104,36 +238,45 @@ static u32 nvgpu_runlist_append_tsg(struct gk20a *g,
 	count++;
 	(*entries_left)--;
 
-	nvgpu_rwsem_down_read(&tsg->ch_list_lock);
-	/* add runnable channels bound to this TSG */
-	nvgpu_list_for_each_entry(ch, &tsg->ch_list,
-			nvgpu_channel, ch_entry) {
-		if (!nvgpu_test_bit(ch->chid,
-			      domain->active_channels)) {
-			continue;
-		}
+	/*
+	 * add runnable channels bound to this TSG: the channels of the TSG
+	 * that are also active in the domain
+	 */
+	for (w = 0U; w < words; w++) {
+		unsigned long active = tsg->ch_bitmap[w] &
+			domain->active_channels[w];
+		unsigned long bit;
+
+		for_each_set_bit(bit, &active, BITS_PER_LONG) {
+			u32 chid = nvgpu_safe_add_u32(
+					nvgpu_safe_mult_u32(w, (u32)BITS_PER_LONG),
+					(u32)bit);
+			struct nvgpu_channel *ch = &f->channel[chid];
+
+			if (*entries_left == 0U) {
+				nvgpu_rwsem_up_read(&tsg->ch_list_lock);
+				return RUNLIST_APPEND_FAILURE;
+			}
 
-		if (*entries_left == 0U) {
-			nvgpu_rwsem_up_read(&tsg->ch_list_lock);
-			return RUNLIST_APPEND_FAILURE;
+			nvgpu_log_info(g, "add channel %d to runlist",
+				ch->chid);
+			g->ops.runlist.get_ch_entry(ch, *runlist_entry);
+			nvgpu_log_info(g, "rl entries left %d runlist [0] %x [1] %x",
+				*entries_left,
+				(*runlist_entry)[0], (*runlist_entry)[1]);
+			count = nvgpu_safe_add_u32(count, 1U);
+			*runlist_entry += runlist_entry_words;
+			(*entries_left)--;
 		}
-
-		nvgpu_log_info(g, "add channel %d to runlist",
-			ch->chid);
-		g->ops.runlist.get_ch_entry(ch, *runlist_entry);
-		nvgpu_log_info(g, "rl entries left %d runlist [0] %x [1] %x",
-			*entries_left,
-			(*runlist_entry)[0], (*runlist_entry)[1]);
-		count = nvgpu_safe_add_u32(count, 1U);
-		*runlist_entry += runlist_entry_words;
-		(*entries_left)--;
 	}
+
+	nvgpu_runlist_tsg_cache_store(f, domain, tsg, tsg_entry, count);
+
 	nvgpu_rwsem_up_read(&tsg->ch_list_lock);
 
 	return count;
 }
 
-
 static u32 nvgpu_runlist_append_prio(struct nvgpu_fifo *f,
 				struct nvgpu_runlist_domain *domain,
 				u32 **runlist_entry,
@@ -369,6 +512,136 @@ static bool nvgpu_runlist_modify_active_locked(struct gk20a *g,
 	return true;
 }
 
+/*
+ * Entries of active TSGs other than skip_tsg that come before a TSG at the
+ * given level and tsgid in a flat (non-interleaved) runlist. TSGs other than
+ * skip_tsg are placed by the level they were rendered with in mem_hw.
+ */
+static u32 nvgpu_runlist_flat_offset(struct nvgpu_fifo *f,
+				     struct nvgpu_runlist_domain *domain,
+				     struct nvgpu_tsg *skip_tsg, u32 level)
+{
+	u32 offset = 0U;
+	unsigned long tsgid;
+
+	for_each_set_bit(tsgid, domain->active_tsgs, f->num_channels) {
+		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g, (u32)tsgid);
+		u32 tsg_level = domain->tsg_levels[tsgid];
+
+		if (tsg == skip_tsg) {
+			continue;
+		}
+
+		/* High comes first, then ascending tsgid within a level. */
+		if ((tsg_level > level) ||
+		    ((tsg_level == level) && (tsg->tsgid < skip_tsg->tsgid))) {
+			offset = nvgpu_safe_add_u32(offset,
+				nvgpu_safe_add_u32(tsg->num_active_channels, 1U));
+		}
+	}
+
+	return offset;
+}
+
+/*
+ * Copy entries [from, to) of the runlist without the old entries of the
+ * updated TSG, i.e., skipping old_len entries at old_off in the source.
+ */
+static void nvgpu_runlist_copy_entries_except(struct nvgpu_fifo *f,
+		u8 *dst, const u8 *src, u32 from, u32 to,
+		u32 old_off, u32 old_len)
+{
+	u32 entry_size = f->runlist_entry_size;
+	u32 split = min(max(from, old_off), to);
+
+	if (split > from) {
+		nvgpu_memcpy(dst, &src[(size_t)from * entry_size],
+				(size_t)(split - from) * entry_size);
+		dst = &dst[(size_t)(split - from) * entry_size];
+	}
+
+	if (to > split) {
+		nvgpu_memcpy(dst,
+			&src[(size_t)nvgpu_safe_add_u32(split, old_len) *
+				entry_size],
+			(size_t)(to - split) * entry_size);
+	}
+}
+
+/*
+ * Patch the runlist for one TSG whose active channel count changed by one.
+ * The rest of the entries are copied as-is from mem_hw, which must be in sync
+ * with the active bitmaps; only the entries of this TSG are rendered again.
+ */
+static int nvgpu_runlist_patch_tsg_locked(struct gk20a *g,
+					  struct nvgpu_runlist_domain *domain,
+					  struct nvgpu_tsg *tsg, bool add)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_runlist_mem *src = domain->mem_hw;
+	struct nvgpu_runlist_mem *dst = domain->mem;
+	u32 entry_size = f->runlist_entry_size;
+	u32 old_num_channels;
+	u32 old_off = 0U, old_len = 0U;
+	u32 new_off = 0U, new_len = 0U;
+	u32 rest, count;
+	u32 *runlist_entry;
+	u32 entries_left;
+
+	dst->in_sync = false;
+
+	old_num_channels = add ?
+		nvgpu_safe_sub_u32(tsg->num_active_channels, 1U) :
+		nvgpu_safe_add_u32(tsg->num_active_channels, 1U);
+
+	if (old_num_channels != 0U) {
+		old_len = nvgpu_safe_add_u32(old_num_channels, 1U);
+		old_off = nvgpu_runlist_flat_offset(f, domain, tsg,
+				domain->tsg_levels[tsg->tsgid]);
+	}
+
+	if (nvgpu_safe_add_u32(old_off, old_len) > src->count) {
+		/* let the full rebuild sort it out */
+		return -EAGAIN;
+	}
+
+	rest = src->count - old_len;
+
+	if (tsg->num_active_channels != 0U) {
+		new_off = nvgpu_runlist_flat_offset(f, domain, tsg,
+				tsg->interleave_level);
+	}
+
+	nvgpu_runlist_copy_entries_except(f, dst->mem.cpu_va,
+			src->mem.cpu_va, 0U, new_off, old_off, old_len);
+
+	if (tsg->num_active_channels != 0U) {
+		runlist_entry = (u32 *)((u8 *)dst->mem.cpu_va +
+				(size_t)new_off * entry_size);
+		entries_left = f->num_runlist_entries - rest;
+		new_len = nvgpu_runlist_append_tsg(g, domain, &runlist_entry,
+				&entries_left, tsg);
+		if (new_len == RUNLIST_APPEND_FAILURE) {
+			return -E2BIG;
+		}
+	}
+
+	nvgpu_runlist_copy_entries_except(f,
+			(u8 *)dst->mem.cpu_va +
+				(size_t)nvgpu_safe_add_u32(new_off, new_len) *
+				entry_size,
+			src->mem.cpu_va, new_off, rest, old_off, old_len);
+
+	count = nvgpu_safe_add_u32(rest, new_len);
+	dst->count = count;
+	dst->in_sync = true;
+
+	rl_dbg(g, "patched TSG %u: %u -> %u entries at %u -> %u",
+		tsg->tsgid, old_len, new_len, old_off, new_off);
+
+	return 0;
+}
+
 static int nvgpu_runlist_reconstruct_locked(struct gk20a *g,
 					    struct nvgpu_runlist *runlist,
 					    struct nvgpu_runlist_domain *domain,
@@ -381,10 +654,14 @@ static int nvgpu_runlist_reconstruct_locked(struct gk20a *g,
 		runlist->id, (u64)nvgpu_mem_get_addr(g, &domain->mem->mem));
 
 	if (!add_entries) {
+		/* the active bitmaps still say otherwise */
 		domain->mem->count = 0;
+		domain->mem->in_sync = false;
 		return 0;
 	}
 
+	domain->mem->in_sync = false;
+
 	num_entries = nvgpu_runlist_construct_locked(f, domain,
 						f->num_runlist_entries);
 	if (num_entries == RUNLIST_APPEND_FAILURE) {
@@ -392,11 +669,23 @@ static int nvgpu_runlist_reconstruct_locked(struct gk20a *g,
 	}
 
 	domain->mem->count = num_entries;
+	domain->mem->in_sync = true;
 	WARN_ON(domain->mem->count > f->num_runlist_entries);
 
 	return 0;
 }
 
+/*
+ * Submit the mem_hw of the active domain and remember how much of it the
+ * hardware has so that a switch between two empty domains can be skipped.
+ */
+static void nvgpu_runlist_submit_locked(struct gk20a *g,
+		struct nvgpu_runlist *rl)
+{
+	g->ops.runlist.hw_submit(g, rl);
+	rl->submitted_count = rl->domain->mem_hw->count;
+}
+
 int nvgpu_runlist_update_locked(struct gk20a *g, struct nvgpu_runlist *rl,
 				struct nvgpu_runlist_domain *domain,
 				struct nvgpu_channel *ch, bool add,
@@ -419,8 +708,31 @@ int nvgpu_runlist_update_locked(struct gk20a *g, struct nvgpu_runlist *rl,
 		add_entries = add;
 	}
 
-	ret = nvgpu_runlist_reconstruct_locked(g, rl, domain, add_entries);
+	/*
+	 * With a flat runlist, a single channel only moves the entries of its
+	 * own TSG; patch those on top of the current buffer instead of
+	 * walking all TSGs again. The interleaved layout repeats TSGs all over
+	 * the buffer, so that still gets rebuilt.
+	 */
+	ret = -EAGAIN;
+	if ((ch != NULL) && g->fifo.runlist_incremental &&
+	    !g->runlist_interleave && domain->mem_hw->in_sync) {
+		ret = nvgpu_runlist_patch_tsg_locked(g, domain,
+				nvgpu_tsg_from_ch(ch), add);
+	}
+
+	if (ret == -EAGAIN) {
+		ret = nvgpu_runlist_reconstruct_locked(g, rl, domain,
+				add_entries);
+	}
 	if (ret != 0) {
+		/*
+		 * The active bitmaps have already been changed; neither
+		 * buffer matches them now, so the next update must not patch
+		 * on top of either.
+		 */
+		domain->mem->in_sync = false;
+		domain->mem_hw->in_sync = false;
 		return ret;
 	}
 
@@ -435,13 +747,22 @@ int nvgpu_runlist_update_locked(struct gk20a *g, struct nvgpu_runlist *rl,
 	domain->mem_hw = mem_tmp;
 
 	/*
-	 * A non-active domain may be updated, but submit still the currently
-	 * active one just for simplicity.
-	 *
-	 * TODO: Later on, updates and submits will need to be totally
-	 * decoupled so that submits are done only in the domain scheduler.
+	 * The domain scheduler sleeps while there's nothing to rotate; let it
+	 * know when this domain gets its first or loses its last entry.
 	 */
-	g->ops.runlist.hw_submit(g, rl);
+	if ((domain->mem->count == 0U) != (domain->mem_hw->count == 0U)) {
+		nvgpu_nvs_worker_notify(g);
+	}
+
+	/*
+	 * A non-active domain gets submitted when the domain scheduler
+	 * switches to it; the active one hasn't changed, so don't resubmit.
+	 */
+	if (domain != rl->domain) {
+		return 0;
+	}
+
+	nvgpu_runlist_submit_locked(g, rl);
 
 	if (wait_for_finish) {
 		ret = g->ops.runlist.wait_pending(g, rl);
@@ -488,7 +809,7 @@ int nvgpu_runlist_reschedule(struct nvgpu_channel *ch, bool preempt_next,
 	 * buffer is just resubmitted so that scheduling begins from the first
 	 * entry in it.
 	 */
-	g->ops.runlist.hw_submit(g, runlist);
+	nvgpu_runlist_submit_locked(g, runlist);
 
 	if (preempt_next) {
 		if (g->ops.runlist.reschedule_preempt_next_locked(ch,
@@ -565,6 +886,14 @@ static void runlist_select_locked(struct gk20a *g, struct nvgpu_runlist *runlist
 
 	runlist->domain = next_domain;
 
+	if ((runlist->submitted_count == 0U) &&
+			(next_domain->mem_hw->count == 0U)) {
+		/* empty to empty is a no-op for the hardware */
+		rl_dbg(g, "Runlist[%u]: both domains empty, skip submit",
+				runlist->id);
+		return;
+	}
+
 	gk20a_busy_noresume(g);
 	if (nvgpu_is_powered_off(g)) {
 		rl_dbg(g, "Runlist[%u]: power is off, skip submit",
@@ -588,12 +917,10 @@ static void runlist_select_locked(struct gk20a *g, struct nvgpu_runlist *runlist
 
 	/*
 	 * Just submit the previously built mem (in nvgpu_runlist_update_locked)
-	 * of the active domain to hardware. In the future, the main scheduling
-	 * loop will get signaled when the RL mem is modified and the same domain
-	 * with new data needs to be submitted (typically triggered by a channel
-	 * getting opened or closed). For now, that code path executes separately.
+	 * of the active domain to hardware. Updates to the active domain get
+	 * submitted directly from nvgpu_runlist_update_locked.
 	 */
-	g->ops.runlist.hw_submit(g, runlist);
+	nvgpu_runlist_submit_locked(g, runlist);
 
 	gk20a_idle(g);
 }
@@ -625,26 +952,43 @@ static void runlist_switch_domain_locked(struct gk20a *g,
 	}
 }
 
-static void runlist_switch_domain(struct gk20a *g, struct nvgpu_runlist *runlist)
+void nvgpu_runlist_select_domain(struct gk20a *g, const char *name)
 {
-	nvgpu_mutex_acquire(&runlist->runlist_lock);
-	runlist_switch_domain_locked(g, runlist);
-	nvgpu_mutex_release(&runlist->runlist_lock);
+	struct nvgpu_fifo *f = &g->fifo;
+	u32 i;
+
+	rl_dbg(g, "select domain %s", name);
+
+	for (i = 0U; i < f->num_runlists; i++) {
+		struct nvgpu_runlist *runlist = &f->active_runlists[i];
+		struct nvgpu_runlist_domain *domain;
+
+		nvgpu_mutex_acquire(&runlist->runlist_lock);
+		domain = nvgpu_rl_domain_get(g, runlist->id, name);
+		if ((domain != NULL) && (domain != runlist->domain)) {
+			runlist_select_locked(g, runlist, domain);
+		}
+		nvgpu_mutex_release(&runlist->runlist_lock);
+	}
 }
 
-void nvgpu_runlist_tick(struct gk20a *g)
+bool nvgpu_rl_domain_has_work(struct gk20a *g, const char *name)
 {
 	struct nvgpu_fifo *f = &g->fifo;
+	bool work = false;
 	u32 i;
 
-	rl_dbg(g, "domain tick");
-
-	for (i = 0U; i < f->num_runlists; i++) {
-		struct nvgpu_runlist *runlist;
+	for (i = 0U; (i < f->num_runlists) && !work; i++) {
+		struct nvgpu_runlist *runlist = &f->active_runlists[i];
+		struct nvgpu_runlist_domain *domain;
 
-		runlist = &f->active_runlists[i];
-		runlist_switch_domain(g, runlist);
+		nvgpu_mutex_acquire(&runlist->runlist_lock);
+		domain = nvgpu_rl_domain_get(g, runlist->id, name);
+		work = (domain != NULL) && (domain->mem_hw->count != 0U);
+		nvgpu_mutex_release(&runlist->runlist_lock);
 	}
+
+	return work;
 }
 
 int nvgpu_runlist_update(struct gk20a *g, struct nvgpu_runlist *rl,
@@ -778,6 +1122,8 @@ static void nvgpu_runlist_domain_free(struct gk20a *g,
 	domain->active_channels = NULL;
 	nvgpu_kfree(g, domain->active_tsgs);
 	domain->active_tsgs = NULL;
+	nvgpu_kfree(g, domain->tsg_levels);
+	domain->tsg_levels = NULL;
 
 	nvgpu_kfree(g, domain);
 }
@@ -1040,6 +1386,11 @@ static struct nvgpu_runlist_domain *nvgpu_runlist_domain_alloc(struct gk20a *g,
 		goto free_active_channels;
 	}
 
+	domain->tsg_levels = nvgpu_kzalloc(g, f->num_channels);
+	if (domain->tsg_levels == NULL) {
+		goto free_active_tsgs;
+	}
+
 	/* deleted in nvgpu_runlist_domain_free() */
 	nvgpu_list_add_tail(&domain->domains_list, &runlist->domains);
 
@@ -1049,6 +1400,8 @@ static struct nvgpu_runlist_domain *nvgpu_runlist_domain_alloc(struct gk20a *g,
 	}
 
 	return domain;
+free_active_tsgs:
+	nvgpu_kfree(g, domain->active_tsgs);
 free_active_channels:
 	nvgpu_kfree(g, domain->active_channels);
 free_mem_hw:
@@ -1150,6 +1503,7 @@ static void nvgpu_init_active_runlist_mapping(struct gk20a *g)
 
 		nvgpu_init_list_node(&runlist->domains);
 		nvgpu_mutex_init(&runlist->runlist_lock);
+		runlist->submitted_count = U32_MAX;
 	}
 }
 
@@ -1190,6 +1544,7 @@ int nvgpu_runlist_setup_sw(struct gk20a *g)
 	f->runlist_entry_size = g->ops.runlist.entry_size(g);
 	f->num_runlist_entries = g->ops.runlist.length_max(g);
 	f->max_runlists = g->ops.runlist.count_max(g);
+	f->runlist_incremental = true;
 
 	f->runlists = nvgpu_kzalloc(g, nvgpu_safe_mult_u64(
 				sizeof(*f->runlists), f->max_runlists));
@@ -342,9 +342,7 @@ static int nvgpu_submit_prepare_gpfifo_track(struct nvgpu_channel *c,
 	struct nvgpu_channel_job *job = NULL;
 	int err;
 
-	nvgpu_channel_joblist_lock(c);
 	err = nvgpu_channel_alloc_job(c, &job);
-	nvgpu_channel_joblist_unlock(c);
 	if (err != 0) {
 		return err;
 	}
@@ -477,7 +475,8 @@ static int nvgpu_do_submit(struct nvgpu_channel *c,
 		struct nvgpu_fence_type **fence_out,
 		struct nvgpu_swprofiler *profiler,
 		bool need_job_tracking,
-		bool need_deferred_cleanup)
+		bool need_deferred_cleanup,
+		bool kick)
 {
 	struct gk20a *g = c->g;
 	int err;
@@ -506,6 +505,8 @@ static int nvgpu_do_submit(struct nvgpu_channel *c,
 	} else {
 		err = nvgpu_submit_prepare_gpfifo_notrack(c, gpfifo,
 				userdata, num_entries, fence_out, profiler);
+		/* no job to tell when this is done */
+		nvgpu_channel_semaphore_set_untracked(c);
 	}
 
 	if (err != 0) {
@@ -514,20 +515,32 @@ static int nvgpu_do_submit(struct nvgpu_channel *c,
 
 	nvgpu_swprofile_snapshot(profiler, PROF_KICKOFF_APPEND);
 
-	g->ops.userd.gp_put(g, c);
+	/*
+	 * Batched submits ring the doorbell once per channel after all the
+	 * entries of the batch have been appended.
+	 */
+	if (kick) {
+		g->ops.userd.gp_put(g, c);
+	}
 
 	return 0;
 }
 
 #ifdef CONFIG_NVGPU_DETERMINISTIC_CHANNELS
-static int nvgpu_submit_deterministic(struct nvgpu_channel *c,
+/*
+ * Must be called with g->deterministic_busy held for reading. If kick is
+ * false, the caller is responsible for updating GP_PUT before releasing
+ * deterministic_busy.
+ */
+static int nvgpu_submit_deterministic_locked(struct nvgpu_channel *c,
 				struct nvgpu_gpfifo_entry *gpfifo,
 				struct nvgpu_gpfifo_userdata userdata,
 				u32 num_entries,
 				u32 flags,
 				struct nvgpu_channel_fence *fence,
 				struct nvgpu_fence_type **fence_out,
-				struct nvgpu_swprofiler *profiler)
+				struct nvgpu_swprofiler *profiler,
+				bool kick)
 {
 	bool skip_buffer_refcounting = (flags &
 			NVGPU_SUBMIT_FLAGS_SKIP_BUFFER_REFCOUNTING) != 0U;
@@ -593,9 +606,6 @@ static int nvgpu_submit_deterministic(struct nvgpu_channel *c,
 		nvgpu_channel_clean_up_deterministic_job(c);
 	}
 
-	/* Grab access to HW to deal with do_idle */
-	nvgpu_rwsem_down_read(&g->deterministic_busy);
-
 	if (c->deterministic_railgate_allowed) {
 		/*
 		 * Nope - this channel has dropped its own power ref. As
@@ -609,18 +619,37 @@ static int nvgpu_submit_deterministic(struct nvgpu_channel *c,
 	}
 
 	err = nvgpu_do_submit(c, gpfifo, userdata, num_entries, flags, fence,
-			fence_out, profiler, need_job_tracking, false);
+			fence_out, profiler, need_job_tracking, false, kick);
 	if (err != 0) {
 		goto clean_up;
 	}
 
-	/* No hw access beyond this point */
-	nvgpu_rwsem_up_read(&g->deterministic_busy);
-
 	return 0;
 
 clean_up:
 	nvgpu_log_fn(g, "fail %d", err);
+	return err;
+}
+
+static int nvgpu_submit_deterministic(struct nvgpu_channel *c,
+				struct nvgpu_gpfifo_entry *gpfifo,
+				struct nvgpu_gpfifo_userdata userdata,
+				u32 num_entries,
+				u32 flags,
+				struct nvgpu_channel_fence *fence,
+				struct nvgpu_fence_type **fence_out,
+				struct nvgpu_swprofiler *profiler)
+{
+	struct gk20a *g = c->g;
+	int err;
+
+	/* Grab access to HW to deal with do_idle */
+	nvgpu_rwsem_down_read(&g->deterministic_busy);
+
+	err = nvgpu_submit_deterministic_locked(c, gpfifo, userdata,
+			num_entries, flags, fence, fence_out, profiler, true);
+
+	/* No hw access beyond this point */
 	nvgpu_rwsem_up_read(&g->deterministic_busy);
 
 	return err;
@@ -634,7 +663,8 @@ static int nvgpu_submit_nondeterministic(struct nvgpu_channel *c,
 				u32 flags,
 				struct nvgpu_channel_fence *fence,
 				struct nvgpu_fence_type **fence_out,
-				struct nvgpu_swprofiler *profiler)
+				struct nvgpu_swprofiler *profiler,
+				bool kick)
 {
 	bool skip_buffer_refcounting = (flags &
 			NVGPU_SUBMIT_FLAGS_SKIP_BUFFER_REFCOUNTING) != 0U;
@@ -683,7 +713,7 @@ static int nvgpu_submit_nondeterministic(struct nvgpu_channel *c,
 	}
 
 	err = nvgpu_do_submit(c, gpfifo, userdata, num_entries, flags, fence,
-			fence_out, profiler, need_job_tracking, true);
+			fence_out, profiler, need_job_tracking, true, kick);
 	if (err != 0) {
 		goto clean_up;
 	}
@@ -692,7 +722,9 @@ static int nvgpu_submit_nondeterministic(struct nvgpu_channel *c,
 
 clean_up:
 	nvgpu_log_fn(g, "fail %d", err);
-	gk20a_idle(g);
+	if (need_job_tracking) {
+		gk20a_idle(g);
+	}
 
 	return err;
 }
@@ -732,6 +764,58 @@ static int check_submit_allowed(struct nvgpu_channel *c)
 	return 0;
 }
 
+static int check_submit_size(struct nvgpu_channel *c, u32 num_entries)
+{
+	/*
+	 * Fifo not large enough for request. Return error immediately.
+	 * Kernel can insert gpfifo entries before and after user gpfifos.
+	 * So, add extra entries in user request. Also, HW with fifo size N
+	 * can accept only N-1 entries.
+	 */
+	if (c->gpfifo.entry_num - 1U < num_entries + EXTRA_GPFIFO_ENTRIES) {
+		nvgpu_err(c->g, "not enough gpfifo space allocated");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void nvgpu_submit_trace_submitted(struct nvgpu_channel *c,
+				u32 num_entries,
+				u32 flags,
+				struct nvgpu_fence_type **fence_out)
+{
+#ifdef CONFIG_NVGPU_TRACE
+	struct gk20a *g = c->g;
+
+	if (fence_out != NULL && *fence_out != NULL) {
+		/*
+		 * This is not a good example on how to use the fence type.
+		 * Don't touch the priv data. The debug trace is special.
+		 */
+#ifdef CONFIG_TEGRA_GK20A_NVHOST
+		trace_gk20a_channel_submitted_gpfifo(g->name,
+					c->chid, num_entries, flags,
+					(*fence_out)->priv.syncpt_id,
+					(*fence_out)->priv.syncpt_value);
+#else
+		trace_gk20a_channel_submitted_gpfifo(g->name,
+					c->chid, num_entries, flags,
+					0, 0);
+#endif
+	} else {
+		trace_gk20a_channel_submitted_gpfifo(g->name,
+					c->chid, num_entries, flags,
+					0, 0);
+	}
+#else
+	(void)c;
+	(void)num_entries;
+	(void)flags;
+	(void)fence_out;
+#endif
+}
+
 static int nvgpu_submit_channel_gpfifo(struct nvgpu_channel *c,
 				struct nvgpu_gpfifo_entry *gpfifo,
 				struct nvgpu_gpfifo_userdata userdata,
@@ -749,15 +833,9 @@ static int nvgpu_submit_channel_gpfifo(struct nvgpu_channel *c,
 		return err;
 	}
 
-	/*
-	 * Fifo not large enough for request. Return error immediately.
-	 * Kernel can insert gpfifo entries before and after user gpfifos.
-	 * So, add extra entries in user request. Also, HW with fifo size N
-	 * can accept only N-1 entries.
-	 */
-	if (c->gpfifo.entry_num - 1U < num_entries + EXTRA_GPFIFO_ENTRIES) {
-		nvgpu_err(g, "not enough gpfifo space allocated");
-		return -ENOMEM;
+	err = check_submit_size(c, num_entries);
+	if (err != 0) {
+		return err;
 	}
 
 	nvgpu_swprofile_snapshot(profiler, PROF_KICKOFF_ENTRY);
@@ -775,35 +853,15 @@ static int nvgpu_submit_channel_gpfifo(struct nvgpu_channel *c,
 #endif
 	{
 		err = nvgpu_submit_nondeterministic(c, gpfifo, userdata,
-				num_entries, flags, fence, fence_out, profiler);
+				num_entries, flags, fence, fence_out, profiler,
+				true);
 	}
 
 	if (err != 0) {
 		return err;
 	}
 
-#ifdef CONFIG_NVGPU_TRACE
-	if (fence_out != NULL && *fence_out != NULL) {
-		/*
-		 * This is not a good example on how to use the fence type.
-		 * Don't touch the priv data. The debug trace is special.
-		 */
-#ifdef CONFIG_TEGRA_GK20A_NVHOST
-		trace_gk20a_channel_submitted_gpfifo(g->name,
-					c->chid, num_entries, flags,
-					(*fence_out)->priv.syncpt_id,
-					(*fence_out)->priv.syncpt_value);
-#else
-		trace_gk20a_channel_submitted_gpfifo(g->name,
-					c->chid, num_entries, flags,
-					0, 0);
-#endif
-	} else {
-		trace_gk20a_channel_submitted_gpfifo(g->name,
-					c->chid, num_entries, flags,
-					0, 0);
-	}
-#endif
+	nvgpu_submit_trace_submitted(c, num_entries, flags, fence_out);
 
 	nvgpu_log_info(g, "post-submit put %d, get %d, size %d",
 		c->gpfifo.put, c->gpfifo.get, c->gpfifo.entry_num);
@@ -846,3 +904,149 @@ int nvgpu_submit_channel_gpfifo_kernel(struct nvgpu_channel *c,
 	return nvgpu_submit_channel_gpfifo(c, gpfifo, userdata, num_entries,
 			flags, fence, fence_out, NULL);
 }
+
+/*
+ * Append one batch entry to its channel without ringing the doorbell. Called
+ * with a batch power ref held and, if deterministic channels are supported,
+ * with g->deterministic_busy held for reading.
+ */
+static int nvgpu_submit_batch_append(struct gk20a *g,
+				struct nvgpu_submit_batch_entry *e)
+{
+	struct nvgpu_gpfifo_userdata userdata = { NULL, NULL };
+	struct nvgpu_channel *c = e->c;
+	int err;
+
+	if ((c == NULL) || (c->g != g)) {
+		return -EINVAL;
+	}
+
+	err = check_submit_allowed(c);
+	if (err != 0) {
+		return err;
+	}
+
+	err = check_submit_size(c, e->num_entries);
+	if (err != 0) {
+		return err;
+	}
+
+	nvgpu_log_info(g, "channel %d", c->chid);
+
+#ifdef CONFIG_NVGPU_DETERMINISTIC_CHANNELS
+	if (c->deterministic) {
+		return nvgpu_submit_deterministic_locked(c, e->gpfifo,
+				userdata, e->num_entries, e->flags, e->fence,
+				e->fence_out, NULL, false);
+	}
+#endif
+	return nvgpu_submit_nondeterministic(c, e->gpfifo, userdata,
+			e->num_entries, e->flags, e->fence, e->fence_out,
+			NULL, false);
+}
+
+/*
+ * GP_PUT is only written for the last successful entry of each channel; the
+ * earlier entries of the same channel are covered by that write.
+ */
+static bool nvgpu_submit_batch_needs_kick(
+				struct nvgpu_submit_batch_entry *entries,
+				u32 idx, u32 num_batch_entries)
+{
+	u32 i;
+
+	if (entries[idx].err != 0) {
+		return false;
+	}
+
+	for (i = idx + 1U; i < num_batch_entries; i++) {
+		if ((entries[i].c == entries[idx].c) &&
+				(entries[i].err == 0)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int nvgpu_submit_channel_gpfifo_kernel_batch(struct gk20a *g,
+				struct nvgpu_submit_batch_entry *entries,
+				u32 num_batch_entries)
+{
+	struct nvgpu_submit_batch_entry *e;
+	int ret = 0;
+	int err;
+	u32 i;
+
+	if (nvgpu_is_enabled(g, NVGPU_DRIVER_IS_DYING)) {
+		nvgpu_info(g, "can't submit, driver dying");
+		err = -ENODEV;
+		goto fail_all;
+	}
+
+	/*
+	 * Keep the GPU powered for the whole batch. Jobs that need tracking
+	 * still take their own ref (dropped by job cleanup), but with this
+	 * one held those never have to resume the GPU, which matters because
+	 * a resume would need deterministic_busy for writing.
+	 */
+	err = gk20a_busy(g);
+	if (err != 0) {
+		nvgpu_err(g, "failed to host gk20a to submit gpfifo batch");
+		goto fail_all;
+	}
+
+	/* update debug settings */
+	nvgpu_ltc_sync_enabled(g);
+
+#ifdef CONFIG_NVGPU_DETERMINISTIC_CHANNELS
+	/* Grab access to HW to deal with do_idle */
+	nvgpu_rwsem_down_read(&g->deterministic_busy);
+#endif
+
+	for (i = 0U; i < num_batch_entries; i++) {
+		e = &entries[i];
+		e->err = nvgpu_submit_batch_append(g, e);
+	}
+
+	for (i = 0U; i < num_batch_entries; i++) {
+		if (nvgpu_submit_batch_needs_kick(entries, i,
+				num_batch_entries)) {
+			g->ops.userd.gp_put(g, entries[i].c);
+		}
+	}
+
+#ifdef CONFIG_NVGPU_DETERMINISTIC_CHANNELS
+	/* No hw access beyond this point */
+	nvgpu_rwsem_up_read(&g->deterministic_busy);
+#endif
+
+	gk20a_idle(g);
+
+	for (i = 0U; i < num_batch_entries; i++) {
+		e = &entries[i];
+		if (e->err != 0) {
+			nvgpu_log_fn(g, "batch entry %u fail %d", i, e->err);
+			if (ret == 0) {
+				ret = e->err;
+			}
+			continue;
+		}
+
+		nvgpu_submit_trace_submitted(e->c, e->num_entries, e->flags,
+				e->fence_out);
+
+		nvgpu_log_info(g, "post-submit put %d, get %d, size %d",
+			e->c->gpfifo.put, e->c->gpfifo.get,
+			e->c->gpfifo.entry_num);
+	}
+
+	nvgpu_log_fn(g, "done");
+	return ret;
+
+fail_all:
+	for (i = 0U; i < num_batch_entries; i++) {
+		entries[i].err = err;
+	}
+	return err;
+}
@@ -148,6 +148,8 @@ int nvgpu_tsg_bind_channel(struct nvgpu_tsg *tsg, struct nvgpu_channel *ch)
 
 	nvgpu_rwsem_down_write(&tsg->ch_list_lock);
 	nvgpu_list_add_tail(&ch->ch_entry, &tsg->ch_list);
+	nvgpu_set_bit(ch->chid, tsg->ch_bitmap);
+	tsg->ch_gen = nvgpu_wrapping_add_u32(tsg->ch_gen, 1U);
 	tsg->ch_count = nvgpu_safe_add_u32(tsg->ch_count, 1U);
 	ch->tsgid = tsg->tsgid;
 	/* channel is serviceable after it is bound to tsg */
@@ -284,6 +286,8 @@ static int nvgpu_tsg_unbind_channel_common(struct nvgpu_tsg *tsg,
 	/* Remove channel from TSG and re-enable rest of the channels */
 	nvgpu_rwsem_down_write(&tsg->ch_list_lock);
 	nvgpu_list_del(&ch->ch_entry);
+	nvgpu_clear_bit(ch->chid, tsg->ch_bitmap);
+	tsg->ch_gen = nvgpu_wrapping_add_u32(tsg->ch_gen, 1U);
 	tsg->ch_count = nvgpu_safe_sub_u32(tsg->ch_count, 1U);
 	ch->tsgid = NVGPU_INVALID_TSG_ID;
 
@@ -387,6 +391,8 @@ fail:
 
 	nvgpu_rwsem_down_write(&tsg->ch_list_lock);
 	nvgpu_list_del(&ch->ch_entry);
+	nvgpu_clear_bit(ch->chid, tsg->ch_bitmap);
+	tsg->ch_gen = nvgpu_wrapping_add_u32(tsg->ch_gen, 1U);
 	ch->tsgid = NVGPU_INVALID_TSG_ID;
 	nvgpu_rwsem_up_write(&tsg->ch_list_lock);
 
@@ -446,6 +452,7 @@ void nvgpu_tsg_unbind_channel_check_ctx_reload(struct nvgpu_tsg *tsg,
 
 static void nvgpu_tsg_destroy(struct nvgpu_tsg *tsg)
 {
+	nvgpu_runlist_free_tsg_cache(tsg->g, tsg);
 #ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
 	nvgpu_mutex_destroy(&tsg->event_id_list_lock);
 #endif
@@ -486,18 +493,24 @@ void nvgpu_tsg_cleanup_sw(struct gk20a *g)
 
 	nvgpu_vfree(g, f->tsg);
 	f->tsg = NULL;
+	nvgpu_vfree(g, f->tsg_ch_bitmaps);
+	f->tsg_ch_bitmaps = NULL;
 	nvgpu_mutex_destroy(&f->tsg_inuse_mutex);
 }
 
 static void nvgpu_tsg_init_support(struct gk20a *g, u32 tsgid)
 {
+	struct nvgpu_fifo *f = &g->fifo;
 	struct nvgpu_tsg *tsg = NULL;
 
-	tsg = &g->fifo.tsg[tsgid];
+	tsg = &f->tsg[tsgid];
 
+	tsg->g = g;
 	tsg->in_use = false;
 	tsg->tsgid = tsgid;
 	tsg->abortable = true;
+	tsg->ch_bitmap = &f->tsg_ch_bitmaps[(size_t)tsgid *
+			BITS_TO_LONGS(f->num_channels)];
 
 	nvgpu_init_list_node(&tsg->ch_list);
 	nvgpu_rwsem_init(&tsg->ch_list_lock);
@@ -524,12 +537,25 @@ int nvgpu_tsg_setup_sw(struct gk20a *g)
 		goto clean_up_mutex;
 	}
 
+	f->tsg_ch_bitmaps = nvgpu_vzalloc(g, nvgpu_safe_mult_u64(
+			nvgpu_safe_mult_u64(f->num_channels,
+				BITS_TO_LONGS(f->num_channels)),
+			sizeof(*f->tsg_ch_bitmaps)));
+	if (f->tsg_ch_bitmaps == NULL) {
+		nvgpu_err(g, "no mem for tsg channel bitmaps");
+		err = -ENOMEM;
+		goto clean_up_tsg;
+	}
+
 	for (tsgid = 0; tsgid < f->num_channels; tsgid++) {
 		nvgpu_tsg_init_support(g, tsgid);
 	}
 
 	return 0;
 
+clean_up_tsg:
+	nvgpu_vfree(g, f->tsg);
+	f->tsg = NULL;
 clean_up_mutex:
 	nvgpu_mutex_destroy(&f->tsg_inuse_mutex);
 	return err;
@@ -22,7 +22,8 @@
 
 #include <nvgpu/gk20a.h>
 #include <nvgpu/nvgpu_init.h>
-#include <nvgpu/list.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/barrier.h>
 #include <nvgpu/log.h>
 #include <nvgpu/log2.h>
 #include <nvgpu/mm.h>
@@ -37,17 +38,37 @@
 
 static void nvgpu_gr_fecs_trace_periodic_polling(void *arg);
 
+static u32 nvgpu_gr_fecs_trace_context_hash(u32 context_ptr)
+{
+	/* multiplicative hash, context_ptr is an inst block pointer >> 12 */
+	u64 key = nvgpu_safe_mult_u64((u64)context_ptr, 0x9e3779b1ULL);
+
+	return u64_lo32(key) >> (32U - NVGPU_FECS_TRACE_CONTEXT_HASH_BITS);
+}
+
+/*
+ * Wait for lookups that may still see unlinked entries. All lookups run
+ * under poll_lock, so once it has been taken and dropped the entries can be
+ * freed.
+ */
+static void nvgpu_gr_fecs_trace_context_sync(struct nvgpu_gr_fecs_trace *trace)
+{
+	nvgpu_mutex_acquire(&trace->poll_lock);
+	nvgpu_mutex_release(&trace->poll_lock);
+}
+
 int nvgpu_gr_fecs_trace_add_context(struct gk20a *g, u32 context_ptr,
-	pid_t pid, u32 vmid, struct nvgpu_list_node *list)
+	pid_t pid, u32 vmid)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
 	struct nvgpu_fecs_trace_context_entry *entry;
+	u32 bucket = nvgpu_gr_fecs_trace_context_hash(context_ptr);
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
 		"adding hash entry context_ptr=%x -> pid=%d, vmid=%d",
 		context_ptr, pid, vmid);
 
-	entry = nvgpu_kzalloc(g, sizeof(*entry));
+	entry = nvgpu_kmem_cache_alloc(trace->context_cache);
 	if (entry == NULL) {
 		nvgpu_err(g,
 			"can't alloc new entry for context_ptr=%x pid=%d vmid=%d",
@@ -55,77 +76,98 @@ int nvgpu_gr_fecs_trace_add_context(struct gk20a *g, u32 context_ptr,
 		return -ENOMEM;
 	}
 
-	nvgpu_init_list_node(&entry->entry);
 	entry->context_ptr = context_ptr;
 	entry->pid = pid;
 	entry->vmid = vmid;
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_add_tail(&entry->entry, list);
-	nvgpu_mutex_release(&trace->list_lock);
+	nvgpu_mutex_acquire(&trace->hash_lock);
+	entry->hash_next = trace->context_hash[bucket];
+	/* publish the entry only once it is fully written */
+	nvgpu_smp_wmb();
+	NV_WRITE_ONCE(trace->context_hash[bucket], entry);
+	nvgpu_mutex_release(&trace->hash_lock);
 
 	return 0;
 }
 
-void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list)
+void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
-	struct nvgpu_fecs_trace_context_entry *entry, *tmp;
+	struct nvgpu_fecs_trace_context_entry **link;
+	struct nvgpu_fecs_trace_context_entry *entry = NULL;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
 		"freeing entry context_ptr=%x", context_ptr);
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_for_each_entry_safe(entry, tmp, list,
-			nvgpu_fecs_trace_context_entry,	entry) {
-		if (entry->context_ptr == context_ptr) {
-			nvgpu_list_del(&entry->entry);
-			nvgpu_log(g, gpu_dbg_ctxsw,
-				"freed entry=%p context_ptr=%x", entry,
-				entry->context_ptr);
-			nvgpu_kfree(g, entry);
+	nvgpu_mutex_acquire(&trace->hash_lock);
+	link = &trace->context_hash[
+			nvgpu_gr_fecs_trace_context_hash(context_ptr)];
+	while (*link != NULL) {
+		if ((*link)->context_ptr == context_ptr) {
+			entry = *link;
+			NV_WRITE_ONCE(*link, entry->hash_next);
 			break;
 		}
+		link = &(*link)->hash_next;
 	}
-	nvgpu_mutex_release(&trace->list_lock);
+	nvgpu_mutex_release(&trace->hash_lock);
+
+	if (entry == NULL) {
+		return;
+	}
+
+	nvgpu_gr_fecs_trace_context_sync(trace);
+	nvgpu_log(g, gpu_dbg_ctxsw,
+		"freed entry=%p context_ptr=%x", entry, entry->context_ptr);
+	nvgpu_kmem_cache_free(trace->context_cache, entry);
 }
 
-void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g,
-	struct nvgpu_list_node *list)
+void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
-	struct nvgpu_fecs_trace_context_entry *entry, *tmp;
+	struct nvgpu_fecs_trace_context_entry *heads[
+			NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE];
+	struct nvgpu_fecs_trace_context_entry *entry, *next;
+	u32 i;
+
+	nvgpu_mutex_acquire(&trace->hash_lock);
+	for (i = 0U; i < NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE; i++) {
+		heads[i] = trace->context_hash[i];
+		NV_WRITE_ONCE(trace->context_hash[i], NULL);
+	}
+	nvgpu_mutex_release(&trace->hash_lock);
+
+	nvgpu_gr_fecs_trace_context_sync(trace);
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_for_each_entry_safe(entry, tmp, list,
-			nvgpu_fecs_trace_context_entry,	entry) {
-		nvgpu_list_del(&entry->entry);
-		nvgpu_kfree(g, entry);
+	for (i = 0U; i < NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE; i++) {
+		for (entry = heads[i]; entry != NULL; entry = next) {
+			next = entry->hash_next;
+			nvgpu_kmem_cache_free(trace->context_cache, entry);
+		}
 	}
-	nvgpu_mutex_release(&trace->list_lock);
 }
 
 void nvgpu_gr_fecs_trace_find_pid(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list, pid_t *pid, u32 *vmid)
+	pid_t *pid, u32 *vmid)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
 	struct nvgpu_fecs_trace_context_entry *entry;
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_for_each_entry(entry, list, nvgpu_fecs_trace_context_entry,
-			entry) {
+	entry = NV_READ_ONCE(trace->context_hash[
+			nvgpu_gr_fecs_trace_context_hash(context_ptr)]);
+	while (entry != NULL) {
+		/* pairs with the barrier in nvgpu_gr_fecs_trace_add_context */
+		nvgpu_smp_rmb();
 		if (entry->context_ptr == context_ptr) {
 			nvgpu_log(g, gpu_dbg_ctxsw,
 				"found context_ptr=%x -> pid=%d, vmid=%d",
 				entry->context_ptr, entry->pid, entry->vmid);
 			*pid = entry->pid;
 			*vmid = entry->vmid;
-			nvgpu_mutex_release(&trace->list_lock);
 			return;
 		}
+		entry = NV_READ_ONCE(entry->hash_next);
 	}
-	nvgpu_mutex_release(&trace->list_lock);
 
 	*pid = 0;
 	*vmid = 0xffffffffU;
@@ -148,14 +190,28 @@ int nvgpu_gr_fecs_trace_init(struct gk20a *g)
 		nvgpu_set_enabled(g, NVGPU_SUPPORT_FECS_CTXSW_TRACE, false);
 		return -ENOMEM;
 	}
+
+	trace->context_cache = nvgpu_kmem_cache_create(g,
+			sizeof(struct nvgpu_fecs_trace_context_entry));
+	trace->batch = nvgpu_kzalloc(g, nvgpu_safe_mult_u64(
+			sizeof(*trace->batch),
+			2ULL * (u64)GK20A_FECS_TRACE_NUM_RECORDS));
+	if ((trace->context_cache == NULL) || (trace->batch == NULL)) {
+		nvgpu_err(g, "failed to allocate fecs_trace context tables");
+		if (trace->context_cache != NULL) {
+			nvgpu_kmem_cache_destroy(trace->context_cache);
+		}
+		nvgpu_kfree(g, trace->batch);
+		nvgpu_kfree(g, trace);
+		nvgpu_set_enabled(g, NVGPU_SUPPORT_FECS_CTXSW_TRACE, false);
+		return -ENOMEM;
+	}
 	g->fecs_trace = trace;
 
 	nvgpu_mutex_init(&trace->poll_lock);
-	nvgpu_mutex_init(&trace->list_lock);
+	nvgpu_mutex_init(&trace->hash_lock);
 	nvgpu_mutex_init(&trace->enable_lock);
 
-	nvgpu_init_list_node(&trace->context_list);
-
 	trace->enable_count = 0;
 
 	err = nvgpu_periodic_timer_init(&trace->poll_timer,
@@ -184,9 +240,11 @@ int nvgpu_gr_fecs_trace_deinit(struct gk20a *g)
 	}
 	nvgpu_periodic_timer_destroy(&trace->poll_timer);
 
-	nvgpu_gr_fecs_trace_remove_contexts(g, &trace->context_list);
+	nvgpu_gr_fecs_trace_remove_contexts(g);
+	nvgpu_kmem_cache_destroy(trace->context_cache);
+	nvgpu_kfree(g, trace->batch);
 
-	nvgpu_mutex_destroy(&g->fecs_trace->list_lock);
+	nvgpu_mutex_destroy(&g->fecs_trace->hash_lock);
 	nvgpu_mutex_destroy(&g->fecs_trace->poll_lock);
 	nvgpu_mutex_destroy(&g->fecs_trace->enable_lock);
 
@@ -363,65 +421,94 @@ void nvgpu_gr_fecs_trace_reset_buffer(struct gk20a *g)
 		g->ops.gr.fecs_trace.get_write_index(g));
 }
 
+static void nvgpu_gr_fecs_trace_resolve_pid(struct gk20a *g,
+	u32 context_ptr, bool valid, struct nvgpu_fecs_trace_pid *last,
+	u32 *last_ptr, struct nvgpu_fecs_trace_pid *out)
+{
+	if (!valid) {
+		out->pid = 0;
+		out->vmid = 0xffffffffU;
+		return;
+	}
+
+	/*
+	 * Back to back records mostly switch from the context the previous
+	 * record switched to, so remember the last lookup.
+	 */
+	if (*last_ptr != context_ptr) {
+		nvgpu_gr_fecs_trace_find_pid(g, context_ptr,
+			&last->pid, &last->vmid);
+		*last_ptr = context_ptr;
+	}
+	*out = *last;
+}
+
 /*
- * Converts HW entry format to userspace-facing format and pushes it to the
- * queue.
+ * Validates up to cnt records from index on and resolves the pids of their
+ * current and new contexts into trace->batch. Returns the number of leading
+ * valid records.
  */
-int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
-	u32 *vm_update_mask)
+static int nvgpu_gr_fecs_trace_resolve_batch(struct gk20a *g, int index,
+	int cnt)
 {
-	int i;
-	struct nvgpu_gpu_ctxsw_trace_entry entry = { };
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
-	pid_t cur_pid = 0, new_pid = 0;
-	u32 cur_vmid = 0U, new_vmid = 0U;
-	u32 vmid = 0U;
-	int count = 0;
+	struct nvgpu_fecs_trace_pid last = { };
+	u32 last_ptr = 0U;
+	int read = index;
+	int n;
 
-	struct nvgpu_fecs_trace_record *r =
-		nvgpu_gr_fecs_trace_get_record(g, index);
-	if (r == NULL) {
-		return -EINVAL;
-	}
+	for (n = 0; n < cnt; n++) {
+		struct nvgpu_fecs_trace_record *r =
+			nvgpu_gr_fecs_trace_get_record(g, read);
 
-	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
-		"consuming record trace=%p read=%d record=%p", trace, index, r);
+		if (r == NULL) {
+			break;
+		}
 
-	if (!nvgpu_gr_fecs_trace_is_valid_record(g, r)) {
-		nvgpu_warn(g,
-			"trace=%p read=%d record=%p magic_lo=%08x magic_hi=%08x (invalid)",
-			trace, index, r, r->magic_lo, r->magic_hi);
-		return -EINVAL;
+		if (!nvgpu_gr_fecs_trace_is_valid_record(g, r)) {
+			nvgpu_warn(g,
+				"trace=%p read=%d record=%p magic_lo=%08x magic_hi=%08x (invalid)",
+				trace, read, r, r->magic_lo, r->magic_hi);
+			break;
+		}
+
+		nvgpu_gr_fecs_trace_resolve_pid(g, r->context_ptr,
+			(r->context_ptr != 0U) && (r->context_id != 0U),
+			&last, &last_ptr, &trace->batch[2 * n]);
+		nvgpu_gr_fecs_trace_resolve_pid(g, r->new_context_ptr,
+			r->new_context_ptr != 0U,
+			&last, &last_ptr, &trace->batch[(2 * n) + 1]);
+
+		read = (read + 1) & (GK20A_FECS_TRACE_NUM_RECORDS - 1);
 	}
 
+	return n;
+}
+
+/*
+ * Converts a validated HW entry to userspace-facing format and pushes it to
+ * the queue.
+ */
+static int nvgpu_gr_fecs_trace_decode_record(struct gk20a *g,
+	struct nvgpu_fecs_trace_record *r, const struct nvgpu_fecs_trace_pid *cur,
+	const struct nvgpu_fecs_trace_pid *new_ctx, u32 *vm_update_mask)
+{
+	int i;
+	struct nvgpu_gpu_ctxsw_trace_entry entry = { };
+	int count = 0;
+
 	/* Clear magic_hi to detect cases where CPU could read write index
 	 * before FECS record is actually written to DRAM. This should not
 	 * as we force FECS writes to SYSMEM by reading through PRAMIN.
 	 */
 	r->magic_hi = 0;
 
-	if ((r->context_ptr != 0U) && (r->context_id != 0U)) {
-		nvgpu_gr_fecs_trace_find_pid(g, r->context_ptr,
-			&trace->context_list, &cur_pid, &cur_vmid);
-	} else {
-		cur_vmid = 0xffffffffU;
-		cur_pid = 0;
-	}
-
-	if (r->new_context_ptr != 0U) {
-		nvgpu_gr_fecs_trace_find_pid(g, r->new_context_ptr,
-			&trace->context_list, &new_pid, &new_vmid);
-	} else {
-		new_vmid = 0xffffffffU;
-		new_pid = 0;
-	}
-
 	nvgpu_log(g, gpu_dbg_ctxsw,
 		"context_ptr=%x (vmid=%u pid=%d)",
-		r->context_ptr, cur_vmid, cur_pid);
+		r->context_ptr, cur->vmid, cur->pid);
 	nvgpu_log(g, gpu_dbg_ctxsw,
 		"new_context_ptr=%x (vmid=%u pid=%d)",
-		r->new_context_ptr, new_vmid, new_pid);
+		r->new_context_ptr, new_ctx->vmid, new_ctx->pid);
 
 	entry.context_id = r->context_id;
 
@@ -442,8 +529,8 @@ int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
 		case NVGPU_GPU_CTXSW_TAG_RESTORE_START:
 		case NVGPU_GPU_CTXSW_TAG_CONTEXT_START:
 			entry.context_id = r->new_context_id;
-			entry.pid = (u64)new_pid;
-			entry.vmid = (u8)new_vmid;
+			entry.pid = (u64)new_ctx->pid;
+			entry.vmid = (u8)new_ctx->vmid;
 			break;
 
 		case NVGPU_GPU_CTXSW_TAG_CTXSW_REQ_BY_HOST:
@@ -454,8 +541,8 @@ int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
 		case NVGPU_GPU_CTXSW_TAG_FE_ACK_CILP:
 		case NVGPU_GPU_CTXSW_TAG_SAVE_END:
 			entry.context_id = r->context_id;
-			entry.pid = (u64)cur_pid;
-			entry.vmid = (u8)cur_vmid;
+			entry.pid = (u64)cur->pid;
+			entry.vmid = (u8)cur->vmid;
 			break;
 
 		default:
@@ -482,6 +569,36 @@ int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
 		count++;
 	}
 
+	return count;
+}
+
+/*
+ * Converts HW entry format to userspace-facing format and pushes it to the
+ * queue. Must be called with poll_lock held.
+ */
+int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
+	u32 *vm_update_mask)
+{
+	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
+	struct nvgpu_fecs_trace_record *r;
+	u32 vmid = 0U;
+	int count;
+
+	r = nvgpu_gr_fecs_trace_get_record(g, index);
+	if (r == NULL) {
+		return -EINVAL;
+	}
+
+	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
+		"consuming record trace=%p read=%d record=%p", trace, index, r);
+
+	if (nvgpu_gr_fecs_trace_resolve_batch(g, index, 1) != 1) {
+		return -EINVAL;
+	}
+
+	count = nvgpu_gr_fecs_trace_decode_record(g, r, &trace->batch[0],
+			&trace->batch[1], vm_update_mask);
+
 	nvgpu_gr_fecs_trace_wake_up(g, (int)vmid);
 	return count;
 }
@@ -493,6 +610,9 @@ int nvgpu_gr_fecs_trace_poll(struct gk20a *g)
 	int read = 0;
 	int write = 0;
 	int cnt;
+	int valid;
+	int i;
+	bool decoded = false;
 	int err = 0;
 
 	nvgpu_mutex_acquire(&trace->poll_lock);
@@ -535,16 +655,32 @@ int nvgpu_gr_fecs_trace_poll(struct gk20a *g)
 		read = ((u32)read) & (~(BIT32(NVGPU_FECS_TRACE_FEATURE_CONTROL_BIT)));
 	}
 
-	while (read != write) {
-		cnt = nvgpu_gr_fecs_trace_ring_read(g, read, &vm_update_mask);
+	/*
+	 * Resolve the pids of all pending records in one pass, then decode
+	 * them and wake up readers once for the whole batch.
+	 */
+	valid = nvgpu_gr_fecs_trace_resolve_batch(g, read, cnt);
+	for (i = 0; i < valid; i++) {
+		nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
+			"consuming record trace=%p read=%d", trace, read);
+
+		cnt = nvgpu_gr_fecs_trace_decode_record(g,
+			nvgpu_gr_fecs_trace_get_record(g, read),
+			&trace->batch[2 * i], &trace->batch[(2 * i) + 1],
+			&vm_update_mask);
 		if (cnt <= 0) {
 			break;
 		}
+		decoded = true;
 
 		/* Get to next record. */
 		read = (read + 1) & (GK20A_FECS_TRACE_NUM_RECORDS - 1);
 	}
 
+	if (decoded) {
+		nvgpu_gr_fecs_trace_wake_up(g, 0);
+	}
+
 	if (nvgpu_is_enabled(g, NVGPU_FECS_TRACE_FEATURE_CONTROL)) {
 		/*
 		 * In the next step, read pointer is going to be updated.
@@ -664,8 +800,7 @@ int nvgpu_gr_fecs_trace_bind_channel(struct gk20a *g,
 
 	g->ops.gr.ctxsw_prog.set_ts_buffer_ptr(g, mem, addr, aperture_mask);
 
-	ret = nvgpu_gr_fecs_trace_add_context(g, context_ptr, pid, vmid,
-		&trace->context_list);
+	ret = nvgpu_gr_fecs_trace_add_context(g, context_ptr, pid, vmid);
 
 	return ret;
 }
@@ -692,8 +827,7 @@ int nvgpu_gr_fecs_trace_unbind_channel(struct gk20a *g,
 		nvgpu_gr_fecs_trace_poll(g);
 	}
 
-	nvgpu_gr_fecs_trace_remove_context(g, context_ptr,
-		&trace->context_list);
+	nvgpu_gr_fecs_trace_remove_context(g, context_ptr);
 
 	return 0;
 }
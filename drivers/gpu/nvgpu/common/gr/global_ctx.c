@@ -470,10 +470,8 @@ void nvgpu_gr_global_ctx_deinit_local_golden_image(struct gk20a *g,
 	nvgpu_kfree(g, local_golden_image);
 }
 
-#ifdef CONFIG_NVGPU_DEBUGGER
 u32 *nvgpu_gr_global_ctx_get_local_golden_image_ptr(
 	struct nvgpu_gr_global_ctx_local_golden_image *local_golden_image)
 {
 	return local_golden_image->context;
 }
-#endif
@@ -334,6 +334,8 @@ static void gr_remove_support(struct gk20a *g)
 	#ifdef CONFIG_NVGPU_DEBUGGER
 		nvgpu_gr_hwpm_map_deinit(g, gr->hwpm_map);
 		gr->hwpm_map = NULL;
+		nvgpu_gr_ctx_offset_map_deinit(g, gr->ctx_offset_map);
+		gr->ctx_offset_map = NULL;
 	#endif
 
 		nvgpu_gr_obj_ctx_deinit(g, gr->golden_image);
@@ -508,6 +510,12 @@ static int gr_init_setup_sw(struct gk20a *g, struct nvgpu_gr *gr)
 		nvgpu_err(g, "hwpm_map init failed");
 		goto clean_up;
 	}
+
+	err = nvgpu_gr_ctx_offset_map_init(g, &gr->ctx_offset_map);
+	if (err != 0) {
+		nvgpu_err(g, "ctx_offset_map init failed");
+		goto clean_up;
+	}
 #endif
 
 	err = gr_init_ctx_bufs(g, gr);
@@ -36,6 +36,7 @@ struct nvgpu_gr_zcull;
 #endif
 #ifdef CONFIG_NVGPU_DEBUGGER
 struct nvgpu_gr_hwpm_map;
+struct nvgpu_gr_ctx_offset_map;
 #endif
 
 /**
@@ -117,6 +118,10 @@ struct nvgpu_gr {
 
 #ifdef CONFIG_NVGPU_DEBUGGER
 	struct nvgpu_gr_hwpm_map *hwpm_map;
+	/**
+	 * Cache of gr context buffer offsets resolved for ctx regops.
+	 */
+	struct nvgpu_gr_ctx_offset_map *ctx_offset_map;
 #endif
 
 #ifdef CONFIG_NVGPU_GRAPHICS
@@ -26,6 +26,7 @@
 #include <nvgpu/sort.h>
 #include <nvgpu/kmem.h>
 #include <nvgpu/bsearch.h>
+#include <nvgpu/string.h>
 #include <nvgpu/fbp.h>
 #include <nvgpu/gr/config.h>
 #include <nvgpu/gr/hwpm_map.h>
@@ -614,3 +615,197 @@ int nvgpu_gr_hwmp_map_find_priv_offset(struct gk20a *g,
 
 	return err;
 }
+
+int nvgpu_gr_ctx_offset_map_init(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map **ctx_offset_map)
+{
+	struct nvgpu_gr_ctx_offset_map *tmp_map;
+
+	tmp_map = nvgpu_kzalloc(g, sizeof(*tmp_map));
+	if (tmp_map == NULL) {
+		return -ENOMEM;
+	}
+
+	nvgpu_mutex_init(&tmp_map->lock);
+
+	*ctx_offset_map = tmp_map;
+
+	return 0;
+}
+
+void nvgpu_gr_ctx_offset_map_deinit(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map *ctx_offset_map)
+{
+	u32 i;
+
+	if (ctx_offset_map == NULL) {
+		return;
+	}
+
+	for (i = 0U; i < ctx_offset_map->count; i++) {
+		nvgpu_kfree(g, ctx_offset_map->map[i].offsets);
+	}
+	if (ctx_offset_map->map != NULL) {
+		nvgpu_big_free(g, ctx_offset_map->map);
+	}
+
+	nvgpu_mutex_destroy(&ctx_offset_map->lock);
+	nvgpu_kfree(g, ctx_offset_map);
+}
+
+static int ctx_offset_map_cmp(const void *a, const void *b)
+{
+	const struct nvgpu_gr_ctx_offset_map_entry *e1;
+	const struct nvgpu_gr_ctx_offset_map_entry *e2;
+
+	e1 = (const struct nvgpu_gr_ctx_offset_map_entry *)a;
+	e2 = (const struct nvgpu_gr_ctx_offset_map_entry *)b;
+
+	if (e1->addr < e2->addr) {
+		return -1;
+	}
+
+	if (e1->addr > e2->addr) {
+		return 1;
+	}
+	return 0;
+}
+
+int nvgpu_gr_ctx_offset_map_find(struct nvgpu_gr_ctx_offset_map *ctx_offset_map,
+	u32 addr, u32 max_offsets, u32 *offsets, u32 *offset_addrs,
+	u32 *num_offsets)
+{
+	struct nvgpu_gr_ctx_offset_map_entry *result, map_key;
+	u32 num;
+	int err = 0;
+
+	map_key.addr = addr;
+
+	nvgpu_mutex_acquire(&ctx_offset_map->lock);
+
+	result = nvgpu_bsearch(&map_key, ctx_offset_map->map,
+			ctx_offset_map->count, sizeof(*ctx_offset_map->map),
+			ctx_offset_map_cmp);
+	if (result == NULL) {
+		err = -ENOENT;
+		goto done;
+	}
+
+	num = result->num_registers;
+	if ((max_offsets > 1U) && (num > max_offsets)) {
+		err = -EINVAL;
+		goto done;
+	}
+
+	if ((max_offsets == 1U) && (num > 1U)) {
+		num = 1U;
+	}
+
+	if (result->num_found < num) {
+		err = result->err;
+		goto done;
+	}
+
+	if (num > 0U) {
+		nvgpu_memcpy((u8 *)offsets, (const u8 *)result->offsets,
+			sizeof(u32) * num);
+		nvgpu_memcpy((u8 *)offset_addrs,
+			(const u8 *)&result->offsets[result->num_found],
+			sizeof(u32) * num);
+	}
+	*num_offsets = num;
+
+done:
+	nvgpu_mutex_release(&ctx_offset_map->lock);
+	return err;
+}
+
+static int ctx_offset_map_grow(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map *ctx_offset_map)
+{
+	struct nvgpu_gr_ctx_offset_map_entry *map;
+	u32 capacity = max(64U, nvgpu_safe_mult_u32(ctx_offset_map->capacity,
+				2U));
+
+	map = nvgpu_big_zalloc(g, sizeof(*map) * capacity);
+	if (map == NULL) {
+		return -ENOMEM;
+	}
+
+	if (ctx_offset_map->map != NULL) {
+		nvgpu_memcpy((u8 *)map, (const u8 *)ctx_offset_map->map,
+			sizeof(*map) * ctx_offset_map->count);
+		nvgpu_big_free(g, ctx_offset_map->map);
+	}
+
+	ctx_offset_map->map = map;
+	ctx_offset_map->capacity = capacity;
+
+	return 0;
+}
+
+void nvgpu_gr_ctx_offset_map_add(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map *ctx_offset_map,
+	u32 addr, int err, u32 num_registers, u32 num_found,
+	const u32 *offsets, const u32 *offset_addrs)
+{
+	struct nvgpu_gr_ctx_offset_map_entry *entry;
+	u32 *entry_offsets = NULL;
+	u32 i, j;
+
+	if (num_found > 0U) {
+		entry_offsets = nvgpu_kzalloc(g,
+				sizeof(u32) * 2U * (size_t)num_found);
+		if (entry_offsets == NULL) {
+			return;
+		}
+		nvgpu_memcpy((u8 *)entry_offsets, (const u8 *)offsets,
+			sizeof(u32) * num_found);
+		nvgpu_memcpy((u8 *)&entry_offsets[num_found],
+			(const u8 *)offset_addrs, sizeof(u32) * num_found);
+	}
+
+	nvgpu_mutex_acquire(&ctx_offset_map->lock);
+
+	if (ctx_offset_map->count >= NVGPU_GR_CTX_OFFSET_MAP_MAX_ENTRIES) {
+		goto fail;
+	}
+
+	/* find the insertion point, bail out if another lookup raced us */
+	for (i = ctx_offset_map->count; i > 0U; i--) {
+		if (ctx_offset_map->map[i - 1U].addr == addr) {
+			goto fail;
+		}
+		if (ctx_offset_map->map[i - 1U].addr < addr) {
+			break;
+		}
+	}
+
+	if ((ctx_offset_map->count == ctx_offset_map->capacity) &&
+	    (ctx_offset_map_grow(g, ctx_offset_map) != 0)) {
+		goto fail;
+	}
+
+	for (j = ctx_offset_map->count; j > i; j--) {
+		ctx_offset_map->map[j] = ctx_offset_map->map[j - 1U];
+	}
+
+	entry = &ctx_offset_map->map[i];
+	entry->addr = addr;
+	entry->err = err;
+	entry->num_registers = num_registers;
+	entry->num_found = num_found;
+	entry->offsets = entry_offsets;
+	ctx_offset_map->count = nvgpu_safe_add_u32(ctx_offset_map->count, 1U);
+
+	nvgpu_mutex_release(&ctx_offset_map->lock);
+
+	nvgpu_log(g, gpu_dbg_gpu_dbg,
+		"cached addr=0x%x num_registers=%u num_found=%u err=%d",
+		addr, num_registers, num_found, err);
+	return;
+
+fail:
+	nvgpu_mutex_release(&ctx_offset_map->lock);
+	nvgpu_kfree(g, entry_offsets);
+}
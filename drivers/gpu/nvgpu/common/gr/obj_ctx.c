@@ -39,6 +39,7 @@
 #include <nvgpu/gr/fs_state.h>
 #include <nvgpu/power_features/cg.h>
 #include <nvgpu/static_analysis.h>
+#include <nvgpu/boot_cache.h>
 
 #include "obj_ctx_priv.h"
 
@@ -703,6 +704,86 @@ clean_up:
 	return err;
 }
 
+/*
+ * Describe the floorsweeping config a golden image is valid for. Returns
+ * false if the config cannot be described, in which case the boot cache is
+ * not used.
+ */
+static bool nvgpu_gr_obj_ctx_boot_cache_key(struct gk20a *g,
+	struct nvgpu_gr_config *config, struct nvgpu_boot_cache_gr_key *key)
+{
+	u32 gpc;
+
+	(void)memset(key, 0, sizeof(*key));
+
+	if (nvgpu_is_enabled(g, NVGPU_SUPPORT_MIG)) {
+		return false;
+	}
+
+	key->gpc_count = nvgpu_gr_config_get_gpc_count(config);
+	key->tpc_count = nvgpu_gr_config_get_tpc_count(config);
+	if (key->gpc_count > NVGPU_BOOT_CACHE_MAX_GPCS) {
+		return false;
+	}
+
+	for (gpc = 0U; gpc < key->gpc_count; gpc++) {
+		key->gpc_tpc_mask[gpc] =
+			nvgpu_gr_config_get_gpc_tpc_mask(config, gpc);
+	}
+
+	return true;
+}
+
+/*
+ * Take the golden image from the boot cache. The image already holds the
+ * context state set up by sw_ctx_load, the bundles and method init, so
+ * only the non context state programmed along with them is set up here.
+ */
+static int nvgpu_gr_obj_ctx_load_cached_golden(struct gk20a *g,
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image,
+	struct nvgpu_gr_config *config,
+	const struct nvgpu_boot_cache_gr_key *key)
+{
+	u64 size = nvgpu_gr_obj_ctx_get_golden_image_size(golden_image);
+	int err;
+
+	err = nvgpu_boot_cache_get_golden(g, key, &golden_image->gfx_regs,
+			(u32)sizeof(golden_image->gfx_regs),
+			nvgpu_gr_global_ctx_get_local_golden_image_ptr(
+				golden_image->local_golden_image), size);
+	if (err != 0) {
+		return err;
+	}
+
+	g->ops.gr.intr.set_hww_esr_report_mask(g);
+
+#ifdef CONFIG_NVGPU_GFXP
+	if (g->ops.gr.init.preemption_state != NULL) {
+		err = g->ops.gr.init.preemption_state(g);
+		if (err != 0) {
+			return err;
+		}
+	}
+#endif
+
+	nvgpu_cg_blcg_gr_load_enable(g);
+
+	err = nvgpu_gr_fs_state_init(g, config);
+	if (err != 0) {
+		return err;
+	}
+
+#ifdef CONFIG_NVGPU_GR_GOLDEN_CTX_VERIFICATION
+	nvgpu_gr_global_ctx_deinit_local_golden_image(g,
+			golden_image->local_golden_image_copy);
+	golden_image->local_golden_image_copy = NULL;
+#endif
+
+	nvgpu_log(g, gpu_dbg_gr, "golden image loaded from boot cache");
+
+	return 0;
+}
+
 /*
  * init global golden image from a fresh gr_ctx in channel ctx.
  * save a copy in local_golden_image.
@@ -714,6 +795,8 @@ int nvgpu_gr_obj_ctx_alloc_golden_ctx_image(struct gk20a *g,
 	struct nvgpu_gr_ctx *gr_ctx,
 	struct nvgpu_mem *inst_block)
 {
+	struct nvgpu_boot_cache_gr_key key;
+	bool cacheable;
 	int err = 0;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_gr, " ");
@@ -730,6 +813,12 @@ int nvgpu_gr_obj_ctx_alloc_golden_ctx_image(struct gk20a *g,
 		goto clean_up;
 	}
 
+	cacheable = nvgpu_gr_obj_ctx_boot_cache_key(g, config, &key);
+	if (cacheable && (nvgpu_gr_obj_ctx_load_cached_golden(g,
+				golden_image, config, &key) == 0)) {
+		goto ready;
+	}
+
 	err = nvgpu_gr_obj_ctx_init_hw_state(g, inst_block);
 	if (err != 0) {
 		goto clean_up;
@@ -766,6 +855,15 @@ int nvgpu_gr_obj_ctx_alloc_golden_ctx_image(struct gk20a *g,
 		g->ops.gr.init.capture_gfx_regs(g, &golden_image->gfx_regs);
 	}
 
+	if (cacheable) {
+		nvgpu_boot_cache_set_golden(g, &key, &golden_image->gfx_regs,
+			(u32)sizeof(golden_image->gfx_regs),
+			nvgpu_gr_global_ctx_get_local_golden_image_ptr(
+				golden_image->local_golden_image),
+			nvgpu_gr_obj_ctx_get_golden_image_size(golden_image));
+	}
+
+ready:
 	golden_image->ready = true;
 #ifdef CONFIG_NVGPU_POWER_PG
 	nvgpu_pmu_set_golden_image_initialized(g, GOLDEN_IMG_READY);
@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/log.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/string.h>
+#include <nvgpu/static_analysis.h>
+#include <nvgpu/boot_cache.h>
+
+#define NVGPU_BOOT_CACHE_HAS_NETLIST	BIT32(0)
+#define NVGPU_BOOT_CACHE_HAS_GOLDEN	BIT32(1)
+
+/* Sections are 8 byte aligned within the blob. */
+#define NVGPU_BOOT_CACHE_ALIGN		8U
+
+#define FNV1A_32_INIT			0x811c9dc5U
+#define FNV1A_32_PRIME			0x01000193U
+
+/*
+ * Layout of a blob: this header followed by the netlist image, the graphics
+ * register init values and the golden context image at the given offsets.
+ */
+struct nvgpu_boot_cache_hdr {
+	u32 magic;
+	u32 version;
+	u32 size;
+	/* FNV-1a of the whole blob with this field set to 0. */
+	u32 checksum;
+
+	u32 gpu_arch;
+	u32 gpu_impl;
+	u32 gpu_rev;
+	u32 sections;
+
+	s32 netlist_net;
+	u32 netlist_offset;
+	u32 netlist_size;
+	/* FNV-1a of the netlist firmware file the image was read from. */
+	u32 netlist_hash;
+
+	struct nvgpu_boot_cache_gr_key gr_key;
+	u32 regs_offset;
+	u32 regs_size;
+	u32 golden_offset;
+	u32 golden_size;
+};
+
+struct nvgpu_boot_cache {
+	/* Protects everything below. */
+	struct nvgpu_mutex lock;
+
+	u8 *netlist;
+	u32 netlist_size;
+	int netlist_net;
+	u32 netlist_hash;
+
+	struct nvgpu_boot_cache_gr_key gr_key;
+	u8 *regs;
+	u32 regs_size;
+	u8 *golden;
+	u32 golden_size;
+};
+
+static u32 nvgpu_boot_cache_fnv1a(u32 hash, const u8 *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0U; i < size; i++) {
+		hash = (hash ^ (u32)data[i]) * FNV1A_32_PRIME;
+	}
+
+	return hash;
+}
+
+static u32 nvgpu_boot_cache_checksum(const u8 *blob, size_t size)
+{
+	struct nvgpu_boot_cache_hdr hdr;
+	u32 hash;
+
+	nvgpu_memcpy((u8 *)&hdr, blob, sizeof(hdr));
+	hdr.checksum = 0U;
+
+	hash = nvgpu_boot_cache_fnv1a(FNV1A_32_INIT, (const u8 *)&hdr,
+				      sizeof(hdr));
+	return nvgpu_boot_cache_fnv1a(hash, &blob[sizeof(hdr)],
+				      size - sizeof(hdr));
+}
+
+static u32 nvgpu_boot_cache_align(u32 size)
+{
+	return nvgpu_safe_add_u32(size, NVGPU_BOOT_CACHE_ALIGN - 1U) &
+		~(NVGPU_BOOT_CACHE_ALIGN - 1U);
+}
+
+static void nvgpu_boot_cache_free_netlist(struct gk20a *g,
+					  struct nvgpu_boot_cache *cache)
+{
+	nvgpu_vfree(g, cache->netlist);
+	cache->netlist = NULL;
+	cache->netlist_size = 0U;
+	cache->netlist_hash = 0U;
+}
+
+static void nvgpu_boot_cache_free_golden(struct gk20a *g,
+					 struct nvgpu_boot_cache *cache)
+{
+	nvgpu_kfree(g, cache->regs);
+	nvgpu_vfree(g, cache->golden);
+	cache->regs = NULL;
+	cache->regs_size = 0U;
+	cache->golden = NULL;
+	cache->golden_size = 0U;
+}
+
+/* Replace an entry of the cache with a copy of src. */
+static int nvgpu_boot_cache_copy(struct gk20a *g, u8 **dst, bool small,
+				 const u8 *src, u32 size)
+{
+	u8 *copy = small ? nvgpu_kzalloc(g, size) : nvgpu_vzalloc(g, size);
+
+	if (copy == NULL) {
+		return -ENOMEM;
+	}
+	nvgpu_memcpy(copy, src, size);
+
+	if (small) {
+		nvgpu_kfree(g, *dst);
+	} else {
+		nvgpu_vfree(g, *dst);
+	}
+	*dst = copy;
+
+	return 0;
+}
+
+int nvgpu_boot_cache_init(struct gk20a *g)
+{
+	struct nvgpu_boot_cache *cache;
+
+	if (g->boot_cache != NULL) {
+		return 0;
+	}
+
+	cache = nvgpu_kzalloc(g, sizeof(*cache));
+	if (cache == NULL) {
+		return -ENOMEM;
+	}
+
+	nvgpu_mutex_init(&cache->lock);
+	g->boot_cache = cache;
+
+	return 0;
+}
+
+void nvgpu_boot_cache_deinit(struct gk20a *g)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	nvgpu_boot_cache_free_netlist(g, cache);
+	nvgpu_boot_cache_free_golden(g, cache);
+	nvgpu_mutex_destroy(&cache->lock);
+	nvgpu_kfree(g, cache);
+	g->boot_cache = NULL;
+}
+
+static bool nvgpu_boot_cache_section_ok(const struct nvgpu_boot_cache_hdr *hdr,
+					u32 offset, u32 size)
+{
+	return (offset >= sizeof(*hdr)) && (offset <= hdr->size) &&
+		(size <= (hdr->size - offset));
+}
+
+static int nvgpu_boot_cache_check(struct gk20a *g, const u8 *blob,
+				  size_t size, struct nvgpu_boot_cache_hdr *hdr)
+{
+	if (size < sizeof(*hdr)) {
+		return -EINVAL;
+	}
+
+	nvgpu_memcpy((u8 *)hdr, blob, sizeof(*hdr));
+
+	if ((hdr->magic != NVGPU_BOOT_CACHE_MAGIC) ||
+	    (hdr->version != NVGPU_BOOT_CACHE_VERSION) ||
+	    (hdr->size != size)) {
+		nvgpu_warn(g, "boot cache: bad header");
+		return -EINVAL;
+	}
+
+	if (nvgpu_boot_cache_checksum(blob, size) != hdr->checksum) {
+		nvgpu_warn(g, "boot cache: checksum mismatch");
+		return -EINVAL;
+	}
+
+	if ((hdr->gpu_arch != g->params.gpu_arch) ||
+	    (hdr->gpu_impl != g->params.gpu_impl) ||
+	    (hdr->gpu_rev != g->params.gpu_rev)) {
+		nvgpu_info(g, "boot cache: saved on another chip");
+		return -ENODEV;
+	}
+
+	if (((hdr->sections & NVGPU_BOOT_CACHE_HAS_NETLIST) != 0U) &&
+	    !nvgpu_boot_cache_section_ok(hdr, hdr->netlist_offset,
+					 hdr->netlist_size)) {
+		return -EINVAL;
+	}
+
+	if (((hdr->sections & NVGPU_BOOT_CACHE_HAS_GOLDEN) != 0U) &&
+	    (!nvgpu_boot_cache_section_ok(hdr, hdr->regs_offset,
+					  hdr->regs_size) ||
+	     !nvgpu_boot_cache_section_ok(hdr, hdr->golden_offset,
+					  hdr->golden_size))) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int nvgpu_boot_cache_load(struct gk20a *g, const void *blob, size_t size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	struct nvgpu_boot_cache_hdr hdr;
+	const u8 *data = (const u8 *)blob;
+	int err;
+
+	if (cache == NULL) {
+		return -EINVAL;
+	}
+
+	err = nvgpu_boot_cache_check(g, data, size, &hdr);
+	if (err != 0) {
+		return err;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	if ((hdr.sections & NVGPU_BOOT_CACHE_HAS_NETLIST) != 0U) {
+		err = nvgpu_boot_cache_copy(g, &cache->netlist, false,
+				&data[hdr.netlist_offset], hdr.netlist_size);
+		if (err != 0) {
+			goto done;
+		}
+		cache->netlist_size = hdr.netlist_size;
+		cache->netlist_net = hdr.netlist_net;
+		cache->netlist_hash = hdr.netlist_hash;
+	}
+
+	if ((hdr.sections & NVGPU_BOOT_CACHE_HAS_GOLDEN) != 0U) {
+		err = nvgpu_boot_cache_copy(g, &cache->regs, true,
+				&data[hdr.regs_offset], hdr.regs_size);
+		if (err == 0) {
+			err = nvgpu_boot_cache_copy(g, &cache->golden, false,
+				&data[hdr.golden_offset], hdr.golden_size);
+		}
+		if (err != 0) {
+			nvgpu_boot_cache_free_netlist(g, cache);
+			nvgpu_boot_cache_free_golden(g, cache);
+			goto done;
+		}
+		cache->regs_size = hdr.regs_size;
+		cache->golden_size = hdr.golden_size;
+		cache->gr_key = hdr.gr_key;
+	}
+
+	nvgpu_log_info(g, "boot cache: netlist %u bytes, golden image %u bytes",
+		       cache->netlist_size, cache->golden_size);
+
+done:
+	nvgpu_mutex_release(&cache->lock);
+	return err;
+}
+
+/* Fill in the section offsets and return the blob size. */
+static u32 nvgpu_boot_cache_layout(struct nvgpu_boot_cache *cache,
+				   struct nvgpu_boot_cache_hdr *hdr)
+{
+	u32 size = nvgpu_boot_cache_align((u32)sizeof(*hdr));
+
+	(void)memset(hdr, 0, sizeof(*hdr));
+
+	if (cache->golden == NULL) {
+		return 0U;
+	}
+
+	if (cache->netlist != NULL) {
+		hdr->sections |= NVGPU_BOOT_CACHE_HAS_NETLIST;
+		hdr->netlist_net = cache->netlist_net;
+		hdr->netlist_offset = size;
+		hdr->netlist_size = cache->netlist_size;
+		hdr->netlist_hash = cache->netlist_hash;
+		size = nvgpu_boot_cache_align(
+			nvgpu_safe_add_u32(size, cache->netlist_size));
+	}
+
+	hdr->sections |= NVGPU_BOOT_CACHE_HAS_GOLDEN;
+	hdr->gr_key = cache->gr_key;
+	hdr->regs_offset = size;
+	hdr->regs_size = cache->regs_size;
+	size = nvgpu_boot_cache_align(nvgpu_safe_add_u32(size,
+							 cache->regs_size));
+	hdr->golden_offset = size;
+	hdr->golden_size = cache->golden_size;
+	size = nvgpu_safe_add_u32(size, cache->golden_size);
+
+	hdr->size = size;
+
+	return size;
+}
+
+size_t nvgpu_boot_cache_save_size(struct gk20a *g)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	struct nvgpu_boot_cache_hdr hdr;
+	u32 size;
+
+	if (cache == NULL) {
+		return 0U;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+	size = nvgpu_boot_cache_layout(cache, &hdr);
+	nvgpu_mutex_release(&cache->lock);
+
+	return size;
+}
+
+int nvgpu_boot_cache_save(struct gk20a *g, void *blob, size_t size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	struct nvgpu_boot_cache_hdr hdr;
+	u8 *data = (u8 *)blob;
+	int err = 0;
+
+	if (cache == NULL) {
+		return -EAGAIN;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	if (nvgpu_boot_cache_layout(cache, &hdr) == 0U) {
+		err = -EAGAIN;
+		goto done;
+	}
+	if (size < hdr.size) {
+		err = -ENOSPC;
+		goto done;
+	}
+
+	hdr.magic = NVGPU_BOOT_CACHE_MAGIC;
+	hdr.version = NVGPU_BOOT_CACHE_VERSION;
+	hdr.gpu_arch = g->params.gpu_arch;
+	hdr.gpu_impl = g->params.gpu_impl;
+	hdr.gpu_rev = g->params.gpu_rev;
+
+	(void)memset(data, 0, hdr.size);
+	if (cache->netlist != NULL) {
+		nvgpu_memcpy(&data[hdr.netlist_offset], cache->netlist,
+			     hdr.netlist_size);
+	}
+	nvgpu_memcpy(&data[hdr.regs_offset], cache->regs, hdr.regs_size);
+	nvgpu_memcpy(&data[hdr.golden_offset], cache->golden,
+		     hdr.golden_size);
+	nvgpu_memcpy(data, (u8 *)&hdr, sizeof(hdr));
+
+	hdr.checksum = nvgpu_boot_cache_checksum(data, hdr.size);
+	nvgpu_memcpy(data, (u8 *)&hdr, sizeof(hdr));
+
+done:
+	nvgpu_mutex_release(&cache->lock);
+	return err;
+}
+
+u8 *nvgpu_boot_cache_get_netlist(struct gk20a *g, int *net, u32 *size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	u8 *image = NULL;
+
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	/*
+	 * Hand out a copy: a concurrent load or set may replace the cached
+	 * image while the caller parses it.
+	 */
+	nvgpu_mutex_acquire(&cache->lock);
+	if (cache->netlist != NULL) {
+		image = nvgpu_vzalloc(g, cache->netlist_size);
+	}
+	if (image != NULL) {
+		nvgpu_memcpy(image, cache->netlist, cache->netlist_size);
+		*net = cache->netlist_net;
+		*size = cache->netlist_size;
+	}
+	nvgpu_mutex_release(&cache->lock);
+
+	return image;
+}
+
+bool nvgpu_boot_cache_check_netlist(struct gk20a *g, const u8 *fw, u32 size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	u32 hash = nvgpu_boot_cache_fnv1a(FNV1A_32_INIT, fw, size);
+	bool match;
+
+	if (cache == NULL) {
+		return false;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+	match = (cache->netlist != NULL) && (cache->netlist_size == size) &&
+		(cache->netlist_hash == hash);
+	if (!match) {
+		/* The golden image was built from the old netlist as well. */
+		nvgpu_boot_cache_free_netlist(g, cache);
+		nvgpu_boot_cache_free_golden(g, cache);
+	}
+	nvgpu_mutex_release(&cache->lock);
+
+	if (!match) {
+		nvgpu_info(g, "boot cache: netlist firmware changed");
+	}
+
+	return match;
+}
+
+void nvgpu_boot_cache_set_netlist(struct gk20a *g, int net,
+				  const u8 *image, u32 size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	u32 hash;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	hash = nvgpu_boot_cache_fnv1a(FNV1A_32_INIT, image, size);
+
+	nvgpu_mutex_acquire(&cache->lock);
+	if ((cache->netlist == NULL) || (cache->netlist_hash != hash)) {
+		/* A golden image from a blob may be of another netlist. */
+		nvgpu_boot_cache_free_golden(g, cache);
+	}
+	if (nvgpu_boot_cache_copy(g, &cache->netlist, false,
+				  image, size) == 0) {
+		cache->netlist_net = net;
+		cache->netlist_size = size;
+		cache->netlist_hash = hash;
+	} else {
+		nvgpu_warn(g, "boot cache: no memory for netlist");
+		nvgpu_boot_cache_free_netlist(g, cache);
+	}
+	nvgpu_mutex_release(&cache->lock);
+}
+
+int nvgpu_boot_cache_get_golden(struct gk20a *g,
+				const struct nvgpu_boot_cache_gr_key *key,
+				void *regs, u32 regs_size,
+				void *image, u64 size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	int err = -ENOENT;
+
+	if (cache == NULL) {
+		return -ENOENT;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+	if ((cache->golden != NULL) &&
+	    (cache->regs_size == regs_size) &&
+	    ((u64)cache->golden_size == size) &&
+	    (nvgpu_memcmp((const u8 *)&cache->gr_key, (const u8 *)key,
+			  sizeof(*key)) == 0)) {
+		nvgpu_memcpy((u8 *)regs, cache->regs, regs_size);
+		nvgpu_memcpy((u8 *)image, cache->golden, cache->golden_size);
+		err = 0;
+	}
+	nvgpu_mutex_release(&cache->lock);
+
+	if (err != 0) {
+		nvgpu_log_info(g, "boot cache: no golden image for this config");
+	}
+
+	return err;
+}
+
+void nvgpu_boot_cache_set_golden(struct gk20a *g,
+				 const struct nvgpu_boot_cache_gr_key *key,
+				 const void *regs, u32 regs_size,
+				 const void *image, u64 size)
+{
+	struct nvgpu_boot_cache *cache = g->boot_cache;
+	int err;
+
+	if ((cache == NULL) || (size > (u64)U32_MAX)) {
+		return;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+	err = nvgpu_boot_cache_copy(g, &cache->regs, true,
+				    (const u8 *)regs, regs_size);
+	if (err == 0) {
+		err = nvgpu_boot_cache_copy(g, &cache->golden, false,
+				(const u8 *)image, (u32)size);
+	}
+	if (err == 0) {
+		cache->gr_key = *key;
+		cache->regs_size = regs_size;
+		cache->golden_size = (u32)size;
+	} else {
+		nvgpu_warn(g, "boot cache: no memory for golden image");
+		nvgpu_boot_cache_free_golden(g, cache);
+	}
+	nvgpu_mutex_release(&cache->lock);
+}
@@ -59,6 +59,8 @@
 #include <nvgpu/cic_rm.h>
 #include <nvgpu/fbp.h>
 #include <nvgpu/nvs.h>
+#include <nvgpu/boot_cache.h>
+#include <nvgpu/regops.h>
 
 #ifdef CONFIG_NVGPU_LS_PMU
 #include <nvgpu/pmu/pmu_pstate.h>
@@ -586,6 +588,15 @@ static int nvgpu_init_set_debugger_mode(struct gk20a *g)
 	return 0;
 }
 
+#ifdef CONFIG_NVGPU_DEBUGGER
+static int nvgpu_init_regops_allowlist(struct gk20a *g)
+{
+	/* regops work without the compiled table, just slower */
+	nvgpu_regops_allowlist_init(g);
+	return 0;
+}
+#endif
+
 static int nvgpu_init_xve_set_speed(struct gk20a *g)
 {
 #ifdef CONFIG_NVGPU_DGPU
@@ -692,14 +703,6 @@ static int nvgpu_init_interrupt_setup(struct gk20a *g)
 	return 0;
 }
 
-typedef int (*nvgpu_init_func_t)(struct gk20a *g);
-struct nvgpu_init_table_t {
-	nvgpu_init_func_t func;
-	const char *name;
-	u32 enable_flag;
-};
-#define NVGPU_INIT_TABLE_ENTRY(ops_ptr, enable_flag) \
-	{ (ops_ptr), #ops_ptr,  (enable_flag) }
 #define NO_FLAG 0U
 
 static bool needs_init(struct gk20a *g, nvgpu_init_func_t func, u32 enable_flag)
@@ -708,10 +711,106 @@ static bool needs_init(struct gk20a *g, nvgpu_init_func_t func, u32 enable_flag)
 		nvgpu_is_enabled(g, enable_flag)) && (func != NULL);
 }
 
+static int nvgpu_init_run_entry(struct gk20a *g,
+				const struct nvgpu_init_table_t *table,
+				u32 idx, struct nvgpu_init_timing *timing)
+{
+	s64 start_ns = nvgpu_current_time_ns();
+	int err;
+
+	nvgpu_log_info(g, "Initializing %s", table[idx].name);
+	err = table[idx].func(g);
+	if (err != 0) {
+		nvgpu_err(g, "Failed initialization for: %s", table[idx].name);
+	}
+
+	if ((timing != NULL) && (idx < timing->count)) {
+		struct nvgpu_init_stage_time *t = &timing->stages[idx];
+
+		t->start_ns = nvgpu_safe_sub_s64(start_ns, timing->start_ns);
+		t->duration_ns = nvgpu_safe_sub_s64(nvgpu_current_time_ns(),
+						    start_ns);
+		t->ran = true;
+	}
+
+	return err;
+}
+
+int nvgpu_init_run_table(struct gk20a *g, const struct nvgpu_init_table_t *table,
+			 u32 count, struct nvgpu_init_timing *timing)
+{
+	int err = 0;
+	u32 i;
+
+	if (timing != NULL) {
+		(void)memset(timing, 0, sizeof(*timing));
+		timing->start_ns = nvgpu_current_time_ns();
+		timing->count = min(count, NVGPU_INIT_MAX_TIMED_STAGES);
+		for (i = 0U; i < timing->count; i++) {
+			timing->stages[i].name = table[i].name;
+		}
+	}
+
+	for (i = 0U; (i < count) && (err == 0); i++) {
+		if (!needs_init(g, table[i].func, table[i].enable_flag)) {
+			nvgpu_log_info(g, "Skipping initializing %s (enable_flag=%u func=%p)",
+				       table[i].name, table[i].enable_flag,
+				       table[i].func);
+		} else {
+			err = nvgpu_init_run_entry(g, table, i, timing);
+		}
+	}
+
+	if (timing != NULL) {
+		timing->total_ns = nvgpu_safe_sub_s64(nvgpu_current_time_ns(),
+						      timing->start_ns);
+	}
+
+	return err;
+}
+
+void nvgpu_init_timing_report(struct gk20a *g,
+			      const struct nvgpu_init_timing *timing,
+			      const char *phase)
+{
+	u32 i;
+
+	if (timing == NULL) {
+		return;
+	}
+
+	nvgpu_log_info(g, "%s took %lld us", phase,
+		       (long long)(timing->total_ns / 1000));
+
+	for (i = 0U; i < timing->count; i++) {
+		const struct nvgpu_init_stage_time *t = &timing->stages[i];
+
+		if (t->ran) {
+			nvgpu_log_info(g, "  %-48s at %8lld us took %8lld us",
+				       t->name,
+				       (long long)(t->start_ns / 1000),
+				       (long long)(t->duration_ns / 1000));
+		}
+	}
+}
+
+/*
+ * The breakdown of a phase is only recorded while gpu_dbg_info logging is
+ * enabled, as that is the only way it is reported.
+ */
+static struct nvgpu_init_timing *nvgpu_init_timing_get(struct gk20a *g,
+					struct nvgpu_init_timing **timing)
+{
+	if ((*timing == NULL) && ((g->log_mask & gpu_dbg_info) != 0ULL)) {
+		*timing = nvgpu_kzalloc(g, sizeof(**timing));
+	}
+
+	return *timing;
+}
+
 static int nvgpu_early_init(struct gk20a *g)
 {
 	int err = 0;
-	size_t i;
 
 	/*
 	 * This cannot be static because we use the func ptrs as initializers
@@ -766,27 +865,11 @@ static int nvgpu_early_init(struct gk20a *g)
 		NVGPU_INIT_TABLE_ENTRY(g->ops.grmgr.init_gr_manager, NO_FLAG),
 	};
 
-	for (i = 0; i < ARRAY_SIZE(nvgpu_early_init_table); i++) {
-		if (!needs_init(g, nvgpu_early_init_table[i].func,
-				nvgpu_early_init_table[i].enable_flag)) {
-			nvgpu_log_info(g,
-				"Skipping initializing %s (enable_flag=%u func=%p)",
-				   nvgpu_early_init_table[i].name,
-				   nvgpu_early_init_table[i].enable_flag,
-				   nvgpu_early_init_table[i].func);
-		} else {
-			nvgpu_log_info(g, "Initializing %s",
-					   nvgpu_early_init_table[i].name);
-			err = nvgpu_early_init_table[i].func(g);
-			if (err != 0) {
-				nvgpu_err(g, "Failed initialization for: %s",
-					  nvgpu_early_init_table[i].name);
-				goto done;
-			}
-		}
-	}
+	err = nvgpu_init_run_table(g, nvgpu_early_init_table,
+				   (u32)ARRAY_SIZE(nvgpu_early_init_table),
+				   nvgpu_init_timing_get(g, &g->early_init_timing));
+	nvgpu_init_timing_report(g, g->early_init_timing, "early_init");
 
-done:
 	return err;
 }
 
@@ -975,6 +1058,9 @@ int nvgpu_finalize_poweron(struct gk20a *g)
 #ifdef CONFIG_NVGPU_PROFILER
 		NVGPU_INIT_TABLE_ENTRY(&nvgpu_pm_reservation_init, NO_FLAG),
 #endif
+#ifdef CONFIG_NVGPU_DEBUGGER
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_regops_allowlist, NO_FLAG),
+#endif
 #ifdef CONFIG_NVGPU_POWER_PG
 		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_restore_golden_img_state,
 				       NO_FLAG),
@@ -991,27 +1077,15 @@ int nvgpu_finalize_poweron(struct gk20a *g)
 #endif
 #endif
 	};
-	size_t i;
 
 	nvgpu_log_fn(g, " ");
 
-	for (i = 0; i < ARRAY_SIZE(nvgpu_init_table); i++) {
-		if (!needs_init(g, nvgpu_init_table[i].func,
-				nvgpu_init_table[i].enable_flag)) {
-			nvgpu_log_info(g, "Skipping initializing %s (enable_flag=%u func=%p)",
-				       nvgpu_init_table[i].name,
-				       nvgpu_init_table[i].enable_flag,
-				       nvgpu_init_table[i].func);
-		} else {
-			nvgpu_log_info(g, "Initializing %s",
-				       nvgpu_init_table[i].name);
-			err = nvgpu_init_table[i].func(g);
-			if (err != 0) {
-				nvgpu_err(g, "Failed initialization for: %s",
-					  nvgpu_init_table[i].name);
-				goto done;
-			}
-		}
+	err = nvgpu_init_run_table(g, nvgpu_init_table,
+				   (u32)ARRAY_SIZE(nvgpu_init_table),
+				   nvgpu_init_timing_get(g, &g->poweron_timing));
+	nvgpu_init_timing_report(g, g->poweron_timing, "finalize_poweron");
+	if (err != 0) {
+		goto done;
 	}
 
 	nvgpu_print_enabled_flags(g);
@@ -1203,9 +1277,18 @@ static void gk20a_free_cb(struct nvgpu_ref *refcount)
 #ifdef CONFIG_NVGPU_PROFILER
 	nvgpu_pm_reservation_deinit(g);
 #endif
+#ifdef CONFIG_NVGPU_DEBUGGER
+	nvgpu_regops_allowlist_deinit(g);
+#endif
 
 	nvgpu_sw_quiesce_remove_support(g);
 
+	nvgpu_kfree(g, g->early_init_timing);
+	g->early_init_timing = NULL;
+	nvgpu_kfree(g, g->poweron_timing);
+	g->poweron_timing = NULL;
+	nvgpu_boot_cache_deinit(g);
+
 	gk20a_debug_deinit(g);
 
 #ifdef CONFIG_NVGPU_NON_FUSA
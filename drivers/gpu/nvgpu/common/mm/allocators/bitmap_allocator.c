@@ -86,14 +86,14 @@ static u64 nvgpu_bitmap_balloc_fixed(struct nvgpu_allocator *na,
 	alloc_lock(na);
 
 	/* Check if the space requested is already occupied. */
-	ret = bitmap_find_next_zero_area(a->bitmap, a->num_bits, offs,
-					(u32)blks, 0UL);
+	ret = nvgpu_hbitmap_find_next_zero_area(&a->bitmap, a->num_bits, offs,
+						(u32)blks, 0UL);
 	if (ret != offs) {
 		goto fail;
 	}
 
 	nvgpu_assert(blks <= U32_MAX);
-	nvgpu_bitmap_set(a->bitmap, (u32)offs, U32(blks));
+	nvgpu_hbitmap_set(&a->bitmap, (u32)offs, U32(blks));
 
 	a->bytes_alloced = nvgpu_safe_add_u64(a->bytes_alloced,
 				nvgpu_safe_mult_u64(blks, a->blk_size));
@@ -140,7 +140,7 @@ static void nvgpu_bitmap_free_fixed(struct nvgpu_allocator *na,
 	alloc_lock(na);
 	nvgpu_assert(offs <= U32_MAX);
 	nvgpu_assert(blks <= (u32)INT_MAX);
-	nvgpu_bitmap_clear(a->bitmap, (u32)offs, (u32)blks);
+	nvgpu_hbitmap_clear(&a->bitmap, (u32)offs, (u32)blks);
 	a->bytes_freed = nvgpu_safe_add_u64(a->bytes_freed,
 				nvgpu_safe_mult_u64(blks, a->blk_size));
 	alloc_unlock(na);
@@ -213,7 +213,7 @@ static int nvgpu_bitmap_store_alloc(struct nvgpu_bitmap_allocator *a,
  * Acquire the alloc_lock.
  * Searche a bitmap for the first space that is large enough to satisfy the
  *  requested size of bits by walking the next available free blocks by
- *  bitmap_find_next_zero_area().
+ *  nvgpu_hbitmap_find_next_zero_area(), which skips over full words.
  * Release the alloc_lock.
  */
 static u64 nvgpu_bitmap_balloc(struct nvgpu_allocator *na, u64 len)
@@ -241,24 +241,24 @@ static u64 nvgpu_bitmap_balloc(struct nvgpu_allocator *na, u64 len)
 	/*
 	 * First look from next_blk and onwards...
 	 */
-	offs = bitmap_find_next_zero_area(a->bitmap, a->num_bits,
-					  a->next_blk, blks, 0);
+	offs = nvgpu_hbitmap_find_next_zero_area(&a->bitmap, a->num_bits,
+						 a->next_blk, blks, 0);
 	if (offs >= a->num_bits) {
 		/*
 		 * If that didn't work try the remaining area. Since there can
 		 * be available space that spans across a->next_blk we need to
 		 * search up to the first set bit after that.
 		 */
-		limit = find_next_bit(a->bitmap, a->num_bits, a->next_blk);
-		offs = bitmap_find_next_zero_area(a->bitmap, limit,
-						  0, blks, 0);
+		limit = find_next_bit(a->bitmap.map, a->num_bits, a->next_blk);
+		offs = nvgpu_hbitmap_find_next_zero_area(&a->bitmap, limit,
+							 0, blks, 0);
 		if (offs >= a->next_blk) {
 			goto fail;
 		}
 	}
 
 	nvgpu_assert(offs <= U32_MAX);
-	nvgpu_bitmap_set(a->bitmap, (u32)offs, blks);
+	nvgpu_hbitmap_set(&a->bitmap, (u32)offs, blks);
 	a->next_blk = offs + blks;
 
 	adjusted_offs = nvgpu_safe_add_u64(offs, a->bit_offs);
@@ -293,7 +293,7 @@ static u64 nvgpu_bitmap_balloc(struct nvgpu_allocator *na, u64 len)
 fail_reset_bitmap:
 	nvgpu_assert(blks <= (u32)INT_MAX);
 	nvgpu_assert(offs <= U32_MAX);
-	nvgpu_bitmap_clear(a->bitmap, (u32)offs, blks);
+	nvgpu_hbitmap_clear(&a->bitmap, (u32)offs, blks);
 fail:
 	a->next_blk = 0;
 	alloc_unlock(na);
@@ -331,7 +331,7 @@ static void nvgpu_bitmap_free(struct nvgpu_allocator *na, u64 addr)
 
 	nvgpu_assert(blks <= (u32)INT_MAX);
 	nvgpu_assert(offs <= U32_MAX);
-	nvgpu_bitmap_clear(a->bitmap, (u32)offs, (u32)blks);
+	nvgpu_hbitmap_clear(&a->bitmap, (u32)offs, (u32)blks);
 	alloc_dbg(na, "Free  0x%-10llx", addr);
 
 	a->bytes_freed = nvgpu_safe_add_u64(a->bytes_freed, alloc->length);
@@ -367,7 +367,7 @@ static void nvgpu_bitmap_alloc_destroy(struct nvgpu_allocator *na)
 	}
 
 	nvgpu_kmem_cache_destroy(a->meta_data_cache);
-	nvgpu_kfree(nvgpu_alloc_to_gpu(na), a->bitmap);
+	nvgpu_hbitmap_deinit(nvgpu_alloc_to_gpu(na), &a->bitmap);
 	nvgpu_kfree(nvgpu_alloc_to_gpu(na), a);
 
 	alloc_unlock(na);
@@ -487,10 +487,8 @@ int nvgpu_bitmap_allocator_init(struct gk20a *g, struct nvgpu_allocator *na,
 	a->flags = flags;
 	a->allocs = NULL;
 
-	a->bitmap = nvgpu_kcalloc(g, BITS_TO_LONGS(a->num_bits),
-				  sizeof(*a->bitmap));
-	if (a->bitmap == NULL) {
-		err = -ENOMEM;
+	err = nvgpu_hbitmap_init(g, &a->bitmap, a->num_bits);
+	if (err != 0) {
 		goto fail;
 	}
 
@@ -31,6 +31,7 @@
 
 #include <nvgpu/rbtree.h>
 #include <nvgpu/kmem.h>
+#include <nvgpu/hbitmap.h>
 
 struct nvgpu_allocator;
 
@@ -83,9 +84,10 @@ struct nvgpu_bitmap_allocator {
 	u64 next_blk;
 
 	/**
-	 * The actual bitmap used for allocations.
+	 * The actual bitmap used for allocations. Its full-word summary lets
+	 * the free space search skip over densely allocated regions.
 	 */
-	unsigned long *bitmap;
+	struct nvgpu_hbitmap bitmap;
 
 	/**
 	 * Tree of outstanding allocations.
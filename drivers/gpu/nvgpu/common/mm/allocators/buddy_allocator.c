@@ -210,6 +210,7 @@ static void balloc_blist_add(struct nvgpu_buddy_allocator *a,
 	balloc_buddy_list_do_add(a, b, balloc_get_order_list(a, b->order));
 	a->buddy_list_len[b->order] =
 		nvgpu_safe_add_u64(a->buddy_list_len[b->order], 1ULL);
+	a->buddy_list_mask |= BIT64(b->order);
 }
 
 static void balloc_blist_rem(struct nvgpu_buddy_allocator *a,
@@ -218,6 +219,9 @@ static void balloc_blist_rem(struct nvgpu_buddy_allocator *a,
 	balloc_buddy_list_do_rem(a, b);
 	nvgpu_assert(a->buddy_list_len[b->order] > 0ULL);
 	a->buddy_list_len[b->order]--;
+	if (a->buddy_list_len[b->order] == 0ULL) {
+		a->buddy_list_mask &= ~BIT64(b->order);
+	}
 }
 
 static u64 balloc_get_order(struct nvgpu_buddy_allocator *a, u64 len)
@@ -572,13 +576,22 @@ static u64 balloc_do_alloc(struct nvgpu_buddy_allocator *a,
 			   u64 order, u32 pte_size)
 {
 	u64 split_order;
+	u64 orders;
 	struct nvgpu_buddy *bud = NULL;
 
-	for (split_order = order; split_order <= a->max_order; split_order++) {
+	if (order > a->max_order) {
+		return 0;
+	}
+
+	/* Only look at the orders that have free buddies. */
+	orders = a->buddy_list_mask & ~(BIT64(order) - 1ULL);
+	while (orders != 0ULL) {
+		split_order = nvgpu_safe_sub_u64(nvgpu_ffs(orders), 1ULL);
 		bud = balloc_find_buddy(a, split_order, pte_size);
 		if (bud != NULL) {
 			break;
 		}
+		orders &= ~BIT64(split_order);
 	}
 
 	/* Out of memory! */
@@ -604,36 +617,20 @@ static u64 balloc_do_alloc(struct nvgpu_buddy_allocator *a,
  * See if the passed range is actually available for allocation. If so, then
  * return 1, otherwise return 0.
  *
- * TODO: Right now this uses the unoptimal approach of going through all
- * outstanding allocations and checking their base/ends. This could be better.
+ * Allocated buddies never overlap each other, so the only one that can
+ * overlap [base, end) is the last one starting below end.
  */
 static bool balloc_is_range_free(struct nvgpu_buddy_allocator *a,
 				u64 base, u64 end)
 {
 	struct nvgpu_rbtree_node *node = NULL;
-	struct nvgpu_buddy *bud;
 
-	nvgpu_rbtree_enum_start(0, &node, a->alloced_buddies);
+	nvgpu_rbtree_less_than_search(end, &node, a->alloced_buddies);
 	if (node == NULL) {
-		return true; /* No allocs yet. */
+		return true; /* Nothing allocated below end. */
 	}
 
-	bud = nvgpu_buddy_from_rbtree_node(node);
-
-	while (bud->start < end) {
-		if (((bud->start > base) && (bud->start < end)) ||
-			((bud->end > base) && (bud->end < end))) {
-			return false;
-		}
-
-		nvgpu_rbtree_enum_next(&node, node);
-		if (node == NULL) {
-			break;
-		}
-		bud = nvgpu_buddy_from_rbtree_node(node);
-	}
-
-	return true;
+	return nvgpu_buddy_from_rbtree_node(node)->end <= base;
 }
 
 static void balloc_alloc_fixed(struct nvgpu_buddy_allocator *a,
@@ -738,6 +735,12 @@ static struct nvgpu_buddy *balloc_make_fixed_buddy(
 	while (cur_order <= a->max_order) {
 		bool found = false;
 
+		if ((a->buddy_list_mask & BIT64(cur_order)) == 0ULL) {
+			balloc_get_parent_range(a, cur_base, cur_order,
+						&cur_base, &cur_order);
+			continue;
+		}
+
 		order_list = balloc_get_order_list(a, cur_order);
 		nvgpu_list_for_each_entry(bud, order_list,
 					nvgpu_buddy, buddy_entry) {
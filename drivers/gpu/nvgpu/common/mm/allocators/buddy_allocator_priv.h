@@ -318,6 +318,12 @@ struct nvgpu_buddy_allocator {
 	 * Length of the buddy list.
 	 */
 	u64 buddy_list_len[GPU_BALLOC_ORDER_LIST_LEN];
+	/**
+	 * Bit n is set when the buddy list of order n is not empty, so that
+	 * allocations find the next order to split from without probing the
+	 * empty lists in between.
+	 */
+	u64 buddy_list_mask;
 	/**
 	 * Number of split nodes.
 	 */
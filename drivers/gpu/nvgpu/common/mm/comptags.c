@@ -24,6 +24,7 @@
 #include <nvgpu/bitops.h>
 #include <nvgpu/comptags.h>
 #include <nvgpu/gk20a.h>
+#include <nvgpu/hbitmap.h>
 
 int gk20a_comptaglines_alloc(struct gk20a_comptag_allocator *allocator,
 			     u32 *offset, u32 len)
@@ -36,13 +37,13 @@ int gk20a_comptaglines_alloc(struct gk20a_comptag_allocator *allocator,
 	}
 
 	nvgpu_mutex_acquire(&allocator->lock);
-	addr = bitmap_find_next_zero_area(allocator->bitmap, allocator->size,
-			0, len, 0);
+	addr = nvgpu_hbitmap_find_next_zero_area(&allocator->bitmap,
+			allocator->size, 0, len, 0);
 	if (addr < allocator->size) {
 		/* number zero is reserved; bitmap base is 1 */
 		nvgpu_assert(addr < U64(U32_MAX));
 		*offset = 1U + U32(addr);
-		nvgpu_bitmap_set(allocator->bitmap, U32(addr), len);
+		nvgpu_hbitmap_set(&allocator->bitmap, U32(addr), len);
 	} else {
 		err = -ENOMEM;
 	}
@@ -66,7 +67,7 @@ void gk20a_comptaglines_free(struct gk20a_comptag_allocator *allocator,
 	WARN_ON((unsigned long)addr + (unsigned long)len > allocator->size);
 
 	nvgpu_mutex_acquire(&allocator->lock);
-	nvgpu_bitmap_clear(allocator->bitmap, addr, len);
+	nvgpu_hbitmap_clear(&allocator->bitmap, addr, len);
 	nvgpu_mutex_release(&allocator->lock);
 }
 
@@ -74,6 +75,8 @@ int gk20a_comptag_allocator_init(struct gk20a *g,
 				 struct gk20a_comptag_allocator *allocator,
 				 unsigned long size)
 {
+	int err;
+
 	nvgpu_mutex_init(&allocator->lock);
 
 	/*
@@ -81,10 +84,9 @@ int gk20a_comptag_allocator_init(struct gk20a *g,
 	 * is 1, and its size is one less than the size of comptag store.
 	 */
 	size--;
-	allocator->bitmap = nvgpu_vzalloc(g,
-					  BITS_TO_LONGS(size) * sizeof(long));
-	if (allocator->bitmap == NULL) {
-		return -ENOMEM;
+	err = nvgpu_hbitmap_init(g, &allocator->bitmap, size);
+	if (err != 0) {
+		return err;
 	}
 
 	allocator->size = size;
@@ -101,5 +103,5 @@ void gk20a_comptag_allocator_destroy(struct gk20a *g,
 	 * unnecessary here.
 	 */
 	allocator->size = 0;
-	nvgpu_vfree(g, allocator->bitmap);
+	nvgpu_hbitmap_deinit(g, &allocator->bitmap);
 }
@@ -38,6 +38,13 @@
 #include <nvgpu/static_analysis.h>
 #include <nvgpu/errata.h>
 #include <nvgpu/power_features/pg.h>
+#include <nvgpu/atomic.h>
+#include <nvgpu/cond.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/worker.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/bitops.h>
+#include <nvgpu/string.h>
 
 #ifdef CONFIG_NVGPU_TRACE
 #define nvgpu_gmmu_dbg(g, attrs, fmt, args...)				\
@@ -61,6 +68,58 @@ NVGPU_COV_WHITELIST(false_positive, NVGPU_MISRA(Rule, 14_4), "Bug 2623654") \
 	} while (false)
 #endif
 
+/*
+ * Max number of PTE level subtrees queued by a single parallel fill before
+ * they are handed out to the workers.
+ */
+#define NVGPU_GMMU_PT_FILL_MAX_JOBS	4096U
+
+/*
+ * A contiguous range below one last level PDE. The PD backing it has already
+ * been allocated and the PDE pointing at it programmed, so filling it in only
+ * writes PTEs into memory that no other job owns entries of.
+ */
+struct nvgpu_gmmu_pt_fill_job {
+	struct nvgpu_gmmu_pd *pd;
+	u64 phys_addr;
+	u64 virt_addr;
+	u64 length;
+};
+
+struct nvgpu_gmmu_pt_fill_worker {
+	struct nvgpu_worker worker;
+	struct nvgpu_list_node item;
+	struct nvgpu_gmmu_pt_fill *fill;
+};
+
+struct nvgpu_gmmu_pt_fill {
+	struct gk20a *g;
+	/* Held for the whole of a parallel update; others fall back to serial. */
+	struct nvgpu_mutex lock;
+	u64 min_length;
+	u32 num_workers;
+	struct nvgpu_gmmu_pt_fill_worker *workers;
+
+	/* State of the update currently holding #lock. */
+	struct vm_gk20a *vm;
+	struct nvgpu_gmmu_attrs *attrs;
+	u32 lvl;
+	struct nvgpu_gmmu_pt_fill_job *jobs;
+	u32 num_jobs;
+	/* Subtree locks of #vm taken by this update, see ..._fill_hold(). */
+	DECLARE_BITMAP(held_locks, NVGPU_VM_PD_SUBTREE_LOCKS);
+	nvgpu_atomic_t next_job;
+	nvgpu_atomic_t pending;
+	nvgpu_atomic_t err;
+	struct nvgpu_cond done;
+};
+
+static int nvgpu_gmmu_pt_fill_add(struct nvgpu_gmmu_pt_fill *fill,
+				  struct nvgpu_gmmu_pd *pd,
+				  u64 phys_addr, u64 virt_addr, u64 length);
+static void nvgpu_gmmu_pt_fill_hold(struct nvgpu_gmmu_pt_fill *fill,
+				    struct nvgpu_mutex *lock);
+
 static int pd_allocate(struct vm_gk20a *vm,
 		       struct nvgpu_gmmu_pd *pd,
 		       const struct gk20a_mmu_level *l,
@@ -196,6 +255,30 @@ void nvgpu_gmmu_unmap(struct vm_gk20a *vm, struct nvgpu_mem *mem)
 	nvgpu_gmmu_unmap_addr(vm, mem, mem->gpu_va);
 }
 
+/*
+ * Find the deepest PDE level which, like all levels above it, is indexed by
+ * the same VA bits for every page size. The PDs down to that level are never
+ * reallocated, so the PDEs of that level split the page table into subtrees
+ * that can be updated independently of each other.
+ */
+static u32 nvgpu_gmmu_pd_lock_level(const struct gk20a_mmu_level *l)
+{
+	u32 lock_lvl = U32_MAX;
+	u32 lvl;
+
+	for (lvl = 0U; l[lvl + 1U].update_entry != NULL; lvl++) {
+		if ((l[lvl].lo_bit[GMMU_PAGE_SIZE_SMALL] !=
+		     l[lvl].lo_bit[GMMU_PAGE_SIZE_BIG]) ||
+		    (l[lvl].hi_bit[GMMU_PAGE_SIZE_SMALL] !=
+		     l[lvl].hi_bit[GMMU_PAGE_SIZE_BIG])) {
+			break;
+		}
+		lock_lvl = lvl;
+	}
+
+	return lock_lvl;
+}
+
 int nvgpu_gmmu_init_page_table(struct vm_gk20a *vm)
 {
 	u32 pdb_size;
@@ -237,6 +320,8 @@ int nvgpu_gmmu_init_page_table(struct vm_gk20a *vm)
 	 */
 	vm->pdb.mem->skip_wmb = true;
 
+	vm->pd_lock_lvl = nvgpu_gmmu_pd_lock_level(vm->mmu_levels);
+
 	return err;
 }
 
@@ -438,6 +523,30 @@ static int nvgpu_set_pd_level_is_next_level_pde(struct vm_gk20a *vm,
 	return 0;
 }
 
+/*
+ * Lock protecting the PDE at @virt_addr of level @lvl and, for the subtree
+ * lock level, everything below it. NULL if the caller already has the PDE
+ * to itself: either the whole update runs under vm->pd_lock or @lvl is inside
+ * a subtree whose lock is already held.
+ */
+static struct nvgpu_mutex *nvgpu_gmmu_pd_entry_lock(struct vm_gk20a *vm,
+				const struct gk20a_mmu_level *l, u32 lvl,
+				u64 virt_addr, struct nvgpu_gmmu_attrs *attrs)
+{
+	u64 idx;
+
+	if ((vm->pd_lock_lvl == U32_MAX) || (lvl > vm->pd_lock_lvl)) {
+		return NULL;
+	}
+	if (lvl < vm->pd_lock_lvl) {
+		return &vm->pd_lock;
+	}
+
+	idx = (virt_addr >> l->lo_bit[attrs->pgsz]) %
+		(u64)NVGPU_VM_PD_SUBTREE_LOCKS;
+	return &vm->pd_subtree_locks[idx];
+}
+
 /*
  * This function programs the GMMU based on two ranges: a physical range and a
  * GPU virtual range. The virtual is mapped to the physical. Physical in this
@@ -460,7 +569,8 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 			      u32 lvl,
 			      u64 phys_addr,
 			      u64 virt_addr, u64 length,
-			      struct nvgpu_gmmu_attrs *attrs)
+			      struct nvgpu_gmmu_attrs *attrs,
+			      struct nvgpu_gmmu_pt_fill *fill)
 {
 	int err = 0;
 	u64 pde_range;
@@ -498,6 +608,20 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 
 	pde_range = 1ULL << (u64)l->lo_bit[attrs->pgsz];
 
+	/*
+	 * The PD of the subtree lock level is shared by all of its subtrees,
+	 * so its entries array is allocated under the upper level lock. It is
+	 * never reallocated afterwards.
+	 */
+	if ((lvl == vm->pd_lock_lvl) && (next_l->update_entry != NULL)) {
+		nvgpu_mutex_acquire(&vm->pd_lock);
+		err = pd_allocate_children(vm, l, pd, attrs);
+		nvgpu_mutex_release(&vm->pd_lock);
+		if (err != 0) {
+			return -ENOMEM;
+		}
+	}
+
 	/*
 	 * Iterate across the mapping in chunks the size of this level's PDE.
 	 * For each of those chunks program our level's PDE and then, if there's
@@ -505,6 +629,7 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 	 */
 	while (length != 0ULL) {
 		u32 pd_idx = pd_index(l, virt_addr, attrs);
+		struct nvgpu_mutex *lock;
 		u64 chunk_size;
 		u64 target_addr;
 		u64 tmp_len;
@@ -518,9 +643,22 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 				virt_addr & (pde_range - 1U));
 		chunk_size = min(length, tmp_len);
 
+		lock = nvgpu_gmmu_pd_entry_lock(vm, l, lvl, virt_addr, attrs);
+		if ((lock != NULL) && (fill != NULL) &&
+		    (lvl == vm->pd_lock_lvl)) {
+			/* Released by nvgpu_gmmu_pt_fill_end(). */
+			nvgpu_gmmu_pt_fill_hold(fill, lock);
+			lock = NULL;
+		} else if (lock != NULL) {
+			nvgpu_mutex_acquire(lock);
+		}
+
 		err = nvgpu_set_pd_level_is_next_level_pde(vm, pd, &next_pd,
 						l, next_l, pd_idx, attrs);
 		if (err != 0) {
+			if (lock != NULL) {
+				nvgpu_mutex_release(lock);
+			}
 			return err;
 		}
 
@@ -539,17 +677,38 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 				target_addr,
 				attrs);
 
-		if (next_l->update_entry != NULL) {
+		/*
+		 * Above the subtree lock level only this PDE needed the lock;
+		 * at that level the lock covers the whole subtree below it.
+		 */
+		if ((lock != NULL) && (lvl != vm->pd_lock_lvl)) {
+			nvgpu_mutex_release(lock);
+			lock = NULL;
+		}
+
+		if ((fill != NULL) && (lvl == fill->lvl)) {
+			/*
+			 * The PTE level below is filled in by the parallel
+			 * fill workers once enough subtrees are queued.
+			 */
+			err = nvgpu_gmmu_pt_fill_add(fill, next_pd,
+						     phys_addr,
+						     virt_addr,
+						     chunk_size);
+		} else if (next_l->update_entry != NULL) {
 			err = nvgpu_set_pd_level(vm, next_pd,
 						 nvgpu_safe_add_u32(lvl, 1U),
 						 phys_addr,
 						 virt_addr,
 						 chunk_size,
-						 attrs);
+						 attrs, fill);
+		}
 
-			if (err != 0) {
-				return err;
-			}
+		if (lock != NULL) {
+			nvgpu_mutex_release(lock);
+		}
+		if (err != 0) {
+			return err;
 		}
 
 		virt_addr = nvgpu_safe_add_u64(virt_addr, chunk_size);
@@ -575,13 +734,308 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 }
 NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 17_2))
 
+/*
+ * Fill in queued PTE subtrees until there are none left or one of them
+ * failed. Runs on each fill worker and on the thread doing the update.
+ */
+static void nvgpu_gmmu_pt_fill_run(struct nvgpu_gmmu_pt_fill *fill)
+{
+	u32 lvl = nvgpu_safe_add_u32(fill->lvl, 1U);
+
+	while (nvgpu_atomic_read(&fill->err) == 0) {
+		struct nvgpu_gmmu_pt_fill_job *job;
+		int idx = nvgpu_atomic_inc_return(&fill->next_job) - 1;
+		int err;
+
+		if ((u32)idx >= fill->num_jobs) {
+			break;
+		}
+
+		job = &fill->jobs[idx];
+		err = nvgpu_set_pd_level(fill->vm, job->pd, lvl,
+					 job->phys_addr,
+					 job->virt_addr,
+					 job->length,
+					 fill->attrs, NULL);
+		if (err != 0) {
+			(void)nvgpu_atomic_cmpxchg(&fill->err, 0, err);
+		}
+	}
+}
+
+static inline struct nvgpu_gmmu_pt_fill_worker *
+nvgpu_gmmu_pt_fill_worker_from_item(struct nvgpu_list_node *node)
+{
+	return (struct nvgpu_gmmu_pt_fill_worker *)
+	   ((uintptr_t)node - offsetof(struct nvgpu_gmmu_pt_fill_worker, item));
+};
+
+static void nvgpu_gmmu_pt_fill_process_item(struct nvgpu_list_node *work_item)
+{
+	struct nvgpu_gmmu_pt_fill_worker *w =
+		nvgpu_gmmu_pt_fill_worker_from_item(work_item);
+	struct nvgpu_gmmu_pt_fill *fill = w->fill;
+
+	nvgpu_gmmu_pt_fill_run(fill);
+
+	/*
+	 * Make this thread's PTE writes visible before the updating thread
+	 * goes on to its own barrier and the TLB invalidate.
+	 */
+	nvgpu_mb();
+
+	if (nvgpu_atomic_dec_and_test(&fill->pending)) {
+		nvgpu_cond_signal(&fill->done);
+	}
+}
+
+static const struct nvgpu_worker_ops nvgpu_gmmu_pt_fill_worker_ops = {
+	.pre_process = NULL,
+	.wakeup_early_exit = NULL,
+	.wakeup_post_process = NULL,
+	.wakeup_process_item = nvgpu_gmmu_pt_fill_process_item,
+	.wakeup_condition = NULL,
+	.wakeup_timeout = NULL,
+};
+
+/*
+ * Hand all queued subtrees out to the workers, help fill them in and wait
+ * until every worker is done with them.
+ */
+static int nvgpu_gmmu_pt_fill_flush(struct nvgpu_gmmu_pt_fill *fill)
+{
+	u32 i;
+	int err;
+
+	if (fill->num_jobs == 0U) {
+		return 0;
+	}
+
+	nvgpu_atomic_set(&fill->next_job, 0);
+	nvgpu_atomic_set(&fill->err, 0);
+	nvgpu_atomic_set(&fill->pending, (int)fill->num_workers);
+
+	for (i = 0U; i < fill->num_workers; i++) {
+		struct nvgpu_gmmu_pt_fill_worker *w = &fill->workers[i];
+
+		if (nvgpu_worker_enqueue(&w->worker, &w->item) != 0) {
+			nvgpu_atomic_dec(&fill->pending);
+		}
+	}
+
+	nvgpu_gmmu_pt_fill_run(fill);
+
+	(void)NVGPU_COND_WAIT(&fill->done,
+			nvgpu_atomic_read(&fill->pending) == 0, 0U);
+
+	err = nvgpu_atomic_read(&fill->err);
+	fill->num_jobs = 0U;
+
+	return err;
+}
+
+/*
+ * Lock a subtree for the rest of a parallel update. The PTEs queued below it
+ * are only written at the next flush, and until then a concurrent update of
+ * the same subtree could reallocate the PDs the workers write to. Subtrees
+ * sharing a lock take it only once.
+ */
+static void nvgpu_gmmu_pt_fill_hold(struct nvgpu_gmmu_pt_fill *fill,
+				    struct nvgpu_mutex *lock)
+{
+	u32 idx = (u32)(lock - &fill->vm->pd_subtree_locks[0]);
+
+	if (!nvgpu_test_bit(idx, fill->held_locks)) {
+		nvgpu_mutex_acquire(lock);
+		nvgpu_set_bit(idx, fill->held_locks);
+	}
+}
+
+static int nvgpu_gmmu_pt_fill_add(struct nvgpu_gmmu_pt_fill *fill,
+				  struct nvgpu_gmmu_pd *pd,
+				  u64 phys_addr, u64 virt_addr, u64 length)
+{
+	struct nvgpu_gmmu_pt_fill_job *job;
+
+	if (fill->num_jobs == NVGPU_GMMU_PT_FILL_MAX_JOBS) {
+		int err = nvgpu_gmmu_pt_fill_flush(fill);
+
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	job = &fill->jobs[fill->num_jobs];
+	job->pd = pd;
+	job->phys_addr = phys_addr;
+	job->virt_addr = virt_addr;
+	job->length = length;
+	fill->num_jobs = nvgpu_safe_add_u32(fill->num_jobs, 1U);
+
+	return 0;
+}
+
+/*
+ * Decide whether this update is filled in in parallel. If so the fill pool
+ * is returned locked and the last PDE level is recorded as the level below
+ * which PTE subtrees get queued instead of being filled in directly.
+ */
+static struct nvgpu_gmmu_pt_fill *nvgpu_gmmu_pt_fill_begin(
+				struct vm_gk20a *vm, u64 length,
+				struct nvgpu_gmmu_attrs *attrs)
+{
+	struct nvgpu_gmmu_pt_fill *fill = vm->mm->pt_fill;
+	const struct gk20a_mmu_level *l = vm->mmu_levels;
+	u32 lvl = 0U;
+
+	if ((fill == NULL) || (length < fill->min_length)) {
+		return NULL;
+	}
+
+	/*
+	 * PDs outside of sysmem are written through the PRAMIN window, which
+	 * serializes every access anyway.
+	 */
+	if (!nvgpu_aperture_is_sysmem(vm->pdb.mem->aperture)) {
+		return NULL;
+	}
+
+	if ((l[0].update_entry == NULL) || (l[1].update_entry == NULL)) {
+		return NULL;
+	}
+	while (l[lvl + 2U].update_entry != NULL) {
+		lvl++;
+	}
+
+	if (nvgpu_mutex_tryacquire(&fill->lock) == 0) {
+		return NULL;
+	}
+
+	fill->vm = vm;
+	fill->attrs = attrs;
+	fill->lvl = lvl;
+	fill->num_jobs = 0U;
+	(void) memset(fill->held_locks, 0, sizeof(fill->held_locks));
+
+	return fill;
+}
+
+/*
+ * Drop the subtree locks of the update; all of its queued subtrees must have
+ * been flushed by now.
+ */
+static void nvgpu_gmmu_pt_fill_end(struct nvgpu_gmmu_pt_fill *fill)
+{
+	unsigned long idx;
+
+	for_each_set_bit(idx, fill->held_locks, NVGPU_VM_PD_SUBTREE_LOCKS) {
+		nvgpu_mutex_release(&fill->vm->pd_subtree_locks[idx]);
+	}
+
+	fill->vm = NULL;
+	fill->attrs = NULL;
+	fill->num_jobs = 0U;
+	nvgpu_mutex_release(&fill->lock);
+}
+
+int nvgpu_gmmu_pt_fill_init(struct gk20a *g, u32 num_workers, u64 min_length)
+{
+	struct nvgpu_gmmu_pt_fill *fill;
+	u32 i;
+	int err;
+
+	if ((num_workers == 0U) || (g->mm.pt_fill != NULL)) {
+		return -EINVAL;
+	}
+
+	fill = nvgpu_kzalloc(g, sizeof(*fill));
+	if (fill == NULL) {
+		return -ENOMEM;
+	}
+
+	fill->g = g;
+	fill->min_length = min_length;
+	nvgpu_mutex_init(&fill->lock);
+	err = nvgpu_cond_init(&fill->done);
+	if (err != 0) {
+		goto clean_up_fill;
+	}
+
+	fill->jobs = nvgpu_vzalloc(g, sizeof(*fill->jobs) *
+				   NVGPU_GMMU_PT_FILL_MAX_JOBS);
+	fill->workers = nvgpu_kzalloc(g, sizeof(*fill->workers) *
+				      (size_t)num_workers);
+	if ((fill->jobs == NULL) || (fill->workers == NULL)) {
+		err = -ENOMEM;
+		goto clean_up_mem;
+	}
+
+	for (i = 0U; i < num_workers; i++) {
+		struct nvgpu_gmmu_pt_fill_worker *w = &fill->workers[i];
+
+		w->fill = fill;
+		nvgpu_init_list_node(&w->item);
+		nvgpu_worker_init_name(&w->worker, "nvgpu_pt_fill", g->name);
+		err = nvgpu_worker_init(g, &w->worker,
+					&nvgpu_gmmu_pt_fill_worker_ops);
+		if (err != 0) {
+			nvgpu_err(g, "failed to start pt fill worker %u", i);
+			goto clean_up_workers;
+		}
+		fill->num_workers = nvgpu_safe_add_u32(fill->num_workers, 1U);
+	}
+
+	g->mm.pt_fill = fill;
+
+	return 0;
+
+clean_up_workers:
+	for (i = 0U; i < fill->num_workers; i++) {
+		nvgpu_worker_deinit(&fill->workers[i].worker);
+	}
+clean_up_mem:
+	nvgpu_kfree(g, fill->workers);
+	nvgpu_vfree(g, fill->jobs);
+	nvgpu_cond_destroy(&fill->done);
+clean_up_fill:
+	nvgpu_mutex_destroy(&fill->lock);
+	nvgpu_kfree(g, fill);
+	return err;
+}
+
+void nvgpu_gmmu_pt_fill_deinit(struct gk20a *g)
+{
+	struct nvgpu_gmmu_pt_fill *fill = g->mm.pt_fill;
+	u32 i;
+
+	if (fill == NULL) {
+		return;
+	}
+
+	/* Wait for an update that may still be using the workers. */
+	nvgpu_mutex_acquire(&fill->lock);
+	g->mm.pt_fill = NULL;
+	nvgpu_mutex_release(&fill->lock);
+
+	for (i = 0U; i < fill->num_workers; i++) {
+		nvgpu_worker_deinit(&fill->workers[i].worker);
+	}
+
+	nvgpu_kfree(g, fill->workers);
+	nvgpu_vfree(g, fill->jobs);
+	nvgpu_cond_destroy(&fill->done);
+	nvgpu_mutex_destroy(&fill->lock);
+	nvgpu_kfree(g, fill);
+}
+
 static int nvgpu_gmmu_do_update_page_table_sgl(struct vm_gk20a *vm,
 				struct nvgpu_sgt *sgt, void *sgl,
 				u64 *space_to_skip_ptr,
 				u64 *virt_addr_ptr, u64 *length_ptr,
 				u64 phys_addr_val, u64 ipa_addr_val,
 				u64 phys_length_val, u64 sgl_length_val,
-				struct nvgpu_gmmu_attrs *attrs)
+				struct nvgpu_gmmu_attrs *attrs,
+				struct nvgpu_gmmu_pt_fill *fill)
 {
 	struct gk20a *g = gk20a_from_vm(vm);
 	u64 space_to_skip = *space_to_skip_ptr;
@@ -639,7 +1093,7 @@ static int nvgpu_gmmu_do_update_page_table_sgl(struct vm_gk20a *vm,
 					 phys_addr,
 					 virt_addr,
 					 mapped_sgl_length,
-					 attrs);
+					 attrs, fill);
 		if (err != 0) {
 			return err;
 		}
@@ -673,7 +1127,8 @@ static int nvgpu_gmmu_do_update_page_table_sgl(struct vm_gk20a *vm,
 static int nvgpu_gmmu_do_update_page_table_no_iommu(struct vm_gk20a *vm,
 				struct nvgpu_sgt *sgt, u64 space_to_skip_val,
 				u64 virt_addr_val, u64 length_val,
-				struct nvgpu_gmmu_attrs *attrs)
+				struct nvgpu_gmmu_attrs *attrs,
+				struct nvgpu_gmmu_pt_fill *fill)
 {
 	struct gk20a *g = gk20a_from_vm(vm);
 	void *sgl;
@@ -724,7 +1179,7 @@ static int nvgpu_gmmu_do_update_page_table_no_iommu(struct vm_gk20a *vm,
 				&space_to_skip, &virt_addr, &length,
 				phys_addr, ipa_addr,
 				phys_length, sgl_length,
-				attrs);
+				attrs, fill);
 		if (err != 0) {
 			return err;
 		}
@@ -767,6 +1222,7 @@ static int nvgpu_gmmu_do_update_page_table(struct vm_gk20a *vm,
 					   struct nvgpu_gmmu_attrs *attrs)
 {
 	struct gk20a *g = gk20a_from_vm(vm);
+	struct nvgpu_gmmu_pt_fill *fill;
 	bool is_iommuable, sgt_is_iommuable;
 	int err = 0;
 
@@ -781,13 +1237,21 @@ static int nvgpu_gmmu_do_update_page_table(struct vm_gk20a *vm,
 					 0U,
 					 0,
 					 virt_addr, length,
-					 attrs);
+					 attrs, NULL);
 		if (err != 0) {
 			nvgpu_err(g, "Failed!");
 		}
 		return err;
 	}
 
+	/*
+	 * Very large maps may have their PTEs filled in by the fill workers.
+	 * All PDs are still allocated and all PDEs programmed here, and the
+	 * workers are done before this returns, so callers (and their TLB
+	 * invalidate batching) see no difference.
+	 */
+	fill = nvgpu_gmmu_pt_fill_begin(vm, length, attrs);
+
 	/*
 	 * At this point we have a scatter-gather list pointing to some number
 	 * of discontiguous chunks of memory. We must iterate over that list and
@@ -817,14 +1281,21 @@ static int nvgpu_gmmu_do_update_page_table(struct vm_gk20a *vm,
 					 io_addr,
 					 virt_addr,
 					 length,
-					 attrs);
+					 attrs, fill);
 	} else {
 		/*
 		 * Handle cases (2), (3), and (4): do the no-IOMMU mapping. In this case
 		 * we really are mapping physical pages directly.
 		 */
 		err = nvgpu_gmmu_do_update_page_table_no_iommu(vm, sgt, space_to_skip,
-							virt_addr, length, attrs);
+							virt_addr, length, attrs, fill);
+	}
+
+	if (fill != NULL) {
+		if (err == 0) {
+			err = nvgpu_gmmu_pt_fill_flush(fill);
+		}
+		nvgpu_gmmu_pt_fill_end(fill);
 	}
 
 	if (err < 0) {
@@ -836,7 +1307,7 @@ static int nvgpu_gmmu_do_update_page_table(struct vm_gk20a *vm,
 					 0U,
 					 0,
 					 virt_addr, length,
-					 &unmap_attrs);
+					 &unmap_attrs, NULL);
 		/*
 		 * If the mapping attempt failed, this unmap attempt may also
 		 * fail, but it can only up to the point where the map did,
@@ -984,12 +1455,22 @@ static int nvgpu_gmmu_update_page_table(struct vm_gk20a *vm,
 	nvgpu_gmmu_update_page_table_dbg_print(g, attrs, vm, sgt,
 				space_to_skip, virt_addr, length, page_size);
 
+	/*
+	 * Without a subtree lock level the page table walk does no locking of
+	 * its own.
+	 */
+	if (vm->pd_lock_lvl == U32_MAX) {
+		nvgpu_mutex_acquire(&vm->pd_lock);
+	}
 	err = nvgpu_gmmu_do_update_page_table(vm,
 					      sgt,
 					      space_to_skip,
 					      virt_addr,
 					      length,
 					      attrs);
+	if (vm->pd_lock_lvl == U32_MAX) {
+		nvgpu_mutex_release(&vm->pd_lock);
+	}
 	if (err != 0) {
 		nvgpu_err(g, "nvgpu_gmmu_do_update_page_table returned error");
 	}
@@ -1011,10 +1492,11 @@ static int nvgpu_gmmu_update_page_table(struct vm_gk20a *vm,
  * should not be. Chip specific stuff is handled at the PTE/PDE programming
  * layer. The rest of the logic is essentially generic for all chips.
  *
- * To call this function you must have locked the VM lock: vm->update_gmmu_lock.
- * However, note: this function is not called directly. It's used through the
- * mm.gmmu_lock() HAL. So before calling the mm.gmmu_lock() HAL make sure you
- * have the update_gmmu_lock aquired.
+ * The page table itself is protected by vm->pd_lock and vm->pd_subtree_locks,
+ * so non-fixed mappings may be created without holding vm->update_gmmu_lock.
+ * Mappings inside a VM area must hold vm->update_gmmu_lock so that the VM area
+ * stays around. Note: this function is not called directly. It's used through
+ * the mm.gmmu_map() HAL.
  */
 u64 nvgpu_gmmu_map_locked(struct vm_gk20a *vm,
 			  u64 vaddr,
@@ -1186,10 +1668,6 @@ void nvgpu_gmmu_unmap_locked(struct vm_gk20a *vm,
 
 	attrs.sparse = sparse;
 
-	if (va_allocated) {
-		nvgpu_vm_free_va(vm, vaddr, pgsz_idx);
-	}
-
 	err = nvgpu_gmmu_update_page_table(vm, NULL, 0,
 					   vaddr, size, &attrs);
 	if (err != 0) {
@@ -1197,6 +1675,14 @@ void nvgpu_gmmu_unmap_locked(struct vm_gk20a *vm,
 	}
 
 	(void)nvgpu_gmmu_cache_maint_unmap(g, vm, batch);
+
+	/*
+	 * Only give the VA range back once its PTEs are cleared: a concurrent
+	 * map may get the range right away.
+	 */
+	if (va_allocated) {
+		nvgpu_vm_free_va(vm, vaddr, pgsz_idx);
+	}
 }
 
 u32 nvgpu_pte_words(struct gk20a *g)
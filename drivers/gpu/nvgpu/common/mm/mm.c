@@ -140,6 +140,8 @@ static void nvgpu_remove_mm_support(struct mm_gk20a *mm)
 {
 	struct gk20a *g = gk20a_from_mm(mm);
 
+	nvgpu_gmmu_pt_fill_deinit(g);
+
 	nvgpu_dma_free(g, &mm->mmu_wr_mem);
 	nvgpu_dma_free(g, &mm->mmu_rd_mem);
 
@@ -571,6 +573,22 @@ static int nvgpu_init_mm_setup_sw(struct gk20a *g)
 		}
 	}
 
+	/*
+	 * The parallel PTE fill is opt-in per platform. Without it large
+	 * mappings are still filled in serially, so a failure to start the
+	 * pool is not fatal.
+	 */
+	if ((mm->pt_fill_workers != 0U) && (mm->pt_fill == NULL)) {
+		err = nvgpu_gmmu_pt_fill_init(g, mm->pt_fill_workers,
+				(mm->pt_fill_min_length != 0ULL) ?
+				mm->pt_fill_min_length :
+				NVGPU_GMMU_PT_FILL_DEFAULT_MIN_LENGTH);
+		if (err != 0) {
+			nvgpu_warn(g, "PTE fill pool not started: %d", err);
+			err = 0;
+		}
+	}
+
 	mm->remove_support = nvgpu_remove_mm_support;
 #ifdef CONFIG_NVGPU_DGPU
 	mm->remove_ce_support = nvgpu_remove_mm_ce_support;
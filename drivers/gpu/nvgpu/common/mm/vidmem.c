@@ -118,6 +118,118 @@ static int nvgpu_vidmem_clear_fence_wait(struct gk20a *g,
 	return 0;
 }
 
+/*
+ * Ranges of a clear not submitted to the CE yet. Physically contiguous chunks
+ * are merged into one range and up to NVGPU_CE_MAX_RANGES_PER_SUBMIT ranges
+ * go into one CE submit. Jobs of one CE context complete in order, so only
+ * the fence of the last submit has to be waited for.
+ */
+struct nvgpu_vidmem_clear_batch {
+	struct nvgpu_ce_range ranges[NVGPU_CE_MAX_RANGES_PER_SUBMIT];
+	u32 num_ranges;
+	struct nvgpu_fence_type *last_fence;
+};
+
+static int nvgpu_vidmem_clear_batch_submit(struct gk20a *g,
+		struct nvgpu_vidmem_clear_batch *batch)
+{
+	struct nvgpu_fence_type *fence_out = NULL;
+	int err;
+
+	if (batch->num_ranges == 0U) {
+		return 0;
+	}
+
+	err = nvgpu_ce_execute_memset_ranges(g,
+			g->mm.vidmem.ce_ctx_id,
+			batch->ranges,
+			batch->num_ranges,
+			0x00000000,
+			NVGPU_CE_DST_LOCATION_LOCAL_FB,
+			0,
+			&fence_out);
+	batch->num_ranges = 0U;
+	if (err != 0) {
+		nvgpu_err(g, "Failed nvgpu_ce_execute_memset_ranges[%d]", err);
+		return err;
+	}
+
+	if (batch->last_fence != NULL) {
+		nvgpu_fence_put(batch->last_fence);
+	}
+	batch->last_fence = fence_out;
+
+	return 0;
+}
+
+static int nvgpu_vidmem_clear_batch_add(struct gk20a *g,
+		struct nvgpu_vidmem_clear_batch *batch, u64 addr, u64 size)
+{
+	struct nvgpu_ce_range *last;
+	int err;
+
+	vidmem_dbg(g, "  > [0x%llx  +0x%llx]", addr, size);
+
+	if (batch->num_ranges != 0U) {
+		last = &batch->ranges[batch->num_ranges - 1U];
+		if (nvgpu_safe_add_u64(last->dst_paddr, last->size) == addr) {
+			last->size = nvgpu_safe_add_u64(last->size, size);
+			return 0;
+		}
+	}
+
+	if (batch->num_ranges == NVGPU_CE_MAX_RANGES_PER_SUBMIT) {
+		err = nvgpu_vidmem_clear_batch_submit(g, batch);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	batch->ranges[batch->num_ranges].dst_paddr = addr;
+	batch->ranges[batch->num_ranges].size = size;
+	batch->num_ranges++;
+
+	return 0;
+}
+
+static int nvgpu_vidmem_clear_batch_add_mem(struct gk20a *g,
+		struct nvgpu_vidmem_clear_batch *batch, struct nvgpu_mem *mem)
+{
+	struct nvgpu_page_alloc *alloc = mem->vidmem_alloc;
+	void *sgl = NULL;
+	int err;
+
+	nvgpu_sgt_for_each_sgl(sgl, &alloc->sgt) {
+		err = nvgpu_vidmem_clear_batch_add(g, batch,
+				nvgpu_sgt_get_phys(g, &alloc->sgt, sgl),
+				nvgpu_sgt_get_length(&alloc->sgt, sgl));
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Submit what is left of the batch and wait for all of it to complete. The
+ * fence of earlier submits is waited for even if the last submit failed.
+ */
+static int nvgpu_vidmem_clear_batch_finish(struct gk20a *g,
+		struct nvgpu_vidmem_clear_batch *batch)
+{
+	int err, wait_err = 0;
+
+	err = nvgpu_vidmem_clear_batch_submit(g, batch);
+
+	if (batch->last_fence != NULL) {
+		wait_err = nvgpu_vidmem_clear_fence_wait(g, batch->last_fence);
+		batch->last_fence = NULL;
+	}
+
+	return (err != 0) ? err : wait_err;
+}
+
 static int nvgpu_vidmem_do_clear_all(struct gk20a *g)
 {
 	struct mm_gk20a *mm = &g->mm;
@@ -165,6 +277,28 @@ static int nvgpu_vidmem_do_clear_all(struct gk20a *g)
 	return 0;
 }
 
+static int nvgpu_vidmem_clear_all(struct gk20a *g)
+{
+	int err;
+
+	if (g->mm.vidmem.cleared) {
+		return 0;
+	}
+
+	nvgpu_mutex_acquire(&g->mm.vidmem.first_clear_mutex);
+	if (!g->mm.vidmem.cleared) {
+		err = nvgpu_vidmem_do_clear_all(g);
+		if (err != 0) {
+			nvgpu_mutex_release(&g->mm.vidmem.first_clear_mutex);
+			nvgpu_err(g, "failed to clear whole vidmem");
+			return err;
+		}
+	}
+	nvgpu_mutex_release(&g->mm.vidmem.first_clear_mutex);
+
+	return 0;
+}
+
 void nvgpu_vidmem_thread_pause_sync(struct mm_gk20a *mm)
 {
 	/*
@@ -199,6 +333,10 @@ void nvgpu_vidmem_thread_unpause(struct mm_gk20a *mm)
 	if (nvgpu_atomic_dec_return(&mm->vidmem.pause_count) == 0) {
 		nvgpu_mutex_release(&mm->vidmem.clearing_thread_lock);
 		vidmem_dbg(mm->g, "  > Clearing thread really unpaused!");
+
+		/* Pick up work queued while paused and the first clear */
+		nvgpu_cond_signal_interruptible(
+				&mm->vidmem.clearing_thread_cond);
 	}
 }
 
@@ -230,34 +368,55 @@ int nvgpu_vidmem_clear_list_enqueue(struct gk20a *g, struct nvgpu_mem *mem)
 	return 0;
 }
 
-static struct nvgpu_mem *nvgpu_vidmem_clear_list_dequeue(struct mm_gk20a *mm)
+/*
+ * Clear everything queued so far with as few CE submits as possible and a
+ * single fence wait, then hand all of it back to the allocator at once.
+ */
+static void nvgpu_vidmem_clear_pending_allocs(struct mm_gk20a *mm)
 {
-	struct nvgpu_mem *mem = NULL;
+	struct gk20a *g = mm->g;
+	struct nvgpu_vidmem_clear_batch batch = { };
+	struct nvgpu_list_node pending;
+	struct nvgpu_mem *mem;
+	int err = 0;
+
+	vidmem_dbg(g, "Running VIDMEM clearing thread:");
 
+	nvgpu_init_list_node(&pending);
 	nvgpu_mutex_acquire(&mm->vidmem.clear_list_mutex);
 	if (!nvgpu_list_empty(&mm->vidmem.clear_list_head)) {
-		mem = nvgpu_list_first_entry(&mm->vidmem.clear_list_head,
-				nvgpu_mem, clear_list_entry);
-		nvgpu_list_del(&mem->clear_list_entry);
+		nvgpu_list_replace_init(&mm->vidmem.clear_list_head, &pending);
 	}
 	nvgpu_mutex_release(&mm->vidmem.clear_list_mutex);
 
-	return mem;
-}
-
-static void nvgpu_vidmem_clear_pending_allocs(struct mm_gk20a *mm)
-{
-	struct gk20a *g = mm->g;
-	struct nvgpu_mem *mem;
-	int err;
-
-	vidmem_dbg(g, "Running VIDMEM clearing thread:");
+	if (nvgpu_list_empty(&pending)) {
+		return;
+	}
 
-	while ((mem = nvgpu_vidmem_clear_list_dequeue(mm)) != NULL) {
-		err = nvgpu_vidmem_clear(g, mem);
-		if (err != 0) {
-			nvgpu_err(g, "nvgpu_vidmem_clear() failed err=%d", err);
+	if (mm->vidmem.ce_ctx_id == NVGPU_CE_INVAL_CTX_ID) {
+		err = -EINVAL;
+	} else {
+		nvgpu_list_for_each_entry(mem, &pending, nvgpu_mem,
+					  clear_list_entry) {
+			err = nvgpu_vidmem_clear_batch_add_mem(g, &batch, mem);
+			if (err != 0) {
+				break;
+			}
 		}
+		if (err == 0) {
+			err = nvgpu_vidmem_clear_batch_finish(g, &batch);
+		} else {
+			(void) nvgpu_vidmem_clear_batch_finish(g, &batch);
+		}
+	}
+	if (err != 0) {
+		nvgpu_err(g, "vidmem clear failed err=%d", err);
+	}
+
+	while (!nvgpu_list_empty(&pending)) {
+		mem = nvgpu_list_first_entry(&pending, nvgpu_mem,
+					     clear_list_entry);
+		nvgpu_list_del(&mem->clear_list_entry);
 
 		WARN_ON(nvgpu_atomic64_sub_return((long)mem->aligned_size,
 					&g->mm.vidmem.bytes_pending) < 0);
@@ -271,6 +430,12 @@ static void nvgpu_vidmem_clear_pending_allocs(struct mm_gk20a *mm)
 	vidmem_dbg(g, "Done!");
 }
 
+static bool nvgpu_vidmem_scrub_pending(struct mm_gk20a *mm)
+{
+	return !mm->vidmem.cleared && !mm->vidmem.scrub_started &&
+		(mm->vidmem.ce_ctx_id != NVGPU_CE_INVAL_CTX_ID);
+}
+
 static int nvgpu_vidmem_clear_pending_allocs_thr(void *mm_ptr)
 {
 	struct mm_gk20a *mm = mm_ptr;
@@ -295,7 +460,8 @@ static int nvgpu_vidmem_clear_pending_allocs_thr(void *mm_ptr)
 				&mm->vidmem.clearing_thread_cond,
 				nvgpu_thread_should_stop(
 					&mm->vidmem.clearing_thread) ||
-				!nvgpu_list_empty(&mm->vidmem.clear_list_head),
+				!nvgpu_list_empty(&mm->vidmem.clear_list_head) ||
+				nvgpu_vidmem_scrub_pending(mm),
 				0U);
 		if (ret == -ERESTARTSYS) {
 			continue;
@@ -311,6 +477,18 @@ static int nvgpu_vidmem_clear_pending_allocs_thr(void *mm_ptr)
 			continue;
 		}
 
+		/*
+		 * Clear the whole VIDMEM as soon as there is a CE context for
+		 * it, so that the first user allocation does not have to. From
+		 * then on freed memory is only returned to the allocator once
+		 * it is cleared, so anything the allocator hands out is zero.
+		 */
+		if (nvgpu_vidmem_scrub_pending(mm)) {
+			mm->vidmem.scrub_started = true;
+			/* On failure the first user allocation retries it */
+			(void) nvgpu_vidmem_clear_all(mm->g);
+		}
+
 		nvgpu_vidmem_clear_pending_allocs(mm);
 
 		nvgpu_mutex_release(&mm->vidmem.clearing_thread_lock);
@@ -459,85 +637,26 @@ int nvgpu_vidmem_get_space(struct gk20a *g, u64 *space)
 
 int nvgpu_vidmem_clear(struct gk20a *g, struct nvgpu_mem *mem)
 {
-	struct nvgpu_fence_type *fence_out = NULL;
-	struct nvgpu_fence_type *last_fence = NULL;
-	struct nvgpu_page_alloc *alloc = NULL;
-	void *sgl = NULL;
-	int err = 0;
+	struct nvgpu_vidmem_clear_batch batch = { };
+	int err;
 
 	if (g->mm.vidmem.ce_ctx_id == NVGPU_CE_INVAL_CTX_ID) {
 		return -EINVAL;
 	}
 
-	alloc = mem->vidmem_alloc;
-
-	nvgpu_sgt_for_each_sgl(sgl, &alloc->sgt) {
-		if (last_fence != NULL) {
-			nvgpu_fence_put(last_fence);
-		}
-
-#ifdef CONFIG_NVGPU_DGPU
-		err = nvgpu_ce_execute_ops(g,
-			g->mm.vidmem.ce_ctx_id,
-			0,
-			nvgpu_sgt_get_phys(g, &alloc->sgt, sgl),
-			nvgpu_sgt_get_length(&alloc->sgt, sgl),
-			0x00000000,
-			NVGPU_CE_DST_LOCATION_LOCAL_FB,
-			NVGPU_CE_MEMSET,
-			0,
-			&fence_out);
-#else
-		/* fail due to lack of ce app support */
-		err = -ENOSYS;
-#endif
-
-		if (err != 0) {
-#ifdef CONFIG_NVGPU_DGPU
-			nvgpu_err(g,
-				"Failed nvgpu_ce_execute_ops[%d]", err);
-#endif
-			return err;
-		}
-
-		vidmem_dbg(g, "  > [0x%llx  +0x%llx]",
-			   nvgpu_sgt_get_phys(g, &alloc->sgt, sgl),
-			   nvgpu_sgt_get_length(&alloc->sgt, sgl));
-
-		last_fence = fence_out;
+	err = nvgpu_vidmem_clear_batch_add_mem(g, &batch, mem);
+	if (err != 0) {
+		(void) nvgpu_vidmem_clear_batch_finish(g, &batch);
+		return err;
 	}
 
-	if (last_fence != NULL) {
-		err = nvgpu_vidmem_clear_fence_wait(g, last_fence);
-		if (err != 0) {
-			return err;
-		}
+	err = nvgpu_vidmem_clear_batch_finish(g, &batch);
+	if (err != 0) {
+		return err;
 	}
 
 	vidmem_dbg(g, "  Done");
 
-	return err;
-}
-
-static int nvgpu_vidmem_clear_all(struct gk20a *g)
-{
-	int err;
-
-	if (g->mm.vidmem.cleared) {
-		return 0;
-	}
-
-	nvgpu_mutex_acquire(&g->mm.vidmem.first_clear_mutex);
-	if (!g->mm.vidmem.cleared) {
-		err = nvgpu_vidmem_do_clear_all(g);
-		if (err != 0) {
-			nvgpu_mutex_release(&g->mm.vidmem.first_clear_mutex);
-			nvgpu_err(g, "failed to clear whole vidmem");
-			return err;
-		}
-	}
-	nvgpu_mutex_release(&g->mm.vidmem.first_clear_mutex);
-
 	return 0;
 }
 
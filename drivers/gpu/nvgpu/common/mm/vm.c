@@ -704,6 +704,26 @@ clean_up_page_tables:
 	return err;
 }
 
+static void nvgpu_vm_init_pd_locks(struct vm_gk20a *vm)
+{
+	u32 i;
+
+	nvgpu_mutex_init(&vm->pd_lock);
+	for (i = 0U; i < NVGPU_VM_PD_SUBTREE_LOCKS; i++) {
+		nvgpu_mutex_init(&vm->pd_subtree_locks[i]);
+	}
+}
+
+static void nvgpu_vm_destroy_pd_locks(struct vm_gk20a *vm)
+{
+	u32 i;
+
+	for (i = 0U; i < NVGPU_VM_PD_SUBTREE_LOCKS; i++) {
+		nvgpu_mutex_destroy(&vm->pd_subtree_locks[i]);
+	}
+	nvgpu_mutex_destroy(&vm->pd_lock);
+}
+
 static int nvgpu_vm_init_attributes(struct mm_gk20a *mm,
 		     struct vm_gk20a *vm,
 		     u32 big_page_size,
@@ -822,6 +842,7 @@ int nvgpu_vm_do_init(struct mm_gk20a *mm,
 
 	nvgpu_mutex_init(&vm->syncpt_ro_map_lock);
 	nvgpu_mutex_init(&vm->update_gmmu_lock);
+	nvgpu_vm_init_pd_locks(vm);
 
 	nvgpu_ref_init(&vm->ref);
 	nvgpu_init_list_node(&vm->vm_area_list);
@@ -844,6 +865,7 @@ int nvgpu_vm_do_init(struct mm_gk20a *mm,
 
 #ifdef CONFIG_NVGPU_SW_SEMAPHORE
 clean_up_gmmu_lock:
+	nvgpu_vm_destroy_pd_locks(vm);
 	nvgpu_mutex_destroy(&vm->update_gmmu_lock);
 	nvgpu_mutex_destroy(&vm->syncpt_ro_map_lock);
 #endif
@@ -986,11 +1008,14 @@ static void nvgpu_vm_remove(struct vm_gk20a *vm)
 
 	nvgpu_vm_free_entries(vm, &vm->pdb);
 
+	nvgpu_big_free(g, vm->mapped_buf_hash);
+
 	if (g->ops.mm.vm_as_free_share != NULL) {
 		g->ops.mm.vm_as_free_share(vm);
 	}
 
 	nvgpu_mutex_release(&vm->update_gmmu_lock);
+	nvgpu_vm_destroy_pd_locks(vm);
 	nvgpu_mutex_destroy(&vm->update_gmmu_lock);
 
 	nvgpu_mutex_destroy(&vm->syncpt_ro_map_lock);
@@ -1020,6 +1045,67 @@ void nvgpu_vm_put(struct vm_gk20a *vm)
 	nvgpu_ref_put(&vm->ref, nvgpu_vm_remove_ref);
 }
 
+#define NVGPU_VM_MAPPED_BUF_HASH_MIN_SIZE	64U
+
+static u32 nvgpu_vm_mapped_buf_hash_bucket(u32 hash_size,
+					   const void *os_buf_id, s16 kind)
+{
+	/* OS buffer objects are at least 16 byte aligned */
+	u64 key = (u64)(uintptr_t)os_buf_id >> 4U;
+
+	key ^= (u64)(u16)kind << 48U;
+	key ^= key >> 17U;
+	key ^= key >> 31U;
+
+	return u64_lo32(key) & (hash_size - 1U);
+}
+
+static void nvgpu_vm_mapped_buf_hash_add(struct nvgpu_mapped_buf **hash,
+					 u32 hash_size,
+					 struct nvgpu_mapped_buf *mapped_buffer)
+{
+	u32 bucket = nvgpu_vm_mapped_buf_hash_bucket(hash_size,
+			mapped_buffer->os_buf_id, mapped_buffer->kind);
+
+	mapped_buffer->hash_next = hash[bucket];
+	hash[bucket] = mapped_buffer;
+}
+
+/*
+ * Rebuild the hash table from the rbtree with room for all mapped buffers. If
+ * the new table cannot be allocated the old one, if any, is kept: it is still
+ * complete, only with longer chains.
+ */
+static bool nvgpu_vm_mapped_buf_hash_resize(struct vm_gk20a *vm)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+	struct nvgpu_mapped_buf **hash;
+	struct nvgpu_rbtree_node *node = NULL;
+	u32 hash_size;
+
+	hash_size = (u32)roundup_pow_of_two(max(
+			nvgpu_safe_mult_u32(vm->num_user_mapped_buffers, 2U),
+			NVGPU_VM_MAPPED_BUF_HASH_MIN_SIZE));
+	hash = nvgpu_big_zalloc(g, nvgpu_safe_mult_u64(sizeof(*hash),
+			hash_size));
+	if (hash == NULL) {
+		return false;
+	}
+
+	nvgpu_rbtree_enum_start(0, &node, vm->mapped_buffers);
+	while (node != NULL) {
+		nvgpu_vm_mapped_buf_hash_add(hash, hash_size,
+				mapped_buffer_from_rbtree_node(node));
+		nvgpu_rbtree_enum_next(&node, node);
+	}
+
+	nvgpu_big_free(g, vm->mapped_buf_hash);
+	vm->mapped_buf_hash = hash;
+	vm->mapped_buf_hash_size = hash_size;
+
+	return true;
+}
+
 void nvgpu_insert_mapped_buf(struct vm_gk20a *vm,
 			    struct nvgpu_mapped_buf *mapped_buffer)
 {
@@ -1030,16 +1116,77 @@ void nvgpu_insert_mapped_buf(struct vm_gk20a *vm,
 	nvgpu_rbtree_insert(&mapped_buffer->node, &vm->mapped_buffers);
 	nvgpu_assert(vm->num_user_mapped_buffers < U32_MAX);
 	vm->num_user_mapped_buffers++;
+
+	/* a resize hashes everything in the rbtree, including this buffer */
+	if (vm->num_user_mapped_buffers > vm->mapped_buf_hash_size) {
+		if (nvgpu_vm_mapped_buf_hash_resize(vm)) {
+			return;
+		}
+	}
+
+	if (vm->mapped_buf_hash != NULL) {
+		nvgpu_vm_mapped_buf_hash_add(vm->mapped_buf_hash,
+				vm->mapped_buf_hash_size, mapped_buffer);
+	}
 }
 
 static void nvgpu_remove_mapped_buf(struct vm_gk20a *vm,
 				    struct nvgpu_mapped_buf *mapped_buffer)
 {
+	struct nvgpu_mapped_buf **link;
+	u32 bucket;
+
+	if (vm->mapped_buf_hash != NULL) {
+		bucket = nvgpu_vm_mapped_buf_hash_bucket(
+				vm->mapped_buf_hash_size,
+				mapped_buffer->os_buf_id, mapped_buffer->kind);
+		link = &vm->mapped_buf_hash[bucket];
+		while (*link != mapped_buffer) {
+			link = &(*link)->hash_next;
+		}
+		*link = mapped_buffer->hash_next;
+	}
+
 	nvgpu_rbtree_unlink(&mapped_buffer->node, &vm->mapped_buffers);
 	nvgpu_assert(vm->num_user_mapped_buffers > 0U);
 	vm->num_user_mapped_buffers--;
 }
 
+struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_reverse(
+	struct vm_gk20a *vm, struct nvgpu_os_buffer *os_buf, s16 kind)
+{
+	const void *os_buf_id = nvgpu_os_buf_get_id(os_buf);
+	struct nvgpu_mapped_buf *mapped_buffer;
+	struct nvgpu_rbtree_node *node = NULL;
+
+	if (vm->mapped_buf_hash != NULL) {
+		mapped_buffer = vm->mapped_buf_hash[
+			nvgpu_vm_mapped_buf_hash_bucket(
+				vm->mapped_buf_hash_size, os_buf_id, kind)];
+		while (mapped_buffer != NULL) {
+			if ((mapped_buffer->os_buf_id == os_buf_id) &&
+			    (mapped_buffer->kind == kind)) {
+				return mapped_buffer;
+			}
+			mapped_buffer = mapped_buffer->hash_next;
+		}
+
+		return NULL;
+	}
+
+	nvgpu_rbtree_enum_start(0, &node, vm->mapped_buffers);
+	while (node != NULL) {
+		mapped_buffer = mapped_buffer_from_rbtree_node(node);
+		if ((mapped_buffer->os_buf_id == os_buf_id) &&
+		    (mapped_buffer->kind == kind)) {
+			return mapped_buffer;
+		}
+		nvgpu_rbtree_enum_next(&node, node);
+	}
+
+	return NULL;
+}
+
 struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf(
 	struct vm_gk20a *vm, u64 addr)
 {
@@ -1471,8 +1618,10 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
 	struct nvgpu_ctag_buffer_info binfo = { };
 	enum gk20a_mem_rw_flag rw = buffer_rw_mode;
 	struct nvgpu_vm_area *vm_area = NULL;
+	struct nvgpu_mapped_buf *existing;
 	int err = 0;
 	bool va_allocated = true;
+	bool locked = false;
 
 	/*
 	 * The kind used as part of the key for map caching. HW may
@@ -1511,12 +1660,17 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
 		return 0;
 	}
 
-	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
-
 	/*
-	 * Check if we should use a fixed offset for mapping this buffer.
+	 * Check if we should use a fixed offset for mapping this buffer. Such
+	 * mappings go into a VM area, which must not go away underneath the
+	 * map, so they are done entirely under the update_gmmu_lock. Other
+	 * mappings get their VA and page tables set up without it and only
+	 * take it to be added to the mapped buffers.
 	 */
 	if ((flags & NVGPU_VM_MAP_FIXED_OFFSET) != 0U)  {
+		nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+		locked = true;
+
 		err = nvgpu_vm_area_validate_buffer(vm,
 						    map_addr,
 						    map_size,
@@ -1533,9 +1687,37 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
 				map_size, phys_offset, rw, flags, batch,
 				aperture, &binfo);
 	if (err != 0) {
+		if (!locked) {
+			goto clean_up_nolock;
+		}
 		goto clean_up;
 	}
 
+	if (!locked) {
+		nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+
+		/*
+		 * The lookup in nvgpu_vm_new_mapping() was done without
+		 * holding the lock across the map, so a concurrent map of the
+		 * same buffer may have won the race. Use its mapping and drop
+		 * this one, as if the first lookup had found it.
+		 */
+		existing = nvgpu_vm_find_mapping(vm, os_buf, map_addr,
+						 binfo.flags, map_key_kind);
+		if (existing != NULL) {
+			nvgpu_ref_get(&existing->ref);
+			nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+			g->ops.mm.gmmu.unmap(vm, map_addr, map_size,
+					     binfo.pgsz_idx, va_allocated,
+					     gk20a_mem_flag_none, false,
+					     batch);
+			nvgpu_kfree(g, mapped_buffer);
+			*mapped_buffer_arg = existing;
+			return 0;
+		}
+	}
+
 	nvgpu_init_list_node(&mapped_buffer->buffer_list);
 	nvgpu_ref_init(&mapped_buffer->ref);
 	mapped_buffer->addr         = map_addr;
@@ -1551,6 +1733,7 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
 #endif
 	mapped_buffer->rw_flag      = rw;
 	mapped_buffer->aperture     = aperture;
+	mapped_buffer->os_buf_id    = nvgpu_os_buf_get_id(os_buf);
 
 	nvgpu_insert_mapped_buf(vm, mapped_buffer);
 
@@ -1573,11 +1756,12 @@ clean_up_nolock:
 }
 
 /*
- * Really unmap. This does the real GMMU unmap and removes the mapping from the
- * VM map tracking tree (and vm_area list if necessary).
+ * GMMU unmap and free a mapped buffer that is no longer tracked by its VM. This
+ * does not need the update_gmmu_lock: nobody can look the buffer up anymore.
  */
-static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
-			      struct vm_gk20a_mapping_batch *batch)
+static void nvgpu_vm_do_unmap_untracked(struct nvgpu_mapped_buf *mapped_buffer,
+					bool sparse,
+					struct vm_gk20a_mapping_batch *batch)
 {
 	struct vm_gk20a *vm = mapped_buffer->vm;
 	struct gk20a *g = vm->mm->g;
@@ -1588,18 +1772,9 @@ static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
 			     mapped_buffer->pgsz_idx,
 			     mapped_buffer->va_allocated,
 			     gk20a_mem_flag_none,
-			     (mapped_buffer->vm_area != NULL) ?
-			     mapped_buffer->vm_area->sparse : false,
+			     sparse,
 			     batch);
 
-	/*
-	 * Remove from mapped buffer tree. Then delete the buffer from the
-	 * linked list of mapped buffers; though note: not all mapped buffers
-	 * are part of a vm_area.
-	 */
-	nvgpu_remove_mapped_buf(vm, mapped_buffer);
-	nvgpu_list_del(&mapped_buffer->buffer_list);
-
 	/*
 	 * OS specific freeing. This is after the generic freeing incase the
 	 * generic freeing relies on some component of the OS specific
@@ -1610,6 +1785,28 @@ static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
 	nvgpu_kfree(g, mapped_buffer);
 }
 
+/*
+ * Really unmap. This does the real GMMU unmap and removes the mapping from the
+ * VM map tracking tree (and vm_area list if necessary).
+ */
+static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
+			      struct vm_gk20a_mapping_batch *batch)
+{
+	struct vm_gk20a *vm = mapped_buffer->vm;
+	bool sparse = (mapped_buffer->vm_area != NULL) ?
+		mapped_buffer->vm_area->sparse : false;
+
+	/*
+	 * Remove from mapped buffer tree. Then delete the buffer from the
+	 * linked list of mapped buffers; though note: not all mapped buffers
+	 * are part of a vm_area.
+	 */
+	nvgpu_remove_mapped_buf(vm, mapped_buffer);
+	nvgpu_list_del(&mapped_buffer->buffer_list);
+
+	nvgpu_vm_do_unmap_untracked(mapped_buffer, sparse, batch);
+}
+
 static struct nvgpu_mapped_buf *nvgpu_mapped_buf_from_ref(struct nvgpu_ref *ref)
 {
 	return (struct nvgpu_mapped_buf *)
@@ -1691,12 +1888,28 @@ void nvgpu_vm_unmap(struct vm_gk20a *vm, u64 offset,
 	}
 
 	/*
-	 * Make sure we have access to the batch if we end up calling through to
-	 * the unmap_ref function.
+	 * Buffers in a VM area are unmapped under the lock so that the VM area
+	 * stays around. Make sure we have access to the batch if we end up
+	 * calling through to the unmap_ref function.
 	 */
-	vm->kref_put_batch = batch;
-	nvgpu_ref_put(&mapped_buffer->ref, nvgpu_vm_unmap_ref_internal);
-	vm->kref_put_batch = NULL;
+	if (mapped_buffer->vm_area != NULL) {
+		vm->kref_put_batch = batch;
+		nvgpu_ref_put(&mapped_buffer->ref, nvgpu_vm_unmap_ref_internal);
+		vm->kref_put_batch = NULL;
+		goto done;
+	}
+
+	/*
+	 * Others only get dropped from the mapped buffers under the lock; the
+	 * page table update runs concurrently with other maps and unmaps.
+	 */
+	if (nvgpu_ref_put_return(&mapped_buffer->ref, NULL) != 0) {
+		nvgpu_remove_mapped_buf(vm, mapped_buffer);
+		nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+		nvgpu_vm_do_unmap_untracked(mapped_buffer, false, batch);
+		return;
+	}
 
 done:
 	nvgpu_mutex_release(&vm->update_gmmu_lock);
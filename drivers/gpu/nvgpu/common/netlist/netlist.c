@@ -32,6 +32,7 @@
 #include <nvgpu/string.h>
 #include <nvgpu/netlist_defs.h>
 #include <nvgpu/static_analysis.h>
+#include <nvgpu/boot_cache.h>
 
 #include "netlist_priv.h"
 
@@ -571,14 +572,219 @@ static bool nvgpu_netlist_is_valid(int net, u32 major_v, u32 major_v_hw)
 	return true;
 }
 
+static void nvgpu_netlist_free_lists(struct gk20a *g,
+			struct nvgpu_netlist_vars *netlist_vars)
+{
+	nvgpu_kfree(g, netlist_vars->ucode.fecs.inst.l);
+	nvgpu_kfree(g, netlist_vars->ucode.fecs.data.l);
+	nvgpu_kfree(g, netlist_vars->ucode.gpccs.inst.l);
+	nvgpu_kfree(g, netlist_vars->ucode.gpccs.data.l);
+	nvgpu_kfree(g, netlist_vars->sw_bundle_init.l);
+	nvgpu_kfree(g, netlist_vars->sw_bundle64_init.l);
+	nvgpu_kfree(g, netlist_vars->sw_veid_bundle_init.l);
+	nvgpu_kfree(g, netlist_vars->sw_method_init.l);
+	nvgpu_kfree(g, netlist_vars->sw_ctx_load.l);
+	nvgpu_kfree(g, netlist_vars->sw_non_ctx_load.l);
+#if defined(CONFIG_NVGPU_NON_FUSA)
+	nvgpu_kfree(g, netlist_vars->sw_non_ctx_local_compute_load.l);
+	nvgpu_kfree(g, netlist_vars->sw_non_ctx_global_compute_load.l);
+#ifdef CONFIG_NVGPU_GRAPHICS
+	nvgpu_kfree(g, netlist_vars->sw_non_ctx_local_gfx_load.l);
+	nvgpu_kfree(g, netlist_vars->sw_non_ctx_global_gfx_load.l);
+#endif
+#endif
+#ifdef CONFIG_NVGPU_DEBUGGER
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc.l);
+#ifdef CONFIG_NVGPU_GRAPHICS
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.zcull_gpc.l);
+#endif
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_sys.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_gpc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_tpc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ppc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.fbp.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_gpc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.fbp_router.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_router.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ltc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_fbpa.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys_router.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_pma.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_rop.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ucgpc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc.l);
+
+#if defined(CONFIG_NVGPU_NON_FUSA)
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys_compute.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_compute.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc_compute.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc_compute.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc_compute.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.lts_bc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.lts_uc.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys_gfx.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_gfx.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc_gfx.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc_gfx.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc_gfx.l);
+#endif
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_cau.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys_control.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_fbp_control.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_gpc_control.l);
+	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_pma_control.l);
+#endif /* CONFIG_NVGPU_DEBUGGER */
+}
+
+static int nvgpu_netlist_parse_image(struct gk20a *g,
+			struct netlist_image *netlist, u32 *major_v,
+			struct nvgpu_netlist_vars *netlist_vars)
+{
+	u32 i, netlist_num;
+	int err = 0;
+
+	for (i = 0; i < netlist->header.regions; i++) {
+		u8 *src = ((u8 *)netlist + netlist->regions[i].data_offset);
+		u32 size = netlist->regions[i].data_size;
+
+		err = nvgpu_netlist_handle_region_id(g,
+				netlist->regions[i].region_id,
+				src, size, major_v, &netlist_num,
+				netlist_vars);
+		if (err != 0) {
+			break;
+		}
+	}
+
+	return err;
+}
+
+/*
+ * A cached image comes from outside the driver, so unlike the firmware files
+ * make sure all regions lie within it before parsing.
+ */
+static bool nvgpu_netlist_image_in_bounds(const u8 *image, u32 size)
+{
+	const struct netlist_image *netlist =
+		(const struct netlist_image *)(uintptr_t)image;
+	u64 regions_end;
+	u32 i;
+
+	if (size < sizeof(struct netlist_image_header)) {
+		return false;
+	}
+
+	regions_end = (u64)sizeof(struct netlist_image_header) +
+		((u64)netlist->header.regions * sizeof(struct netlist_region));
+	if (regions_end > (u64)size) {
+		return false;
+	}
+
+	for (i = 0; i < netlist->header.regions; i++) {
+		if (((u64)netlist->regions[i].data_offset +
+		     (u64)netlist->regions[i].data_size) > (u64)size) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * A cached netlist image is only used while the firmware file it was read
+ * from is unchanged. Without the file the cached image is the only copy.
+ */
+static bool nvgpu_netlist_cached_fw_matches(struct gk20a *g, int net)
+{
+	struct nvgpu_firmware *netlist_fw;
+	char name[MAX_NETLIST_NAME];
+	bool match;
+
+	if (g->ops.netlist.get_netlist_name(g, net, name) != 0) {
+		return false;
+	}
+
+	netlist_fw = nvgpu_request_firmware(g, name, 0);
+	if (netlist_fw == NULL) {
+		nvgpu_log_info(g, "no %s, using the cached netlist", name);
+		return true;
+	}
+
+	match = (netlist_fw->size <= (size_t)U32_MAX) &&
+		nvgpu_boot_cache_check_netlist(g, netlist_fw->data,
+				(u32)netlist_fw->size);
+	nvgpu_release_firmware(g, netlist_fw);
+
+	return match;
+}
+
+/*
+ * Try the netlist image kept in the boot cache. The image is checked against
+ * the HW the same way as one read from the firmware files.
+ */
+static bool nvgpu_netlist_init_ctx_vars_cached(struct gk20a *g,
+			bool fw_defined, u32 major_v_hw)
+{
+	struct nvgpu_netlist_vars *netlist_vars = g->netlist_vars;
+	u32 major_v = ~U32(0U);
+	bool loaded = false;
+	u8 *image;
+	u32 size = 0U;
+	int net = 0;
+	int err;
+
+	image = nvgpu_boot_cache_get_netlist(g, &net, &size);
+	if (image == NULL) {
+		return false;
+	}
+
+	if ((net == NETLIST_FINAL) != fw_defined) {
+		nvgpu_log_info(g, "cached netlist %d not for this HW", net);
+		goto done;
+	}
+
+	if (!nvgpu_netlist_image_in_bounds(image, size)) {
+		nvgpu_warn(g, "cached netlist is malformed");
+		goto done;
+	}
+
+	if (!nvgpu_netlist_cached_fw_matches(g, net)) {
+		goto done;
+	}
+
+	err = nvgpu_netlist_parse_image(g,
+			(struct netlist_image *)(uintptr_t)image,
+			&major_v, netlist_vars);
+	if ((err == 0) && nvgpu_netlist_is_valid(net, major_v, major_v_hw)) {
+		nvgpu_log_info(g, "cached netlist image %d loaded", net);
+		g->netlist_valid = true;
+		loaded = true;
+		goto done;
+	}
+
+	nvgpu_log_info(g, "cached netlist %d not usable: major_v 0x%08x hw 0x%08x",
+		net, major_v, major_v_hw);
+	nvgpu_netlist_free_lists(g, netlist_vars);
+	(void)memset(netlist_vars, 0, sizeof(*netlist_vars));
+
+done:
+	nvgpu_vfree(g, image);
+	return loaded;
+}
+
 static int nvgpu_netlist_init_ctx_vars_fw(struct gk20a *g)
 {
 	struct nvgpu_netlist_vars *netlist_vars = g->netlist_vars;
 	struct nvgpu_firmware *netlist_fw;
 	struct netlist_image *netlist = NULL;
 	char name[MAX_NETLIST_NAME];
-	u32 i, major_v = ~U32(0U), major_v_hw, netlist_num;
+	u32 major_v = ~U32(0U), major_v_hw;
 	int net, max_netlist_num, err = -ENOENT;
+	bool dynamic, cached;
 
 	nvgpu_log_fn(g, " ");
 
@@ -586,13 +792,19 @@ static int nvgpu_netlist_init_ctx_vars_fw(struct gk20a *g)
 		net = NETLIST_FINAL;
 		max_netlist_num = 0;
 		major_v_hw = ~U32(0U);
-		netlist_vars->dynamic = false;
+		dynamic = false;
 	} else {
 		net = NETLIST_SLOT_A;
 		max_netlist_num = MAX_NETLIST;
 		major_v_hw =
 		g->ops.gr.falcon.get_fecs_ctx_state_store_major_rev_id(g);
-		netlist_vars->dynamic = true;
+		dynamic = true;
+	}
+
+	cached = nvgpu_netlist_init_ctx_vars_cached(g, !dynamic, major_v_hw);
+	netlist_vars->dynamic = dynamic;
+	if (cached) {
+		return 0;
 	}
 
 	for (; net < max_netlist_num; net++) {
@@ -609,17 +821,10 @@ static int nvgpu_netlist_init_ctx_vars_fw(struct gk20a *g)
 
 		netlist = (struct netlist_image *)(uintptr_t)netlist_fw->data;
 
-		for (i = 0; i < netlist->header.regions; i++) {
-			u8 *src = ((u8 *)netlist + netlist->regions[i].data_offset);
-			u32 size = netlist->regions[i].data_size;
-
-			 err = nvgpu_netlist_handle_region_id(g,
-					netlist->regions[i].region_id,
-					src, size, &major_v, &netlist_num,
-					netlist_vars);
-			if (err != 0) {
-				goto clean_up;
-			}
+		err = nvgpu_netlist_parse_image(g, netlist, &major_v,
+				netlist_vars);
+		if (err != 0) {
+			goto clean_up;
 		}
 
 		if (!nvgpu_netlist_is_valid(net, major_v, major_v_hw)) {
@@ -630,74 +835,18 @@ static int nvgpu_netlist_init_ctx_vars_fw(struct gk20a *g)
 
 		g->netlist_valid = true;
 
+		if (netlist_fw->size <= (size_t)U32_MAX) {
+			nvgpu_boot_cache_set_netlist(g, net, netlist_fw->data,
+					(u32)netlist_fw->size);
+		}
+
 		nvgpu_release_firmware(g, netlist_fw);
 		nvgpu_log_fn(g, "done");
 		goto done;
 
 clean_up:
 		g->netlist_valid = false;
-		nvgpu_kfree(g, netlist_vars->ucode.fecs.inst.l);
-		nvgpu_kfree(g, netlist_vars->ucode.fecs.data.l);
-		nvgpu_kfree(g, netlist_vars->ucode.gpccs.inst.l);
-		nvgpu_kfree(g, netlist_vars->ucode.gpccs.data.l);
-		nvgpu_kfree(g, netlist_vars->sw_bundle_init.l);
-		nvgpu_kfree(g, netlist_vars->sw_bundle64_init.l);
-		nvgpu_kfree(g, netlist_vars->sw_veid_bundle_init.l);
-		nvgpu_kfree(g, netlist_vars->sw_method_init.l);
-		nvgpu_kfree(g, netlist_vars->sw_ctx_load.l);
-		nvgpu_kfree(g, netlist_vars->sw_non_ctx_load.l);
-#if defined(CONFIG_NVGPU_NON_FUSA)
-		nvgpu_kfree(g, netlist_vars->sw_non_ctx_local_compute_load.l);
-		nvgpu_kfree(g, netlist_vars->sw_non_ctx_global_compute_load.l);
-#ifdef CONFIG_NVGPU_GRAPHICS
-		nvgpu_kfree(g, netlist_vars->sw_non_ctx_local_gfx_load.l);
-		nvgpu_kfree(g, netlist_vars->sw_non_ctx_global_gfx_load.l);
-#endif
-#endif
-#ifdef CONFIG_NVGPU_DEBUGGER
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc.l);
-#ifdef CONFIG_NVGPU_GRAPHICS
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.zcull_gpc.l);
-#endif
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_sys.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_gpc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_tpc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ppc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.fbp.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_gpc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.fbp_router.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_router.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ltc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_fbpa.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys_router.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_pma.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_rop.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ucgpc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc.l);
-#if defined(CONFIG_NVGPU_NON_FUSA)
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys_compute.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_compute.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc_compute.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc_compute.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc_compute.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.lts_bc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.lts_uc.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys_gfx.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_gfx.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc_gfx.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc_gfx.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc_gfx.l);
-#endif
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_cau.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys_control.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_fbp_control.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_gpc_control.l);
-		nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_pma_control.l);
-#endif /* CONFIG_NVGPU_DEBUGGER */
+		nvgpu_netlist_free_lists(g, netlist_vars);
 		nvgpu_release_firmware(g, netlist_fw);
 		err = -ENOENT;
 	}
@@ -755,69 +904,7 @@ void nvgpu_netlist_deinit_ctx_vars(struct gk20a *g)
 	}
 
 	g->netlist_valid = false;
-	nvgpu_kfree(g, netlist_vars->ucode.fecs.inst.l);
-	nvgpu_kfree(g, netlist_vars->ucode.fecs.data.l);
-	nvgpu_kfree(g, netlist_vars->ucode.gpccs.inst.l);
-	nvgpu_kfree(g, netlist_vars->ucode.gpccs.data.l);
-	nvgpu_kfree(g, netlist_vars->sw_bundle_init.l);
-	nvgpu_kfree(g, netlist_vars->sw_bundle64_init.l);
-	nvgpu_kfree(g, netlist_vars->sw_veid_bundle_init.l);
-	nvgpu_kfree(g, netlist_vars->sw_method_init.l);
-	nvgpu_kfree(g, netlist_vars->sw_ctx_load.l);
-	nvgpu_kfree(g, netlist_vars->sw_non_ctx_load.l);
-#if defined(CONFIG_NVGPU_NON_FUSA)
-	nvgpu_kfree(g, netlist_vars->sw_non_ctx_local_compute_load.l);
-	nvgpu_kfree(g, netlist_vars->sw_non_ctx_global_compute_load.l);
-#ifdef CONFIG_NVGPU_GRAPHICS
-	nvgpu_kfree(g, netlist_vars->sw_non_ctx_local_gfx_load.l);
-	nvgpu_kfree(g, netlist_vars->sw_non_ctx_global_gfx_load.l);
-#endif
-#endif
-#ifdef CONFIG_NVGPU_DEBUGGER
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc.l);
-#ifdef CONFIG_NVGPU_GRAPHICS
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.zcull_gpc.l);
-#endif
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_sys.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_gpc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_tpc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ppc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.fbp.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_gpc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.fbp_router.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_router.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ltc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_fbpa.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys_router.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_pma.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_rop.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_ucgpc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc.l);
-
-#if defined(CONFIG_NVGPU_NON_FUSA)
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys_compute.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_compute.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc_compute.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc_compute.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc_compute.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.lts_bc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.lts_uc.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.sys_gfx.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.gpc_gfx.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.tpc_gfx.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.ppc_gfx.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.etpc_gfx.l);
-#endif
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.pm_cau.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_sys_control.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_fbp_control.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_gpc_control.l);
-	nvgpu_kfree(g, netlist_vars->ctxsw_regs.perf_pma_control.l);
-#endif /* CONFIG_NVGPU_DEBUGGER */
+	nvgpu_netlist_free_lists(g, netlist_vars);
 
 	nvgpu_kfree(g, netlist_vars);
 	g->netlist_vars = NULL;
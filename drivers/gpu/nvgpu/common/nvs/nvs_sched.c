@@ -34,11 +34,7 @@ static struct nvs_sched_ops nvgpu_nvs_ops = {
 };
 
 /*
- * TODO: make use of worker items when
- * 1) the active domain gets modified
- *    - currently updates happen asynchronously elsewhere
- *    - either resubmit the domain or do the updates later
- * 2) recovery gets triggered
+ * TODO: make use of worker items when recovery gets triggered
  *    - currently it just locks all affected runlists
  *    - consider pausing the scheduler logic and signaling users
  */
@@ -65,10 +61,12 @@ static void nvgpu_nvs_worker_poll_init(struct nvgpu_worker *worker)
 	struct nvgpu_nvs_worker *nvs_worker =
 		nvgpu_nvs_worker_from_worker(worker);
 
-	/* 100 ms is a nice arbitrary timeout for default status */
-	nvs_worker->current_timeout = 100;
-	nvgpu_timeout_init_cpu_timer_sw(worker->g, &nvs_worker->timeout,
-			nvs_worker->current_timeout);
+	/*
+	 * Start idle; the domains that exist already are evaluated on the
+	 * first wakeup, which the pending event below guarantees.
+	 */
+	nvs_worker->current_timeout = 0U;
+	nvgpu_atomic_set(&nvs_worker->events, 1);
 }
 
 static u32 nvgpu_nvs_worker_wakeup_timeout(struct nvgpu_worker *worker)
@@ -76,9 +74,18 @@ static u32 nvgpu_nvs_worker_wakeup_timeout(struct nvgpu_worker *worker)
 	struct nvgpu_nvs_worker *nvs_worker =
 		nvgpu_nvs_worker_from_worker(worker);
 
+	/* 0 means no domain to rotate: sleep until the next event */
 	return nvs_worker->current_timeout;
 }
 
+static bool nvgpu_nvs_worker_wakeup_condition(struct nvgpu_worker *worker)
+{
+	struct nvgpu_nvs_worker *nvs_worker =
+		nvgpu_nvs_worker_from_worker(worker);
+
+	return nvgpu_atomic_read(&nvs_worker->events) != 0;
+}
+
 static void nvgpu_nvs_worker_wakeup_process_item(
 		struct nvgpu_list_node *work_item)
 {
@@ -88,34 +95,70 @@ static void nvgpu_nvs_worker_wakeup_process_item(
 	/* placeholder; never called yet */
 }
 
-static u64 nvgpu_nvs_tick(struct gk20a *g)
+/*
+ * A domain is runnable when its runlist domain has entries on any runlist.
+ * Returns the number of runnable domains.
+ */
+static u32 nvgpu_nvs_update_runnable_locked(struct gk20a *g, u64 now)
+{
+	struct nvs_sched *nvs = g->scheduler->sched;
+	struct nvs_domain *nvs_dom;
+	u32 runnable = 0U;
+
+	nvs_domain_for_each(nvs, nvs_dom) {
+		bool work = nvgpu_rl_domain_has_work(g, nvs_dom->name);
+
+		nvs_domain_set_runnable(nvs, nvs_dom, work, now);
+		if (work) {
+			runnable = nvgpu_safe_add_u32(runnable, 1U);
+		}
+	}
+
+	return runnable;
+}
+
+/*
+ * Returns the timeslice of the active domain in ns, or 0 if there is nothing
+ * to schedule. The algorithm picks the next domain only if rotate is set,
+ * i.e., when the timeslice of the current one has run out; events that arrive
+ * in the middle of a timeslice just reevaluate the idle state.
+ *
+ * Rotating domains only makes sense if there are at least two of them and
+ * some runlist domain has something to run; otherwise the scheduler can just
+ * stay where it is until the next event.
+ */
+static u64 nvgpu_nvs_tick(struct gk20a *g, bool rotate)
 {
 	struct nvgpu_nvs_scheduler *sched = g->scheduler;
-	struct nvgpu_nvs_domain *domain;
 	struct nvs_domain *nvs_domain;
-	u64 timeslice;
+	u64 timeslice = 0ULL;
+	u64 now = nvgpu_current_time_ns();
 
-	nvs_dbg(g, "nvs tick");
+	nvs_dbg(g, "nvs tick, rotate: %d", rotate ? 1 : 0);
 
 	nvgpu_mutex_acquire(&g->sched_mutex);
 
-	domain = sched->active_domain;
-
-	if (domain == NULL) {
-		/* nothing to schedule, TODO wait for an event instead */
-		nvgpu_mutex_release(&g->sched_mutex);
-		return 100 * NSEC_PER_MSEC;
+	if ((nvgpu_nvs_update_runnable_locked(g, now) == 0U) ||
+	    (sched->active_domain == NULL) ||
+	    (nvs_domain_count(sched->sched) <= 1U)) {
+		goto unlock;
 	}
 
-	nvs_domain = domain->parent->next;
-	if (nvs_domain == NULL) {
-		nvs_domain = g->scheduler->sched->domain_list->domains;
+	nvs_domain = sched->active_domain->parent;
+
+	if (rotate) {
+		nvs_domain = nvs_sched_schedule(sched->sched, now);
+		if (nvs_domain == NULL) {
+			goto unlock;
+		}
+
+		nvgpu_runlist_select_domain(g, nvs_domain->name);
+		sched->active_domain = nvs_domain->priv;
 	}
-	timeslice = nvs_domain->timeslice_ns;
 
-	nvgpu_runlist_tick(g);
-	sched->active_domain = nvs_domain->priv;
+	timeslice = nvs_domain->timeslice_ns;
 
+unlock:
 	nvgpu_mutex_release(&g->sched_mutex);
 
 	return timeslice;
@@ -126,22 +169,49 @@ static void nvgpu_nvs_worker_wakeup_post_process(struct nvgpu_worker *worker)
 	struct gk20a *g = worker->g;
 	struct nvgpu_nvs_worker *nvs_worker =
 		nvgpu_nvs_worker_from_worker(worker);
+	bool events = nvgpu_atomic_xchg(&nvs_worker->events, 0) != 0;
+	bool expired = (nvs_worker->current_timeout != 0U) &&
+		nvgpu_timeout_peek_expired(&nvs_worker->timeout);
+	u64 next_timeout_ns;
 
-	if (nvgpu_timeout_peek_expired(&nvs_worker->timeout)) {
-		u32 next_timeout_ns = nvgpu_nvs_tick(g);
+	if (!events && !expired) {
+		return;
+	}
 
-		if (next_timeout_ns != 0U) {
-			nvs_worker->current_timeout =
-				(next_timeout_ns + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
-		}
+	next_timeout_ns = nvgpu_nvs_tick(g, expired);
+
+	if (next_timeout_ns == 0ULL) {
+		nvs_worker->current_timeout = 0U;
+		return;
+	}
 
+	/* a running timeslice is not restarted by events */
+	if (expired || (nvs_worker->current_timeout == 0U)) {
+		nvs_worker->current_timeout = nvgpu_safe_cast_u64_to_u32(
+			(next_timeout_ns + NSEC_PER_MSEC - 1ULL) /
+			NSEC_PER_MSEC);
 		nvgpu_timeout_init_cpu_timer_sw(g, &nvs_worker->timeout,
 				nvs_worker->current_timeout);
 	}
 }
 
+void nvgpu_nvs_worker_notify(struct gk20a *g)
+{
+	struct nvgpu_nvs_worker *nvs_worker;
+
+	if (g->scheduler == NULL) {
+		return;
+	}
+
+	nvs_worker = &g->scheduler->worker;
+
+	nvgpu_atomic_set(&nvs_worker->events, 1);
+	nvgpu_cond_signal_interruptible(&nvs_worker->worker.wq);
+}
+
 static const struct nvgpu_worker_ops nvs_worker_ops = {
 	.pre_process = nvgpu_nvs_worker_poll_init,
+	.wakeup_condition = nvgpu_nvs_worker_wakeup_condition,
 	.wakeup_timeout = nvgpu_nvs_worker_wakeup_timeout,
 	.wakeup_process_item = nvgpu_nvs_worker_wakeup_process_item,
 	.wakeup_post_process = nvgpu_nvs_worker_wakeup_post_process,
@@ -333,6 +403,9 @@ int nvgpu_nvs_add_domain(struct gk20a *g, const char *name, u64 timeslice,
 	}
 
 	*pdomain = nvgpu_dom;
+
+	/* a second domain makes the worker start rotating */
+	nvgpu_nvs_worker_notify(g);
 unlock:
 	nvgpu_mutex_release(&g->sched_mutex);
 	return err;
@@ -474,11 +547,32 @@ int nvgpu_nvs_del_domain(struct gk20a *g, u64 dom_id)
 	nvs_domain_destroy(s->sched, nvs_dom);
 	nvgpu_kfree(g, nvgpu_dom);
 
+	nvgpu_nvs_worker_notify(g);
+
 unlock:
 	nvgpu_mutex_release(&g->sched_mutex);
 	return err;
 }
 
+int nvgpu_nvs_set_algo(struct gk20a *g, const char *name)
+{
+	const struct nvs_domain_algo *algo = nvs_algo_by_name(name);
+
+	if (algo == NULL) {
+		return -EINVAL;
+	}
+
+	nvgpu_mutex_acquire(&g->sched_mutex);
+	nvs_sched_set_algo(g->scheduler->sched, algo);
+	nvgpu_mutex_release(&g->sched_mutex);
+
+	nvs_dbg(g, "domain algorithm: %s", name);
+
+	nvgpu_nvs_worker_notify(g);
+
+	return 0;
+}
+
 u32 nvgpu_nvs_domain_count(struct gk20a *g)
 {
 	u32 count;
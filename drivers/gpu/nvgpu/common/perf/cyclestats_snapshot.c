@@ -139,6 +139,7 @@ int nvgpu_css_enable_snapshot(struct nvgpu_channel *ch,
 	data->hw_end = data->hw_snapshot +
 		snapshot_size / sizeof(struct gk20a_cs_snapshot_fifo_entry);
 	data->hw_get = data->hw_snapshot;
+	data->hw_scan = data->hw_snapshot;
 	(void) memset(data->hw_snapshot, 0xff, snapshot_size);
 
 	g->ops.perf.membuf_reset_streaming(g);
@@ -192,18 +193,162 @@ static void css_gr_free_shared_data(struct gk20a *g)
 
 
 struct gk20a_cs_snapshot_client *
-nvgpu_css_gr_search_client(struct nvgpu_list_node *clients, u32 perfmon)
+nvgpu_css_gr_find_client(struct gk20a_cs_snapshot *data, u32 perfmon)
 {
-	struct gk20a_cs_snapshot_client *client;
+	if (perfmon >= CSS_MAX_PERFMON_IDS) {
+		return NULL;
+	}
+
+	return data->perfmon_clients[perfmon];
+}
+
+static void css_gr_map_client(struct gk20a_cs_snapshot *data,
+				struct gk20a_cs_snapshot_client *client,
+				struct gk20a_cs_snapshot_client *owner)
+{
+	u32 i;
+
+	for (i = 0U; i < client->perfmon_count; i++) {
+		u32 pm = client->perfmon_start + i;
 
-	nvgpu_list_for_each_entry(client, clients,
-			gk20a_cs_snapshot_client,  list) {
-		if (CONTAINS_PERFMON(client, perfmon)) {
-			return client;
+		if (pm >= CSS_MAX_PERFMON_IDS) {
+			break;
 		}
+		data->perfmon_clients[pm] = owner;
+	}
+}
+
+/* number of entries from a to b in the HW ring */
+static u32 css_gr_hw_distance(struct gk20a_cs_snapshot *css,
+				struct gk20a_cs_snapshot_fifo_entry *a,
+				struct gk20a_cs_snapshot_fifo_entry *b)
+{
+	if (b >= a) {
+		return U32(b - a);
+	}
+
+	return U32((css->hw_end - a) + (b - css->hw_snapshot));
+}
+
+static struct gk20a_cs_snapshot_fifo_entry *css_gr_hw_advance(
+				struct gk20a_cs_snapshot *css,
+				struct gk20a_cs_snapshot_fifo_entry *e,
+				u32 count)
+{
+	u32 left = css_gr_hw_distance(css, e, css->hw_end);
+
+	if (count < left) {
+		return e + count;
+	}
+
+	return css->hw_snapshot + (count - left);
+}
+
+static u32 css_gr_hw_offset(struct gk20a_cs_snapshot *css,
+				struct gk20a_cs_snapshot_fifo_entry *e)
+{
+	return U32((size_t)(e - css->hw_snapshot) * sizeof(*e));
+}
+
+/*
+ * Number of entries a cursor client still has to read, or held + 1 for a
+ * cursor that does not point into the held entries.
+ */
+static u32 css_gr_cursor_lag(struct gk20a_cs_snapshot *css,
+				struct gk20a_cs_snapshot_client *client,
+				u32 held)
+{
+	u32 get = client->snapshot->get;
+	u32 hw_size = css_gr_hw_offset(css, css->hw_end);
+	u32 read;
+
+	if (get >= hw_size ||
+	    (get % U32(sizeof(struct gk20a_cs_snapshot_fifo_entry))) != 0U) {
+		return held + 1U;
 	}
 
-	return NULL;
+	read = css_gr_hw_distance(css, css->hw_get, CSS_FIFO_ENTRY(
+					css->hw_snapshot, get));
+	if (read > held) {
+		return held + 1U;
+	}
+
+	return held - read;
+}
+
+/*
+ * Hand the entries all cursor clients are done with back to HW. A client
+ * that lags by more than half the buffer loses its oldest entries so that
+ * it cannot stall the other clients into HW overflows.
+ */
+static void css_gr_release_hw_entries(struct gk20a *g,
+				struct gk20a_cs_snapshot *css)
+{
+	struct gk20a_cs_snapshot_client *cur;
+	struct gk20a_cs_snapshot_fifo_entry *end;
+	u32 held = css_gr_hw_distance(css, css->hw_get, css->hw_scan);
+	u32 max_held = css_gr_hw_distance(css, css->hw_snapshot,
+					  css->hw_end) / 2U;
+	u32 release = held;
+	u32 lag;
+
+	if (css->cursor_clients != 0U) {
+		nvgpu_list_for_each_entry(cur, &css->clients,
+				gk20a_cs_snapshot_client, list) {
+			if (!cur->hw_cursor || cur->snapshot == NULL) {
+				continue;
+			}
+
+			cur->snapshot->put = css_gr_hw_offset(css,
+							css->hw_scan);
+
+			lag = css_gr_cursor_lag(css, cur, held);
+			if (lag > held) {
+				/* bogus cursor, restart it at the newest data */
+				cur->snapshot->get = cur->snapshot->put;
+				cur->snapshot->sw_overflow_events_occured++;
+				continue;
+			}
+
+			if (lag > max_held) {
+				cur->snapshot->get = css_gr_hw_offset(css,
+					css_gr_hw_advance(css, css->hw_scan,
+						css_gr_hw_distance(css,
+							css->hw_snapshot,
+							css->hw_end) -
+						max_held));
+				cur->snapshot->sw_overflow_events_occured++;
+				nvgpu_warn(g, "cyclestats: perfmon %u cursor overflow",
+							cur->perfmon_start);
+				lag = max_held;
+			}
+
+			if (held - lag < release) {
+				release = held - lag;
+			}
+		}
+	}
+
+	if (release == 0U) {
+		return;
+	}
+
+	/* re-set HW buffer after processing taking wrapping into account */
+	end = css_gr_hw_advance(css, css->hw_get, release);
+	if (css->hw_get < end) {
+		(void) memset(css->hw_get, 0xff,
+			(size_t)(end - css->hw_get) * sizeof(*end));
+	} else {
+		(void) memset(css->hw_snapshot, 0xff,
+			(size_t)(end - css->hw_snapshot) * sizeof(*end));
+		(void) memset(css->hw_get, 0xff,
+			(size_t)(css->hw_end - css->hw_get) * sizeof(*end));
+	}
+	css->hw_get = end;
+
+	if (g->ops.css.set_handled_snapshots) {
+		g->ops.css.set_handled_snapshots(g, release);
+	}
 }
 
 static int css_gr_flush_snapshots(struct nvgpu_channel *ch)
@@ -211,7 +356,7 @@ static int css_gr_flush_snapshots(struct nvgpu_channel *ch)
 	struct gk20a *g = ch->g;
 	struct gk20a_cs_snapshot *css = g->cs_data;
 	struct gk20a_cs_snapshot_client *cur;
-	u32 pending, completed;
+	u32 pending, completed, held;
 	bool hw_overflow;
 	int err;
 
@@ -255,23 +400,29 @@ static int css_gr_flush_snapshots(struct nvgpu_channel *ch)
 		nvgpu_warn(g, "cyclestats: hardware overflow detected");
 	}
 
+	/* entries still held for cursor clients are pending for HW as well */
+	held = css_gr_hw_distance(css, css->hw_get, css->hw_scan);
+	pending = pending > held ? pending - held : 0U;
+
 	/* process all items in HW buffer */
 	sid = 0;
 	completed = 0;
 	cur = NULL;
 	dst = NULL;
 	dst_put = NULL;
-	src = css->hw_get;
+	src = css->hw_scan;
 
 	/* proceed all completed records */
 	while (sid < pending && 0 == src->zero0) {
 		/* we may have a new perfmon_id which required to */
 		/* switch to a new client -> let's forget current */
 		if (cur && !CONTAINS_PERFMON(cur, src->perfmon_id)) {
-			s64 tmp_ptr = (char *)dst_put - (char *)dst;
+			if (dst) {
+				s64 tmp_ptr = (char *)dst_put - (char *)dst;
 
-			nvgpu_assert(tmp_ptr < (s64)U32_MAX);
-			dst->put = U32(tmp_ptr);
+				nvgpu_assert(tmp_ptr < (s64)U32_MAX);
+				dst->put = U32(tmp_ptr);
+			}
 			dst = NULL;
 			cur = NULL;
 		}
@@ -280,9 +431,10 @@ static int css_gr_flush_snapshots(struct nvgpu_channel *ch)
 		/* the client selection rate depends from experiment  */
 		/* activity but on Android usually happened 1-2 times */
 		if (!cur) {
-			cur = nvgpu_css_gr_search_client(&css->clients,
-							src->perfmon_id);
-			if (cur) {
+			cur = nvgpu_css_gr_find_client(css, src->perfmon_id);
+			if (cur && cur->hw_cursor) {
+				/* read in place, nothing to copy */
+			} else if (cur) {
 				/* found - setup all required data */
 				dst = cur->snapshot;
 				dst_get = CSS_FIFO_ENTRY(dst, dst->get);
@@ -302,8 +454,10 @@ static int css_gr_flush_snapshots(struct nvgpu_channel *ch)
 			}
 		}
 
-		/* check for software overflows */
-		if (dst_nxt == dst_get) {
+		if (!dst) {
+			completed++;
+		} else if (dst_nxt == dst_get) {
+			/* check for software overflows */
 			/* no data copy, no pointer updates */
 			dst->sw_overflow_events_occured++;
 			nvgpu_warn(g, "cyclestats: perfmon %u soft overflow",
@@ -334,21 +488,8 @@ next_hw_fifo_entry:
 		dst->put = U32(tmp_ptr);
 	}
 
-	/* re-set HW buffer after processing taking wrapping into account */
-	if (css->hw_get < src) {
-		(void) memset(css->hw_get, 0xff,
-			(size_t)(src - css->hw_get) * sizeof(*src));
-	} else {
-		(void) memset(css->hw_snapshot, 0xff,
-			(size_t)(src - css->hw_snapshot) * sizeof(*src));
-		(void) memset(css->hw_get, 0xff,
-			(size_t)(css->hw_end - css->hw_get) * sizeof(*src));
-	}
-	g->cs_data->hw_get = src;
-
-	if (g->ops.css.set_handled_snapshots) {
-		g->ops.css.set_handled_snapshots(g, sid);
-	}
+	css->hw_scan = src;
+	css_gr_release_hw_entries(g, css);
 
 	if (completed != sid) {
 		/* not all entries proceed correctly. some of problems */
@@ -405,6 +546,15 @@ static int css_gr_free_client_data(struct gk20a *g,
 		nvgpu_list_del(&client->list);
 	}
 
+	if (client->perfmon_start < CSS_MAX_PERFMON_IDS &&
+	    data->perfmon_clients[client->perfmon_start] == client) {
+		css_gr_map_client(data, client, NULL);
+	}
+
+	if (client->hw_cursor && data->cursor_clients > 0U) {
+		data->cursor_clients--;
+	}
+
 	if (client->perfmon_start && client->perfmon_count
 					&& g->ops.css.release_perfmon_ids) {
 		if (client->perfmon_count != g->ops.css.release_perfmon_ids(data,
@@ -454,6 +604,9 @@ static int css_gr_create_client_data(struct gk20a *g,
 	}
 
 	nvgpu_list_add_tail(&cur->list, &data->clients);
+	if (cur->hw_cursor) {
+		data->cursor_clients++;
+	}
 
 	return 0;
 }
@@ -462,6 +615,7 @@ static int css_gr_create_client_data(struct gk20a *g,
 int nvgpu_css_attach(struct nvgpu_channel *ch,
 			u32 perfmon_count,
 			u32 *perfmon_start,
+			u32 flags,
 			struct gk20a_cs_snapshot_client *cs_client)
 {
 	int ret = 0;
@@ -479,6 +633,8 @@ int nvgpu_css_attach(struct nvgpu_channel *ch,
 
 	nvgpu_speculation_barrier();
 
+	cs_client->hw_cursor = (flags & NVGPU_CSS_ATTACH_HW_CURSOR) != 0U;
+
 	nvgpu_mutex_acquire(&g->cs_lock);
 
 	ret = css_gr_create_shared_data(g);
@@ -498,6 +654,26 @@ int nvgpu_css_attach(struct nvgpu_channel *ch,
 		goto failed;
 	}
 
+	if (cs_client->hw_cursor) {
+		struct gk20a_cs_snapshot *data = g->cs_data;
+
+		/* a cursor needs a header and a local HW buffer to point into */
+		if (cs_client->snapshot == NULL || data->hw_snapshot == NULL) {
+			ret = -EINVAL;
+			goto failed;
+		}
+
+		cs_client->snapshot->start = 0U;
+		cs_client->snapshot->end = css_gr_hw_offset(data,
+							data->hw_end);
+		cs_client->snapshot->put = css_gr_hw_offset(data,
+							data->hw_scan);
+		cs_client->snapshot->get = cs_client->snapshot->put;
+	}
+
+	/* perfmon IDs are final now, also in the virtual case */
+	css_gr_map_client(g->cs_data, cs_client, cs_client);
+
 	if (perfmon_start) {
 		*perfmon_start = cs_client->perfmon_start;
 	}
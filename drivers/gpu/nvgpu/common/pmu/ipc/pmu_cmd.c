@@ -637,16 +637,128 @@ exit:
 	return err;
 }
 
+int nvgpu_pmu_rpc_pool_init(struct gk20a *g, struct nvgpu_pmu *pmu)
+{
+	if (pmu->rpc_payload_cache != NULL) {
+		/* skip alloc/reinit for unrailgate sequence */
+		return 0;
+	}
+
+	pmu->rpc_payload_cache = nvgpu_kmem_cache_create(g,
+		sizeof(struct rpc_handler_payload) +
+		PMU_RPC_POOL_PAYLOAD_SIZE);
+	if (pmu->rpc_payload_cache == NULL) {
+		return -ENOMEM;
+	}
+
+	nvgpu_atomic_set(&pmu->rpc_in_flight, 0);
+
+	return 0;
+}
+
+void nvgpu_pmu_rpc_pool_deinit(struct gk20a *g, struct nvgpu_pmu *pmu)
+{
+	if (pmu->rpc_payload_cache == NULL) {
+		return;
+	}
+
+	/*
+	 * Payloads of async RPCs come from the cache and are written by the
+	 * RPC handler once the PMU responds, so drain them first. If some are
+	 * still outstanding, keep the cache rather than free it under them.
+	 */
+	if (nvgpu_atomic_read(&pmu->rpc_in_flight) != 0) {
+		(void) nvgpu_pmu_rpc_wait_idle(pmu, nvgpu_get_poll_timeout(g));
+	}
+
+	if (nvgpu_atomic_read(&pmu->rpc_in_flight) != 0) {
+		nvgpu_err(g, "%d async RPCs in flight, RPC payload cache kept",
+			nvgpu_atomic_read(&pmu->rpc_in_flight));
+		return;
+	}
+
+	nvgpu_kmem_cache_destroy(pmu->rpc_payload_cache);
+	pmu->rpc_payload_cache = NULL;
+}
+
+static struct rpc_handler_payload *pmu_rpc_payload_alloc(struct gk20a *g,
+	struct nvgpu_pmu *pmu, u16 size_rpc)
+{
+	size_t size = sizeof(struct rpc_handler_payload) + size_rpc;
+	struct rpc_handler_payload *rpc_payload = NULL;
+
+	if ((pmu->rpc_payload_cache != NULL) &&
+		(size_rpc <= PMU_RPC_POOL_PAYLOAD_SIZE)) {
+		rpc_payload = nvgpu_kmem_cache_alloc(pmu->rpc_payload_cache);
+		if (rpc_payload != NULL) {
+			(void) memset(rpc_payload, 0, size);
+			rpc_payload->is_pooled = true;
+		}
+	}
+
+	if (rpc_payload == NULL) {
+		rpc_payload = nvgpu_kzalloc(g, size);
+		if (rpc_payload == NULL) {
+			return NULL;
+		}
+	}
+
+	rpc_payload->rpc_buff = (u8 *)rpc_payload +
+		sizeof(struct rpc_handler_payload);
+
+	return rpc_payload;
+}
+
+void nvgpu_pmu_rpc_payload_free(struct gk20a *g,
+	struct rpc_handler_payload *rpc_payload)
+{
+	if (rpc_payload->is_pooled) {
+		nvgpu_kmem_cache_free(g->pmu->rpc_payload_cache, rpc_payload);
+	} else {
+		nvgpu_kfree(g, rpc_payload);
+	}
+}
+
+static int pmu_rpc_post(struct gk20a *g, struct nv_pmu_rpc_header *rpc,
+	u16 size_rpc, u16 size_scratch, pmu_callback callback,
+	struct rpc_handler_payload *rpc_payload)
+{
+	void *rpc_buff = rpc_payload->rpc_buff;
+	struct pmu_payload payload;
+	struct pmu_cmd cmd;
+	int status;
+
+	(void) memset(&cmd, 0, sizeof(struct pmu_cmd));
+	(void) memset(&payload, 0, sizeof(struct pmu_payload));
+
+	cmd.hdr.unit_id = rpc->unit_id;
+	cmd.hdr.size = (u8)(PMU_CMD_HDR_SIZE + sizeof(struct nv_pmu_rpc_cmd));
+	cmd.cmd.rpc.cmd_type = NV_PMU_RPC_CMD_ID;
+	cmd.cmd.rpc.flags = rpc->flags;
+
+	nvgpu_memcpy((u8 *)rpc_buff, (u8 *)rpc, size_rpc);
+	payload.rpc.prpc = rpc_buff;
+	payload.rpc.size_rpc = size_rpc;
+	payload.rpc.size_scratch = size_scratch;
+
+	status = nvgpu_pmu_cmd_post(g, &cmd, &payload,
+			PMU_COMMAND_QUEUE_LPQ, callback,
+			rpc_payload);
+	if (status != 0) {
+		nvgpu_err(g, "Failed to execute RPC status=0x%x, func=0x%x",
+				status, rpc->function);
+	}
+
+	return status;
+}
+
 int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 	u16 size_rpc, u16 size_scratch, pmu_callback caller_cb,
 	void *caller_cb_param, bool is_copy_back)
 {
 	struct gk20a *g = pmu->g;
-	struct pmu_cmd cmd;
-	struct pmu_payload payload;
 	struct rpc_handler_payload *rpc_payload = NULL;
 	pmu_callback callback = NULL;
-	void *rpc_buff = NULL;
 	int status = 0;
 
 	if (nvgpu_can_busy(g) == 0) {
@@ -660,15 +772,12 @@ int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 	}
 
 	if (caller_cb == NULL) {
-		rpc_payload = nvgpu_kzalloc(g,
-			sizeof(struct rpc_handler_payload) + size_rpc);
+		rpc_payload = pmu_rpc_payload_alloc(g, pmu, size_rpc);
 		if (rpc_payload == NULL) {
 			status = ENOMEM;
 			goto exit;
 		}
 
-		rpc_payload->rpc_buff = (u8 *)rpc_payload +
-			sizeof(struct rpc_handler_payload);
 		rpc_payload->is_mem_free_set =
 			is_copy_back ? false : true;
 
@@ -680,8 +789,7 @@ int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 			status = EINVAL;
 			goto exit;
 		}
-		rpc_payload = nvgpu_kzalloc(g,
-			sizeof(struct rpc_handler_payload));
+		rpc_payload = pmu_rpc_payload_alloc(g, pmu, 0U);
 		if (rpc_payload == NULL) {
 			status = ENOMEM;
 			goto exit;
@@ -692,26 +800,9 @@ int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 		WARN_ON(is_copy_back);
 	}
 
-	rpc_buff = rpc_payload->rpc_buff;
-	(void) memset(&cmd, 0, sizeof(struct pmu_cmd));
-	(void) memset(&payload, 0, sizeof(struct pmu_payload));
-
-	cmd.hdr.unit_id = rpc->unit_id;
-	cmd.hdr.size = (u8)(PMU_CMD_HDR_SIZE + sizeof(struct nv_pmu_rpc_cmd));
-	cmd.cmd.rpc.cmd_type = NV_PMU_RPC_CMD_ID;
-	cmd.cmd.rpc.flags = rpc->flags;
-
-	nvgpu_memcpy((u8 *)rpc_buff, (u8 *)rpc, size_rpc);
-	payload.rpc.prpc = rpc_buff;
-	payload.rpc.size_rpc = size_rpc;
-	payload.rpc.size_scratch = size_scratch;
-
-	status = nvgpu_pmu_cmd_post(g, &cmd, &payload,
-			PMU_COMMAND_QUEUE_LPQ, callback,
+	status = pmu_rpc_post(g, rpc, size_rpc, size_scratch, callback,
 			rpc_payload);
 	if (status != 0) {
-		nvgpu_err(g, "Failed to execute RPC status=0x%x, func=0x%x",
-				status, rpc->function);
 		goto cleanup;
 	}
 
@@ -730,15 +821,97 @@ int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 			goto cleanup;
 		}
 		/* copy back data to caller */
-		nvgpu_memcpy((u8 *)rpc, (u8 *)rpc_buff, size_rpc);
+		nvgpu_memcpy((u8 *)rpc, (u8 *)rpc_payload->rpc_buff,
+			size_rpc);
 		/* free allocated memory */
-		nvgpu_kfree(g, rpc_payload);
+		nvgpu_pmu_rpc_payload_free(g, rpc_payload);
 	}
 
 	return 0;
 
 cleanup:
-	nvgpu_kfree(g, rpc_payload);
+	nvgpu_pmu_rpc_payload_free(g, rpc_payload);
 exit:
 	return status;
 }
+
+int nvgpu_pmu_rpc_execute_async(struct nvgpu_pmu *pmu,
+	struct nv_pmu_rpc_header *rpc, u16 size_rpc, u16 size_scratch,
+	pmu_rpc_done_callback done, void *done_param)
+{
+	struct gk20a *g = pmu->g;
+	struct rpc_handler_payload *rpc_payload;
+	int status;
+
+	if (nvgpu_can_busy(g) == 0) {
+		/* dropped like nvgpu_pmu_rpc_execute(), but still completed */
+		if (done != NULL) {
+			done(g, rpc, done_param, -ENODEV);
+		}
+		return 0;
+	}
+
+	if (!nvgpu_pmu_get_fw_ready(g, pmu)) {
+		nvgpu_warn(g, "PMU is not ready to process RPC");
+		status = -EINVAL;
+		goto fail;
+	}
+
+	rpc_payload = pmu_rpc_payload_alloc(g, pmu, size_rpc);
+	if (rpc_payload == NULL) {
+		status = -ENOMEM;
+		goto fail;
+	}
+
+	rpc_payload->is_mem_free_set = true;
+	rpc_payload->is_async = true;
+	rpc_payload->done = done;
+	rpc_payload->done_param = done_param;
+
+	/* account before posting, the response may come in right away */
+	nvgpu_atomic_inc(&pmu->rpc_in_flight);
+
+	status = pmu_rpc_post(g, rpc, size_rpc, size_scratch,
+			nvgpu_pmu_rpc_handler, rpc_payload);
+	if (status != 0) {
+		nvgpu_atomic_dec(&pmu->rpc_in_flight);
+		nvgpu_pmu_rpc_payload_free(g, rpc_payload);
+		goto fail;
+	}
+
+	return 0;
+
+fail:
+	if (done != NULL) {
+		done(g, rpc, done_param, status);
+	}
+	return status;
+}
+
+int nvgpu_pmu_rpc_wait_idle(struct nvgpu_pmu *pmu, u32 timeout_ms)
+{
+	struct gk20a *g = pmu->g;
+	struct nvgpu_timeout timeout;
+	u32 delay = POLL_DELAY_MIN_US;
+
+	nvgpu_timeout_init_cpu_timer(g, &timeout, timeout_ms);
+
+	do {
+		if ((nvgpu_atomic_read(&pmu->rpc_in_flight) == 0) ||
+			(nvgpu_can_busy(g) == 0)) {
+			return 0;
+		}
+
+		if (g->ops.pmu.pmu_is_interrupted(pmu)) {
+			g->ops.pmu.pmu_isr(g);
+		}
+
+		nvgpu_usleep_range(delay, delay * 2U);
+		delay = min_t(u32, delay << 1, POLL_DELAY_MAX_US);
+	} while (nvgpu_timeout_expired(&timeout) == 0);
+
+	nvgpu_err(g, "%d async RPCs still in flight",
+		nvgpu_atomic_read(&pmu->rpc_in_flight));
+
+	return -ETIMEDOUT;
+}
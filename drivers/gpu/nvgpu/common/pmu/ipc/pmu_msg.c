@@ -611,11 +611,16 @@ void nvgpu_pmu_rpc_handler(struct gk20a *g, struct pmu_msg *msg,
 	struct nv_pmu_rpc_header rpc;
 	struct rpc_handler_payload *rpc_payload =
 		(struct rpc_handler_payload *)param;
-
-	(void)status;
+	bool is_async = rpc_payload->is_async;
+	int err = (int)status;
 
 	if (nvgpu_can_busy(g) == 0) {
-		return;
+		if (!is_async) {
+			return;
+		}
+		/* still complete async RPCs so they are not left in flight */
+		err = -ENODEV;
+		goto exit;
 	}
 
 	(void) memset(&rpc, 0, sizeof(struct nv_pmu_rpc_header));
@@ -626,6 +631,9 @@ void nvgpu_pmu_rpc_handler(struct gk20a *g, struct pmu_msg *msg,
 		nvgpu_err(g,
 			"failed RPC response, unit-id=0x%x, func=0x%x, status=0x%x",
 			rpc.unit_id, rpc.function, rpc.flcn_status);
+		if (err == 0) {
+			err = -EIO;
+		}
 		goto exit;
 	}
 
@@ -634,9 +642,19 @@ void nvgpu_pmu_rpc_handler(struct gk20a *g, struct pmu_msg *msg,
 exit:
 	rpc_payload->complete = true;
 
+	if (rpc_payload->done != NULL) {
+		rpc_payload->done(g,
+			(struct nv_pmu_rpc_header *)rpc_payload->rpc_buff,
+			rpc_payload->done_param, err);
+	}
+
 	/* free allocated memory */
 	if (rpc_payload->is_mem_free_set) {
-		nvgpu_kfree(g, rpc_payload);
+		nvgpu_pmu_rpc_payload_free(g, rpc_payload);
+	}
+
+	if (is_async) {
+		nvgpu_atomic_dec(&g->pmu->rpc_in_flight);
 	}
 }
 
@@ -43,6 +43,7 @@ void nvgpu_pmu_sequences_sw_setup(struct gk20a *g, struct nvgpu_pmu *pmu,
 		sizeof(struct pmu_sequence) * PMU_MAX_NUM_SEQUENCES);
 	(void) memset(sequences->pmu_seq_tbl, 0,
 		sizeof(sequences->pmu_seq_tbl));
+	sequences->next_seq_id = 0U;
 
 	for (i = 0; i < PMU_MAX_NUM_SEQUENCES; i++) {
 		sequences->seq[i].id = (u8)i;
@@ -80,7 +81,7 @@ int nvgpu_pmu_sequences_init(struct gk20a *g, struct nvgpu_pmu *pmu,
 		return -ENOMEM;
 	}
 
-	nvgpu_mutex_init(&sequences->pmu_seq_lock);
+	nvgpu_spinlock_init(&sequences->pmu_seq_lock);
 
 	*sequences_p = sequences;
 exit:
@@ -98,7 +99,6 @@ void nvgpu_pmu_sequences_deinit(struct gk20a *g, struct nvgpu_pmu *pmu,
 		return;
 	}
 
-	nvgpu_mutex_destroy(&sequences->pmu_seq_lock);
 	if (sequences->seq != NULL) {
 		nvgpu_kfree(g, sequences->seq);
 	}
@@ -124,17 +124,22 @@ int nvgpu_pmu_seq_acquire(struct gk20a *g,
 	struct pmu_sequence *seq;
 	unsigned long index;
 
-	nvgpu_mutex_acquire(&sequences->pmu_seq_lock);
-	index = find_first_zero_bit(sequences->pmu_seq_tbl,
-				sizeof(sequences->pmu_seq_tbl));
-	if (index >= sizeof(sequences->pmu_seq_tbl)) {
+	nvgpu_spinlock_acquire(&sequences->pmu_seq_lock);
+	index = find_next_zero_bit(sequences->pmu_seq_tbl,
+				PMU_MAX_NUM_SEQUENCES, sequences->next_seq_id);
+	if (index >= PMU_MAX_NUM_SEQUENCES) {
+		index = find_first_zero_bit(sequences->pmu_seq_tbl,
+				PMU_MAX_NUM_SEQUENCES);
+	}
+	if (index >= PMU_MAX_NUM_SEQUENCES) {
+		nvgpu_spinlock_release(&sequences->pmu_seq_lock);
 		nvgpu_err(g, "no free sequence available");
-		nvgpu_mutex_release(&sequences->pmu_seq_lock);
 		return -EAGAIN;
 	}
-	nvgpu_assert(index <= U32_MAX);
+	nvgpu_assert(index < PMU_MAX_NUM_SEQUENCES);
 	nvgpu_set_bit((u32)index, sequences->pmu_seq_tbl);
-	nvgpu_mutex_release(&sequences->pmu_seq_lock);
+	sequences->next_seq_id = ((u32)index + 1U) % PMU_MAX_NUM_SEQUENCES;
+	nvgpu_spinlock_release(&sequences->pmu_seq_lock);
 
 	seq = &sequences->seq[index];
 	seq->state = PMU_SEQ_STATE_PENDING;
@@ -159,9 +164,9 @@ void nvgpu_pmu_seq_release(struct gk20a *g,
 	seq->cb_params	= NULL;
 	seq->out_payload = NULL;
 
-	nvgpu_mutex_acquire(&sequences->pmu_seq_lock);
+	nvgpu_spinlock_acquire(&sequences->pmu_seq_lock);
 	nvgpu_clear_bit(seq->id, sequences->pmu_seq_tbl);
-	nvgpu_mutex_release(&sequences->pmu_seq_lock);
+	nvgpu_spinlock_release(&sequences->pmu_seq_lock);
 }
 
 u16 nvgpu_pmu_seq_get_fbq_out_offset(struct pmu_sequence *seq)
@@ -604,6 +604,17 @@ exit:
 	return 0;
 }
 
+static void pmu_perfmon_sampling_rpc_done(struct gk20a *g,
+	struct nv_pmu_rpc_header *rpc, void *param, int err)
+{
+	(void)param;
+
+	if (err != 0) {
+		nvgpu_err(g, "perfmon RPC func=0x%x failed, err=%d",
+			rpc->function, err);
+	}
+}
+
 int nvgpu_pmu_perfmon_start_sampling_rpc(struct nvgpu_pmu *pmu)
 {
 	struct gk20a *g = pmu->g;
@@ -626,11 +637,10 @@ int nvgpu_pmu_perfmon_start_sampling_rpc(struct nvgpu_pmu *pmu)
 	rpc.counter[0].upper_threshold = 3000;
 	rpc.counter[0].lower_threshold = 1000;
 
+	/* nothing waits for the reply, failures are reported by the callback */
 	nvgpu_pmu_dbg(g, "RPC post NV_PMU_RPC_ID_PERFMON_START\n");
-	PMU_RPC_EXECUTE(status, pmu, PERFMON_T18X, START, &rpc, 0);
-	if (status != 0) {
-		nvgpu_err(g, "Failed to execute RPC, status=0x%x", status);
-	}
+	PMU_RPC_EXECUTE_ASYNC(status, pmu, PERFMON_T18X, START, &rpc, 0,
+		pmu_perfmon_sampling_rpc_done, NULL);
 
 	return status;
 }
@@ -650,10 +660,8 @@ int nvgpu_pmu_perfmon_stop_sampling_rpc(struct nvgpu_pmu *pmu)
 	(void) memset(&rpc, 0, sizeof(struct nv_pmu_rpc_struct_perfmon_stop));
 	/* PERFMON Stop */
 	nvgpu_pmu_dbg(g, "RPC post NV_PMU_RPC_ID_PERFMON_STOP\n");
-	PMU_RPC_EXECUTE(status, pmu, PERFMON_T18X, STOP, &rpc, 0);
-	if (status != 0) {
-		nvgpu_err(g, "Failed to execute RPC, status=0x%x", status);
-	}
+	PMU_RPC_EXECUTE_ASYNC(status, pmu, PERFMON_T18X, STOP, &rpc, 0,
+		pmu_perfmon_sampling_rpc_done, NULL);
 
 	return status;
 }
@@ -112,6 +112,14 @@ int nvgpu_pmu_destroy(struct gk20a *g, struct nvgpu_pmu *pmu)
 	}
 #endif
 
+	/*
+	 * Let async RPCs complete while the PMU still runs. Whatever does not
+	 * complete now never will, as the PMU is reset before it is used again.
+	 */
+	if (nvgpu_pmu_rpc_wait_idle(pmu, nvgpu_get_poll_timeout(g)) != 0) {
+		nvgpu_atomic_set(&pmu->rpc_in_flight, 0);
+	}
+
 	nvgpu_pmu_queues_free(g, &pmu->queues);
 
 	/*
@@ -183,6 +191,7 @@ static void remove_pmu_support(struct nvgpu_pmu *pmu)
 	nvgpu_pmu_pg_deinit(g, pmu, pmu->pg);
 #endif
 	nvgpu_pmu_sequences_deinit(g, pmu, pmu->sequences);
+	nvgpu_pmu_rpc_pool_deinit(g, pmu);
 	nvgpu_pmu_mutexe_deinit(g, pmu, pmu->mutexes);
 	nvgpu_pmu_fw_deinit(g, pmu, pmu->fw);
 	nvgpu_pmu_deinitialize_perfmon(g, pmu);
@@ -519,6 +528,11 @@ int nvgpu_pmu_rtos_early_init(struct gk20a *g, struct nvgpu_pmu *pmu)
 		goto init_failed;
 	}
 
+	err = nvgpu_pmu_rpc_pool_init(g, pmu);
+	if (err != 0) {
+		goto init_failed;
+	}
+
 #ifdef CONFIG_NVGPU_POWER_PG
 	if (g->can_elpg) {
 		err = nvgpu_pmu_pg_init(g, pmu, &pmu->pg);
@@ -23,6 +23,7 @@
  */
 
 #include <nvgpu/log.h>
+#include <nvgpu/kmem.h>
 #include <nvgpu/bsearch.h>
 #include <nvgpu/bug.h>
 #include <nvgpu/io.h>
@@ -62,6 +63,161 @@ static inline bool linear_search(u32 offset, const u32 *list, u64 size)
 	return false;
 }
 
+/*
+ * The whitelists cover 24-bit 4-byte aligned offsets. Each leaf of the
+ * compiled allowlist holds 4 flag bits per register of a 16K window.
+ */
+#define REGOPS_ALLOWLIST_LIMIT		BIT32(24U)
+#define REGOPS_ALLOWLIST_LEAF_SHIFT	14U
+#define REGOPS_ALLOWLIST_NUM_LEAVES	\
+	(REGOPS_ALLOWLIST_LIMIT >> REGOPS_ALLOWLIST_LEAF_SHIFT)
+#define REGOPS_ALLOWLIST_LEAF_WORDS	\
+	(BIT32(REGOPS_ALLOWLIST_LEAF_SHIFT) / 4U / 8U)
+
+#define REGOPS_ALLOWLIST_GLOBAL		BIT32(0U)
+#define REGOPS_ALLOWLIST_CONTEXT	BIT32(1U)
+#define REGOPS_ALLOWLIST_RUNCONTROL	BIT32(2U)
+
+struct nvgpu_regops_allowlist {
+	u32 *leaf[REGOPS_ALLOWLIST_NUM_LEAVES];
+};
+
+static int regops_allowlist_set(struct gk20a *g,
+		struct nvgpu_regops_allowlist *al, u32 offset, u32 flag)
+{
+	u32 idx = offset >> REGOPS_ALLOWLIST_LEAF_SHIFT;
+	u32 reg;
+
+	/* such offsets never pass validate_reg_op_offset() */
+	if (((offset & 3U) != 0U) || (offset >= REGOPS_ALLOWLIST_LIMIT)) {
+		return 0;
+	}
+
+	if (al->leaf[idx] == NULL) {
+		al->leaf[idx] = nvgpu_kzalloc(g,
+			REGOPS_ALLOWLIST_LEAF_WORDS * sizeof(u32));
+		if (al->leaf[idx] == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	reg = (offset & (BIT32(REGOPS_ALLOWLIST_LEAF_SHIFT) - 1U)) >> 2U;
+	al->leaf[idx][reg >> 3U] |= flag << ((reg & 7U) << 2U);
+
+	return 0;
+}
+
+static u32 regops_allowlist_get(const struct nvgpu_regops_allowlist *al,
+		u32 offset)
+{
+	const u32 *leaf = al->leaf[offset >> REGOPS_ALLOWLIST_LEAF_SHIFT];
+	u32 reg;
+
+	if (leaf == NULL) {
+		return 0U;
+	}
+
+	reg = (offset & (BIT32(REGOPS_ALLOWLIST_LEAF_SHIFT) - 1U)) >> 2U;
+	return (leaf[reg >> 3U] >> ((reg & 7U) << 2U)) & 0xfU;
+}
+
+static int regops_allowlist_add_ranges(struct gk20a *g,
+		struct nvgpu_regops_allowlist *al,
+		const struct regop_offset_range *ranges, u64 count, u32 flag)
+{
+	u64 i;
+	u32 j;
+	int err;
+
+	for (i = 0ULL; i < count; i++) {
+		for (j = 0U; j < U32(ranges[i].count); j++) {
+			err = regops_allowlist_set(g, al,
+				nvgpu_safe_add_u32(U32(ranges[i].base),
+					nvgpu_safe_mult_u32(j, 4U)), flag);
+			if (err != 0) {
+				return err;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void nvgpu_regops_allowlist_deinit(struct gk20a *g)
+{
+	struct nvgpu_regops_allowlist *al = g->regops_allowlist;
+	u32 i;
+
+	if (al == NULL) {
+		return;
+	}
+
+	for (i = 0U; i < REGOPS_ALLOWLIST_NUM_LEAVES; i++) {
+		nvgpu_kfree(g, al->leaf[i]);
+	}
+	nvgpu_kfree(g, al);
+	g->regops_allowlist = NULL;
+}
+
+void nvgpu_regops_allowlist_init(struct gk20a *g)
+{
+	struct nvgpu_regops_allowlist *al;
+	const u32 *runcontrol;
+	u64 i;
+	int err = 0;
+
+	/* the whitelists are static, so this survives railgating */
+	if (g->regops_allowlist != NULL) {
+		return;
+	}
+
+	al = nvgpu_kzalloc(g, sizeof(*al));
+	if (al == NULL) {
+		err = -ENOMEM;
+		goto fail;
+	}
+	g->regops_allowlist = al;
+
+	if (g->ops.regops.get_global_whitelist_ranges != NULL) {
+		err = regops_allowlist_add_ranges(g, al,
+			g->ops.regops.get_global_whitelist_ranges(),
+			g->ops.regops.get_global_whitelist_ranges_count(),
+			REGOPS_ALLOWLIST_GLOBAL);
+		if (err != 0) {
+			goto fail;
+		}
+	}
+
+	if (g->ops.regops.get_context_whitelist_ranges != NULL) {
+		err = regops_allowlist_add_ranges(g, al,
+			g->ops.regops.get_context_whitelist_ranges(),
+			g->ops.regops.get_context_whitelist_ranges_count(),
+			REGOPS_ALLOWLIST_CONTEXT);
+		if (err != 0) {
+			goto fail;
+		}
+	}
+
+	if (g->ops.regops.get_runcontrol_whitelist != NULL) {
+		runcontrol = g->ops.regops.get_runcontrol_whitelist();
+		for (i = 0ULL;
+		     i < g->ops.regops.get_runcontrol_whitelist_count(); i++) {
+			err = regops_allowlist_set(g, al, runcontrol[i],
+				REGOPS_ALLOWLIST_RUNCONTROL);
+			if (err != 0) {
+				goto fail;
+			}
+		}
+	}
+
+	return;
+
+fail:
+	/* not fatal, the lookups fall back to searching the whitelists */
+	nvgpu_err(g, "failed to compile regops whitelists, err=%d", err);
+	nvgpu_regops_allowlist_deinit(g);
+}
+
 /*
  * In order to perform a context relative op the context has
  * to be created already... which would imply that the
@@ -471,14 +627,31 @@ static int validate_reg_op_info(struct nvgpu_dbg_reg_op *op)
 	return err;
 }
 
-static bool check_whitelists(struct gk20a *g,
-			     struct nvgpu_dbg_reg_op *op,
-			     u32 offset,
-			     bool valid_ctx)
+bool nvgpu_regops_offset_whitelisted(struct gk20a *g, u8 type, u32 offset,
+				     bool valid_ctx)
 {
 	bool valid = false;
+	u32 flags;
+
+	if ((g->regops_allowlist != NULL) &&
+	    (offset < REGOPS_ALLOWLIST_LIMIT)) {
+		flags = regops_allowlist_get(g->regops_allowlist, offset);
+
+		if (type == REGOP(TYPE_GLOBAL)) {
+			valid = ((flags & REGOPS_ALLOWLIST_GLOBAL) != 0U) ||
+				(valid_ctx &&
+				 ((flags & (REGOPS_ALLOWLIST_CONTEXT |
+					    REGOPS_ALLOWLIST_RUNCONTROL)) != 0U));
+		} else if (type == REGOP(TYPE_GR_CTX)) {
+			valid = ((flags & REGOPS_ALLOWLIST_CONTEXT) != 0U) ||
+				(valid_ctx &&
+				 ((flags & REGOPS_ALLOWLIST_RUNCONTROL) != 0U));
+		}
+
+		return valid;
+	}
 
-	if (op->type == REGOP(TYPE_GLOBAL)) {
+	if (type == REGOP(TYPE_GLOBAL)) {
 		/* search global list */
 		valid = (g->ops.regops.get_global_whitelist_ranges != NULL) &&
 		        (nvgpu_bsearch(&offset,
@@ -505,7 +678,7 @@ static bool check_whitelists(struct gk20a *g,
 					     g->ops.regops.get_runcontrol_whitelist(),
 					     g->ops.regops.get_runcontrol_whitelist_count());
 		}
-	} else if (op->type == REGOP(TYPE_GR_CTX)) {
+	} else if (type == REGOP(TYPE_GR_CTX)) {
 		/* binary search context list */
 		valid = (g->ops.regops.get_context_whitelist_ranges != NULL) &&
 		        (nvgpu_bsearch(&offset,
@@ -596,9 +769,11 @@ static int validate_reg_op_offset(struct gk20a *g,
 		return -EINVAL;
 	}
 
-	valid = check_whitelists(g, op, offset, valid_ctx);
+	valid = nvgpu_regops_offset_whitelisted(g, op->type, offset,
+						valid_ctx);
 	if ((op->op == REGOP(READ_64) || op->op == REGOP(WRITE_64)) && valid) {
-		valid = check_whitelists(g, op, offset + 4U, valid_ctx);
+		valid = nvgpu_regops_offset_whitelisted(g, op->type,
+					offset + 4U, valid_ctx);
 	}
 
 	if (!valid) {
@@ -709,7 +884,15 @@ static bool validate_reg_ops(struct gk20a *g,
 /* exported for tools like cyclestats, etc */
 bool is_bar0_global_offset_whitelisted_gk20a(struct gk20a *g, u32 offset)
 {
-	bool valid = nvgpu_bsearch(&offset,
+	bool valid;
+
+	if ((g->regops_allowlist != NULL) &&
+	    ((offset & 3U) == 0U) && (offset < REGOPS_ALLOWLIST_LIMIT)) {
+		return (regops_allowlist_get(g->regops_allowlist, offset) &
+			REGOPS_ALLOWLIST_GLOBAL) != 0U;
+	}
+
+	valid = nvgpu_bsearch(&offset,
 			g->ops.regops.get_global_whitelist_ranges(),
 			g->ops.regops.get_global_whitelist_ranges_count(),
 			sizeof(*g->ops.regops.get_global_whitelist_ranges()),
@@ -26,26 +26,80 @@
 #include <nvgpu/debug.h>
 #include <nvgpu/kmem.h>
 #include <nvgpu/timers.h>
-#include <nvgpu/sort.h>
+#include <nvgpu/barrier.h>
+#include <nvgpu/os_sched.h>
+#include <nvgpu/log2.h>
 #include <nvgpu/log.h>
 
 /*
  * A simple profiler, capable of generating simple stats for a set of samples.
+ *
+ * Each thread taking a sample owns a slot holding the start time of its
+ * sample; subsamples are accounted as the time since that start, straight
+ * into per-subsample histograms with atomic counters. Nothing on the
+ * sampling path takes a lock, and the histograms can be printed while
+ * sampling goes on.
  */
 
 /*
- * The sample array is a 1d array comprised of repeating rows of data. To
- * index the array as though it were a row-major matrix, we need to do some
- * simple math.
+ * The histogram array is a 1d array comprised of repeating rows of buckets,
+ * one row per subsample.
  */
-static inline u32 matrix_to_linear_index(struct nvgpu_swprofiler *p,
-					 u32 row, u32 col)
+static inline u32 matrix_to_linear_index(u32 row, u32 col)
+{
+	return (row * NVGPU_SWPROFILE_BUCKETS) + col;
+}
+
+static u32 nvgpu_swprofile_bucket(u64 val)
+{
+	u32 msb;
+	u32 shift;
+
+	if (val < (u64)NVGPU_SWPROFILE_SUB_BUCKETS) {
+		return (u32)val;
+	}
+
+	msb = (u32)nvgpu_ilog2(val);
+	shift = msb - NVGPU_SWPROFILE_SUB_BUCKET_BITS;
+
+	return ((shift + 1U) * NVGPU_SWPROFILE_SUB_BUCKETS) +
+		(u32)((val >> shift) & (u64)(NVGPU_SWPROFILE_SUB_BUCKETS - 1U));
+}
+
+static u64 nvgpu_swprofile_bucket_lower(u32 bucket)
+{
+	u32 group = bucket / NVGPU_SWPROFILE_SUB_BUCKETS;
+	u32 sub = bucket % NVGPU_SWPROFILE_SUB_BUCKETS;
+
+	if (group == 0U) {
+		return (u64)bucket;
+	}
+
+	return (u64)(NVGPU_SWPROFILE_SUB_BUCKETS + sub) << (group - 1U);
+}
+
+static u64 nvgpu_swprofile_bucket_upper(u32 bucket)
+{
+	u32 group = bucket / NVGPU_SWPROFILE_SUB_BUCKETS;
+
+	if (group == 0U) {
+		return (u64)bucket;
+	}
+
+	return nvgpu_swprofile_bucket_lower(bucket) +
+		((1ULL << (group - 1U)) - 1ULL);
+}
+
+static inline struct nvgpu_swprofile_slot *nvgpu_swprofile_slot(
+		struct nvgpu_swprofiler *p, int tid)
 {
-	return (row * p->psample_len) + col;
+	u32 hash = (u32)tid * 0x9e3779b1U;
+
+	return &p->slots[hash >> (32U - NVGPU_SWPROFILE_SLOT_BITS)];
 }
 
 /*
- * Just check the samples field; it'll be allocated for an enabled profiler.
+ * Just check the hist field; it'll be allocated for an enabled profiler.
  * This is an intrisically racy call; don't rely on it to determine whether the
  * underlying pointers/fields really are initialized or not.
  *
@@ -55,7 +109,7 @@ static inline u32 matrix_to_linear_index(struct nvgpu_swprofiler *p,
  */
 bool nvgpu_swprofile_is_enabled(struct nvgpu_swprofiler *p)
 {
-	return p->samples != NULL;
+	return p->hist != NULL;
 }
 
 void nvgpu_swprofile_initialize(struct gk20a *g,
@@ -82,14 +136,16 @@ void nvgpu_swprofile_initialize(struct gk20a *g,
 
 int nvgpu_swprofile_open(struct gk20a *g, struct nvgpu_swprofiler *p)
 {
+	nvgpu_atomic64_t *hist;
 	int ret = 0;
+	u32 i;
 
 	nvgpu_mutex_acquire(&p->lock);
 
 	/*
 	 * If this profiler is already opened, just take a ref and return.
 	 */
-	if (p->samples != NULL) {
+	if (p->hist != NULL) {
 		nvgpu_ref_get(&p->ref);
 		nvgpu_mutex_release(&p->lock);
 		return 0;
@@ -98,32 +154,48 @@ int nvgpu_swprofile_open(struct gk20a *g, struct nvgpu_swprofiler *p)
 	/*
 	 * Otherwise allocate the necessary data structures, etc.
 	 */
-	p->samples = nvgpu_vzalloc(g,
-				   PROFILE_ENTRIES * p->psample_len *
-				   sizeof(*p->samples));
-	if (p->samples == NULL) {
+	p->slots = nvgpu_vzalloc(g,
+				 NVGPU_SWPROFILE_SLOTS * sizeof(*p->slots));
+	if (p->slots == NULL) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	p->cols = nvgpu_vzalloc(g, p->psample_len * sizeof(*p->cols));
+	if (p->cols == NULL) {
 		ret = -ENOMEM;
 		goto fail;
 	}
 
-	p->samples_start = nvgpu_vzalloc(g,
-				   PROFILE_ENTRIES * sizeof(*p->samples_start));
-	if (p->samples_start == NULL) {
+	/* min is compared as a u64, so -1 is U64_MAX */
+	for (i = 0U; i < p->psample_len; i++) {
+		nvgpu_atomic64_set(&p->cols[i].min, -1);
+	}
+	nvgpu_atomic64_set(&p->dropped, 0);
+
+	hist = nvgpu_vzalloc(g,
+			     NVGPU_SWPROFILE_BUCKETS * p->psample_len *
+			     sizeof(*hist));
+	if (hist == NULL) {
 		ret = -ENOMEM;
 		goto fail;
 	}
 
 	nvgpu_ref_init(&p->ref);
 
+	/* Publish the histograms last; they enable sampling. */
+	nvgpu_smp_wmb();
+	p->hist = hist;
+
 	nvgpu_mutex_release(&p->lock);
 
 	return 0;
 
 fail:
-	if (p->samples != NULL) {
-		nvgpu_vfree(g, p->samples);
-		p->samples = NULL;
-	}
+	nvgpu_vfree(g, p->cols);
+	nvgpu_vfree(g, p->slots);
+	p->cols = NULL;
+	p->slots = NULL;
 	nvgpu_mutex_release(&p->lock);
 
 	return ret;
@@ -132,11 +204,16 @@ fail:
 static void nvgpu_swprofile_free(struct nvgpu_ref *ref)
 {
 	struct nvgpu_swprofiler *p = container_of(ref, struct nvgpu_swprofiler, ref);
+	nvgpu_atomic64_t *hist = p->hist;
 
-	nvgpu_vfree(p->g, p->samples);
-	nvgpu_vfree(p->g, p->samples_start);
-	p->samples = NULL;
-	p->samples_start = NULL;
+	p->hist = NULL;
+	nvgpu_smp_wmb();
+
+	nvgpu_vfree(p->g, hist);
+	nvgpu_vfree(p->g, p->cols);
+	nvgpu_vfree(p->g, p->slots);
+	p->cols = NULL;
+	p->slots = NULL;
 }
 
 void nvgpu_swprofile_close(struct nvgpu_swprofiler *p)
@@ -156,118 +233,190 @@ static void nvgpu_profile_print_col_header(struct nvgpu_swprofiler *p,
 
 }
 
+static void nvgpu_swprofile_update_min(nvgpu_atomic64_t *min, u64 val)
+{
+	long cur = nvgpu_atomic64_read(min);
+
+	while ((u64)cur > val) {
+		long old = nvgpu_atomic64_cmpxchg(min, cur, (long)val);
+
+		if (old == cur) {
+			break;
+		}
+		cur = old;
+	}
+}
+
+static void nvgpu_swprofile_update_max(nvgpu_atomic64_t *max, u64 val)
+{
+	long cur = nvgpu_atomic64_read(max);
+
+	while ((u64)cur < val) {
+		long old = nvgpu_atomic64_cmpxchg(max, cur, (long)val);
+
+		if (old == cur) {
+			break;
+		}
+		cur = old;
+	}
+}
+
 /*
- * Note: this does _not_ lock the profiler. This is a conscious choice. If we
- * do lock the profiler then there's the possibility that you get bad data due
- * to the snapshot blocking on some other user printing the contents of the
- * profiler.
- *
- * Instead, this way, it's possible that someone printing the data in the
- * profiler gets a sample that's a mix of old and new. That's not great, but
- * IMO worse than a completely bogus sample.
- *
- * Also it's really quite unlikely for this race to happen in practice as the
- * print function is executed as a result of a debugfs call.
+ * Note: this does _not_ lock the profiler. Printing reads the histogram
+ * counters while they are being updated, so a print may see a subsample of
+ * a sample but not the next one. Each counter is always consistent though.
  */
 void nvgpu_swprofile_snapshot(struct nvgpu_swprofiler *p, u32 idx)
 {
-	u32 index;
+	struct nvgpu_swprofile_slot *slot;
+	nvgpu_atomic64_t *hist;
+	struct nvgpu_swprofile_col *col;
+	int tid;
+	int seq;
+	u64 start;
+	u64 now;
+	u64 delta;
 
 	/*
 	 * Handle two cases: the first allows calling code to simply skip
 	 * any profiling by passing in a NULL profiler; see the CDE code
 	 * for this. The second case is if a profiler is not "opened".
 	 */
-	if (p == NULL || p->samples == NULL) {
+	if (p == NULL || p->hist == NULL) {
 		return;
 	}
 
+	now = (u64)nvgpu_current_time_ns();
+	tid = nvgpu_current_tid(p->g);
+	slot = nvgpu_swprofile_slot(p, tid);
+
 	/*
-	 * p->sample_index is the current row, aka sample, we are writing to.
-	 * idx is the column - i.e the sub-sample.
+	 * Read the start time of this thread's sample; drop the subsample if
+	 * another thread took the slot meanwhile.
 	 */
-	index = matrix_to_linear_index(p, p->sample_index, idx);
+	seq = nvgpu_atomic_read(&slot->seq);
+	nvgpu_smp_rmb();
+	start = slot->start;
+	if (slot->tid != tid || start == 0ULL) {
+		nvgpu_atomic64_inc(&p->dropped);
+		return;
+	}
+	nvgpu_smp_rmb();
+	if ((((u32)seq & 1U) != 0U) || nvgpu_atomic_read(&slot->seq) != seq) {
+		nvgpu_atomic64_inc(&p->dropped);
+		return;
+	}
 
-	p->samples[index] = (u64)nvgpu_current_time_ns();
+	delta = now > start ? now - start : 0ULL;
+
+	hist = p->hist;
+	col = &p->cols[idx];
+	nvgpu_atomic64_inc(&hist[matrix_to_linear_index(idx,
+				nvgpu_swprofile_bucket(delta))]);
+	nvgpu_atomic64_add((long)delta, &col->sum);
+	nvgpu_atomic64_inc(&col->count);
+	nvgpu_swprofile_update_min(&col->min, delta);
+	nvgpu_swprofile_update_max(&col->max, delta);
 }
 
 void nvgpu_swprofile_begin_sample(struct nvgpu_swprofiler *p)
 {
-	nvgpu_mutex_acquire(&p->lock);
+	struct nvgpu_swprofile_slot *slot;
+	int tid;
+	int seq;
 
-	if (p == NULL || p->samples == NULL) {
-		nvgpu_mutex_release(&p->lock);
+	if (p == NULL || p->hist == NULL) {
 		return;
 	}
 
-	p->sample_index++;
+	tid = nvgpu_current_tid(p->g);
+	slot = nvgpu_swprofile_slot(p, tid);
 
-	/* Handle wrap. */
-	if (p->sample_index >= PROFILE_ENTRIES) {
-		p->sample_index = 0U;
+	/*
+	 * Claim the slot by making its sequence odd. If another thread is
+	 * claiming it right now, give up on this sample rather than wait; the
+	 * following snapshots will be dropped as the slot is not ours.
+	 */
+	seq = nvgpu_atomic_read(&slot->seq);
+	if ((((u32)seq & 1U) != 0U) ||
+	    nvgpu_atomic_cmpxchg(&slot->seq, seq, seq + 1) != seq) {
+		nvgpu_atomic64_inc(&p->dropped);
+		return;
 	}
+	nvgpu_smp_wmb();
+
+	slot->tid = tid;
 
 	/*
 	 * Reference time for subsequent subsamples in this sample.
 	 */
-	p->samples_start[p->sample_index] = (u64)nvgpu_current_time_ns();
+	slot->start = (u64)nvgpu_current_time_ns();
 
-	nvgpu_mutex_release(&p->lock);
+	nvgpu_smp_wmb();
+	nvgpu_atomic_set(&slot->seq, seq + 2);
 }
 
-static int profile_cmp(const void *a, const void *b)
+/*
+ * Copy out the histogram of a subsample. Returns the number of samples in it.
+ */
+static u64 nvgpu_swprofile_read_hist(struct nvgpu_swprofiler *p, u32 col,
+				     u64 *counts)
 {
-	return (int)(*((const u64 *) a) - *((const u64 *) b));
-}
+	u64 total = 0ULL;
+	u32 i;
+
+	for (i = 0U; i < NVGPU_SWPROFILE_BUCKETS; i++) {
+		counts[i] = (u64)nvgpu_atomic64_read(
+				&p->hist[matrix_to_linear_index(col, i)]);
+		total += counts[i];
+	}
 
-#define PERCENTILE_WIDTH	5
-#define PERCENTILE_RANGES	(100/PERCENTILE_WIDTH)
+	return total;
+}
 
-static u32 nvgpu_swprofile_build_ranges(struct nvgpu_swprofiler *p,
-					u64 *storage,
-					u64 *percentiles,
-					u32 index_end,
-					u32 index_start)
+/*
+ * Value at the given percentile, in 1/1000ths, of a histogram.
+ */
+static u64 nvgpu_swprofile_percentile(const u64 *counts, u64 total,
+				      u64 permille)
 {
+	u64 target = ((total * permille) + 999ULL) / 1000ULL;
+	u64 seen = 0ULL;
 	u32 i;
-	u32 nelem = 0U;
-
-	/*
-	 * Iterate through a column and build a temporary slice array of samples
-	 * so that we can sort them without corrupting the current data.
-	 *
-	 * Note that we have to first convert the row/column indexes into linear
-	 * indexes to access the underlying sample array.
-	 */
-	for (i = 0; i < PROFILE_ENTRIES; i++) {
-		u32 linear_idx_start = matrix_to_linear_index(p, i, index_start);
-		u32 linear_idx_end = matrix_to_linear_index(p, i, index_end);
-
-		if (p->samples[linear_idx_end] <=
-		    p->samples[linear_idx_start]) {
-			/* This is an invalid element */
-			continue;
-		}
 
-		storage[nelem] = p->samples[linear_idx_end] -
-				 p->samples[linear_idx_start];
-		nelem++;
+	if (total == 0ULL) {
+		return 0ULL;
 	}
 
-	/* sort it */
-	sort(storage, nelem, sizeof(u64), profile_cmp, NULL);
+	if (target == 0ULL) {
+		target = 1ULL;
+	}
 
-	/* build ranges */
-	for (i = 0; i < PERCENTILE_RANGES; i++) {
-		percentiles[i] = nelem < PERCENTILE_RANGES ? 0 :
-			storage[(PERCENTILE_WIDTH * (i + 1) * nelem)/100 - 1];
+	for (i = 0U; i < NVGPU_SWPROFILE_BUCKETS; i++) {
+		seen += counts[i];
+		if (seen >= target) {
+			return nvgpu_swprofile_bucket_upper(i);
+		}
 	}
 
-	return nelem;
+	return nvgpu_swprofile_bucket_upper(NVGPU_SWPROFILE_BUCKETS - 1U);
 }
 
+static const struct {
+	const char *name;
+	u64 permille;
+} nvgpu_swprofile_percentiles[] = {
+	{ "p50",   500ULL },
+	{ "p90",   900ULL },
+	{ "p99",   990ULL },
+	{ "p99.9", 999ULL },
+};
+
+#define NVGPU_SWPROFILE_PERCENTILES	\
+	ARRAY_SIZE(nvgpu_swprofile_percentiles)
+
 /*
- * Print a list of percentiles spaced by 5%. Note that the debug_context needs
+ * Print a list of percentiles. Note that the debug_context needs
  * to be special here. _Most_ print functions in NvGPU automatically add a new
  * line to the end of each print statement. This function _specifically_
  * requires that your debug print function does _NOT_ do this.
@@ -276,40 +425,47 @@ void nvgpu_swprofile_print_ranges(struct gk20a *g,
 				  struct nvgpu_swprofiler *p,
 				  struct nvgpu_debug_context *o)
 {
-	u32 nelem = 0U, i, j;
-	u64 *sorted_data = NULL;
+	u64 nelem = 0ULL;
+	u32 i, j;
+	u64 *counts = NULL;
 	u64 *percentiles = NULL;
 
 	nvgpu_mutex_acquire(&p->lock);
 
-	if (p->samples == NULL) {
+	if (p->hist == NULL) {
 		gk20a_debug_output(o, "Profiler not enabled.\n");
 		goto done;
 	}
 
-	sorted_data = nvgpu_vzalloc(g,
-				    PROFILE_ENTRIES * p->psample_len *
-				    sizeof(u64));
+	counts = nvgpu_vzalloc(g, NVGPU_SWPROFILE_BUCKETS * sizeof(u64));
 	percentiles = nvgpu_vzalloc(g,
-				    PERCENTILE_RANGES * p->psample_len *
-				    sizeof(u64));
-	if (!sorted_data || !percentiles) {
+				    NVGPU_SWPROFILE_PERCENTILES *
+				    p->psample_len * sizeof(u64));
+	if (!counts || !percentiles) {
 		nvgpu_err(g, "vzalloc: OOM!");
 		goto done;
 	}
 
 	/*
-	 * Loop over each column; sort the column's data and then build
-	 * percentile ranges based on that sorted data.
+	 * Loop over each column and pick the percentiles out of its histogram.
 	 */
 	for (i = 0U; i < p->psample_len; i++) {
-		nelem = nvgpu_swprofile_build_ranges(p,
-						   &sorted_data[i * PROFILE_ENTRIES],
-						   &percentiles[i * PERCENTILE_RANGES],
-						   i, 0U);
+		u64 total = nvgpu_swprofile_read_hist(p, i, counts);
+
+		for (j = 0U; j < NVGPU_SWPROFILE_PERCENTILES; j++) {
+			percentiles[(i * NVGPU_SWPROFILE_PERCENTILES) + j] =
+				nvgpu_swprofile_percentile(counts, total,
+					nvgpu_swprofile_percentiles[j].permille);
+		}
+
+		if (total > nelem) {
+			nelem = total;
+		}
 	}
 
-	gk20a_debug_output(o, "Samples: %u\n", nelem);
+	gk20a_debug_output(o, "Samples: %llu\n", nelem);
+	gk20a_debug_output(o, "Dropped: %lld\n",
+			   (long long)nvgpu_atomic64_read(&p->dropped));
 	gk20a_debug_output(o, "%6s", "Perc");
 	nvgpu_profile_print_col_header(p, o);
 
@@ -322,25 +478,31 @@ void nvgpu_swprofile_print_ranges(struct gk20a *g,
 	/*
 	 * percentiles is another matrix, but this time it's using column major indexing.
 	 */
-	for (i = 0U; i < PERCENTILE_RANGES; i++) {
-		gk20a_debug_output(o, "%3upc ", PERCENTILE_WIDTH * (i + 1));
+	for (i = 0U; i < NVGPU_SWPROFILE_PERCENTILES; i++) {
+		gk20a_debug_output(o, "%6s", nvgpu_swprofile_percentiles[i].name);
 		for (j = 0U; j < p->psample_len; j++) {
 			gk20a_debug_output(o, " %15llu",
-					   percentiles[(j * PERCENTILE_RANGES) + i]);
+				percentiles[(j * NVGPU_SWPROFILE_PERCENTILES) + i]);
 		}
 		gk20a_debug_output(o, "\n");
 	}
-	gk20a_debug_output(o, "\n");
+
+	gk20a_debug_output(o, "%6s", "max");
+	for (j = 0U; j < p->psample_len; j++) {
+		gk20a_debug_output(o, " %15llu",
+			(u64)nvgpu_atomic64_read(&p->cols[j].max));
+	}
+	gk20a_debug_output(o, "\n\n");
 
 done:
-	nvgpu_vfree(g, sorted_data);
+	nvgpu_vfree(g, counts);
 	nvgpu_vfree(g, percentiles);
 	nvgpu_mutex_release(&p->lock);
 }
 
 /*
- * Print raw data for the profiler. Can be useful if you want to do more sophisticated
- * analysis in python or something like that.
+ * Print the raw histograms for the profiler. Can be useful if you want to do
+ * more sophisticated analysis in python or something like that.
  *
  * Note this requires a debug context that does not automatically add newlines.
  */
@@ -354,22 +516,38 @@ void nvgpu_swprofile_print_raw_data(struct gk20a *g,
 
 	nvgpu_mutex_acquire(&p->lock);
 
-	if (p->samples == NULL) {
+	if (p->hist == NULL) {
 		gk20a_debug_output(o, "Profiler not enabled.\n");
 		goto done;
 	}
 
-	gk20a_debug_output(o, "max samples: %u, sample len: %u\n",
-			   PROFILE_ENTRIES, p->psample_len);
+	gk20a_debug_output(o, "buckets: %u, sample len: %u\n",
+			   NVGPU_SWPROFILE_BUCKETS, p->psample_len);
 
+	gk20a_debug_output(o, " %15s", "bucket");
 	nvgpu_profile_print_col_header(p, o);
 
-	for (i = 0U; i < PROFILE_ENTRIES; i++) {
+	for (i = 0U; i < NVGPU_SWPROFILE_BUCKETS; i++) {
+		bool empty = true;
+
 		for (j = 0U; j < p->psample_len; j++) {
-			u32 index = matrix_to_linear_index(p, i, j);
+			if (nvgpu_atomic64_read(
+				&p->hist[matrix_to_linear_index(j, i)]) != 0) {
+				empty = false;
+				break;
+			}
+		}
+
+		if (empty) {
+			continue;
+		}
 
+		gk20a_debug_output(o, " %15llu",
+				   nvgpu_swprofile_bucket_lower(i));
+		for (j = 0U; j < p->psample_len; j++) {
 			gk20a_debug_output(o, " %15llu",
-					   p->samples[index] - p->samples_start[i]);
+				(u64)nvgpu_atomic64_read(
+					&p->hist[matrix_to_linear_index(j, i)]));
 		}
 		gk20a_debug_output(o, "\n");
 	}
@@ -388,100 +566,77 @@ done:
  *   Sigma ^ 2
  *
  * Note that the results array has to be at least 5 entries long. Storage should be
- * an array that is at least PROFILE_ENTRIES long. This is used for working out the
- * median - we need a sorted sample set for that.
- *
- * Note: this skips empty samples.
+ * an array that is at least NVGPU_SWPROFILE_BUCKETS long. Min, max and mean are
+ * exact; median and variance are worked out from the histogram, using the middle
+ * of each bucket.
  *
  * Note: there's a limit to the sensitivity of these profiling stats. For things that
  * happen faster than the granularity of the underlying timer, you'll need to use
  * something more sophisticated. It's ok to have some zeros, but too many and you
  * won't get a very interesting picture of the data.
  */
-static u32 nvgpu_swprofile_subsample_basic_stats(struct gk20a *g,
+static u64 nvgpu_swprofile_subsample_basic_stats(struct gk20a *g,
 						 struct nvgpu_swprofiler *p,
 						 u32 subsample,
 						 u64 *results,
 						 u64 *storage)
 {
-	u64 sum = 0U, samples = 0U;
-	u64 min = U64_MAX, max = 0U;
+	struct nvgpu_swprofile_col *col = &p->cols[subsample];
+	u64 samples, count;
 	u64 mean, median;
 	u64 sigma_2 = 0U;
 	u32 i;
 
 	(void)g;
 
-	/*
-	 * First, let's work out min, max, sum, and number of samples of data. With this we
-	 * can then get the mean, median, and sigma^2.
-	 */
-	for (i = 0U; i < PROFILE_ENTRIES; i++) {
-		u32 ss       = matrix_to_linear_index(p, i, subsample);
-		u64 sample   = p->samples[ss] - p->samples_start[i];
-
-		if (p->samples_start[i] == 0U) {
-			continue;
-		}
-
-		if (sample < min) {
-			min = sample;
-		}
-		if (sample > max) {
-			max = sample;
-		}
-
-		storage[samples] = sample;
-		sum += sample;
-		samples += 1U;
-	}
-
-	/*
-	 * If min is still U64_MAX it means that we almost certainly did not actually
-	 * get a single valid sample.
-	 */
-	if (min == U64_MAX) {
-		min = 0U;
-	}
-
-	/* With the sorted list of samples we can easily compute the median. */
-	sort(storage, samples, sizeof(u64), profile_cmp, NULL);
-
+	samples = nvgpu_swprofile_read_hist(p, subsample, storage);
 	if (samples == 0U) {
 		return 0U;
 	}
 
-	mean = sum / samples;
-	median = storage[samples / 2];
+	/*
+	 * The totals may have moved on since the histogram was read; the mean
+	 * uses the totals' own count so it stays consistent.
+	 */
+	count = (u64)nvgpu_atomic64_read(&col->count);
+	mean = count == 0U ? 0U :
+		(u64)nvgpu_atomic64_read(&col->sum) / count;
+	median = nvgpu_swprofile_percentile(storage, samples, 500ULL);
 
 	/*
 	 * If only 1 sample is found, the min, max, median and mean would be
-	 * the value of that one observation (storage[0]). The variance in this
-	 * case would be 0.
-	 * The need for this special case is because in the original implementation,
-	 * sigma_2 is divided by samples-1 which is 0 in our case, causing a divide
-	 * by zero error.
+	 * the value of that one observation. The variance in this case would
+	 * be 0. The need for this special case is that sigma_2 is divided by
+	 * samples-1 which is 0 in our case, causing a divide by zero error.
 	 */
-	if (samples == 1U) {
-		sigma_2 = 0U;
-	} else {
+	if (samples > 1U) {
 		/* Compute the sample variance (i.e sigma squared). */
-		for (i = 0U; i < samples; i++) {
-			sigma_2 += storage[i] * storage[i];
+		for (i = 0U; i < NVGPU_SWPROFILE_BUCKETS; i++) {
+			u64 mid;
+			u64 diff;
+
+			if (storage[i] == 0U) {
+				continue;
+			}
+
+			mid = nvgpu_swprofile_bucket_lower(i) +
+				((nvgpu_swprofile_bucket_upper(i) -
+				  nvgpu_swprofile_bucket_lower(i)) / 2U);
+			diff = mid > mean ? mid - mean : mean - mid;
+			sigma_2 += storage[i] * diff * diff;
 		}
 
 		/* Remember: _sample_ variance. */
 		sigma_2 /= (samples - 1U);
-		sigma_2 -= (mean * mean);
 	}
 
-	results[0] = min;
-	results[1] = max;
+	results[0] = (u64)nvgpu_atomic64_read(&col->min);
+	results[1] = (u64)nvgpu_atomic64_read(&col->max);
 	results[2] = mean;
 	results[3] = median;
 	results[4] = sigma_2;
 
-	return (u32)samples;
+	return samples;
 }
 
 /*
@@ -497,14 +652,9 @@ void nvgpu_swprofile_print_basic_stats(struct gk20a *g,
 	const char *fmt_header = "%-18s %15s %15s %15s %15s %15s\n";
 	const char *fmt_output = "%-18s %15llu %15llu %15llu %15llu %15llu\n";
 	u64 *storage;
-	u32 samples = 0U;
+	u64 samples = 0U;
 
-	if (p->samples == NULL) {
-		gk20a_debug_output(o, "Profiler not enabled.\n");
-		return;
-	}
-
-	storage = nvgpu_kzalloc(g, sizeof(u64) * PROFILE_ENTRIES);
+	storage = nvgpu_kzalloc(g, sizeof(u64) * NVGPU_SWPROFILE_BUCKETS);
 	if (storage == NULL) {
 		gk20a_debug_output(o, "OOM!");
 		return;
@@ -512,6 +662,11 @@ void nvgpu_swprofile_print_basic_stats(struct gk20a *g,
 
 	nvgpu_mutex_acquire(&p->lock);
 
+	if (p->hist == NULL) {
+		gk20a_debug_output(o, "Profiler not enabled.\n");
+		goto done;
+	}
+
 	gk20a_debug_output(o, fmt_header,
 			   "SubSample", "Min", "Max",
 			   "Mean", "Median", "Sigma^2");
@@ -533,8 +688,9 @@ void nvgpu_swprofile_print_basic_stats(struct gk20a *g,
 				results[2], results[3], results[4]);
 	}
 
-	gk20a_debug_output(o, "Number of samples: %u\n", samples);
+	gk20a_debug_output(o, "Number of samples: %llu\n", samples);
 
+done:
 	nvgpu_mutex_release(&p->lock);
 	nvgpu_kfree(g, storage);
 }
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/bitops.h>
+#include <nvgpu/bug.h>
+#include <nvgpu/errno.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/static_analysis.h>
+#include <nvgpu/hbitmap.h>
+
+int nvgpu_hbitmap_init(struct gk20a *g, struct nvgpu_hbitmap *hb,
+		       unsigned long nbits)
+{
+	if (nbits == 0UL) {
+		return -EINVAL;
+	}
+
+	hb->nbits = nbits;
+	hb->nwords = BITS_TO_LONGS(nbits);
+
+	hb->map = nvgpu_big_zalloc(g, hb->nwords * sizeof(*hb->map));
+	if (hb->map == NULL) {
+		return -ENOMEM;
+	}
+
+	hb->full = nvgpu_big_zalloc(g,
+			BITS_TO_LONGS(hb->nwords) * sizeof(*hb->full));
+	if (hb->full == NULL) {
+		nvgpu_big_free(g, hb->map);
+		hb->map = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void nvgpu_hbitmap_deinit(struct gk20a *g, struct nvgpu_hbitmap *hb)
+{
+	if (hb->map != NULL) {
+		nvgpu_big_free(g, hb->map);
+	}
+	if (hb->full != NULL) {
+		nvgpu_big_free(g, hb->full);
+	}
+	hb->map = NULL;
+	hb->full = NULL;
+	hb->nbits = 0UL;
+	hb->nwords = 0UL;
+}
+
+/*
+ * Recompute the summary bit of word w. Bits of the last word past nbits do
+ * not exist and count as set.
+ */
+static void hbitmap_update_summary(struct nvgpu_hbitmap *hb, unsigned long w)
+{
+	unsigned long tail = hb->nbits & (BITS_PER_LONG - 1UL);
+	unsigned long word = hb->map[w];
+
+	if ((w == (hb->nwords - 1UL)) && (tail != 0UL)) {
+		word |= ~0UL << tail;
+	}
+
+	if (word == ~0UL) {
+		nvgpu_set_bit(nvgpu_safe_cast_u64_to_u32(w), hb->full);
+	} else {
+		nvgpu_clear_bit(nvgpu_safe_cast_u64_to_u32(w), hb->full);
+	}
+}
+
+void nvgpu_hbitmap_set(struct nvgpu_hbitmap *hb, u32 start, u32 len)
+{
+	unsigned long first, last;
+
+	if (len == 0U) {
+		return;
+	}
+
+	nvgpu_assert(nvgpu_safe_add_u64(start, len) <= hb->nbits);
+
+	nvgpu_bitmap_set(hb->map, start, len);
+
+	first = start / BITS_PER_LONG;
+	last = (nvgpu_safe_add_u64(start, len) - 1UL) / BITS_PER_LONG;
+
+	/*
+	 * Only the first and the last word can be partially set, all the words
+	 * in between are full now.
+	 */
+	hbitmap_update_summary(hb, first);
+	if (last > first) {
+		nvgpu_bitmap_set(hb->full,
+				 nvgpu_safe_cast_u64_to_u32(first + 1UL),
+				 nvgpu_safe_cast_u64_to_u32(last - first - 1UL));
+		hbitmap_update_summary(hb, last);
+	}
+}
+
+void nvgpu_hbitmap_clear(struct nvgpu_hbitmap *hb, u32 start, u32 len)
+{
+	unsigned long first, last;
+
+	if (len == 0U) {
+		return;
+	}
+
+	nvgpu_assert(nvgpu_safe_add_u64(start, len) <= hb->nbits);
+
+	nvgpu_bitmap_clear(hb->map, start, len);
+
+	first = start / BITS_PER_LONG;
+	last = (nvgpu_safe_add_u64(start, len) - 1UL) / BITS_PER_LONG;
+
+	/* Every touched word now has at least one zero bit. */
+	nvgpu_bitmap_clear(hb->full, nvgpu_safe_cast_u64_to_u32(first),
+			   nvgpu_safe_cast_u64_to_u32(last - first + 1UL));
+}
+
+/*
+ * First zero bit at or after start and below size. The rest of the start word
+ * is checked directly, after that the summary gives the next word that is not
+ * full.
+ */
+static unsigned long hbitmap_next_zero_bit(const struct nvgpu_hbitmap *hb,
+					   unsigned long size,
+					   unsigned long start)
+{
+	unsigned long w = start / BITS_PER_LONG;
+	unsigned long w_end;
+	unsigned long bit;
+
+	if (start >= size) {
+		return size;
+	}
+
+	w_end = nvgpu_safe_mult_u64(w + 1UL, BITS_PER_LONG);
+	w_end = min(size, w_end);
+	bit = find_next_zero_bit(hb->map, w_end, start);
+	if (bit < w_end) {
+		return bit;
+	}
+
+	w = find_next_zero_bit(hb->full, hb->nwords, w + 1UL);
+	if (w >= hb->nwords) {
+		return size;
+	}
+
+	return find_next_zero_bit(hb->map, size,
+				  nvgpu_safe_mult_u64(w, BITS_PER_LONG));
+}
+
+unsigned long nvgpu_hbitmap_find_next_zero_area(const struct nvgpu_hbitmap *hb,
+						unsigned long size,
+						unsigned long start,
+						u32 nr,
+						unsigned long align_mask)
+{
+	unsigned long end, offs;
+
+	size = min(size, hb->nbits);
+
+	while (nvgpu_safe_add_u64(start, nr) <= size) {
+		start = hbitmap_next_zero_bit(hb, size, start);
+		start = nvgpu_safe_add_u64(start, align_mask) & ~align_mask;
+
+		end = nvgpu_safe_add_u64(start, nr);
+		if (end > size) {
+			return size;
+		}
+
+		/* Any set bit in [start, end) restarts the search past it. */
+		offs = find_next_bit(hb->map, end, start);
+		if (offs >= end) {
+			return start;
+		}
+
+		start = offs + 1UL;
+	}
+
+	return size;
+}
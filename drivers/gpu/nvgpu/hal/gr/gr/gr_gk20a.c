@@ -440,6 +440,7 @@ int gr_gk20a_get_ctx_buffer_offsets(struct gk20a *g,
 	u32 i;
 	u32 priv_offset = 0;
 	u32 *priv_registers;
+	u32 *priv_offsets;
 	u32 num_registers = 0;
 	int err = 0;
 	struct nvgpu_gr *gr = nvgpu_gr_get_cur_instance_ptr(g);
@@ -461,30 +462,38 @@ int gr_gk20a_get_ctx_buffer_offsets(struct gk20a *g,
 		return -ENODEV;
 	}
 
-	priv_registers = nvgpu_kzalloc(g, sizeof(u32) * potential_offsets);
-	if (priv_registers == NULL) {
-		nvgpu_log_fn(g, "failed alloc for potential_offsets=%d", potential_offsets);
-		err = -ENOMEM;
-		goto cleanup;
-	}
 	(void) memset(offsets,      0, sizeof(u32) * max_offsets);
 	(void) memset(offset_addrs, 0, sizeof(u32) * max_offsets);
 	*num_offsets = 0;
 
-	g->ops.gr.create_priv_addr_table(g, addr, &priv_registers[0],
-			&num_registers);
+	/* the offsets only depend on the golden image, look them up once */
+	if (gr->ctx_offset_map != NULL) {
+		err = nvgpu_gr_ctx_offset_map_find(gr->ctx_offset_map, addr,
+				max_offsets, offsets, offset_addrs,
+				num_offsets);
+		if (err != -ENOENT) {
+			return err;
+		}
+		err = 0;
+	}
 
-	if ((max_offsets > 1U) && (num_registers > max_offsets)) {
-		nvgpu_log_fn(g, "max_offsets = %d, num_registers = %d",
-				max_offsets, num_registers);
-		err = -EINVAL;
+	/* room for the unicast registers and their offsets */
+	priv_registers = nvgpu_kzalloc(g,
+			sizeof(u32) * 2U * (size_t)potential_offsets);
+	if (priv_registers == NULL) {
+		nvgpu_log_fn(g, "failed alloc for potential_offsets=%d", potential_offsets);
+		err = -ENOMEM;
 		goto cleanup;
 	}
+	priv_offsets = priv_registers + potential_offsets;
 
-	if ((max_offsets == 1U) && (num_registers > 1U)) {
-		num_registers = 1;
-	}
+	g->ops.gr.create_priv_addr_table(g, addr, &priv_registers[0],
+			&num_registers);
 
+	/*
+	 * Resolve all registers the address expands to, whatever max_offsets
+	 * is, so the result can be cached for any later caller.
+	 */
 	for (i = 0; i < num_registers; i++) {
 		err = g->ops.gr.find_priv_offset_in_buffer(g,
 			  priv_registers[i],
@@ -496,10 +505,46 @@ int gr_gk20a_get_ctx_buffer_offsets(struct gk20a *g,
 		if (err != 0) {
 			nvgpu_log_fn(g, "Could not determine priv_offset for addr:0x%x",
 				      addr); /*, grPriRegStr(addr)));*/
+			break;
+		}
+
+		priv_offsets[i] = priv_offset;
+	}
+
+	if (gr->ctx_offset_map != NULL) {
+		int map_err;
+
+		nvgpu_gr_ctx_offset_map_add(g, gr->ctx_offset_map, addr, err,
+			num_registers, i, priv_offsets, priv_registers);
+		map_err = nvgpu_gr_ctx_offset_map_find(gr->ctx_offset_map,
+				addr, max_offsets, offsets, offset_addrs,
+				num_offsets);
+		if (map_err != -ENOENT) {
+			err = map_err;
 			goto cleanup;
 		}
+	}
 
-		offsets[i] = priv_offset;
+	/* not cached, apply max_offsets directly */
+	if ((max_offsets > 1U) && (num_registers > max_offsets)) {
+		nvgpu_log_fn(g, "max_offsets = %d, num_registers = %d",
+				max_offsets, num_registers);
+		err = -EINVAL;
+		goto cleanup;
+	}
+
+	if ((max_offsets == 1U) && (num_registers > 1U)) {
+		num_registers = 1;
+	}
+
+	if (i < num_registers) {
+		/* err still holds the failed lookup */
+		goto cleanup;
+	}
+	err = 0;
+
+	for (i = 0; i < num_registers; i++) {
+		offsets[i] = priv_offsets[i];
 		offset_addrs[i] = priv_registers[i];
 	}
 
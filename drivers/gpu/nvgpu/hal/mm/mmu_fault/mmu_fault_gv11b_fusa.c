@@ -43,6 +43,10 @@
 #include <nvgpu/nvgpu_init.h>
 #include <nvgpu/power_features/pg.h>
 #include <nvgpu/string.h>
+#include <nvgpu/kmem.h>
+#ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+#include <nvgpu/sort.h>
+#endif
 
 #include <nvgpu/hw/gv11b/hw_gmmu_gv11b.h>
 
@@ -54,6 +58,9 @@ static int gv11b_fb_fix_page_fault(struct gk20a *g,
 		 struct mmu_fault_info *mmufault);
 static void gv11b_mm_mmu_fault_handle_replayable(struct gk20a *g,
 		struct mmu_fault_info *mmufault, u32 *invalidate_replay_val);
+static void gv11b_mm_mmu_fault_handle_replay_batch(struct gk20a *g,
+		struct nvgpu_mem *mem, u32 *invalidate_replay_val,
+		u32 fault_status, u32 get_indx, u32 entries);
 #endif
 
 static const char mmufault_invalid_str[] = "invalid";
@@ -606,10 +613,20 @@ void gv11b_mm_mmu_fault_handle_nonreplay_replay_fault(struct gk20a *g,
 		 nvgpu_safe_add_u32(offset, gmmu_fault_buf_entry_valid_w()));
 	nvgpu_log(g, gpu_dbg_intr, "entry valid offset val = 0x%x", rd32_val);
 
-	gv11b_mm_mmu_fault_handle_buf_valid_entry(g, mem, mmufault,
+#ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+	if (index == NVGPU_MMU_FAULT_REPLAY_REG_INDX &&
+	    g->mm.replay_faults != NULL) {
+		gv11b_mm_mmu_fault_handle_replay_batch(g, mem,
+				&invalidate_replay_val, fault_status,
+				get_indx, entries);
+	} else {
+#endif
+		gv11b_mm_mmu_fault_handle_buf_valid_entry(g, mem, mmufault,
 				&invalidate_replay_val, rd32_val, fault_status,
 				index, get_indx, offset, entries);
 #ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+	}
+
 	if (index == NVGPU_MMU_FAULT_REPLAY_REG_INDX &&
 	    invalidate_replay_val != 0U) {
 		err = gv11b_fb_replay_or_cancel_faults(g,
@@ -704,6 +721,11 @@ void gv11b_mm_mmu_fault_info_mem_destroy(struct gk20a *g)
 		nvgpu_dma_unmap_free(vm,
 			 &g->mm.hw_fault_buf[NVGPU_MMU_FAULT_REPLAY_INDX]);
 	}
+	if (g->mm.replay_faults != NULL) {
+		nvgpu_vfree(g, g->mm.replay_faults);
+		g->mm.replay_faults = NULL;
+		g->mm.replay_faults_len = 0U;
+	}
 #endif
 
 	nvgpu_mutex_release(&g->mm.hub_isr_mutex);
@@ -712,7 +734,26 @@ void gv11b_mm_mmu_fault_info_mem_destroy(struct gk20a *g)
 
 static int gv11b_mm_mmu_fault_info_buf_init(struct gk20a *g)
 {
+#ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+	u32 len;
+
+	if (g->mm.replay_faults != NULL) {
+		return 0;
+	}
+
+	/* One replay batch can hold every entry of the replay fault buf */
+	len = nvgpu_safe_add_u32(g->ops.channel.count(g), 1U);
+	g->mm.replay_faults = nvgpu_vzalloc(g,
+			nvgpu_safe_mult_u64(sizeof(*g->mm.replay_faults),
+					    (u64)len));
+	if (g->mm.replay_faults == NULL) {
+		nvgpu_err(g, "Error in replay fault batch alloc");
+		return -ENOMEM;
+	}
+	g->mm.replay_faults_len = len;
+#else
 	(void)g;
+#endif
 	return 0;
 }
 
@@ -790,6 +831,171 @@ int gv11b_mm_mmu_fault_setup_sw(struct gk20a *g)
 }
 
 #ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+static int gv11b_mm_mmu_fault_replay_tlb_flush(struct gk20a *g)
+{
+	struct vm_gk20a *vm = g->mm.replay_tlb_vm;
+	int err;
+
+	if (vm == NULL) {
+		return 0;
+	}
+	g->mm.replay_tlb_vm = NULL;
+
+	err = nvgpu_pg_elpg_ms_protected_call(g,
+			g->ops.fb.tlb_invalidate(g, vm->pdb.mem));
+	if (err != 0) {
+		nvgpu_err(g, "tlb invalidate failed");
+	}
+	nvgpu_vm_put(vm);
+
+	return err;
+}
+
+static int gv11b_mm_mmu_fault_replay_tlb_invalidate(struct gk20a *g,
+		struct vm_gk20a *vm)
+{
+	int err;
+
+	if (!g->mm.replay_tlb_defer) {
+		err = nvgpu_pg_elpg_ms_protected_call(g,
+				g->ops.fb.tlb_invalidate(g, vm->pdb.mem));
+		if (err != 0) {
+			nvgpu_err(g, "tlb invalidate failed");
+		}
+		return err;
+	}
+
+	/*
+	 * The faulted accesses are only replayed once the whole batch is
+	 * serviced, so a single invalidate per VM is enough. Batches are
+	 * sorted by instance block and channels of a TSG usually share their
+	 * VM, so the pending VM only changes between address spaces.
+	 */
+	if (g->mm.replay_tlb_vm == vm) {
+		return 0;
+	}
+	err = gv11b_mm_mmu_fault_replay_tlb_flush(g);
+	nvgpu_vm_get(vm);
+	g->mm.replay_tlb_vm = vm;
+
+	return err;
+}
+
+static int gv11b_mm_mmu_fault_replay_cmp(const void *a, const void *b)
+{
+	const struct mmu_fault_info *fa = (const struct mmu_fault_info *)a;
+	const struct mmu_fault_info *fb = (const struct mmu_fault_info *)b;
+
+	if (fa->inst_ptr != fb->inst_ptr) {
+		return (fa->inst_ptr < fb->inst_ptr) ? -1 : 1;
+	}
+	if (fa->fault_addr != fb->fault_addr) {
+		return (fa->fault_addr < fb->fault_addr) ? -1 : 1;
+	}
+	if (fa->fault_type != fb->fault_type) {
+		return (fa->fault_type < fb->fault_type) ? -1 : 1;
+	}
+	return 0;
+}
+
+static u32 gv11b_mm_mmu_fault_drain_replay_buf(struct gk20a *g,
+		struct nvgpu_mem *mem, u32 *get_indx, u32 entries)
+{
+	struct mmu_fault_info *faults = g->mm.replay_faults;
+	u32 offset, rd32_val;
+	u32 n = 0U;
+
+	nvgpu_assert(entries != 0U);
+
+	while (n < g->mm.replay_faults_len) {
+		offset = nvgpu_safe_mult_u32(*get_indx,
+				gmmu_fault_buf_size_v()) / U32(sizeof(u32));
+		rd32_val = nvgpu_mem_rd32(g, mem,
+				nvgpu_safe_add_u32(offset,
+					gmmu_fault_buf_entry_valid_w()));
+		if ((rd32_val & gmmu_fault_buf_entry_valid_m()) == 0U) {
+			break;
+		}
+		nvgpu_log(g, gpu_dbg_intr, "entry valid = 0x%x", rd32_val);
+
+		gv11b_fb_copy_from_hw_fault_buf(g, mem, offset, &faults[n]);
+		n = nvgpu_safe_add_u32(n, 1U);
+
+		*get_indx = nvgpu_safe_add_u32(*get_indx, 1U) % entries;
+	}
+
+	return n;
+}
+
+/*
+ * Drain every valid entry of the replay fault buffer before servicing any of
+ * them. Sorting the batch by instance block and fault address groups the
+ * faults of a storm on the same pages together, so each unique page is fixed
+ * once, the TLB of each VM is invalidated once and GET is written once per
+ * batch. The replay itself is issued once by the caller.
+ */
+static void gv11b_mm_mmu_fault_handle_replay_batch(struct gk20a *g,
+		struct nvgpu_mem *mem, u32 *invalidate_replay_val,
+		u32 fault_status, u32 get_indx, u32 entries)
+{
+	struct mmu_fault_info *faults = g->mm.replay_faults;
+	struct mmu_fault_info *prev;
+	u32 err_type = GPU_HUBMMU_PAGE_FAULT_REPLAYABLE_FAULT_NOTIFY_ERROR;
+	u32 n, i;
+	int err;
+
+	g->mm.replay_tlb_defer = true;
+
+	do {
+		n = gv11b_mm_mmu_fault_drain_replay_buf(g, mem,
+				&get_indx, entries);
+		if (n == 0U) {
+			break;
+		}
+
+		nvgpu_report_err_to_sdl(g, NVGPU_ERR_MODULE_HUBMMU, err_type);
+		nvgpu_err(g, "page fault error: err_type = 0x%x, "
+				"fault_status = 0x%x, faults = %u",
+				err_type, fault_status, n);
+
+		nvgpu_log(g, gpu_dbg_intr, "new get index = %d", get_indx);
+		gv11b_fb_fault_buffer_get_ptr_update(g,
+				NVGPU_MMU_FAULT_REPLAY_REG_INDX, get_indx);
+
+		sort(faults, n, sizeof(*faults),
+				gv11b_mm_mmu_fault_replay_cmp, NULL);
+
+		prev = NULL;
+		for (i = 0U; i < n; i++) {
+			/*
+			 * fault_addr "0" is not supposed to be fixed ever,
+			 * it is left to the common handler to cancel.
+			 */
+			if (prev != NULL && faults[i].fault_addr != 0ULL &&
+			    gv11b_mm_mmu_fault_replay_cmp(prev,
+						&faults[i]) == 0) {
+				nvgpu_log(g, gpu_dbg_intr,
+					"pte already scanned");
+				if (faults[i].refch != NULL) {
+					nvgpu_channel_put(faults[i].refch);
+					faults[i].refch = NULL;
+				}
+				continue;
+			}
+			gv11b_mm_mmu_fault_handle_mmu_fault_common(g,
+					&faults[i], invalidate_replay_val);
+			prev = &faults[i];
+		}
+	} while (n == g->mm.replay_faults_len);
+
+	g->mm.replay_tlb_defer = false;
+	err = gv11b_mm_mmu_fault_replay_tlb_flush(g);
+	if (err != 0) {
+		*invalidate_replay_val |=
+			gv11b_fb_get_replay_cancel_global_val();
+	}
+}
+
 static void gv11b_mm_mmu_fault_handle_replayable(struct gk20a *g,
 		struct mmu_fault_info *mmufault, u32 *invalidate_replay_val)
 {
@@ -865,10 +1071,8 @@ static int gv11b_fb_fix_page_fault(struct gk20a *g,
 		return err;
 	}
 	/* invalidate tlb so that GMMU does not use old cached translation */
-	err = nvgpu_pg_elpg_ms_protected_call(g,
-			g->ops.fb.tlb_invalidate(g, mmufault->refch->vm->pdb.mem));
+	err = gv11b_mm_mmu_fault_replay_tlb_invalidate(g, mmufault->refch->vm);
 	if (err != 0) {
-		nvgpu_err(g, "tlb invalidate failed");
 		return err;
 	}
 
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NVGPU_BOOT_CACHE_H
+#define NVGPU_BOOT_CACHE_H
+
+#include <nvgpu/types.h>
+
+struct gk20a;
+
+/**
+ * @file
+ *
+ * Boot cache
+ * ==========
+ *
+ * The boot cache keeps the products of the two slowest one-time SW steps of a
+ * cold boot in one versioned blob the OS can store and hand back at the next
+ * boot of the same GPU:
+ *
+ * - the netlist image selected by nvgpu_netlist_init_ctx_vars(), so the
+ *   netlist firmware files do not have to be searched again,
+ * - the golden context image and the graphics register init values, so the
+ *   first context allocation does not have to replay sw_ctx_load, the
+ *   bundles and method init and have FECS save the golden context.
+ *
+ * The cache is opt-in: it is only used after nvgpu_boot_cache_init(). A
+ * blob handed in with nvgpu_boot_cache_load() is checked for its format
+ * version, size, checksum and chip. The netlist is only taken if the
+ * netlist firmware file it was read from is unchanged and it is still valid
+ * for the FECS context state store revision of the HW, and the golden image
+ * only if it was built from that netlist and the floorsweeping config and
+ * image size match. Anything that does not match is ignored and rebuilt the
+ * normal way.
+ *
+ * Once the golden image exists nvgpu_boot_cache_save() serializes a fresh
+ * blob for the OS to store.
+ */
+
+/** Blob magic, "NVBC". */
+#define NVGPU_BOOT_CACHE_MAGIC		0x4342564eU
+/** Blob format version. */
+#define NVGPU_BOOT_CACHE_VERSION	2U
+/** Maximum number of GPCs described by a floorsweeping key. */
+#define NVGPU_BOOT_CACHE_MAX_GPCS	16U
+
+/**
+ * Floorsweeping config a golden context image was captured with.
+ */
+struct nvgpu_boot_cache_gr_key {
+	/** Number of GPCs. */
+	u32 gpc_count;
+	/** Number of TPCs. */
+	u32 tpc_count;
+	/** TPC mask of each GPC. */
+	u32 gpc_tpc_mask[NVGPU_BOOT_CACHE_MAX_GPCS];
+};
+
+/**
+ * @brief Enable the boot cache.
+ *
+ * @param g [in]	The GPU.
+ *
+ * Must be called before nvgpu_finalize_poweron() for the netlist and golden
+ * image of this boot to be captured.
+ *
+ * @return 0 in case of success, < 0 otherwise.
+ * @retval -ENOMEM if memory allocation fails.
+ */
+int nvgpu_boot_cache_init(struct gk20a *g);
+
+/**
+ * @brief Disable the boot cache and free its contents.
+ *
+ * @param g [in]	The GPU.
+ */
+void nvgpu_boot_cache_deinit(struct gk20a *g);
+
+/**
+ * @brief Hand a stored blob to the boot cache.
+ *
+ * @param g [in]	The GPU.
+ * @param blob [in]	Blob from nvgpu_boot_cache_save() of an earlier boot.
+ * @param size [in]	Size of \a blob in bytes.
+ *
+ * The blob is copied, so the caller may free it on return. Must be called
+ * after nvgpu_boot_cache_init() and before nvgpu_finalize_poweron().
+ *
+ * @return 0 in case of success, < 0 otherwise.
+ * @retval -EINVAL if the cache is not enabled or the blob is malformed,
+ *	   corrupted or of another format version.
+ * @retval -ENODEV if the blob was saved on another chip.
+ * @retval -ENOMEM if memory allocation fails.
+ */
+int nvgpu_boot_cache_load(struct gk20a *g, const void *blob, size_t size);
+
+/**
+ * @brief Size of the blob nvgpu_boot_cache_save() would write.
+ *
+ * @param g [in]	The GPU.
+ *
+ * @return Blob size in bytes, 0 if the cache is not enabled or the golden
+ *	   context image has not been created yet.
+ */
+size_t nvgpu_boot_cache_save_size(struct gk20a *g);
+
+/**
+ * @brief Serialize the netlist and golden context image into a blob.
+ *
+ * @param g [in]	The GPU.
+ * @param blob [out]	Buffer to write the blob to.
+ * @param size [in]	Size of \a blob in bytes.
+ *
+ * @return 0 in case of success, < 0 otherwise.
+ * @retval -EAGAIN if the cache is not enabled or the golden context image
+ *	   has not been created yet.
+ * @retval -ENOSPC if \a size is less than nvgpu_boot_cache_save_size().
+ */
+int nvgpu_boot_cache_save(struct gk20a *g, void *blob, size_t size);
+
+/**
+ * @brief Get a copy of the cached netlist image.
+ *
+ * @param g [in]	The GPU.
+ * @param net [out]	Netlist index the image was loaded from.
+ * @param size [out]	Size of the image in bytes.
+ *
+ * @return Copy of the image for the caller to free with nvgpu_vfree(), NULL
+ *	   if the cache has none or memory allocation fails.
+ */
+u8 *nvgpu_boot_cache_get_netlist(struct gk20a *g, int *net, u32 *size);
+
+/**
+ * @brief Check the cached netlist against its firmware file.
+ *
+ * @param g [in]	The GPU.
+ * @param fw [in]	Contents of the netlist firmware file.
+ * @param size [in]	Size of \a fw in bytes.
+ *
+ * If the cached netlist was not read from this firmware file, it is dropped
+ * along with the golden context image built from it.
+ *
+ * @return true if the cached netlist was read from \a fw.
+ */
+bool nvgpu_boot_cache_check_netlist(struct gk20a *g, const u8 *fw, u32 size);
+
+/**
+ * @brief Record the netlist image of this boot.
+ *
+ * @param g [in]	The GPU.
+ * @param net [in]	Netlist index the image was loaded from.
+ * @param image [in]	Netlist image.
+ * @param size [in]	Size of \a image in bytes.
+ *
+ * Drops a golden context image that was not built from \a image. Does
+ * nothing if the cache is not enabled.
+ */
+void nvgpu_boot_cache_set_netlist(struct gk20a *g, int net,
+				  const u8 *image, u32 size);
+
+/**
+ * @brief Get the cached golden context image.
+ *
+ * @param g [in]	The GPU.
+ * @param key [in]	Floorsweeping config of this boot.
+ * @param regs [out]	Graphics register init values.
+ * @param regs_size [in]	Size of \a regs in bytes.
+ * @param image [out]	Golden context image.
+ * @param size [in]	Size of \a image in bytes.
+ *
+ * @return 0 if a golden image for \a key and of \a size bytes was copied,
+ *	   -ENOENT otherwise.
+ */
+int nvgpu_boot_cache_get_golden(struct gk20a *g,
+				const struct nvgpu_boot_cache_gr_key *key,
+				void *regs, u32 regs_size,
+				void *image, u64 size);
+
+/**
+ * @brief Record the golden context image of this boot.
+ *
+ * @param g [in]	The GPU.
+ * @param key [in]	Floorsweeping config the image was captured with.
+ * @param regs [in]	Graphics register init values.
+ * @param regs_size [in]	Size of \a regs in bytes.
+ * @param image [in]	Golden context image.
+ * @param size [in]	Size of \a image in bytes.
+ *
+ * Does nothing if the cache is not enabled.
+ */
+void nvgpu_boot_cache_set_golden(struct gk20a *g,
+				 const struct nvgpu_boot_cache_gr_key *key,
+				 const void *regs, u32 regs_size,
+				 const void *image, u64 size);
+
+#endif /* NVGPU_BOOT_CACHE_H */
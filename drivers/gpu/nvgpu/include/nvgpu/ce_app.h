@@ -38,6 +38,9 @@ struct nvgpu_fence_type;
 
 #define NVGPU_CE_MAX_INFLIGHT_JOBS 32U
 
+/* Maximum number of ranges one nvgpu_ce_execute_memset_ranges() covers */
+#define NVGPU_CE_MAX_RANGES_PER_SUBMIT 8U
+
 /*
  * A copyengine job for any buffer size needs at most:
  *
@@ -45,10 +48,11 @@ struct nvgpu_fence_type;
  * - two operations, both either 16 words (transfer) or 15 words (memset)
  *
  * The size does not need to be exact, so this uses the upper bound:
- * 2 + 2 * 16 = 34 words, or 136 bytes.
+ * 2 + 2 * 16 = 34 words, or 136 bytes per range, for up to
+ * NVGPU_CE_MAX_RANGES_PER_SUBMIT ranges in one submit.
  */
 #define NVGPU_CE_MAX_COMMAND_BUFF_BYTES_PER_SUBMIT \
-	((2U + 2U * 16U) * sizeof(u32))
+	(NVGPU_CE_MAX_RANGES_PER_SUBMIT * (2U + 2U * 16U) * sizeof(u32))
 
 /* dma launch_flags */
 	/* location */
@@ -83,6 +87,12 @@ enum {
 	NVGPU_CE_GPU_CTX_DELETED           = (1 << 1),
 };
 
+/* Physical range of a multi-range CE job. */
+struct nvgpu_ce_range {
+	u64 dst_paddr;
+	u64 size;
+};
+
 /* global CE app related apis */
 int nvgpu_ce_app_init_support(struct gk20a *g);
 void nvgpu_ce_app_suspend(struct gk20a *g);
@@ -105,4 +115,16 @@ int nvgpu_ce_execute_ops(struct gk20a *g,
 		u32 request_operation,
 		u32 submit_flags,
 		struct nvgpu_fence_type **fence_out);
+/*
+ * Memset up to NVGPU_CE_MAX_RANGES_PER_SUBMIT ranges with one submit, so one
+ * fence covers all of them.
+ */
+int nvgpu_ce_execute_memset_ranges(struct gk20a *g,
+		u32 ce_ctx_id,
+		const struct nvgpu_ce_range *ranges,
+		u32 num_ranges,
+		u32 payload,
+		u32 launch_flags,
+		u32 submit_flags,
+		struct nvgpu_fence_type **fence_out);
 #endif /*NVGPU_CE_APP_H*/
@@ -51,6 +51,7 @@ struct priv_cmd_entry;
 struct nvgpu_channel_wdt;
 struct nvgpu_user_fence;
 struct nvgpu_runlist;
+struct nvgpu_channel_job;
 
 /**
  * S/W defined invalid channel identifier.
@@ -135,6 +136,27 @@ struct nvgpu_gpfifo_entry {
 	u32 entry1;
 };
 
+/**
+ * One channel's work in a batched kernel mode submit.
+ * See #nvgpu_submit_channel_gpfifo_kernel_batch.
+ */
+struct nvgpu_submit_batch_entry {
+	/** Channel to submit on. */
+	struct nvgpu_channel *c;
+	/** Kernel gpfifo entries to append. */
+	struct nvgpu_gpfifo_entry *gpfifo;
+	/** Number of entries in gpfifo. */
+	u32 num_entries;
+	/** NVGPU_SUBMIT_FLAGS_* for this channel. */
+	u32 flags;
+	/** Pre-fence, used with NVGPU_SUBMIT_FLAGS_FENCE_WAIT. */
+	struct nvgpu_channel_fence *fence;
+	/** Post fence out, may be NULL. */
+	struct nvgpu_fence_type **fence_out;
+	/** Per-channel result, filled in by the batch submit. */
+	int err;
+};
+
 struct gpfifo_desc {
 	/** Memory area containing gpfifo entries. */
 	struct nvgpu_mem mem;
@@ -258,14 +280,36 @@ struct notification {
 	u16 status;
 };
 
+struct nvgpu_channel_job_chunk;
+
+/**
+ * Jobs in flight, in submit order.
+ *
+ * This is a single-producer single-consumer queue: the submit path is the only
+ * producer and job cleanup the only consumer, so neither side takes a lock.
+ * The jobs live in a ring of fixed-size chunks. The producer splices a new
+ * chunk into the ring when the next one still holds jobs in flight, so the
+ * ring only grows to the high-water mark of the channel. Deterministic
+ * channels preallocate enough chunks for \a capacity jobs up front and never
+ * grow.
+ */
 struct nvgpu_channel_joblist {
-	struct {
-		unsigned int length;
-		unsigned int put;
-		unsigned int get;
-		struct nvgpu_channel_job *jobs;
-		struct nvgpu_mutex read_lock;
-	} pre_alloc;
+	/** Max number of jobs in flight. */
+	u32 capacity;
+	/** Number of jobs added so far, written by the producer only. */
+	u32 put;
+	/** Number of jobs deleted so far, written by the consumer only. */
+	u32 get;
+	/** Number of chunks in the ring, owned by the producer. */
+	u32 num_chunks;
+	/** Chunk the next job is allocated from, owned by the producer. */
+	struct nvgpu_channel_job_chunk *tail;
+	/** Index of the next job in \a tail. */
+	u32 tail_idx;
+	/** Chunk of the oldest job, owned by the consumer. */
+	struct nvgpu_channel_job_chunk *head;
+	/** Index of the oldest job in \a head. */
+	u32 head_idx;
 };
 
 /**
@@ -339,6 +383,13 @@ struct nvgpu_channel {
 	 * has been set up, and bound in CCSR).
 	 */
 	nvgpu_atomic_t bound;
+	/** Threads waiting on #semaphore_wq outside of job fences. */
+	nvgpu_atomic_t semaphore_waiters;
+	/**
+	 * Work not tracked in jobs (usermode submit, submits without job
+	 * tracking) may release semaphores; always wake up this channel.
+	 */
+	bool semaphore_untracked;
 
 	/** Channel Identifier. */
 	u32 chid;
@@ -388,6 +439,10 @@ struct nvgpu_channel {
 	struct nvgpu_mem usermode_gpfifo;
 	/** Channel instance block memory. */
 	struct nvgpu_mem inst_block;
+	/** Address of #inst_block as indexed in #nvgpu_fifo.inst_hash. */
+	u64 inst_hash_addr;
+	/** Next chid + 1 in the same #nvgpu_fifo.inst_hash bucket, or 0. */
+	u32 inst_hash_next;
 
 	/**
 	 * USERD address that will be programmed in H/W.
@@ -578,6 +633,29 @@ int nvgpu_submit_channel_gpfifo_kernel(struct nvgpu_channel *c,
 				u32 flags,
 				struct nvgpu_channel_fence *fence,
 				struct nvgpu_fence_type **fence_out);
+
+/**
+ * @brief Submit kernel gpfifo entries to several channels at once.
+ *
+ * @param g [in]			The GPU driver struct.
+ * @param entries [in,out]		Per-channel submit descriptors.
+ * @param num_batch_entries [in]	Number of descriptors.
+ *
+ * Equivalent to calling #nvgpu_submit_channel_gpfifo_kernel for each
+ * descriptor in order, but the GPU power ref, the deterministic_busy lock
+ * and the debug settings update are taken once per batch, and GP_PUT is
+ * written once per channel after all of its entries have been appended. A
+ * channel may appear more than once in the batch.
+ *
+ * The result of each submit is stored in the descriptor's err field; a
+ * failing entry does not stop the remaining ones.
+ *
+ * @return 0 if every entry was submitted, otherwise the error of the first
+ *         failing entry.
+ */
+int nvgpu_submit_channel_gpfifo_kernel_batch(struct gk20a *g,
+				struct nvgpu_submit_batch_entry *entries,
+				u32 num_batch_entries);
 #ifdef CONFIG_TEGRA_GK20A_NVHOST
 int nvgpu_channel_set_syncpt(struct nvgpu_channel *ch);
 #endif
@@ -777,11 +855,42 @@ void nvgpu_channel_abort_clean_up(struct nvgpu_channel *ch);
  * @param post_events [in]	When true, notify all threads waiting
  *				on TSG events.
  *
- * Goes through all channels, and wakes up semaphore wait queue.
- * If #post_events is true, it also wakes up TSG event wait queue.
+ * Goes through the channels that have jobs in flight, semaphore waiters or
+ * untracked work (see #nvgpu_fifo.sema_wakeup_chs), and wakes up semaphore
+ * wait queue. If #post_events is true, it also wakes up TSG event wait queue.
+ * Channels that no longer need wakeups are dropped from the set.
  */
 void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events);
 
+/**
+ * @brief Mark channel to always get semaphore wakeups.
+ *
+ * @param ch [in]	Channel pointer.
+ *
+ * Work that is not tracked in jobs can release semaphores at any time, so
+ * the channel is woken up on every semaphore interrupt until it is closed.
+ */
+void nvgpu_channel_semaphore_set_untracked(struct nvgpu_channel *ch);
+
+/**
+ * @brief Register a thread about to wait on channel's semaphore_wq.
+ *
+ * @param ch [in]	Channel pointer.
+ *
+ * Waits on #nvgpu_channel.semaphore_wq that are not for a job fence must be
+ * enclosed in #nvgpu_channel_semaphore_wait_begin and
+ * #nvgpu_channel_semaphore_wait_end, so that semaphore interrupts wake the
+ * channel up meanwhile.
+ */
+void nvgpu_channel_semaphore_wait_begin(struct nvgpu_channel *ch);
+
+/**
+ * @brief Unregister a thread done waiting on channel's semaphore_wq.
+ *
+ * @param ch [in]	Channel pointer.
+ */
+void nvgpu_channel_semaphore_wait_end(struct nvgpu_channel *ch);
+
 /**
  * @brief Enable all channels in channel's TSG
  *
@@ -27,6 +27,7 @@
 
 #include <nvgpu/lock.h>
 #include <nvgpu/types.h>
+#include <nvgpu/hbitmap.h>
 
 struct gk20a;
 struct nvgpu_os_buffer;
@@ -65,8 +66,11 @@ struct gk20a_comptag_allocator {
 
 	struct nvgpu_mutex lock;
 
-	/* This bitmap starts at ctag 1. 0th cannot be taken. */
-	unsigned long *bitmap;
+	/*
+	 * This bitmap starts at ctag 1. 0th cannot be taken. Its summary lets
+	 * allocations skip over the fully used part of a large backing store.
+	 */
+	struct nvgpu_hbitmap bitmap;
 
 	/* Size of bitmap, not max ctags, so one less. */
 	unsigned long size;
@@ -35,6 +35,9 @@
 /* the minimal size of HW buffer - should be enough to avoid HW overflows */
 #define CSS_MIN_HW_SNAPSHOT_SIZE	(8 * 1024 * 1024)
 
+/* nvgpu_css_attach() flag: read the HW buffer in place, see hw_cursor */
+#define NVGPU_CSS_ATTACH_HW_CURSOR	BIT32(0)
+
 struct gk20a;
 struct nvgpu_channel;
 
@@ -109,6 +112,15 @@ struct gk20a_cs_snapshot_client {
 	u32			snapshot_size;
 	u32			perfmon_start;
 	u32			perfmon_count;
+	/*
+	 * Set by nvgpu_css_attach() for NVGPU_CSS_ATTACH_HW_CURSOR: the
+	 * client maps the HW snapshot buffer read-only and reads its entries
+	 * in place. Nothing is copied for such a client; its fifo header is a
+	 * cursor into the HW buffer instead: start/end describe the HW
+	 * buffer, the kernel publishes the end of the completed entries in
+	 * put and the client moves get past the entries it has read.
+	 */
+	bool			hw_cursor;
 };
 
 static inline struct gk20a_cs_snapshot_client *
@@ -132,7 +144,14 @@ struct gk20a_cs_snapshot {
 	/* pointer to allocated cpu_va memory where GPU place data */
 	struct gk20a_cs_snapshot_fifo_entry	*hw_snapshot;
 	struct gk20a_cs_snapshot_fifo_entry	*hw_end;
+	/* oldest entry not handed back to HW yet */
 	struct gk20a_cs_snapshot_fifo_entry	*hw_get;
+	/* next entry to process; entries from hw_get are held for cursors */
+	struct gk20a_cs_snapshot_fifo_entry	*hw_scan;
+	/* number of attached hw_cursor clients */
+	u32			cursor_clients;
+	/* owner of each perfmon ID */
+	struct gk20a_cs_snapshot_client	*perfmon_clients[CSS_MAX_PERFMON_IDS];
 };
 
 bool nvgpu_css_get_overflow_status(struct gk20a *g);
@@ -149,11 +168,12 @@ u32 nvgpu_css_release_perfmon_ids(struct gk20a_cs_snapshot *data,
 int nvgpu_css_check_data_available(struct nvgpu_channel *ch, u32 *pending,
 					bool *hw_overflow);
 struct gk20a_cs_snapshot_client *
-nvgpu_css_gr_search_client(struct nvgpu_list_node *clients, u32 perfmon);
+nvgpu_css_gr_find_client(struct gk20a_cs_snapshot *data, u32 perfmon);
 
 int nvgpu_css_attach(struct nvgpu_channel *ch,   /* in - main hw structure */
 			u32 perfmon_id_count,	    /* in - number of perfmons*/
 			u32 *perfmon_id_start,	    /* out- index of first pm */
+			u32 flags,		    /* in - NVGPU_CSS_ATTACH_* */
 			/* in/out - pointer to client data used in later     */
 			struct gk20a_cs_snapshot_client *css_client);
 
@@ -191,6 +191,7 @@
 
 #include <nvgpu/types.h>
 #include <nvgpu/lock.h>
+#include <nvgpu/atomic.h>
 #include <nvgpu/kref.h>
 #include <nvgpu/list.h>
 #include <nvgpu/swprofile.h>
@@ -243,6 +244,13 @@ struct nvgpu_fifo {
 	/** Number of runlist entries per runlist as supported by the h/w. */
 	unsigned int num_runlist_entries;
 
+	/**
+	 * Patch only the affected TSG's entries when a single channel is
+	 * added to or removed from a non-interleaved runlist, instead of
+	 * rebuilding the whole runlist buffer.
+	 */
+	bool runlist_incremental;
+
 	/**
 	 * Array of pointers to the engines that host controls. The size is
 	 * based on the GPU litter value HOST_NUM_ENGINES. This is indexed by
@@ -323,6 +331,31 @@ struct nvgpu_fifo {
 	 */
 	struct nvgpu_mutex free_chs_mutex;
 
+	/**
+	 * Hash buckets of channels by instance block address, for looking
+	 * up channels from fault and interrupt info. Each bucket holds the
+	 * first chid + 1 in the chain, or 0 if the bucket is empty; the
+	 * chains continue in #nvgpu_channel.inst_hash_next.
+	 */
+	u32 *inst_hash;
+	/** Number of buckets in #inst_hash, a power of two. */
+	u32 inst_hash_size;
+	/** Serializes updates of #inst_hash and the chains. */
+	struct nvgpu_spinlock inst_hash_lock;
+	/**
+	 * Odd while #inst_hash is being updated. Lookups don't take
+	 * #inst_hash_lock but retry if this changed under them.
+	 */
+	nvgpu_atomic_t inst_hash_seq;
+
+	/**
+	 * Bitmap of channels that may need a wakeup on semaphore interrupts,
+	 * i.e. channels with jobs in flight, semaphore waiters or work that
+	 * isn't tracked in jobs. Only these are visited by
+	 * #nvgpu_channel_semaphore_wakeup().
+	 */
+	unsigned long *sema_wakeup_chs;
+
 	/** Lock used to prevent multiple recoveries. */
 	struct nvgpu_mutex engines_reset_mutex;
 
@@ -335,6 +368,10 @@ struct nvgpu_fifo {
 	 * #num_channels number of TSG.
 	 */
 	struct nvgpu_tsg *tsg;
+	/**
+	 * Backing store of #nvgpu_tsg.ch_bitmap of all #num_channels TSGs.
+	 */
+	unsigned long *tsg_ch_bitmaps;
 	/**
 	 * Lock used to read and update #nvgpu_tsg.in_use. TSG entry is
 	 * in use when a TSG is opened and not in use when TSG is closed
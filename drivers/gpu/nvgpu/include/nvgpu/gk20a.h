@@ -111,6 +111,7 @@ struct gk20a_cs_snapshot;
 #ifdef CONFIG_NVGPU_DEBUGGER
 struct dbg_session_gk20a;
 struct nvgpu_dbg_reg_op;
+struct nvgpu_regops_allowlist;
 #endif
 #ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
 struct _resmgr_context;
@@ -121,6 +122,8 @@ struct clk_domains_mon_status_params;
 #endif
 struct nvgpu_cic_mon;
 struct nvgpu_cic_rm;
+struct nvgpu_init_timing;
+struct nvgpu_boot_cache;
 #ifdef CONFIG_NVGPU_GSP_SCHEDULER
 struct nvgpu_gsp_sched;
 #endif
@@ -465,6 +468,19 @@ struct gk20a {
 	/** An entry into list of callbacks to be called when BUG() is hit. */
 	struct nvgpu_list_node bug_node;
 
+	/**
+	 * Per stage wall clock times of the last nvgpu_early_poweron(), NULL
+	 * unless gpu_dbg_info logging was enabled.
+	 */
+	struct nvgpu_init_timing *early_init_timing;
+	/**
+	 * Per stage wall clock times of the last nvgpu_finalize_poweron(),
+	 * NULL unless gpu_dbg_info logging was enabled.
+	 */
+	struct nvgpu_init_timing *poweron_timing;
+	/** Netlist and golden image kept across boots, NULL if disabled. */
+	struct nvgpu_boot_cache *boot_cache;
+
 	/** Controls which messages are logged */
 	u64 log_mask;
 #ifdef CONFIG_NVGPU_NON_FUSA
@@ -646,6 +662,9 @@ struct gk20a {
 	struct nvgpu_dbg_reg_op *dbg_regops_tmp_buf;
 	u32 dbg_regops_tmp_buf_ops;
 
+	/* regops whitelists compiled by nvgpu_regops_allowlist_init() */
+	struct nvgpu_regops_allowlist *regops_allowlist;
+
 	/* For perfbuf mapping */
 	struct {
 		struct dbg_session_gk20a *owner;
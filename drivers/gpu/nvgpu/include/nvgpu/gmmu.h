@@ -280,6 +280,46 @@ static inline const char *nvgpu_gmmu_perm_str(enum gk20a_mem_rw_flag p)
  */
 int nvgpu_gmmu_init_page_table(struct vm_gk20a *vm);
 
+/**
+ * @brief Enable parallel PTE population for large mappings.
+ *
+ * @param g		[in]	The GPU.
+ * @param num_workers	[in]	Number of fill worker threads to start.
+ * @param min_length	[in]	Mappings at least this long are filled in
+ *				in parallel.
+ *
+ * Start a pool of worker threads that fill in the PTE level of mappings of
+ * at least \a min_length bytes. For such a mapping all PDs are allocated and
+ * all PDEs are programmed by the mapping thread first; the last level PDE
+ * subtrees are then split among the workers and the mapping thread. The
+ * mapping does not return until all PTEs are written, so TLB invalidate
+ * batching through #vm_gk20a_mapping_batch is unaffected.
+ *
+ * Only one mapping at a time uses the pool; concurrent mappings on other VMs
+ * and mappings whose PDs are not in sysmem are filled in serially.
+ *
+ * @return	0 in case of success, < 0 otherwise.
+ * @retval	-EINVAL if \a num_workers is 0 or the pool already exists.
+ * @retval	-ENOMEM if memory allocation fails.
+ */
+int nvgpu_gmmu_pt_fill_init(struct gk20a *g, u32 num_workers, u64 min_length);
+
+/**
+ * Smallest mapping filled in by the pool when the platform does not set
+ * mm_gk20a.pt_fill_min_length.
+ */
+#define NVGPU_GMMU_PT_FILL_DEFAULT_MIN_LENGTH	(1ULL << 30)
+
+/**
+ * @brief Stop the parallel PTE population workers.
+ *
+ * @param g		[in]	The GPU.
+ *
+ * Waits for a mapping currently using the pool, then stops the workers and
+ * frees the pool. Does nothing if the pool was never started.
+ */
+void nvgpu_gmmu_pt_fill_deinit(struct gk20a *g);
+
 /**
  * @brief Map memory into the GMMU. This is required to make the particular
  * context on the GR, CE to access the given virtual address.
@@ -587,8 +627,6 @@ u64 nvgpu_gmmu_map_locked(struct vm_gk20a *vm,
  * Native GPU "HAL" functions for GMMU Unmap.
  *
  * Locked version of GMMU Unmap routine:
- * Free the reserved GPU VA space staring at \a gpu_va.
- * #nvgpu_vm_free_va does free the GPU VA space.
  * Program PDE and PTE entry with default information which is internally
  *  frees up the GPU VA space.
  * Chip specific stuff is handled at the PTE/PDE programming HAL layer.
@@ -596,6 +634,8 @@ u64 nvgpu_gmmu_map_locked(struct vm_gk20a *vm,
  *  (i.e, gv11b).
  * Flush the GPU L2. gv11b_mm_l2_flush does the L2 flush.
  * Invalidates the GPU TLB, gm20b_fb_tlb_invalidate does the tlb invalidate.
+ * Free the reserved GPU VA space staring at \a gpu_va.
+ * #nvgpu_vm_free_va does free the GPU VA space.
  *
  * @return	None.
  */
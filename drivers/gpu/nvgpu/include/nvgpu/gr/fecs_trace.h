@@ -38,6 +38,11 @@
 #define GK20A_FECS_TRACE_FRAME_PERIOD_NS	(1000000000ULL/60ULL)
 #define GK20A_FECS_TRACE_PTIMER_SHIFT		5
 
+/* Number of buckets of the context_ptr -> pid hash, a power of two. */
+#define NVGPU_FECS_TRACE_CONTEXT_HASH_BITS	8U
+#define NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE	\
+	(1U << NVGPU_FECS_TRACE_CONTEXT_HASH_BITS)
+
 #define NVGPU_GPU_CTXSW_TAG_SOF                     0x00U
 #define NVGPU_GPU_CTXSW_TAG_CTXSW_REQ_BY_HOST       0x01U
 #define NVGPU_GPU_CTXSW_TAG_FE_ACK                  0x02U
@@ -65,10 +70,31 @@ struct nvgpu_gr_subctx;
 struct nvgpu_gr_ctx;
 struct nvgpu_tsg;
 struct vm_area_struct;
+struct nvgpu_kmem_cache;
+struct nvgpu_fecs_trace_context_entry;
+
+/* pid and vmid a context_ptr resolved to. */
+struct nvgpu_fecs_trace_pid {
+	pid_t pid;
+	u32 vmid;
+};
 
 struct nvgpu_gr_fecs_trace {
-	struct nvgpu_list_node context_list;
-	struct nvgpu_mutex list_lock;
+	/*
+	 * Bound contexts hashed by context_ptr. Lookups don't take hash_lock:
+	 * they run under poll_lock, and removed entries are only returned to
+	 * context_cache once poll_lock has been cycled.
+	 */
+	struct nvgpu_fecs_trace_context_entry *
+		context_hash[NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE];
+	struct nvgpu_mutex hash_lock;
+	struct nvgpu_kmem_cache *context_cache;
+
+	/*
+	 * Current and new context pid of each record of one poll, resolved
+	 * in a single pass before the records are decoded.
+	 */
+	struct nvgpu_fecs_trace_pid *batch;
 
 	struct nvgpu_mutex poll_lock;
 	struct nvgpu_periodic_timer poll_timer;
@@ -124,15 +150,8 @@ struct nvgpu_fecs_trace_context_entry {
 	pid_t pid;
 	u32 vmid;
 
-	struct nvgpu_list_node entry;
-};
-
-static inline struct nvgpu_fecs_trace_context_entry *
-nvgpu_fecs_trace_context_entry_from_entry(struct nvgpu_list_node *node)
-{
-	return (struct nvgpu_fecs_trace_context_entry *)
-		((uintptr_t)node -
-		offsetof(struct nvgpu_fecs_trace_context_entry, entry));
+	/* Next entry in the same nvgpu_gr_fecs_trace.context_hash bucket. */
+	struct nvgpu_fecs_trace_context_entry *hash_next;
 };
 
 int nvgpu_gr_fecs_trace_init(struct gk20a *g);
@@ -145,13 +164,12 @@ bool nvgpu_gr_fecs_trace_is_valid_record(struct gk20a *g,
 	struct nvgpu_fecs_trace_record *r);
 
 int nvgpu_gr_fecs_trace_add_context(struct gk20a *g, u32 context_ptr,
-	pid_t pid, u32 vmid, struct nvgpu_list_node *list);
-void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list);
-void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g,
-	struct nvgpu_list_node *list);
+	pid_t pid, u32 vmid);
+void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr);
+void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g);
+/* Must be called with nvgpu_gr_fecs_trace.poll_lock held. */
 void nvgpu_gr_fecs_trace_find_pid(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list, pid_t *pid, u32 *vmid);
+	pid_t *pid, u32 *vmid);
 
 size_t nvgpu_gr_fecs_trace_buffer_size(struct gk20a *g);
 int nvgpu_gr_fecs_trace_max_entries(struct gk20a *g,
@@ -333,9 +333,14 @@ struct nvgpu_posix_fault_inj *nvgpu_golden_ctx_verif_get_fault_injection(void);
 struct nvgpu_posix_fault_inj *nvgpu_local_golden_image_get_fault_injection(void);
 #endif
 
-#ifdef CONFIG_NVGPU_DEBUGGER
+/**
+ * @brief Get pointer to local golden context image data.
+ *
+ * @param local_golden_image [in]	Pointer to local golden context image struct.
+ *
+ * @return Pointer to the local golden context image data.
+ */
 u32 *nvgpu_gr_global_ctx_get_local_golden_image_ptr(
 	struct nvgpu_gr_global_ctx_local_golden_image *local_golden_image);
-#endif
 
 #endif /* NVGPU_GR_GLOBAL_CTX_H */
@@ -26,6 +26,7 @@
 #ifdef CONFIG_NVGPU_DEBUGGER
 
 #include <nvgpu/types.h>
+#include <nvgpu/lock.h>
 
 struct gk20a;
 struct ctxsw_buf_offset_map_entry;
@@ -45,6 +46,39 @@ struct nvgpu_gr_hwpm_map {
 	bool init;
 };
 
+/*
+ * Resolved context buffer offsets of one register address, as computed by
+ * gr_gk20a_get_ctx_buffer_offsets() for the largest possible max_offsets.
+ */
+struct nvgpu_gr_ctx_offset_map_entry {
+	u32 addr;
+	/* Error of the first failed priv offset lookup, 0 if none failed. */
+	int err;
+	/* Number of unicast registers the address expands to. */
+	u32 num_registers;
+	/* Number of leading registers whose offset was found. */
+	u32 num_found;
+	/* num_found offsets followed by their num_found register addresses. */
+	u32 *offsets;
+};
+
+/*
+ * Cache of gr_gk20a_get_ctx_buffer_offsets() results, sorted by address.
+ * The offsets only depend on the golden context image and the floorswept
+ * config, which both live as long as the gr instance, so entries are never
+ * invalidated.
+ */
+struct nvgpu_gr_ctx_offset_map {
+	struct nvgpu_mutex lock;
+
+	u32 count;
+	u32 capacity;
+	struct nvgpu_gr_ctx_offset_map_entry *map;
+};
+
+/* Upper bound of addresses cached by a nvgpu_gr_ctx_offset_map. */
+#define NVGPU_GR_CTX_OFFSET_MAP_MAX_ENTRIES	8192U
+
 int nvgpu_gr_hwpm_map_init(struct gk20a *g, struct nvgpu_gr_hwpm_map **hwpm_map,
 	u32 size);
 void nvgpu_gr_hwpm_map_deinit(struct gk20a *g,
@@ -56,5 +90,27 @@ int nvgpu_gr_hwmp_map_find_priv_offset(struct gk20a *g,
 	struct nvgpu_gr_hwpm_map *hwpm_map,
 	u32 addr, u32 *priv_offset, struct nvgpu_gr_config *config);
 
+int nvgpu_gr_ctx_offset_map_init(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map **ctx_offset_map);
+void nvgpu_gr_ctx_offset_map_deinit(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map *ctx_offset_map);
+
+/*
+ * Look up the cached offsets of addr and apply max_offsets the way
+ * gr_gk20a_get_ctx_buffer_offsets() does. Returns -ENOENT if addr is not
+ * cached, else the result of the cached lookup.
+ */
+int nvgpu_gr_ctx_offset_map_find(struct nvgpu_gr_ctx_offset_map *ctx_offset_map,
+	u32 addr, u32 max_offsets, u32 *offsets, u32 *offset_addrs,
+	u32 *num_offsets);
+/*
+ * Cache the offsets resolved for addr. Failing to cache is not an error,
+ * the offsets are then resolved again on the next lookup.
+ */
+void nvgpu_gr_ctx_offset_map_add(struct gk20a *g,
+	struct nvgpu_gr_ctx_offset_map *ctx_offset_map,
+	u32 addr, int err, u32 num_registers, u32 num_found,
+	const u32 *offsets, const u32 *offset_addrs);
+
 #endif /* CONFIG_NVGPU_DEBUGGER */
 #endif /* NVGPU_GR_HWPM_MAP_H */
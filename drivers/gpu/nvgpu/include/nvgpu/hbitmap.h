@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NVGPU_HBITMAP_H
+#define NVGPU_HBITMAP_H
+
+#include <nvgpu/types.h>
+
+struct gk20a;
+
+/**
+ * @file
+ *
+ * Hierarchical bitmap
+ * ===================
+ *
+ * A bitmap with a one bit per word summary on top of it. Bit n of the summary
+ * is set when word n of the bitmap has no zero bit left. Searches for free
+ * (zero) space walk the summary to step over full words, and over 64 full
+ * words at a time where a whole summary word is full, instead of reading
+ * every word of the bitmap.
+ *
+ * The bitmap is only updated through nvgpu_hbitmap_set() and
+ * nvgpu_hbitmap_clear(), which keep the summary in sync. Like the plain
+ * bitmap ops, updates are not atomic: the owner serializes them with its own
+ * lock.
+ */
+
+/**
+ * Hierarchical bitmap.
+ */
+struct nvgpu_hbitmap {
+	/** The bitmap, one bit per tracked item. */
+	unsigned long *map;
+	/** Summary, one bit per word of \a map, set if that word is full. */
+	unsigned long *full;
+	/** Number of bits in \a map. */
+	unsigned long nbits;
+	/** Number of words in \a map, i.e. number of bits in \a full. */
+	unsigned long nwords;
+};
+
+/**
+ * @brief Allocate an all zero hierarchical bitmap.
+ *
+ * @param g [in]	The GPU.
+ * @param hb [out]	Bitmap to initialize.
+ * @param nbits [in]	Number of bits.
+ *
+ * @return 0 in case of success, < 0 otherwise.
+ * @retval -EINVAL if \a nbits is 0.
+ * @retval -ENOMEM if memory allocation fails.
+ */
+int nvgpu_hbitmap_init(struct gk20a *g, struct nvgpu_hbitmap *hb,
+		       unsigned long nbits);
+
+/**
+ * @brief Free a hierarchical bitmap.
+ *
+ * @param g [in]	The GPU.
+ * @param hb [in]	Bitmap to free.
+ */
+void nvgpu_hbitmap_deinit(struct gk20a *g, struct nvgpu_hbitmap *hb);
+
+/**
+ * @brief Set a range of bits.
+ *
+ * @param hb [in]	Bitmap.
+ * @param start [in]	First bit to set.
+ * @param len [in]	Number of bits to set.
+ *
+ * Sets the bits with nvgpu_bitmap_set() and marks the words that became full
+ * in the summary. The range must lie within the bitmap.
+ */
+void nvgpu_hbitmap_set(struct nvgpu_hbitmap *hb, u32 start, u32 len);
+
+/**
+ * @brief Clear a range of bits.
+ *
+ * @param hb [in]	Bitmap.
+ * @param start [in]	First bit to clear.
+ * @param len [in]	Number of bits to clear.
+ *
+ * Clears the bits with nvgpu_bitmap_clear() and unmarks the touched words in
+ * the summary. The range must lie within the bitmap.
+ */
+void nvgpu_hbitmap_clear(struct nvgpu_hbitmap *hb, u32 start, u32 len);
+
+/**
+ * @brief Find the first zero area that fits a request.
+ *
+ * @param hb [in]		Bitmap.
+ * @param size [in]		Only search below this bit.
+ * @param start [in]		Bit to start the search at.
+ * @param nr [in]		Number of zero bits needed.
+ * @param align_mask [in]	Alignment mask of the area start, 0 for none.
+ *
+ * Same contract as bitmap_find_next_zero_area() but full words are stepped
+ * over through the summary.
+ *
+ * @return First bit of the area, \a size (clamped to the bitmap size) if no
+ *	   area fits.
+ */
+unsigned long nvgpu_hbitmap_find_next_zero_area(const struct nvgpu_hbitmap *hb,
+						unsigned long size,
+						unsigned long start,
+						u32 nr,
+						unsigned long align_mask);
+
+#endif /* NVGPU_HBITMAP_H */
@@ -45,8 +45,7 @@ int nvgpu_channel_alloc_job(struct nvgpu_channel *c,
 void nvgpu_channel_free_job(struct nvgpu_channel *c,
 		struct nvgpu_channel_job *job);
 
-void nvgpu_channel_joblist_lock(struct nvgpu_channel *c);
-void nvgpu_channel_joblist_unlock(struct nvgpu_channel *c);
+bool nvgpu_channel_joblist_is_empty(struct nvgpu_channel *c);
 struct nvgpu_channel_job *nvgpu_channel_joblist_peek(struct nvgpu_channel *c);
 void nvgpu_channel_joblist_add(struct nvgpu_channel *c,
 		struct nvgpu_channel_job *job);
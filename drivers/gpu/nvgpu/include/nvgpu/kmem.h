@@ -78,16 +78,15 @@ struct nvgpu_mem_alloc_tracker;
  * @brief Create an nvgpu memory cache.
  *
  * The internal implementation of the function is OS specific. In Posix
- * implementation, the function would just allocate a normal malloc memory for
- * the cache structure using \a malloc and populates the variables \a g and
- * \a size in struct #nvgpu_kmem_cache. This cache can be used to allocate
+ * implementation, the function allocates the cache structure, populates the
+ * variables \a g and \a size in struct #nvgpu_kmem_cache and sets up an empty
+ * slab depot for objects of \a size bytes. This cache can be used to allocate
  * objects of size \a size. Common usage would be for a struct that gets
  * allocated a lot. In that case \a size should be sizeof(struct my_struct).
  * A given implementation of this need not do anything special. The allocation
  * routines can simply be passed on to #nvgpu_kzalloc() if desired, so packing
- * and alignment of the structs cannot be assumed. In Posix implementation, the
- * allocation from this cache would just return a normal malloc memory of size
- * \a size. Function does not perform any validation of the input parameters.
+ * and alignment of the structs cannot be assumed. Function does not perform
+ * any validation of the input parameters.
  *
  * @param g [in] The GPU driver struct using this cache.
  * @param size [in] Size of the object allocated by the cache.
@@ -102,8 +101,11 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size);
  * @brief Destroy a cache created by #nvgpu_kmem_cache_create().
  *
  * Destroy the allocated OS specific internal structure to avoid memory leak.
- * Uses the function \a free() with \a cache as parameter. Function does not
- * perform any validation of the parameter.
+ * Every object allocated from \a cache must have been freed back to it
+ * before; objects must not be used after the cache is destroyed. In Posix
+ * implementation this releases every slab of the cache. If objects are still
+ * in use a warning is logged and the slabs are leaked instead, so that those
+ * objects are not freed under their owners.
  *
  * @param cache [in] The cache to destroy.
  */
@@ -113,10 +115,10 @@ void nvgpu_kmem_cache_destroy(struct nvgpu_kmem_cache *cache);
  * @brief Allocate an object from the cache
  *
  * Allocate an object from a cache created using #nvgpu_kmem_cache_create().
- * In Posix implementation, this function would just return a normal malloc
- * memory allocated using the function \a malloc with \a size in struct
- * #nvgpu_kmem_cache as parameter. Function does not perform any validation of
- * the parameter.
+ * In Posix implementation, the object is taken from the calling thread's
+ * magazine for this cache; an empty magazine is refilled from the shared slab
+ * depot, which grows by a new slab when it runs dry. The object is not
+ * cleared. Function does not perform any validation of the parameter.
  *
  * @param cache [in] The cache to alloc from.
  *
@@ -130,8 +132,10 @@ void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache);
  * @brief Free an object back to a cache
  *
  * Free an object back to a cache allocated using #nvgpu_kmem_cache_alloc().
- * Uses the function \a free with \a ptr as argument to free the allocated
- * memory. Function does not perform any validation of the input parameters.
+ * In Posix implementation, the object goes to the calling thread's magazine;
+ * a full magazine returns half of its objects to the shared slab depot. Slab
+ * memory is only released by #nvgpu_kmem_cache_destroy(). Function does not
+ * perform any validation of the input parameters.
  *
  * @param cache [in] The cache to return the object to.
  * @param ptr [in] Pointer to the object to free.
@@ -172,6 +172,7 @@ struct gk20a;
 struct vm_gk20a;
 struct nvgpu_mem;
 struct nvgpu_pd_cache;
+struct nvgpu_gmmu_pt_fill;
 
 /**
  * This flag designates the requested operations on various units
@@ -324,6 +325,12 @@ struct mm_gk20a {
 	 */
 	struct nvgpu_pd_cache *pd_cache;
 
+	/**
+	 * Worker pool filling in the PTEs of very large mappings in parallel.
+	 * NULL unless enabled with nvgpu_gmmu_pt_fill_init().
+	 */
+	struct nvgpu_gmmu_pt_fill *pt_fill;
+
 	/** Lock to serialize L2 operations. */
 	struct nvgpu_mutex l2_op_lock;
 	/** Lock to serialize TLB operations. */
@@ -340,6 +347,22 @@ struct mm_gk20a {
 	struct mmu_fault_info fault_info[NVGPU_MMU_FAULT_TYPE_NUM];
 	/** Lock to serialize Hub isr Operations. */
 	struct nvgpu_mutex hub_isr_mutex;
+#ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+	/**
+	 * Replayable faults drained from the replay fault buffer, to be
+	 * sorted and serviced as one batch. Protected by #hub_isr_mutex.
+	 */
+	struct mmu_fault_info *replay_faults;
+	/** Number of entries in #replay_faults. */
+	u32 replay_faults_len;
+	/**
+	 * VM whose TLB invalidate is deferred until the current replay batch
+	 * has been serviced, NULL if there is none. Holds a VM reference.
+	 */
+	struct vm_gk20a *replay_tlb_vm;
+	/** Defer the TLB invalidates of fixed PTEs to the end of the batch. */
+	bool replay_tlb_defer;
+#endif
 #ifdef CONFIG_NVGPU_DGPU
 	/**
 	 * Separate function to cleanup the CE since it requires a channel to
@@ -369,6 +392,18 @@ struct mm_gk20a {
 	/** Disable big page support. */
 	bool disable_bigpage;
 
+	/**
+	 * Number of workers of the parallel PTE fill pool, set by the OS
+	 * layer before MM init. 0 leaves the pool off.
+	 */
+	u32 pt_fill_workers;
+
+	/**
+	 * Smallest mapping in bytes handed to the parallel PTE fill pool;
+	 * 0 selects #NVGPU_GMMU_PT_FILL_DEFAULT_MIN_LENGTH.
+	 */
+	u64 pt_fill_min_length;
+
 	/**
 	 * 4K bytes memory which is used for memory scrubbing
 	 * during GPU poweron.
@@ -414,6 +449,11 @@ struct mm_gk20a {
 		u32 ce_ctx_id;
 		/** True if whole VIDMEM memory is cleared. */
 		volatile bool cleared;
+		/**
+		 * True once the clearing thread has started clearing the whole
+		 * VIDMEM memory in the background.
+		 */
+		bool scrub_started;
 		/** Lock to serialize whole VIDMEM memory clear operation. */
 		struct nvgpu_mutex first_clear_mutex;
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2019-2022, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -54,6 +54,10 @@ struct nvgpu_ref;
  * which will initialize all of the common units in the driver and must be done
  * before the driver is ready to provide full functionality.
  *
+ * Both phases run a table of init functions in table order. While
+ * gpu_dbg_info logging is enabled the wall clock time of every entry of the
+ * last run of each phase is kept in #nvgpu_init_timing and logged.
+ *
  * Common Teardown
  * ---------------
  * If the GPU is unused, the driver can be torn down by calling
@@ -79,6 +83,87 @@ struct nvgpu_ref;
  * + nvgpu_check_gpu_state() - Restart if the state is invalid.
  */
 
+/** Maximum number of init table entries whose run time is recorded. */
+#define NVGPU_INIT_MAX_TIMED_STAGES	96U
+
+/** Init function run by an init table entry. */
+typedef int (*nvgpu_init_func_t)(struct gk20a *g);
+
+/**
+ * One entry of an init table.
+ */
+struct nvgpu_init_table_t {
+	/** Function to run, the entry is skipped if NULL. */
+	nvgpu_init_func_t func;
+	/** Name of the function for logs and timing. */
+	const char *name;
+	/** Enable flag required to run the entry, 0 for none. */
+	u32 enable_flag;
+};
+
+/** Init table entry for \a ops_ptr named after it. */
+#define NVGPU_INIT_TABLE_ENTRY(ops_ptr, enable_flag) \
+	{ (ops_ptr), #ops_ptr, (enable_flag) }
+
+/**
+ * Wall clock time of one init table entry.
+ */
+struct nvgpu_init_stage_time {
+	/** Name of the entry. */
+	const char *name;
+	/** Start of the entry relative to the start of the table, in ns. */
+	s64 start_ns;
+	/** Run time of the entry in ns. */
+	s64 duration_ns;
+	/** False if the entry was skipped or not reached. */
+	bool ran;
+};
+
+/**
+ * Wall clock breakdown of one run of an init table.
+ */
+struct nvgpu_init_timing {
+	/** Time the table started running, from nvgpu_current_time_ns(). */
+	s64 start_ns;
+	/** Run time of the whole table in ns. */
+	s64 total_ns;
+	/** Number of valid entries in \a stages. */
+	u32 count;
+	/** Per entry times, in table order. */
+	struct nvgpu_init_stage_time stages[NVGPU_INIT_MAX_TIMED_STAGES];
+};
+
+/**
+ * @brief Run an init table.
+ *
+ * @param g		[in]	The GPU.
+ * @param table		[in]	Init table entries.
+ * @param count		[in]	Number of entries in \a table.
+ * @param timing	[out]	Per entry wall clock times, may be NULL.
+ *
+ * Runs all entries of \a table whose function is set and whose enable flag
+ * is enabled, in table order. No entry runs after the first failing one.
+ *
+ * @return	0 in case of success, or the error of the first failing entry.
+ */
+int nvgpu_init_run_table(struct gk20a *g, const struct nvgpu_init_table_t *table,
+			 u32 count, struct nvgpu_init_timing *timing);
+
+/**
+ * @brief Log the wall clock breakdown of an init table run.
+ *
+ * @param g		[in]	The GPU.
+ * @param timing	[in]	Times recorded by nvgpu_init_run_table(), may be
+ *				NULL.
+ * @param phase		[in]	Name of the init phase.
+ *
+ * Logs the total time and the start and run time of every entry that ran
+ * with the gpu_dbg_info log mask. Does nothing if \a timing is NULL.
+ */
+void nvgpu_init_timing_report(struct gk20a *g,
+			      const struct nvgpu_init_timing *timing,
+			      const char *phase);
+
 /**
  * @brief Initial driver initialization
  *
@@ -127,6 +212,8 @@ int nvgpu_early_poweron(struct gk20a *g);
  *
  * Note: Requires the GPU is already powered on and the HAL is initialized.
  *
+ * The per stage breakdown is kept in gk20a.poweron_timing.
+ *
  * @return 0 in case of success, < 0 in case of failure.
  */
 int nvgpu_finalize_poweron(struct gk20a *g);
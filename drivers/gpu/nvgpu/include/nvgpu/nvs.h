@@ -76,7 +76,10 @@ struct nvgpu_nvs_domain {
 struct nvgpu_nvs_worker {
 	struct nvgpu_worker worker;
 	struct nvgpu_timeout timeout;
+	/* Timeslice of the active domain in ms, or 0 when idle. */
 	u32 current_timeout;
+	/* Nonzero when domains or runlists have changed since the last tick. */
+	nvgpu_atomic_t events;
 };
 
 struct nvgpu_nvs_scheduler {
@@ -97,6 +100,12 @@ int nvgpu_nvs_add_domain(struct gk20a *g, const char *name, u64 timeslice,
 			 u64 preempt_grace, struct nvgpu_nvs_domain **pdomain);
 void nvgpu_nvs_print_domain(struct gk20a *g, struct nvgpu_nvs_domain *domain);
 
+/*
+ * Select the algorithm that picks the next domain when a timeslice ends by
+ * its nvsched name: "rr" (the default), "wfq" or "edf".
+ */
+int nvgpu_nvs_set_algo(struct gk20a *g, const char *name);
+
 struct nvgpu_nvs_domain *
 nvgpu_nvs_domain_by_id(struct gk20a *g, u64 domain_id);
 struct nvgpu_nvs_domain *
@@ -104,6 +113,14 @@ nvgpu_nvs_domain_by_name(struct gk20a *g, const char *name);
 void nvgpu_nvs_domain_get(struct gk20a *g, struct nvgpu_nvs_domain *dom);
 void nvgpu_nvs_domain_put(struct gk20a *g, struct nvgpu_nvs_domain *dom);
 const char *nvgpu_nvs_domain_get_name(struct nvgpu_nvs_domain *dom);
+
+/*
+ * Wake up the scheduler worker to reevaluate the domains. This must be called
+ * whenever something changes that may start or stop domain rotation: domains
+ * getting added or removed, or a runlist domain becoming empty or nonempty.
+ * The worker sleeps indefinitely when there is nothing to rotate.
+ */
+void nvgpu_nvs_worker_notify(struct gk20a *g);
 /*
  * Debug wrapper for NVS code.
  */
@@ -122,6 +139,11 @@ static inline void nvgpu_nvs_remove_support(struct gk20a *g)
 	(void)g;
 }
 
+static inline void nvgpu_nvs_worker_notify(struct gk20a *g)
+{
+	(void)g;
+}
+
 static inline struct nvgpu_nvs_domain *
 nvgpu_nvs_domain_by_name(struct gk20a *g, const char *name)
 {
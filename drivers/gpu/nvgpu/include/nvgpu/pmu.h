@@ -31,9 +31,11 @@
 #include <nvgpu/flcnif_cmn.h>
 #include <nvgpu/falcon.h>
 #include <nvgpu/timers.h>
+#include <nvgpu/atomic.h>
 #ifdef CONFIG_NVGPU_LS_PMU
 #include <nvgpu/pmu/queue.h>
 #include <nvgpu/pmu/msg.h>
+#include <nvgpu/pmu/cmd.h>
 #include <nvgpu/pmu/fw.h>
 #include <nvgpu/pmu/volt.h>
 
@@ -219,6 +221,13 @@ struct rpc_handler_payload {
 	void *rpc_buff;
 	bool is_mem_free_set;
 	bool complete;
+	/* allocated from pmu->rpc_payload_cache */
+	bool is_pooled;
+	/* posted with nvgpu_pmu_rpc_execute_async() */
+	bool is_async;
+	/* completion callback of an RPC posted with nvgpu_pmu_rpc_execute_async() */
+	pmu_rpc_done_callback done;
+	void *done_param;
 };
 
 struct pmu_rpc_desc {
@@ -420,6 +429,11 @@ struct nvgpu_pmu {
 	struct nvgpu_pmu_therm *therm_pmu;
 	struct nvgpu_pmu_volt *volt;
 
+	/* RPC payloads of up to PMU_RPC_POOL_PAYLOAD_SIZE bytes */
+	struct nvgpu_kmem_cache *rpc_payload_cache;
+	/* RPCs posted with nvgpu_pmu_rpc_execute_async() not completed yet */
+	nvgpu_atomic_t rpc_in_flight;
+
 	void (*remove_support)(struct nvgpu_pmu *pmu);
 	void (*therm_rpc_handler)(struct gk20a *g, struct nvgpu_pmu *pmu,
 			struct nv_pmu_rpc_header *rpc);
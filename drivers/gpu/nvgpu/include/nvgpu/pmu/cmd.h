@@ -35,10 +35,25 @@ struct nvgpu_pmu;
 struct pmu_msg;
 struct pmu_sequence;
 struct falcon_payload_alloc;
+struct rpc_handler_payload;
 
 typedef void (*pmu_callback)(struct gk20a *g, struct pmu_msg *msg, void *param,
 		u32 status);
 
+/*
+ * Completion callback of an async RPC. rpc points to the RPC as returned by
+ * the PMU and is only valid during the call. status is 0 on success, or the
+ * error of the transfer or the PMU status of the RPC.
+ */
+typedef void (*pmu_rpc_done_callback)(struct gk20a *g,
+		struct nv_pmu_rpc_header *rpc, void *param, int status);
+
+/*
+ * RPCs with a payload of up to this size are served from a cache of
+ * preallocated payload buffers, bigger ones are allocated on demand.
+ */
+#define PMU_RPC_POOL_PAYLOAD_SIZE	512U
+
 struct pmu_cmd {
 	struct pmu_hdr hdr;
 	union {
@@ -62,6 +77,29 @@ int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 	u16 size_rpc, u16 size_scratch, pmu_callback caller_cb,
 	void *caller_cb_param, bool is_copy_back);
 
+/*
+ * Post an RPC without waiting for it. Any number of RPCs, up to the number
+ * of PMU sequences, can be in flight at once. The RPC is copied, so rpc may
+ * be reused on return. Once the PMU responds, the RPC goes through the
+ * default RPC handler and then done, if not NULL, is called.
+ *
+ * done is called exactly once per call: with the RPC status once the PMU
+ * responds, or with the error if the RPC could not be posted, in which
+ * case the error is also returned. If the GPU is going away, the RPC is
+ * dropped, done gets -ENODEV and 0 is returned.
+ */
+int nvgpu_pmu_rpc_execute_async(struct nvgpu_pmu *pmu,
+	struct nv_pmu_rpc_header *rpc, u16 size_rpc, u16 size_scratch,
+	pmu_rpc_done_callback done, void *done_param);
+/* Wait for all RPCs posted with nvgpu_pmu_rpc_execute_async() to complete. */
+int nvgpu_pmu_rpc_wait_idle(struct nvgpu_pmu *pmu, u32 timeout_ms);
+
+/* RPC payload cache, kept across railgating */
+int nvgpu_pmu_rpc_pool_init(struct gk20a *g, struct nvgpu_pmu *pmu);
+void nvgpu_pmu_rpc_pool_deinit(struct gk20a *g, struct nvgpu_pmu *pmu);
+void nvgpu_pmu_rpc_payload_free(struct gk20a *g,
+	struct rpc_handler_payload *rpc_payload);
+
 
 /* RPC */
 #define PMU_RPC_EXECUTE(_stat, _pmu, _unit, _func, _prpc, _size)\
@@ -105,4 +143,19 @@ int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 			(_size), _cb, _cbp, false);	\
 	} while (false)
 
+/* RPC posted without waiting, _done is called once the PMU responds */
+#define PMU_RPC_EXECUTE_ASYNC(_stat, _pmu, _unit, _func, _prpc, _size, _done,\
+		_param)\
+	do {                                                 \
+		(void) memset(&((_prpc)->hdr), 0, sizeof((_prpc)->hdr));\
+		\
+		(_prpc)->hdr.unit_id   = PMU_UNIT_##_unit;       \
+		(_prpc)->hdr.function = NV_PMU_RPC_ID_##_unit##_##_func;\
+		(_prpc)->hdr.flags    = 0x0;    \
+		\
+		_stat = nvgpu_pmu_rpc_execute_async(_pmu, &((_prpc)->hdr),\
+			(u16)(sizeof(*(_prpc)) - sizeof((_prpc)->scratch)),\
+			(_size), _done, _param);	\
+	} while (false)
+
 #endif /* NVGPU_PMU_CMD_H*/
@@ -88,8 +88,14 @@ struct pmu_sequence {
 
 struct pmu_sequences {
 	struct pmu_sequence *seq;
-	struct nvgpu_mutex pmu_seq_lock;
+	struct nvgpu_spinlock pmu_seq_lock;
 	unsigned long pmu_seq_tbl[PMU_SEQ_TBL_SIZE];
+	/*
+	 * Id the search for a free sequence starts at. Ids are handed out
+	 * round robin so that a just released id is not reused while the
+	 * next commands are still in flight.
+	 */
+	u32 next_seq_id;
 };
 
 void nvgpu_pmu_sequences_sw_setup(struct gk20a *g, struct nvgpu_pmu *pmu,
@@ -194,6 +194,21 @@ unsigned long find_first_bit(const unsigned long *address, unsigned long size);
 unsigned long find_next_bit(const unsigned long *address, unsigned long size,
 			    unsigned long offset);
 
+/**
+ * @brief Finds the next zero bit.
+ *
+ * Finds the next zero bit position in the input data \a address.
+ * Function does not perform any validation of the input parameter.
+ *
+ * @param address [in]	Input value to search for next zero bit.
+ * @param size [in]	Size of the input value in bits.
+ * @param offset [in]	Offset to start from the input data.
+ *
+ * @return Returns the position of next zero bit.
+ */
+unsigned long find_next_zero_bit(const unsigned long *address,
+				 unsigned long size, unsigned long offset);
+
 /**
  * @brief Finds the first zero bit.
  *
@@ -301,9 +316,10 @@ void nvgpu_clear_bit(unsigned int bit, volatile unsigned long *address);
  * @brief Sets a bitmap.
  *
  * Sets a bitmap of length \a len starting from bit position \a start in
- * \a map. Uses the function #nvgpu_set_bit() internally in a loop with the bit
- * positions and \a map as input parameters. Function does not perform any
- * validation of the input parameters.
+ * \a map. The partial first and last words are updated with a mask and the
+ * words in between are written whole. The update is not atomic, callers
+ * serialize updates of \a map. Function does not perform any validation of
+ * the input parameters.
  *
  * @param map [in,out]	Input data to set bitmap.
  * @param start [in]	Start position of the bitmap.
@@ -315,9 +331,10 @@ void nvgpu_bitmap_set(unsigned long *map, unsigned int start, unsigned int len);
  * @brief Clears a bitmap.
  *
  * Clears a bitmap of length \a len starting from bit position \a start in \a
- * map. Uses the function #nvgpu_clear_bit() internally in a loop with the bit
- * positions and \a map as input parameters. Function does not perform any
- * validation of the input parameters.
+ * map. The partial first and last words are updated with a mask and the
+ * words in between are written whole. The update is not atomic, callers
+ * serialize updates of \a map. Function does not perform any validation of
+ * the input parameters.
  *
  * @param map [in,out]	Input data to clear bitmap.
  * @param start [in]	Start position of the bitmap.
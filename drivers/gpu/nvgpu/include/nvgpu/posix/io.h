@@ -129,6 +129,30 @@ nvgpu_posix_io_reg_access_from_link(struct nvgpu_list_node *node)
 	   ((uintptr_t)node - offsetof(struct nvgpu_posix_io_reg_access, link));
 };
 
+/*
+ * Register access profile. While profiling is enabled every BAR0 readl and
+ * writel is counted per register address.
+ */
+struct nvgpu_posix_io_reg_profile {
+	u32 addr;
+	u64 reads;
+	u64 writes;
+};
+
+/* Clear previous counts and start counting register accesses. */
+void nvgpu_posix_io_start_profile(struct gk20a *g);
+/* Stop counting; the counts are kept until the next start. */
+void nvgpu_posix_io_stop_profile(struct gk20a *g);
+/*
+ * Copy up to max of the most accessed registers to hot, hottest first.
+ * Returns the number of entries copied.
+ */
+u32 nvgpu_posix_io_get_profile(struct gk20a *g,
+	struct nvgpu_posix_io_reg_profile *hot, u32 max);
+
+/* Free the lookup table and profile; reg spaces are left registered. */
+void nvgpu_posix_io_cleanup(struct gk20a *g);
+
 void nvgpu_posix_io_start_recorder(struct gk20a *g);
 void nvgpu_posix_io_record_access(struct gk20a *g,
 	struct nvgpu_reg_access *access);
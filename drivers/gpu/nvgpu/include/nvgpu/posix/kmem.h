@@ -150,6 +150,43 @@ void nvgpu_kfree_impl(struct gk20a *g, void *addr);
  */
 void nvgpu_vfree_impl(struct gk20a *g, void *addr);
 
+struct nvgpu_kmem_cache;
+
+/**
+ * Usage statistics of a slab backed kmem cache.
+ */
+struct nvgpu_kmem_cache_stats {
+	/** Allocations served from a per-thread magazine. */
+	u64 hits;
+	/** Allocations that had to refill a magazine from the shared depot. */
+	u64 misses;
+	/** Number of slabs allocated so far. */
+	u64 slabs;
+	/** Size of one object after rounding for alignment. */
+	u64 obj_size;
+	/** Number of objects carved out of each slab. */
+	u64 objs_per_slab;
+	/**
+	 * Objects allocated and not freed yet. Freed objects still held in
+	 * the magazines of other live threads are counted as well.
+	 */
+	u64 in_use;
+};
+
+/**
+ * @brief Get kmem cache statistics.
+ *
+ * Copies the statistics of \a cache to \a stats. Hits recorded by the
+ * calling thread are always included; hits of other threads are folded in
+ * when their magazines next exchange objects with the depot or when those
+ * threads exit. Function does not perform any validation of the parameters.
+ *
+ * @param cache [in]	Cache created by #nvgpu_kmem_cache_create().
+ * @param stats [out]	Statistics of \a cache.
+ */
+void nvgpu_kmem_cache_get_stats(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_cache_stats *stats);
+
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 /**
  * @brief Get fault injection structure.
@@ -107,6 +107,23 @@ int nvgpu_regops_exec(struct gk20a *g,
 bool reg_op_is_gr_ctx(u8 type);
 bool reg_op_is_read(u8 op);
 bool is_bar0_global_offset_whitelisted_gk20a(struct gk20a *g, u32 offset);
+/*
+ * Whether an op of the given type may access offset. valid_ctx tells if the
+ * op comes with a bound context, which also opens up the context and
+ * runcontrol whitelists. This is the check validate_reg_ops() applies.
+ */
+bool nvgpu_regops_offset_whitelisted(struct gk20a *g, u8 type, u32 offset,
+				     bool valid_ctx);
+
+/*
+ * The global, context and runcontrol whitelists are compiled at poweron into
+ * a two level table of per-register flags, so validating an op offset takes
+ * a single probe instead of two binary searches and a linear scan. If the
+ * table cannot be allocated, g->regops_allowlist stays NULL and the offsets
+ * are looked up in the whitelists directly.
+ */
+void nvgpu_regops_allowlist_init(struct gk20a *g);
+void nvgpu_regops_allowlist_deinit(struct gk20a *g);
 
 #endif /* CONFIG_NVGPU_DEBUGGER */
 #endif /* NVGPU_REGOPS_H */
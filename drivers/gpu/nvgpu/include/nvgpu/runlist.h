@@ -89,6 +89,13 @@ struct nvgpu_runlist_mem {
 
 	/** Number of entries written in the buffer. */
 	u32 count;
+
+	/**
+	 * The entries describe exactly the active channels and TSGs of the
+	 * domain, so the buffer can be used as the base of an incremental
+	 * update. Cleared when an empty runlist is built on purpose.
+	 */
+	bool in_sync;
 };
 
 /*
@@ -131,6 +138,12 @@ struct nvgpu_runlist_domain {
 	unsigned long *active_channels;
 	/** Bitmap of active TSGs in the runlist domain. One bit per tsgid. */
 	unsigned long *active_tsgs;
+	/**
+	 * Interleave level each TSG had when its entries were last rendered.
+	 * One byte per tsgid. Used to locate the entries of a TSG for
+	 * incremental updates.
+	 */
+	u8 *tsg_levels;
 
 	/** Runlist buffer free to use in sw. Swapped with another mem on next load. */
 	struct nvgpu_runlist_mem *mem;
@@ -155,6 +168,11 @@ struct nvgpu_runlist {
 	 * documentation of nvgpu_runlist_domain.
 	 */
 	struct nvgpu_list_node domains;
+	/*
+	 * Entry count of the buffer most recently submitted to hardware, or
+	 * U32_MAX if nothing has been submitted yet.
+	 */
+	u32 submitted_count;
 
 	/** Bitmask of PBDMAs supported for this runlist. */
 	u32  pbdma_bitmask;
@@ -191,7 +209,27 @@ nvgpu_runlist_domain_from_domains_list(struct nvgpu_list_node *node)
 	((uintptr_t)node - offsetof(struct nvgpu_runlist_domain, domains_list));
 }
 
-void nvgpu_runlist_tick(struct gk20a *g);
+/*
+ * Switch all runlists to their domain called name; called by the domain
+ * scheduler when a timeslice ends.
+ */
+void nvgpu_runlist_select_domain(struct gk20a *g, const char *name);
+/*
+ * Check if the domain called name has entries to run on any runlist. Takes
+ * the runlist locks.
+ */
+bool nvgpu_rl_domain_has_work(struct gk20a *g, const char *name);
+
+/**
+ * @brief Free the runlist entries cached for a TSG.
+ *
+ * @param g [in]		The GPU driver struct.
+ * @param tsg [in]		TSG whose cache to free.
+ *
+ * The runlist unit keeps the entries it last rendered for each TSG and
+ * reuses them while the TSG's timeslice and active channels stay the same.
+ */
+void nvgpu_runlist_free_tsg_cache(struct gk20a *g, struct nvgpu_tsg *tsg);
 
 /**
  * @brief Rebuild runlist
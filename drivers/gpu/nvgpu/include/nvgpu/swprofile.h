@@ -26,17 +26,66 @@
 #include <nvgpu/lock.h>
 #include <nvgpu/types.h>
 #include <nvgpu/kref.h>
+#include <nvgpu/bitops.h>
+#include <nvgpu/atomic.h>
 
 struct nvgpu_debug_context;
 
 /*
- * Number of entries in the kickoff latency buffer used to calculate the
- * profiling and histogram. This number is calculated to be statistically
- * significant on a histogram on a 5% step.
+ * Samples are kept as log-bucketed histograms: each power of two is split
+ * into NVGPU_SWPROFILE_SUB_BUCKETS linear buckets, so a bucket is at most
+ * 1/8th of its value wide. Values below NVGPU_SWPROFILE_SUB_BUCKETS get a
+ * bucket each.
  */
-#define PROFILE_ENTRIES		16384U
+#define NVGPU_SWPROFILE_SUB_BUCKET_BITS	3U
+#define NVGPU_SWPROFILE_SUB_BUCKETS	BIT32(NVGPU_SWPROFILE_SUB_BUCKET_BITS)
+#define NVGPU_SWPROFILE_BUCKETS		\
+	((64U - NVGPU_SWPROFILE_SUB_BUCKET_BITS + 1U) * \
+	 NVGPU_SWPROFILE_SUB_BUCKETS)
+
+/*
+ * Number of in-flight sample slots. Threads are hashed to a slot by their
+ * thread id; a thread that shares its slot with another thread taking a
+ * sample at the same time loses that sample instead of corrupting it.
+ */
+#define NVGPU_SWPROFILE_SLOT_BITS	6U
+#define NVGPU_SWPROFILE_SLOTS		BIT32(NVGPU_SWPROFILE_SLOT_BITS)
+
+/**
+ * The sample a thread is currently taking.
+ */
+struct nvgpu_swprofile_slot {
+	/**
+	 * Odd while the slot is being claimed by nvgpu_swprofile_begin_sample().
+	 */
+	nvgpu_atomic_t        seq;
+
+	/**
+	 * Thread that owns the slot.
+	 */
+	int                   tid;
+
+	/**
+	 * Reference time for the subsamples of the sample.
+	 */
+	u64                   start;
+};
+
+/**
+ * Running totals for one subsample.
+ */
+struct nvgpu_swprofile_col {
+	nvgpu_atomic64_t      count;
+	nvgpu_atomic64_t      sum;
+	nvgpu_atomic64_t      min;
+	nvgpu_atomic64_t      max;
+};
 
 struct nvgpu_swprofiler {
+	/**
+	 * Serializes opening the profiler and printing it. Not taken when
+	 * sampling.
+	 */
 	struct nvgpu_mutex    lock;
 
 	/**
@@ -46,25 +95,26 @@ struct nvgpu_swprofiler {
 	u32                   psample_len;
 
 	/**
-	 * Sample array: this is essentially a matrix where rows correspond to
-	 * a given sample and rows correspond to a type of sample. Number of
-	 * samples is always %PROFILING_ENTRIES. This 1d array is accessed with
-	 * row-major indexing.
+	 * In-flight samples, %NVGPU_SWPROFILE_SLOTS of them.
+	 */
+	struct nvgpu_swprofile_slot *slots;
+
+	/**
+	 * Histogram matrix: a row of %NVGPU_SWPROFILE_BUCKETS counters per
+	 * subsample, counting the time from the start of the sample to the
+	 * subsample.
 	 */
-	u64                  *samples;
+	nvgpu_atomic64_t     *hist;
 
 	/**
-	 * Array of u64 timestamps for each sample to reference against. This
-	 * way each subsample in .samples can reference this, not the 0th entry
-	 * of each sample.
+	 * Running totals, one per subsample.
 	 */
-	u64                  *samples_start;
+	struct nvgpu_swprofile_col *cols;
 
 	/**
-	 * Pointer to next sample array to write. Will be wrapped at
-	 * %PROFILING_ENTRIES.
+	 * Subsamples lost to slot collisions.
 	 */
-	u32                   sample_index;
+	nvgpu_atomic64_t      dropped;
 
 	/**
 	 * Column names used for printing the histogram. This is NULL terminated
@@ -153,14 +203,17 @@ bool nvgpu_swprofile_is_enabled(struct nvgpu_swprofiler *p);
  * @param[in] p  The profiler to start sampling with.
  *
  * Each iteration through a given SW sequence requires one call to this
- * function. It essentially just increments (with wraparound) an internal
- * tracker which points to the sample space in the internal sample array.
- * Typical usage is to call nvgpu_swprofile_begin_sample() and then a
- * sequence of calls to nvgpu_swprofile_snapshot().
+ * function. It records the reference time of the sample in the calling
+ * thread's sample slot. Typical usage is to call
+ * nvgpu_swprofile_begin_sample() and then a sequence of calls to
+ * nvgpu_swprofile_snapshot() from the same thread.
  *
  * Once done with the sequence being profiled nothing needs to happen. When
  * the next iteration of the sequence is executed this function should be
  * called again.
+ *
+ * This does not take a lock, so any number of threads can take samples
+ * at the same time.
  */
 void nvgpu_swprofile_begin_sample(struct nvgpu_swprofiler *p);
 
@@ -172,7 +225,9 @@ void nvgpu_swprofile_begin_sample(struct nvgpu_swprofiler *p);
  *
  * This captures a subsample. Any given run through a SW sequence that is
  * being profiled will result in one or more subsamples which together make
- * up a sample.
+ * up a sample. The time since nvgpu_swprofile_begin_sample() is added to the
+ * histogram of the subsample. Must be called from the thread that began the
+ * sample; lock free.
  */
 void nvgpu_swprofile_snapshot(struct nvgpu_swprofiler *p, u32 idx);
 
@@ -183,8 +238,10 @@ void nvgpu_swprofile_snapshot(struct nvgpu_swprofiler *p, u32 idx);
  * @param[in] p   The profiler to print.
  * @param[in] o   A debug context object used for printing.
  *
- * Print a percentile table for all columns of sub-samples. This gives a
- * good overview of the collected data.
+ * Print the p50, p90, p99, p99.9 and max latencies of all columns of
+ * sub-samples. This gives a good overview of the collected data. Values are
+ * bucket upper bounds, so within 1/8th of the actual latency. Sampling goes
+ * on while printing.
  */
 void nvgpu_swprofile_print_ranges(struct gk20a *g,
 				  struct nvgpu_swprofiler *p,
@@ -197,8 +254,9 @@ void nvgpu_swprofile_print_ranges(struct gk20a *g,
  * @param[in] p   The profiler to print.
  * @param[in] o   A debug context object used for printing.
  *
- * Print out the raw data captured by this profiler. The data is formatted
- * as one row per sample.
+ * Print out the histograms captured by this profiler. The data is formatted
+ * as one row per non-empty bucket: the bucket's lower bound followed by the
+ * count of each sub-sample.
  */
 void nvgpu_swprofile_print_raw_data(struct gk20a *g,
 				    struct nvgpu_swprofiler *p,
@@ -215,7 +273,8 @@ void nvgpu_swprofile_print_raw_data(struct gk20a *g,
  *
  *   { Min, Max, Mean, Median, Sample Variance }
  *
- * This set of data is provided to allow basic first pass analysis.
+ * This set of data is provided to allow basic first pass analysis. Median
+ * and variance are computed from the histogram.
  */
 void nvgpu_swprofile_print_basic_stats(struct gk20a *g,
 				       struct nvgpu_swprofiler *p,
@@ -56,6 +56,7 @@ struct nvgpu_channel_hw_state;
 struct nvgpu_profiler_object;
 struct nvgpu_runlist;
 struct nvgpu_runlist_domain;
+struct nvgpu_runlist_tsg_cache;
 struct nvgpu_nvs_domain;
 
 #ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
@@ -139,6 +140,25 @@ struct nvgpu_tsg {
 	 */
 	u32 ch_count;
 
+	/**
+	 * Bitmap of the channels bound to this TSG, one bit per chid. The
+	 * active channels of the TSG are the AND of this and the active
+	 * channels of a runlist domain. Modified together with #ch_list.
+	 */
+	unsigned long *ch_bitmap;
+
+	/**
+	 * Incremented (with wraparound) whenever a channel is bound to or
+	 * unbound from the TSG.
+	 */
+	u32 ch_gen;
+
+	/**
+	 * Runlist entries of this TSG as last rendered; owned by the runlist
+	 * unit.
+	 */
+	struct nvgpu_runlist_tsg_cache *rl_cache;
+
 	/**
 	 * Total number of active channels that are bound to a TSG. This count
 	 * is incremented when a channel bound to TSG is added into the runlist
@@ -99,6 +99,12 @@ struct nvgpu_os_buffer;
 
 #define NVGPU_VM_NAME_LEN	32U
 
+/**
+ * Number of locks the page directory subtrees of a VM are striped over. See
+ * #vm_gk20a.pd_subtree_locks.
+ */
+#define NVGPU_VM_PD_SUBTREE_LOCKS	32U
+
 /**
  * This structure describes the properties of batch mapping/unmapping.
  */
@@ -194,6 +200,16 @@ struct nvgpu_mapped_buf {
 	 * Aperture specified when mapping was created
 	 */
 	enum nvgpu_aperture aperture;
+	/**
+	 * Identity of the OS buffer that is mapped, see
+	 * #nvgpu_os_buf_get_id(). Together with #kind, this is the key of
+	 * vm_gk20a.mapped_buf_hash.
+	 */
+	const void *os_buf_id;
+	/**
+	 * Next buffer in the same vm_gk20a.mapped_buf_hash bucket.
+	 */
+	struct nvgpu_mapped_buf *hash_next;
 
 	/**
 	 * Os specific buffer structure.
@@ -277,7 +293,9 @@ struct vm_gk20a {
 	struct nvgpu_ref ref;
 	/**
 	 * Lock to synchronise the operations like add and delete of a
-	 * page table entry and walking the page table in this VM context.
+	 * mapped buffer or VM area and walking the mapped buffers in this VM
+	 * context. Page table updates of non-fixed mappings are done outside
+	 * of this lock; they are serialized by #pd_lock and #pd_subtree_locks.
 	 */
 	struct nvgpu_mutex update_gmmu_lock;
 	/**
@@ -285,6 +303,28 @@ struct vm_gk20a {
 	 * It describes the list of PDEs or PTEs associated in the GMMU.
 	 */
 	struct nvgpu_gmmu_pd pdb;
+	/**
+	 * Lock for allocating and programming the page directories above
+	 * #pd_lock_lvl. Held only for a single PDE at a time.
+	 */
+	struct nvgpu_mutex pd_lock;
+	/**
+	 * Page table level whose PDEs are protected by #pd_subtree_locks.
+	 * The geometry of this level and of all levels above it does not
+	 * depend on the page size, so the PDs of those levels never get
+	 * reallocated once they exist. U32_MAX if there is no such level, in
+	 * which case #pd_lock is held for whole page table updates.
+	 */
+	u32 pd_lock_lvl;
+	/**
+	 * Locks for the PDEs of level #pd_lock_lvl and all the PDs below
+	 * them, striped by the PDE index. A page table update of a range
+	 * holds the lock of one such subtree at a time, so updates of
+	 * different subtrees run concurrently. An update whose PTEs are
+	 * filled in by the parallel fill workers keeps the locks of all its
+	 * subtrees until the workers are done with them.
+	 */
+	struct nvgpu_mutex pd_subtree_locks[NVGPU_VM_PD_SUBTREE_LOCKS];
 
 	/**
 	 * Pointers to different types of page allocators.
@@ -304,6 +344,15 @@ struct vm_gk20a {
 	 * RB tree having the buffers associated with this vm context.
 	 */
 	struct nvgpu_rbtree_node *mapped_buffers;
+	/**
+	 * Buffers associated with this vm context, hashed by OS buffer and
+	 * kind. Grows with #num_user_mapped_buffers; NULL until the first
+	 * buffer is mapped or if it could not be allocated, in which case
+	 * lookups walk #mapped_buffers.
+	 */
+	struct nvgpu_mapped_buf **mapped_buf_hash;
+	/** Number of buckets in #mapped_buf_hash, a power of two. */
+	u32 mapped_buf_hash_size;
 	/**
 	 * List of vm_area associated with this vm context.
 	 */
@@ -539,8 +588,8 @@ void nvgpu_vm_put_buffers(struct vm_gk20a *vm,
  * @param kind [in]		Kind parameter.
  *
  * - Acquire the vm.update_gmmu_lock.
- * - Walk the tree and find the buffer by calling nvgpu_vm_find_mapped_buf() or
- *   nvgpu_vm_find_mapped_buf_reverse using the input flags.
+ * - Find the buffer by calling nvgpu_vm_find_mapped_buf() or
+ *   nvgpu_vm_find_mapped_buf_reverse() using the input flags.
  * - Release the lock held.
  *
  * @return			#nvgpu_mapped_buf struct, if it finds.
@@ -581,16 +630,17 @@ struct nvgpu_mapped_buf *nvgpu_vm_find_mapping(struct vm_gk20a *vm,
  * @param mapped_buffer_arg [in/out]	Mapped buffer.
  *
  * - Validate the inputs.
- * - Acquire the vm.update_gmmu_lock.
  * - Get the buffer size by calling #nvgpu_os_buf_get_size().
- * - Check the buffer is mapped already by calling #nvgpu_vm_find_mapping().
+ * - Check the buffer is mapped already by calling #nvgpu_vm_find_mapping()
+ *   with the vm.update_gmmu_lock held.
  * - If the buffer is already mapped, return the buffer.
- * - If it is fixed mapping, validate the @size and @phys_offset.
+ * - If it is fixed mapping, acquire the vm.update_gmmu_lock and validate the
+ *   @size and @phys_offset.
  * - Check the buffer can be mapped by computing the page table entry size.
  * - Call HAL specific map function to map the buffer.
  * - Increase the reference in mapped buffer.
- * - Insert the mapped buffer in VM context by calling
- *   #nvgpu_insert_mapped_buf().
+ * - Acquire the vm.update_gmmu_lock if not held yet and insert the mapped
+ *   buffer in VM context by calling #nvgpu_insert_mapped_buf().
  * - Release the lock held.
  *
  * @return			Zero, for successful mapping.
@@ -628,9 +678,10 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
  * - Get the buffer calling #nvgpu_vm_find_mapping().
  * - If it is fixed mapping, wait for all references to leave
  *   by triggering 100ms software timer.
- * - Check the buffer references. When it becomes null release the buffer by
- *   calling HAL specific unmap function to unmap the buffer.
- * - Remove it from VM context.
+ * - Check the buffer references. When it becomes null remove it from VM
+ *   context.
+ * - Unless the buffer is in a VM area, release the vm.update_gmmu_lock.
+ * - Call HAL specific unmap function to unmap the buffer.
  * - Call #nvgpu_vm_unmap_system() to free some OS specific data.
  *
  * @return				None.
@@ -678,6 +729,18 @@ void nvgpu_vm_unmap_ref_internal(struct nvgpu_ref *ref);
  */
 u64 nvgpu_os_buf_get_size(struct nvgpu_os_buffer *os_buf);
 
+/**
+ * @brief Os specific function to get the identity of a buffer.
+ *
+ * @param os_buf [in]	Pointer to OS specific #nvgpu_os_buffer struct.
+ *
+ * - OS specific function to get a pointer that is the same for every
+ *   #nvgpu_os_buffer wrapping the same underlying buffer.
+ *
+ * @return			Identity of the buffer.
+ */
+const void *nvgpu_os_buf_get_id(struct nvgpu_os_buffer *os_buf);
+
 /*
  * These all require the VM update lock to be held.
  */
@@ -735,6 +798,24 @@ struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_range(
 struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_less_than(
 	struct vm_gk20a *vm, u64 addr);
 
+/**
+ * @brief Find a mapping of an OS buffer with the given kind.
+ *
+ * @param vm [in]		Pointer to VM context.
+ * @param os_buf [in]		Pointer to #nvgpu_os_buffer struct.
+ * @param kind [in]		Kind the buffer is mapped with.
+ *
+ * The caller must hold vm.update_gmmu_lock.
+ *
+ * - Look up the buffer in vm.mapped_buf_hash by the identity of #os_buf and
+ *   #kind, or walk vm.mapped_buffers if there is no hash table.
+ *
+ * @return			#nvgpu_mapped_buf struct, if it finds.
+ * @retval NULL if #os_buf is not mapped with #kind.
+ */
+struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_reverse(
+	struct vm_gk20a *vm, struct nvgpu_os_buffer *os_buf, s16 kind);
+
 /**
  * @brief Insert the mapped buffer in VM context.
  *
@@ -745,6 +826,9 @@ struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_less_than(
  *   and key_end as the sum of mapped_buffer.addr and size.
  * - Get the root node by accessing vm.mapped_buffers.
  * - Insert the node using root node by calling #nvgpu_rbtree_insert().
+ * - Add the buffer to vm.mapped_buf_hash by mapped_buffer.os_buf_id and
+ *   mapped_buffer.kind, growing the table if it has fewer buckets than
+ *   mapped buffers.
  *
  * @return		None.
  */
@@ -355,6 +355,8 @@ static void nvgpu_init_mm_vars(struct gk20a *g)
 	struct gk20a_platform *platform = dev_get_drvdata(dev_from_gk20a(g));
 
 	g->mm.disable_bigpage = platform->disable_bigpage;
+	g->mm.pt_fill_workers = platform->gmmu_pt_fill_workers;
+	g->mm.pt_fill_min_length = platform->gmmu_pt_fill_min_length;
 	nvgpu_set_enabled(g, NVGPU_MM_HONORS_APERTURE,
 			    platform->honors_aperture);
 	nvgpu_set_enabled(g, NVGPU_MM_UNIFIED_MEMORY,
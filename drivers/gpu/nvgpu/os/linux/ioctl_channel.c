@@ -252,6 +252,7 @@ int gk20a_attach_cycle_stats_snapshot(struct nvgpu_channel *ch,
 	ret = nvgpu_css_attach(ch,
 				perfmon_id_count,
 				perfmon_id_start,
+				0U,
 				ch->cs_client);
 
 	nvgpu_mutex_release(&ch->cs_client_mutex);
@@ -738,11 +739,13 @@ static int gk20a_channel_wait_semaphore(struct nvgpu_channel *ch,
 		goto cleanup_put;
 	}
 
+	nvgpu_channel_semaphore_wait_begin(ch);
 	ret = NVGPU_COND_WAIT_INTERRUPTIBLE(
 			&ch->semaphore_wq,
 			channel_test_user_semaphore(dmabuf, data, offset, payload) ||
 				nvgpu_channel_check_unserviceable(ch),
 			timeout);
+	nvgpu_channel_semaphore_wait_end(ch);
 
 	gk20a_dmabuf_vunmap(dmabuf, data);
 cleanup_put:
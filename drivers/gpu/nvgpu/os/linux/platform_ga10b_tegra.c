@@ -790,6 +790,9 @@ struct gk20a_platform ga10b_tegra_platform = {
 	.honors_aperture = true,
 	.unified_memory = true,
 
+	/* fill in the PTEs of mappings of 1 GB and more on 4 CPUs */
+	.gmmu_pt_fill_workers = 4U,
+
 	/*
 	 * This specifies the maximum contiguous size of a DMA mapping to Linux
 	 * kernel's DMA framework.
@@ -176,6 +176,14 @@ struct gk20a_platform {
 	/* Disable big page support */
 	bool disable_bigpage;
 
+	/*
+	 * Worker threads filling in the PTEs of mappings of at least
+	 * gmmu_pt_fill_min_length bytes (0: driver default) in parallel.
+	 * 0 workers keeps all mappings serial.
+	 */
+	u32 gmmu_pt_fill_workers;
+	u64 gmmu_pt_fill_min_length;
+
 	/* Disable nvlink support */
 	bool disable_nvlink;
 
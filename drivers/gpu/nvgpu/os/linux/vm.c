@@ -118,28 +118,6 @@ static int nvgpu_vm_translate_map_access(struct gk20a *g, u32 flags,
 	return 0;
 }
 
-static struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_reverse(
-	struct vm_gk20a *vm, struct dma_buf *dmabuf, s16 kind)
-{
-	struct nvgpu_rbtree_node *node = NULL;
-	struct nvgpu_rbtree_node *root = vm->mapped_buffers;
-
-	nvgpu_rbtree_enum_start(0, &node, root);
-
-	while (node) {
-		struct nvgpu_mapped_buf *mapped_buffer =
-				mapped_buffer_from_rbtree_node(node);
-
-		if (mapped_buffer->os_priv.dmabuf == dmabuf &&
-		    mapped_buffer->kind == kind)
-			return mapped_buffer;
-
-		nvgpu_rbtree_enum_next(&node, node);
-	}
-
-	return NULL;
-}
-
 int nvgpu_vm_find_buf(struct vm_gk20a *vm, u64 gpu_va,
 		      struct dma_buf **dmabuf,
 		      u64 *offset)
@@ -170,6 +148,11 @@ u64 nvgpu_os_buf_get_size(struct nvgpu_os_buffer *os_buf)
 	return os_buf->dmabuf->size;
 }
 
+const void *nvgpu_os_buf_get_id(struct nvgpu_os_buffer *os_buf)
+{
+	return os_buf->dmabuf;
+}
+
 /*
  * vm->update_gmmu_lock must be held. This checks to see if we already have
  * mapped the passed buffer into this VM. If so, just return the existing
@@ -194,9 +177,7 @@ struct nvgpu_mapped_buf *nvgpu_vm_find_mapping(struct vm_gk20a *vm,
 			return NULL;
 	} else {
 		mapped_buffer =
-			nvgpu_vm_find_mapped_buf_reverse(vm,
-							 os_buf->dmabuf,
-							 kind);
+			nvgpu_vm_find_mapped_buf_reverse(vm, os_buf, kind);
 		if (!mapped_buffer)
 			return NULL;
 	}
@@ -145,33 +145,81 @@ unsigned long find_next_bit(const unsigned long *address, unsigned long size,
 	return nvgpu_posix_find_next_bit(address, size, offset, false);
 }
 
-static unsigned long find_next_zero_bit(const unsigned long *address,
-					unsigned long size,
-					unsigned long offset)
+unsigned long find_next_zero_bit(const unsigned long *address,
+				 unsigned long size, unsigned long offset)
 {
 	return nvgpu_posix_find_next_bit(address, size, offset, true);
 }
 
+/*
+ * Mask of the bits at and above start in the first word of a range.
+ */
+static inline unsigned long bitmap_first_word_mask(unsigned long start)
+{
+	return ~0UL << (start & (BITS_PER_LONG - 1UL));
+}
+
+/*
+ * Mask of the bits below end in the last word of a range. end is
+ * exclusive and must be non-zero.
+ */
+static inline unsigned long bitmap_last_word_mask(unsigned long end)
+{
+	return ~0UL >> ((BITS_PER_LONG - (end & (BITS_PER_LONG - 1UL))) &
+			(BITS_PER_LONG - 1UL));
+}
+
+/*
+ * Like the Linux bitmap_set()/bitmap_clear() these are not atomic: callers
+ * serialize updates of a bitmap with their own lock. The partial first and
+ * last words are masked and everything in between is written a whole word at
+ * a time.
+ */
 void nvgpu_bitmap_set(unsigned long *map, unsigned int start, unsigned int len)
 {
-	unsigned int end = start + len;
+	unsigned long end = nvgpu_safe_add_u64(start, len);
+	unsigned long idx = start / BITS_PER_LONG;
+	unsigned long last;
+	unsigned long mask;
 
-	/*
-	 * Super slow naive implementation. But speed isn't what matters here.
-	 */
-	while (start < end) {
-		nvgpu_set_bit(start++, map);
+	if (len == 0U) {
+		return;
+	}
+
+	last = (end - 1UL) / BITS_PER_LONG;
+	mask = bitmap_first_word_mask(start);
+
+	while (idx < last) {
+		map[idx] |= mask;
+		mask = ~0UL;
+		idx++;
 	}
+
+	map[last] |= mask & bitmap_last_word_mask(end);
 }
 
 void nvgpu_bitmap_clear(unsigned long *map,
 				unsigned int start, unsigned int len)
 {
-	unsigned int end = start + len;
+	unsigned long end = nvgpu_safe_add_u64(start, len);
+	unsigned long idx = start / BITS_PER_LONG;
+	unsigned long last;
+	unsigned long mask;
 
-	while (start < end) {
-		nvgpu_clear_bit(start++, map);
+	if (len == 0U) {
+		return;
 	}
+
+	last = (end - 1UL) / BITS_PER_LONG;
+	mask = bitmap_first_word_mask(start);
+
+	while (idx < last) {
+		map[idx] &= ~mask;
+		mask = ~0UL;
+		idx++;
+	}
+
+	map[last] &= ~(mask & bitmap_last_word_mask(end));
 }
 
 /*
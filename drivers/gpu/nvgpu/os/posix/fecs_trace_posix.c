@@ -60,7 +60,8 @@ void nvgpu_gr_fecs_trace_add_tsg_reset(struct gk20a *g, struct nvgpu_tsg *tsg)
 
 u8 nvgpu_gpu_ctxsw_tags_to_common_tags(u8 tags)
 {
-	return 0;
+	/* no separate userspace tag numbering here, the FECS tags are it */
+	return tags;
 }
 
 int vgpu_alloc_user_buffer(struct gk20a *g, void **buf, size_t *size)
@@ -21,12 +21,16 @@
  */
 
 #include <stdlib.h>
+#include <pthread.h>
 
 #include <nvgpu/bug.h>
 #include <nvgpu/log.h>
 #include <nvgpu/kmem.h>
 #include <nvgpu/types.h>
 #include <nvgpu/atomic.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/utils.h>
+#include <nvgpu/errno.h>
 #include <nvgpu/posix/kmem.h>
 #include <nvgpu/posix/sizes.h>
 #include <nvgpu/posix/bug.h>
@@ -38,14 +42,74 @@
 #define CACHE_NAME_LEN	128
 #endif
 
+/*
+ * Objects are carved out of slabs of at least KMEM_SLAB_SIZE bytes (and at
+ * least KMEM_SLAB_MIN_OBJS objects). Object sizes are rounded up so every
+ * object keeps the alignment malloc() would have given it.
+ */
+#define KMEM_SLAB_SIZE		(64U * 1024U)
+#define KMEM_SLAB_MIN_OBJS	8U
+#define KMEM_OBJ_ALIGN		16U
+
+/*
+ * Each thread keeps a small magazine of free objects per cache so the common
+ * alloc/free path does not touch the shared depot (and its lock). Magazines
+ * are exchanged with the depot KMEM_MAG_BATCH objects at a time.
+ */
+#define KMEM_MAG_SIZE		32U
+#define KMEM_MAG_BATCH		(KMEM_MAG_SIZE / 2U)
+#define KMEM_MAG_SLOTS		16U
+
+struct nvgpu_kmem_slab {
+	struct nvgpu_kmem_slab *next;
+};
+
+/* Free objects are chained through their first word. */
+struct nvgpu_kmem_free_obj {
+	struct nvgpu_kmem_free_obj *next;
+};
+
 struct nvgpu_kmem_cache {
 	struct gk20a *g;
 	size_t size;
 #ifdef __NVGPU_UNIT_TEST__
 	char name[CACHE_NAME_LEN];
 #endif
+	/* Unique for the life of the process; 0 marks an unused magazine. */
+	u64 id;
+	size_t obj_size;
+	size_t objs_per_slab;
+
+	/* Depot: everything below is protected by lock. */
+	struct nvgpu_mutex lock;
+	struct nvgpu_kmem_free_obj *free_list;
+	/* Objects on free_list. */
+	u64 free_objs;
+	struct nvgpu_kmem_slab *slabs;
+	struct nvgpu_kmem_cache_stats stats;
+
+	/* Link in the list of live caches, protected by kmem_cache_list_lock. */
+	struct nvgpu_kmem_cache *next;
+};
+
+struct nvgpu_kmem_magazine {
+	u64 cache_id;
+	u32 count;
+	/* Allocations served by this magazine not yet folded into stats. */
+	u64 hits;
+	void *objs[KMEM_MAG_SIZE];
 };
 
+static __thread struct nvgpu_kmem_magazine kmem_mags[KMEM_MAG_SLOTS];
+
+static pthread_mutex_t kmem_cache_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct nvgpu_kmem_cache *kmem_cache_list;
+static u64 kmem_cache_next_id = 1ULL;
+
+static pthread_once_t kmem_mag_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t kmem_mag_key;
+static bool kmem_mag_key_valid;
+
 #ifdef __NVGPU_UNIT_TEST__
 static nvgpu_atomic_t kmem_cache_id;
 #endif
@@ -60,13 +124,206 @@ struct nvgpu_posix_fault_inj *nvgpu_kmem_get_fault_injection(void)
 }
 #endif
 
+/* Must be called with kmem_cache_list_lock held. */
+static struct nvgpu_kmem_cache *nvgpu_kmem_cache_lookup(u64 id)
+{
+	struct nvgpu_kmem_cache *cache;
+
+	for (cache = kmem_cache_list; cache != NULL; cache = cache->next) {
+		if (cache->id == id) {
+			return cache;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Give back the objects [from, mag->count) of a magazine to the depot and
+ * fold its hit count into the cache statistics.
+ */
+static void nvgpu_kmem_mag_put_locked(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_magazine *mag, u32 from)
+{
+	struct nvgpu_kmem_free_obj *obj;
+	u32 i;
+
+	for (i = from; i < mag->count; i++) {
+		obj = (struct nvgpu_kmem_free_obj *)mag->objs[i];
+		obj->next = cache->free_list;
+		cache->free_list = obj;
+		cache->free_objs = nvgpu_safe_add_u64(cache->free_objs, 1ULL);
+	}
+	mag->count = from;
+
+	cache->stats.hits = nvgpu_safe_add_u64(cache->stats.hits, mag->hits);
+	mag->hits = 0ULL;
+}
+
 /*
- * kmem cache emulation: basically just do a regular malloc(). This is slower
- * but should not affect a user of kmem cache in the slightest bit.
+ * Empty a magazine that belongs to some other cache than the one about to use
+ * its slot. The owner may already be gone, in which case its objects went
+ * away with its slabs and there is nothing to give back.
+ */
+static void nvgpu_kmem_mag_evict(struct nvgpu_kmem_magazine *mag)
+{
+	struct nvgpu_kmem_cache *owner;
+
+	if (mag->cache_id == 0ULL) {
+		return;
+	}
+
+	(void)pthread_mutex_lock(&kmem_cache_list_lock);
+	owner = nvgpu_kmem_cache_lookup(mag->cache_id);
+	if (owner != NULL) {
+		nvgpu_mutex_acquire(&owner->lock);
+		nvgpu_kmem_mag_put_locked(owner, mag, 0U);
+		nvgpu_mutex_release(&owner->lock);
+	}
+	(void)pthread_mutex_unlock(&kmem_cache_list_lock);
+
+	mag->cache_id = 0ULL;
+	mag->count = 0U;
+	mag->hits = 0ULL;
+}
+
+/* Thread exit: hand the magazines of the exiting thread back. */
+static void nvgpu_kmem_mag_thread_exit(void *arg)
+{
+	u32 i;
+
+	(void)arg;
+
+	for (i = 0U; i < KMEM_MAG_SLOTS; i++) {
+		nvgpu_kmem_mag_evict(&kmem_mags[i]);
+	}
+}
+
+static void nvgpu_kmem_mag_key_init(void)
+{
+	kmem_mag_key_valid = (pthread_key_create(&kmem_mag_key,
+				nvgpu_kmem_mag_thread_exit) == 0);
+}
+
+static struct nvgpu_kmem_magazine *nvgpu_kmem_mag_get(
+		struct nvgpu_kmem_cache *cache)
+{
+	struct nvgpu_kmem_magazine *mag =
+		&kmem_mags[cache->id % (u64)KMEM_MAG_SLOTS];
+
+	if (mag->cache_id != cache->id) {
+		nvgpu_kmem_mag_evict(mag);
+		/*
+		 * The key only needs a non-NULL value so that the destructor
+		 * runs when this thread exits.
+		 */
+		(void)pthread_once(&kmem_mag_key_once, nvgpu_kmem_mag_key_init);
+		if (kmem_mag_key_valid) {
+			(void)pthread_setspecific(kmem_mag_key, kmem_mags);
+		}
+		mag->cache_id = cache->id;
+	}
+
+	return mag;
+}
+
+/* Carve a new slab into objects and push them on the depot free list. */
+static int nvgpu_kmem_cache_grow_locked(struct nvgpu_kmem_cache *cache)
+{
+	struct nvgpu_kmem_slab *slab;
+	struct nvgpu_kmem_free_obj *obj;
+	size_t hdr = KMEM_OBJ_ALIGN;
+	char *base;
+	size_t i;
+
+	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
+	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
+	slab = malloc(nvgpu_safe_add_u64(hdr, nvgpu_safe_mult_u64(
+				cache->obj_size, cache->objs_per_slab)));
+	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
+	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
+
+	if (slab == NULL) {
+		return -ENOMEM;
+	}
+
+	slab->next = cache->slabs;
+	cache->slabs = slab;
+
+	base = (char *)slab + hdr;
+	for (i = cache->objs_per_slab; i > 0U; i--) {
+		obj = (struct nvgpu_kmem_free_obj *)(void *)
+			(base + ((i - 1U) * cache->obj_size));
+		obj->next = cache->free_list;
+		cache->free_list = obj;
+	}
+
+	cache->free_objs = nvgpu_safe_add_u64(cache->free_objs,
+			cache->objs_per_slab);
+	cache->stats.slabs = nvgpu_safe_add_u64(cache->stats.slabs, 1ULL);
+
+	return 0;
+}
+
+/*
+ * Objects carved out and neither on the depot free list nor in this thread's
+ * magazine. Free objects in the magazines of other live threads cannot be
+ * seen from here and count as in use.
+ */
+static u64 nvgpu_kmem_cache_in_use_locked(struct nvgpu_kmem_cache *cache)
+{
+	struct nvgpu_kmem_magazine *mag =
+		&kmem_mags[cache->id % (u64)KMEM_MAG_SLOTS];
+	u64 free_objs = cache->free_objs;
+
+	if (mag->cache_id == cache->id) {
+		free_objs = nvgpu_safe_add_u64(free_objs, mag->count);
+	}
+
+	return nvgpu_safe_sub_u64(nvgpu_safe_mult_u64(cache->stats.slabs,
+			cache->objs_per_slab), free_objs);
+}
+
+/* Refill an empty magazine with up to KMEM_MAG_BATCH objects. */
+static int nvgpu_kmem_mag_refill(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_magazine *mag)
+{
+	struct nvgpu_kmem_free_obj *obj;
+	int err = 0;
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	cache->stats.misses = nvgpu_safe_add_u64(cache->stats.misses, 1ULL);
+	cache->stats.hits = nvgpu_safe_add_u64(cache->stats.hits, mag->hits);
+	mag->hits = 0ULL;
+
+	if (cache->free_list == NULL) {
+		err = nvgpu_kmem_cache_grow_locked(cache);
+	}
+
+	while ((err == 0) && (cache->free_list != NULL) &&
+			(mag->count < KMEM_MAG_BATCH)) {
+		obj = cache->free_list;
+		cache->free_list = obj->next;
+		cache->free_objs = nvgpu_safe_sub_u64(cache->free_objs, 1ULL);
+		mag->objs[mag->count] = obj;
+		mag->count++;
+	}
+
+	nvgpu_mutex_release(&cache->lock);
+
+	return err;
+}
+
+/*
+ * kmem cache emulation: objects are handed out from per-size slabs through
+ * per-thread magazines, so the simulation and replay paths that churn through
+ * small driver objects do not pay for a malloc()/free() pair each time.
  */
 struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 {
 	struct nvgpu_kmem_cache *cache;
+	size_t obj_size;
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 	if (nvgpu_posix_fault_injection_handle_call(
 					nvgpu_kmem_get_fault_injection())) {
@@ -75,7 +332,7 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 #endif
 	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
 	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
-	cache = malloc(sizeof(struct nvgpu_kmem_cache));
+	cache = calloc(1, sizeof(struct nvgpu_kmem_cache));
 	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
 	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
 
@@ -86,24 +343,96 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 	cache->g = g;
 	cache->size = size;
 
+	obj_size = (size < sizeof(struct nvgpu_kmem_free_obj)) ?
+		sizeof(struct nvgpu_kmem_free_obj) : size;
+	cache->obj_size = NVGPU_ALIGN(obj_size, (size_t)KMEM_OBJ_ALIGN);
+	cache->objs_per_slab = KMEM_SLAB_SIZE / cache->obj_size;
+	if (cache->objs_per_slab < KMEM_SLAB_MIN_OBJS) {
+		cache->objs_per_slab = KMEM_SLAB_MIN_OBJS;
+	}
+	cache->stats.obj_size = cache->obj_size;
+	cache->stats.objs_per_slab = cache->objs_per_slab;
+
+	nvgpu_mutex_init(&cache->lock);
+
 #ifdef __NVGPU_UNIT_TEST__
 	(void)snprintf(cache->name, sizeof(cache->name),
 			"nvgpu-cache-0x%p-%lu-%d", g, size,
 			nvgpu_atomic_inc_return(&kmem_cache_id));
 #endif
 
+	(void)pthread_mutex_lock(&kmem_cache_list_lock);
+	cache->id = kmem_cache_next_id;
+	kmem_cache_next_id = nvgpu_safe_add_u64(kmem_cache_next_id, 1ULL);
+	cache->next = kmem_cache_list;
+	kmem_cache_list = cache;
+	(void)pthread_mutex_unlock(&kmem_cache_list_lock);
+
 	return cache;
 }
 
 void nvgpu_kmem_cache_destroy(struct nvgpu_kmem_cache *cache)
 {
+	struct nvgpu_kmem_cache **pp;
+	struct nvgpu_kmem_magazine *mag;
+	struct nvgpu_kmem_slab *slab;
+	u64 in_use;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	(void)pthread_mutex_lock(&kmem_cache_list_lock);
+	for (pp = &kmem_cache_list; *pp != NULL; pp = &(*pp)->next) {
+		if (*pp == cache) {
+			*pp = cache->next;
+			break;
+		}
+	}
+	(void)pthread_mutex_unlock(&kmem_cache_list_lock);
+
+	nvgpu_mutex_acquire(&cache->lock);
+	in_use = nvgpu_kmem_cache_in_use_locked(cache);
+	nvgpu_mutex_release(&cache->lock);
+
+	/*
+	 * Magazines of other threads still naming this cache are dropped the
+	 * next time their slot is reused: the id is never handed out again.
+	 */
+	mag = &kmem_mags[cache->id % (u64)KMEM_MAG_SLOTS];
+	if (mag->cache_id == cache->id) {
+		mag->cache_id = 0ULL;
+		mag->count = 0U;
+		mag->hits = 0ULL;
+	}
+
+	/*
+	 * Objects still in use live in the slabs; rather than leave their
+	 * owners with dangling pointers, leak the slabs like the baseline
+	 * malloc() based cache leaked the objects.
+	 */
+	if (in_use != 0ULL) {
+		nvgpu_warn(cache->g,
+			"kmem cache destroyed with %llu objects in use",
+			(unsigned long long)in_use);
+	}
+
+	while ((in_use == 0ULL) && (cache->slabs != NULL)) {
+		slab = cache->slabs;
+		cache->slabs = slab->next;
+		NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
+		free(slab);
+	}
+
+	nvgpu_mutex_destroy(&cache->lock);
+
 	NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
 	free(cache);
 }
 
 void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache)
 {
-	void *ptr;
+	struct nvgpu_kmem_magazine *mag;
 
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 	if (nvgpu_posix_fault_injection_handle_call(
@@ -111,25 +440,55 @@ void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache)
 		return NULL;
 	}
 #endif
-	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
-	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
-	ptr = malloc(cache->size);
-	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
-	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
+	mag = nvgpu_kmem_mag_get(cache);
 
-	if (ptr == NULL) {
+	if (mag->count > 0U) {
+		mag->hits = nvgpu_safe_add_u64(mag->hits, 1ULL);
+	} else if (nvgpu_kmem_mag_refill(cache, mag) != 0) {
 		nvgpu_warn(NULL, "malloc returns NULL");
 		return NULL;
 	}
 
-	return ptr;
+	mag->count--;
+
+	return mag->objs[mag->count];
 }
 
 void nvgpu_kmem_cache_free(struct nvgpu_kmem_cache *cache, void *ptr)
 {
-	(void)cache;
-	NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
-	free(ptr);
+	struct nvgpu_kmem_magazine *mag;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+	mag = nvgpu_kmem_mag_get(cache);
+
+	if (mag->count == KMEM_MAG_SIZE) {
+		nvgpu_mutex_acquire(&cache->lock);
+		nvgpu_kmem_mag_put_locked(cache, mag, KMEM_MAG_BATCH);
+		nvgpu_mutex_release(&cache->lock);
+	}
+
+	mag->objs[mag->count] = ptr;
+	mag->count++;
+}
+
+void nvgpu_kmem_cache_get_stats(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_cache_stats *stats)
+{
+	struct nvgpu_kmem_magazine *mag =
+		&kmem_mags[cache->id % (u64)KMEM_MAG_SLOTS];
+
+	nvgpu_mutex_acquire(&cache->lock);
+	if (mag->cache_id == cache->id) {
+		cache->stats.hits = nvgpu_safe_add_u64(cache->stats.hits,
+				mag->hits);
+		mag->hits = 0ULL;
+	}
+	*stats = cache->stats;
+	stats->in_use = nvgpu_kmem_cache_in_use_locked(cache);
+	nvgpu_mutex_release(&cache->lock);
 }
 
 void *nvgpu_kmalloc_impl(struct gk20a *g, size_t size, void *ip)
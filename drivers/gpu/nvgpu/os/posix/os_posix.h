@@ -26,6 +26,18 @@
 #include <nvgpu/gk20a.h>
 
 struct nvgpu_posix_io_callbacks;
+struct nvgpu_posix_io_reg_profile;
+
+/*
+ * One address range of the flattened register space lookup table. Ranges are
+ * sorted, do not overlap and each maps to the reg space that wins for those
+ * addresses (the most recently registered one).
+ */
+struct nvgpu_posix_io_reg_range {
+	u64 start;
+	u64 end;
+	struct nvgpu_posix_io_reg_space *space;
+};
 
 struct nvgpu_os_posix {
 	struct gk20a g;
@@ -42,6 +54,26 @@ struct nvgpu_os_posix {
 	struct nvgpu_list_node reg_space_head;
 	int error_code;
 
+	/*
+	 * Sorted lookup table built from reg_space_head whenever a space is
+	 * (un)registered, plus the index of the range that served the last
+	 * lookup. If the table could not be built, lookups walk the list.
+	 */
+	struct nvgpu_posix_io_reg_range *reg_ranges;
+	u32 reg_range_count;
+	u32 reg_range_last;
+	bool reg_ranges_valid;
+
+	/*
+	 * Optional BAR0 access profile: open addressed hash table of
+	 * reg_profile_size entries keyed by register address.
+	 */
+	struct nvgpu_mutex reg_profile_lock;
+	struct nvgpu_posix_io_reg_profile *reg_profile;
+	u32 reg_profile_size;
+	u32 reg_profile_used;
+	bool reg_profiling;
+
 
 	/*
 	 * List to record sequence of register writes.
@@ -20,9 +20,13 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdlib.h>
+
 #include <nvgpu/io.h>
 #include <nvgpu/io_usermode.h>
 #include <nvgpu/bug.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/sort.h>
 
 #include <nvgpu/posix/io.h>
 #include <nvgpu/posix/posix-fault-injection.h>
@@ -60,6 +64,147 @@ struct nvgpu_posix_io_callbacks *nvgpu_posix_register_io(
 	return old_io;
 }
 
+#define REG_PROFILE_MIN_SIZE	1024U
+
+static u32 nvgpu_posix_io_profile_hash(u32 addr, u32 size)
+{
+	/* Registers are word aligned; Fibonacci hash the word index. */
+	return (u32)(((u64)(addr >> 2U) * 2654435761ULL) & (u64)(size - 1U));
+}
+
+static struct nvgpu_posix_io_reg_profile *nvgpu_posix_io_profile_slot(
+		struct nvgpu_posix_io_reg_profile *table, u32 size, u32 addr)
+{
+	u32 i = nvgpu_posix_io_profile_hash(addr, size);
+
+	/* An entry is in use once it has counted at least one access. */
+	while ((table[i].reads != 0ULL || table[i].writes != 0ULL) &&
+			(table[i].addr != addr)) {
+		i = (i + 1U) & (size - 1U);
+	}
+
+	return &table[i];
+}
+
+/* Double the table once it is half full. Returns false if out of memory. */
+static bool nvgpu_posix_io_profile_grow(struct nvgpu_os_posix *p)
+{
+	struct nvgpu_posix_io_reg_profile *table, *slot;
+	u32 size = (p->reg_profile_size == 0U) ? REG_PROFILE_MIN_SIZE :
+		(p->reg_profile_size * 2U);
+	u32 i;
+
+	table = calloc(size, sizeof(*table));
+	if (table == NULL) {
+		return false;
+	}
+
+	for (i = 0U; i < p->reg_profile_size; i++) {
+		if (p->reg_profile[i].reads != 0ULL ||
+				p->reg_profile[i].writes != 0ULL) {
+			slot = nvgpu_posix_io_profile_slot(table, size,
+					p->reg_profile[i].addr);
+			*slot = p->reg_profile[i];
+		}
+	}
+
+	free(p->reg_profile);
+	p->reg_profile = table;
+	p->reg_profile_size = size;
+
+	return true;
+}
+
+static void nvgpu_posix_io_profile_access(struct nvgpu_os_posix *p, u32 addr,
+		bool write)
+{
+	struct nvgpu_posix_io_reg_profile *slot;
+
+	nvgpu_mutex_acquire(&p->reg_profile_lock);
+
+	if ((p->reg_profile_used * 2U >= p->reg_profile_size) &&
+			!nvgpu_posix_io_profile_grow(p)) {
+		nvgpu_mutex_release(&p->reg_profile_lock);
+		return;
+	}
+
+	slot = nvgpu_posix_io_profile_slot(p->reg_profile,
+			p->reg_profile_size, addr);
+	if (slot->reads == 0ULL && slot->writes == 0ULL) {
+		slot->addr = addr;
+		p->reg_profile_used++;
+	}
+	if (write) {
+		slot->writes++;
+	} else {
+		slot->reads++;
+	}
+
+	nvgpu_mutex_release(&p->reg_profile_lock);
+}
+
+void nvgpu_posix_io_start_profile(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
+	nvgpu_mutex_acquire(&p->reg_profile_lock);
+	if (p->reg_profile != NULL) {
+		(void) memset(p->reg_profile, 0,
+			p->reg_profile_size * sizeof(*p->reg_profile));
+	}
+	p->reg_profile_used = 0U;
+	p->reg_profiling = true;
+	nvgpu_mutex_release(&p->reg_profile_lock);
+}
+
+void nvgpu_posix_io_stop_profile(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
+	p->reg_profiling = false;
+}
+
+u32 nvgpu_posix_io_get_profile(struct gk20a *g,
+		struct nvgpu_posix_io_reg_profile *hot, u32 max)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	struct nvgpu_posix_io_reg_profile *e;
+	u32 n = 0U;
+	u32 i, j;
+
+	nvgpu_mutex_acquire(&p->reg_profile_lock);
+
+	/* Insertion into the top-max list; max is expected to be small. */
+	for (i = 0U; i < p->reg_profile_size; i++) {
+		u64 total;
+
+		e = &p->reg_profile[i];
+		total = e->reads + e->writes;
+		if (total == 0ULL) {
+			continue;
+		}
+
+		j = n;
+		while ((j > 0U) &&
+			(hot[j - 1U].reads + hot[j - 1U].writes < total)) {
+			if (j < max) {
+				hot[j] = hot[j - 1U];
+			}
+			j--;
+		}
+		if (j < max) {
+			hot[j] = *e;
+			if (n < max) {
+				n++;
+			}
+		}
+	}
+
+	nvgpu_mutex_release(&p->reg_profile_lock);
+
+	return n;
+}
+
 static void nvgpu_posix_writel(struct gk20a *g, u32 r, u32 v)
 {
 	struct nvgpu_posix_io_callbacks *callbacks =
@@ -74,6 +219,11 @@ static void nvgpu_posix_writel(struct gk20a *g, u32 r, u32 v)
 		BUG();
 	}
 
+	if (nvgpu_os_posix_from_gk20a(g)->reg_profiling) {
+		nvgpu_posix_io_profile_access(nvgpu_os_posix_from_gk20a(g),
+				r, true);
+	}
+
 	callbacks->writel(g, &access);
 }
 
@@ -98,6 +248,11 @@ static u32 nvgpu_posix_readl(struct gk20a *g, u32 r)
 		BUG();
 	}
 
+	if (nvgpu_os_posix_from_gk20a(g)->reg_profiling) {
+		nvgpu_posix_io_profile_access(nvgpu_os_posix_from_gk20a(g),
+				r, false);
+	}
+
 	callbacks->readl(g, &access);
 
 	return access.value;
@@ -204,6 +359,134 @@ void nvgpu_posix_io_init_reg_space(struct gk20a *g)
 	p->error_code = 0;
 	nvgpu_init_list_node(&p->reg_space_head);
 	nvgpu_init_list_node(&p->recorder_head);
+
+	p->reg_ranges = NULL;
+	p->reg_range_count = 0U;
+	p->reg_range_last = 0U;
+	p->reg_ranges_valid = true;
+
+	nvgpu_mutex_init(&p->reg_profile_lock);
+	p->reg_profile = NULL;
+	p->reg_profile_size = 0U;
+	p->reg_profile_used = 0U;
+	p->reg_profiling = false;
+}
+
+void nvgpu_posix_io_cleanup(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
+	free(p->reg_ranges);
+	p->reg_ranges = NULL;
+	p->reg_range_count = 0U;
+	p->reg_ranges_valid = false;
+
+	p->reg_profiling = false;
+	free(p->reg_profile);
+	p->reg_profile = NULL;
+	p->reg_profile_size = 0U;
+	p->reg_profile_used = 0U;
+	nvgpu_mutex_destroy(&p->reg_profile_lock);
+}
+
+static int nvgpu_posix_io_cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a;
+	u64 y = *(const u64 *)b;
+
+	return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/*
+ * Flatten the reg space list into sorted, non-overlapping ranges. The list
+ * is ordered by precedence, so each elementary range between two space
+ * boundaries belongs to the first space in the list that covers it.
+ *
+ * The table is allocated with plain malloc() so that rebuilding it does not
+ * consume kmem fault injection counts set up by unit tests.
+ */
+static void nvgpu_posix_io_rebuild_reg_ranges(struct nvgpu_os_posix *p)
+{
+	struct nvgpu_posix_io_reg_space *reg_space;
+	struct nvgpu_posix_io_reg_range *ranges = NULL;
+	u64 *bounds = NULL;
+	u32 nr_spaces = 0U;
+	u32 nr_bounds = 0U;
+	u32 nr_ranges = 0U;
+	u32 i;
+
+	free(p->reg_ranges);
+	p->reg_ranges = NULL;
+	p->reg_range_count = 0U;
+	p->reg_range_last = 0U;
+	p->reg_ranges_valid = false;
+
+	nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
+			nvgpu_posix_io_reg_space, link) {
+		nr_spaces++;
+	}
+
+	if (nr_spaces == 0U) {
+		p->reg_ranges_valid = true;
+		return;
+	}
+
+	bounds = malloc(2U * nr_spaces * sizeof(*bounds));
+	ranges = malloc(2U * nr_spaces * sizeof(*ranges));
+	if ((bounds == NULL) || (ranges == NULL)) {
+		free(bounds);
+		free(ranges);
+		return;
+	}
+
+	nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
+			nvgpu_posix_io_reg_space, link) {
+		bounds[nr_bounds++] = reg_space->base;
+		bounds[nr_bounds++] = (u64)reg_space->base + reg_space->size;
+	}
+
+	sort(bounds, nr_bounds, sizeof(*bounds), nvgpu_posix_io_cmp_u64, NULL);
+
+	for (i = 0U; (i + 1U) < nr_bounds; i++) {
+		u64 start = bounds[i];
+		u64 end = bounds[i + 1U];
+		struct nvgpu_posix_io_reg_space *owner = NULL;
+
+		if (start == end) {
+			continue;
+		}
+
+		nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
+				nvgpu_posix_io_reg_space, link) {
+			if ((start >= reg_space->base) &&
+				(start < (u64)reg_space->base +
+					reg_space->size)) {
+				owner = reg_space;
+				break;
+			}
+		}
+
+		if (owner == NULL) {
+			continue;
+		}
+
+		if ((nr_ranges > 0U) &&
+				(ranges[nr_ranges - 1U].space == owner) &&
+				(ranges[nr_ranges - 1U].end == start)) {
+			ranges[nr_ranges - 1U].end = end;
+		} else {
+			ranges[nr_ranges].start = start;
+			ranges[nr_ranges].end = end;
+			ranges[nr_ranges].space = owner;
+			nr_ranges++;
+		}
+	}
+
+	free(bounds);
+
+	p->reg_ranges = ranges;
+	p->reg_range_count = nr_ranges;
+	p->reg_ranges_valid = true;
 }
 
 int nvgpu_posix_io_get_error_code(struct gk20a *g)
@@ -239,14 +522,17 @@ int nvgpu_posix_io_register_reg_space(struct gk20a *g,
 	 * over the default reg lists.
 	 */
 	nvgpu_list_add(&reg_space->link, &p->reg_space_head);
+	nvgpu_posix_io_rebuild_reg_ranges(p);
 	return 0;
 }
 
 void nvgpu_posix_io_unregister_reg_space(struct gk20a *g,
 		struct nvgpu_posix_io_reg_space *reg_space)
 {
-	(void)g;
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
 	nvgpu_list_del(&reg_space->link);
+	nvgpu_posix_io_rebuild_reg_ranges(p);
 }
 
 /*
@@ -288,6 +574,39 @@ void nvgpu_posix_io_delete_reg_space(struct gk20a *g, u32 base)
 	nvgpu_kfree(g, reg_space);
 }
 
+static struct nvgpu_posix_io_reg_space *nvgpu_posix_io_find_reg_range(
+		struct nvgpu_os_posix *p, u32 addr)
+{
+	struct nvgpu_posix_io_reg_range *r;
+	u32 last = p->reg_range_last;
+	u32 lo = 0U;
+	u32 hi = p->reg_range_count;
+
+	/* Accesses come in bursts to the same unit; try the last hit first. */
+	if (last < p->reg_range_count) {
+		r = &p->reg_ranges[last];
+		if ((addr >= r->start) && (addr < r->end)) {
+			return r->space;
+		}
+	}
+
+	while (lo < hi) {
+		u32 mid = lo + ((hi - lo) / 2U);
+
+		r = &p->reg_ranges[mid];
+		if (addr < r->start) {
+			hi = mid;
+		} else if (addr >= r->end) {
+			lo = mid + 1U;
+		} else {
+			p->reg_range_last = mid;
+			return r->space;
+		}
+	}
+
+	return NULL;
+}
+
 /*
  * Lookup a register space from a given address. If no register space is found
  * this is a bug similar to a translation fault.
@@ -298,13 +617,21 @@ struct nvgpu_posix_io_reg_space *nvgpu_posix_io_get_reg_space(struct gk20a *g,
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
 	struct nvgpu_posix_io_reg_space *reg_space;
 
-	nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
-			nvgpu_posix_io_reg_space, link) {
-		u32 offset = addr - reg_space->base;
-
-		if ((addr >= reg_space->base) && (offset < reg_space->size)) {
+	if (p->reg_ranges_valid) {
+		reg_space = nvgpu_posix_io_find_reg_range(p, addr);
+		if (reg_space != NULL) {
 			return reg_space;
 		}
+	} else {
+		nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
+				nvgpu_posix_io_reg_space, link) {
+			u32 offset = addr - reg_space->base;
+
+			if ((addr >= reg_space->base) &&
+					(offset < reg_space->size)) {
+				return reg_space;
+			}
+		}
 	}
 	p->error_code = -EFAULT;
 	nvgpu_err(g, "ABORT for address 0x%x", addr);
@@ -32,6 +32,11 @@ u64 nvgpu_os_buf_get_size(struct nvgpu_os_buffer *os_buf)
 	return os_buf->size;
 }
 
+const void *nvgpu_os_buf_get_id(struct nvgpu_os_buffer *os_buf)
+{
+	return os_buf->buf;
+}
+
 struct nvgpu_mapped_buf *nvgpu_vm_find_mapping(struct vm_gk20a *vm,
 					       struct nvgpu_os_buffer *os_buf,
 					       u64 map_addr,
@@ -40,10 +45,12 @@ struct nvgpu_mapped_buf *nvgpu_vm_find_mapping(struct vm_gk20a *vm,
 {
 	struct nvgpu_mapped_buf *mapped_buffer = NULL;
 
-	(void)os_buf;
-	(void)kind;
-
-	mapped_buffer = nvgpu_vm_find_mapped_buf(vm, map_addr);
+	if ((flags & NVGPU_VM_MAP_FIXED_OFFSET) != 0U) {
+		mapped_buffer = nvgpu_vm_find_mapped_buf(vm, map_addr);
+	} else {
+		mapped_buffer = nvgpu_vm_find_mapped_buf_reverse(vm, os_buf,
+				kind);
+	}
 	if (mapped_buffer == NULL) {
 		return NULL;
 	}
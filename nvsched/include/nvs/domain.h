@@ -63,6 +63,23 @@ struct nvs_domain {
 	u64			 timeslice_ns;
 	u64			 preempt_grace_ns;
 
+	/*
+	 * Algorithm parameters. The weight is the share of this domain relative
+	 * to others under weighted fair queuing; zero is treated as one. The
+	 * deadline is how soon this domain must be dispatched after becoming
+	 * runnable under earliest deadline first; zero means no deadline.
+	 */
+	u32			 weight;
+	u64			 deadline_ns;
+
+	/*
+	 * Algorithm bookkeeping: whether this domain has work, the virtual
+	 * time it has consumed and its current absolute deadline.
+	 */
+	bool			 runnable;
+	u64			 vtime;
+	u64			 abs_deadline_ns;
+
 	/*
 	 * Priv pointer for downstream use.
 	 */
@@ -84,5 +101,7 @@ void nvs_domain_destroy(struct nvs_sched *sched, struct nvs_domain *dom);
 void nvs_domain_clear_all(struct nvs_sched *sched);
 u32 nvs_domain_count(struct nvs_sched *sched);
 struct nvs_domain *nvs_domain_by_name(struct nvs_sched *sched, const char *name);
+void nvs_domain_set_runnable(struct nvs_sched *sched, struct nvs_domain *dom,
+			     bool runnable, u64 now);
 
 #endif
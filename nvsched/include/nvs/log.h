@@ -46,6 +46,7 @@ enum nvs_event {
 	NVS_EV_CREATE_SCHED,
 	NVS_EV_CREATE_DOMAIN,
 	NVS_EV_REMOVE_DOMAIN,
+	NVS_EV_SWITCH_DOMAIN,
 	NVS_EV_MAX = 0xffffffff /* Force to 32 bit enum size. */
 };
 
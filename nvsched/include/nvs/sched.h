@@ -58,6 +58,20 @@
  * use a round-robin approach for picking next domains, but another may wish
  * to use a priority based approach.
  *
+ * The built in algorithms are:
+ *
+ * - Round-robin: every domain gets its timeslice in list order whether it
+ *   has work or not, like the host hardware does with channels.
+ * - Weighted fair queuing: runnable domains are charged the time they ran
+ *   divided by their weight, and the least charged one runs next.
+ * - Earliest deadline first: a domain with a relative deadline has to be
+ *   dispatched within that time from becoming runnable; the runnable domain
+ *   with the earliest absolute deadline runs next. Domains without a deadline
+ *   share the remaining time with weighted fair queuing.
+ *
+ * The implementation reports domain runnability with nvs_domain_set_runnable()
+ * and calls nvs_sched_schedule() when a timeslice ends to get the next domain.
+ *
  * Core Scheduler
  * ==============
  *
@@ -127,6 +141,48 @@ struct nvs_sched_ops {
 	int	(*recover)(struct nvs_sched *sched);
 };
 
+/**
+ * @brief A domain scheduling algorithm.
+ *
+ * Algorithms keep their bookkeeping in the scheduling fields of struct
+ * nvs_domain and struct nvs_sched, so an algorithm object has no state of its
+ * own and can be shared by several schedulers.
+ */
+struct nvs_domain_algo {
+	/**
+	 * Name for selecting the algorithm, see nvs_algo_by_name().
+	 */
+	const char		*name;
+
+	/**
+	 * @brief Reset the bookkeeping of all domains in \a sched when the
+	 *        algorithm gets selected. Optional.
+	 */
+	void	(*init)(struct nvs_sched *sched);
+
+	/**
+	 * @brief Domain \a dom became runnable at \a now. Optional.
+	 */
+	void	(*wakeup)(struct nvs_sched *sched, struct nvs_domain *dom,
+			  u64 now);
+
+	/**
+	 * @brief Charge \a ran_ns of execution that ended at \a now to \a dom.
+	 *        Optional.
+	 */
+	void	(*schedule)(struct nvs_sched *sched, struct nvs_domain *dom,
+			    u64 now, u64 ran_ns);
+
+	/**
+	 * @brief Pick the domain to run next; NULL if nothing can run.
+	 */
+	struct nvs_domain *(*next_domain)(struct nvs_sched *sched);
+};
+
+extern const struct nvs_domain_algo nvs_algo_round_robin;
+extern const struct nvs_domain_algo nvs_algo_wfq;
+extern const struct nvs_domain_algo nvs_algo_edf;
+
 /**
  * @brief Define a top level scheduler object.
  */
@@ -146,9 +202,23 @@ struct nvs_sched {
 	struct nvs_domain_list	*domain_list;
 
 	/**
-	 * Algorithm instance; invoked after a schedule() call.
+	 * Algorithm instance; invoked after a schedule() call. Round-robin
+	 * unless changed with nvs_sched_set_algo().
+	 */
+	const struct nvs_domain_algo	*algorithm;
+
+	/**
+	 * The domain picked by the last nvs_sched_schedule() call and the time
+	 * it was picked at.
 	 */
-	struct nvs_domain_algo	*algorithm;
+	struct nvs_domain	*current;
+	u64			 dispatch_ns;
+
+	/**
+	 * System virtual time for weighted fair queuing: the smallest virtual
+	 * time of the runnable domains. Never decreases.
+	 */
+	u64			 vtime;
 
 	/**
 	 * Log buffer with log entries.
@@ -184,4 +254,28 @@ int	nvs_sched_create(struct nvs_sched *sched,
 
 void	nvs_sched_close(struct nvs_sched *sched);
 
+/**
+ * @brief Find a built in algorithm by its name; NULL if there is none.
+ */
+const struct nvs_domain_algo *nvs_algo_by_name(const char *name);
+
+/**
+ * @brief Switch \a sched to use \a algo to pick domains.
+ */
+void	nvs_sched_set_algo(struct nvs_sched *sched,
+			   const struct nvs_domain_algo *algo);
+
+/**
+ * @brief End the timeslice of the current domain at \a now and pick the
+ *        next one.
+ *
+ * @param sched		The scheduler.
+ * @param now		Current time in ns.
+ *
+ * The current domain is charged for the time since it was picked. Returns the
+ * domain to run next, which may be the same as before, or NULL if no domain
+ * can run.
+ */
+struct nvs_domain *nvs_sched_schedule(struct nvs_sched *sched, u64 now);
+
 #endif
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2021-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <nvs/log.h>
+#include <nvs/sched.h>
+#include <nvs/domain.h>
+
+/*
+ * Round-robin: rotate through the domain list, giving every domain its
+ * timeslice whether it has work or not.
+ */
+static struct nvs_domain *nvs_rr_next_domain(struct nvs_sched *sched)
+{
+	struct nvs_domain *next = NULL;
+
+	if (sched->current != NULL) {
+		next = sched->current->next;
+	}
+
+	if (next == NULL) {
+		next = sched->domain_list->domains;
+	}
+
+	return next;
+}
+
+const struct nvs_domain_algo nvs_algo_round_robin = {
+	.name		= "rr",
+	.init		= NULL,
+	.wakeup		= NULL,
+	.schedule	= NULL,
+	.next_domain	= nvs_rr_next_domain,
+};
+
+/*
+ * Weighted fair queuing: each domain accumulates virtual time at a rate
+ * inversely proportional to its weight, and the runnable domain that has
+ * consumed the least virtual time runs next. A domain that wakes up is
+ * brought forward to the system virtual time so that it can't hog the device
+ * with credit it built up while idle.
+ */
+static struct nvs_domain *nvs_wfq_min_vtime(struct nvs_sched *sched)
+{
+	struct nvs_domain *dom;
+	struct nvs_domain *best = NULL;
+
+	nvs_domain_for_each(sched, dom) {
+		if (!dom->runnable) {
+			continue;
+		}
+
+		if ((best == NULL) || (dom->vtime < best->vtime)) {
+			best = dom;
+		}
+	}
+
+	return best;
+}
+
+static void nvs_wfq_init(struct nvs_sched *sched)
+{
+	struct nvs_domain *dom;
+
+	sched->vtime = 0ULL;
+
+	nvs_domain_for_each(sched, dom) {
+		dom->vtime = 0ULL;
+		dom->abs_deadline_ns = 0ULL;
+	}
+}
+
+static void nvs_wfq_wakeup(struct nvs_sched *sched, struct nvs_domain *dom,
+			   u64 now)
+{
+	(void)now;
+
+	if (dom->vtime < sched->vtime) {
+		dom->vtime = sched->vtime;
+	}
+}
+
+static void nvs_wfq_schedule(struct nvs_sched *sched, struct nvs_domain *dom,
+			     u64 now, u64 ran_ns)
+{
+	struct nvs_domain *min;
+	u32 weight = (dom->weight != 0U) ? dom->weight : 1U;
+
+	(void)now;
+
+	dom->vtime += ran_ns / weight;
+
+	min = nvs_wfq_min_vtime(sched);
+	if ((min != NULL) && (min->vtime > sched->vtime)) {
+		sched->vtime = min->vtime;
+	}
+}
+
+const struct nvs_domain_algo nvs_algo_wfq = {
+	.name		= "wfq",
+	.init		= nvs_wfq_init,
+	.wakeup		= nvs_wfq_wakeup,
+	.schedule	= nvs_wfq_schedule,
+	.next_domain	= nvs_wfq_min_vtime,
+};
+
+/*
+ * Earliest deadline first: a domain with a deadline gets an absolute deadline
+ * when it wakes up, and a new one each time its timeslice ends while it still
+ * has work. Domains with deadlines always go before the ones without; the
+ * latter are served with weighted fair queuing, which also keeps charging
+ * everyone so that switching algorithms is seamless.
+ */
+static void nvs_edf_wakeup(struct nvs_sched *sched, struct nvs_domain *dom,
+			   u64 now)
+{
+	nvs_wfq_wakeup(sched, dom, now);
+
+	if (dom->deadline_ns != 0ULL) {
+		dom->abs_deadline_ns = now + dom->deadline_ns;
+	}
+}
+
+static void nvs_edf_schedule(struct nvs_sched *sched, struct nvs_domain *dom,
+			     u64 now, u64 ran_ns)
+{
+	nvs_wfq_schedule(sched, dom, now, ran_ns);
+
+	if (dom->deadline_ns != 0ULL) {
+		dom->abs_deadline_ns = now + dom->deadline_ns;
+	}
+}
+
+static struct nvs_domain *nvs_edf_next_domain(struct nvs_sched *sched)
+{
+	struct nvs_domain *dom;
+	struct nvs_domain *best = NULL;
+
+	nvs_domain_for_each(sched, dom) {
+		if (!dom->runnable || (dom->deadline_ns == 0ULL)) {
+			continue;
+		}
+
+		if ((best == NULL) ||
+		    (dom->abs_deadline_ns < best->abs_deadline_ns)) {
+			best = dom;
+		}
+	}
+
+	if (best == NULL) {
+		best = nvs_wfq_min_vtime(sched);
+	}
+
+	return best;
+}
+
+const struct nvs_domain_algo nvs_algo_edf = {
+	.name		= "edf",
+	.init		= nvs_wfq_init,
+	.wakeup		= nvs_edf_wakeup,
+	.schedule	= nvs_edf_schedule,
+	.next_domain	= nvs_edf_next_domain,
+};
+
+static const struct nvs_domain_algo *nvs_algos[] = {
+	&nvs_algo_round_robin,
+	&nvs_algo_wfq,
+	&nvs_algo_edf,
+};
+
+const struct nvs_domain_algo *nvs_algo_by_name(const char *name)
+{
+	u32 i;
+
+	for (i = 0U; i < (u32)(sizeof(nvs_algos) / sizeof(nvs_algos[0])); i++) {
+		if (strcmp(nvs_algos[i]->name, name) == 0) {
+			return nvs_algos[i];
+		}
+	}
+
+	return NULL;
+}
@@ -45,6 +45,8 @@ struct nvs_domain *nvs_domain_create(struct nvs_sched *sched,
 	strncpy(dom->name, name, sizeof(dom->name) - 1);
 	dom->timeslice_ns     = timeslice;
 	dom->preempt_grace_ns = preempt_grace;
+	dom->weight           = 1U;
+	dom->vtime            = sched->vtime;
 	dom->priv             = priv;
 
 	nvs_log_event(sched, NVS_EV_CREATE_DOMAIN, 0U);
@@ -116,6 +118,10 @@ void nvs_domain_destroy(struct nvs_sched *sched,
 
 	nvs_domain_unlink(sched, dom);
 
+	if (sched->current == dom) {
+		sched->current = NULL;
+	}
+
 	nvs_memset(dom, 0, sizeof(*dom));
 	nvs_free(sched, dom);
 
@@ -148,3 +154,21 @@ struct nvs_domain *nvs_domain_by_name(struct nvs_sched *sched, const char *name)
 
 	return NULL;
 }
+
+/*
+ * The algorithms only consider runnable domains, except for round-robin which
+ * rotates through all of them.
+ */
+void nvs_domain_set_runnable(struct nvs_sched *sched, struct nvs_domain *dom,
+			     bool runnable, u64 now)
+{
+	if (runnable == dom->runnable) {
+		return;
+	}
+
+	dom->runnable = runnable;
+
+	if (runnable && (sched->algorithm->wakeup != NULL)) {
+		sched->algorithm->wakeup(sched, dom, now);
+	}
+}
@@ -37,6 +37,7 @@ int nvs_sched_create(struct nvs_sched *sched,
 
 	sched->ops  = ops;
 	sched->priv = priv;
+	sched->algorithm = &nvs_algo_round_robin;
 
 	sched->domain_list = nvs_malloc(sched, sizeof(*sched->domain_list));
 	if (sched->domain_list == NULL) {
@@ -64,3 +65,41 @@ void nvs_sched_close(struct nvs_sched *sched)
 
 	nvs_memset(sched, 0, sizeof(*sched));
 }
+
+void nvs_sched_set_algo(struct nvs_sched *sched,
+			const struct nvs_domain_algo *algo)
+{
+	nvs_log(sched, "Switching to algorithm %s", algo->name);
+
+	sched->algorithm = algo;
+	if (algo->init != NULL) {
+		algo->init(sched);
+	}
+}
+
+struct nvs_domain *nvs_sched_schedule(struct nvs_sched *sched, u64 now)
+{
+	const struct nvs_domain_algo *algo = sched->algorithm;
+	struct nvs_domain *next;
+
+	if ((sched->current != NULL) && (algo->schedule != NULL)) {
+		u64 ran_ns = 0ULL;
+
+		if (now > sched->dispatch_ns) {
+			ran_ns = now - sched->dispatch_ns;
+		}
+
+		algo->schedule(sched, sched->current, now, ran_ns);
+	}
+
+	next = algo->next_domain(sched);
+
+	sched->current = next;
+	sched->dispatch_ns = now;
+
+	if (next != NULL) {
+		nvs_log_event(sched, NVS_EV_SWITCH_DOMAIN, 0U);
+	}
+
+	return next;
+}
@@ -82,6 +82,7 @@
  *   - @ref SWUTS-interface-atomic
  *   - @ref SWUTS-ltc
  *   - @ref SWUTS-nvgpu-rc
+ *   - @ref SWUTS-nvsched
  *   - @ref SWUTS-mc
  *   - @ref SWUTS-mm-allocators-bitmap-allocator
  *   - @ref SWUTS-mm-allocators-buddy-allocator
@@ -137,6 +138,7 @@
  *   - @ref SWUTS-channel_os
  *   - @ref SWUTS-top
  *   - @ref SWUTS-class
+ *   - @ref SWUTS-regops
  *   - @ref SWUTS-gr
  *   - @ref SWUTS-gr-setup
  *   - @ref SWUTS-gr-intr
@@ -147,6 +149,9 @@
  *   - @ref SWUTS-gr-global-ctx
  *   - @ref SWUTS-gr-ctx
  *   - @ref SWUTS-gr-obj-ctx
+ *   - @ref SWUTS-gr-fecs-trace
+ *   - @ref SWUTS-gr-hwpm-map
+ *   - @ref SWUTS-cyclestats
  *   - @ref SWUTS-gr-config
  *   - @ref SWUTS-ecc
  *   - @ref SWUTS-pmu
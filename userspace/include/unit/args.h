@@ -45,6 +45,7 @@
 #endif
 #define DEFAULT_ARG_UNIT_LOAD_PATH	stringify(__DEFAULT_ARG_UNIT_LOAD_PATH)
 #define TEST_PLAN_MAX 1
+#define REG_PROFILE_MAX 64U
 
 struct unit_fw;
 
@@ -57,6 +58,7 @@ struct unit_fw_args {
 	bool		 is_qnx;
 	unsigned int	 test_lvl;
 	bool		 debug;
+	unsigned int	 reg_profile;
 	const char	*binary_name;
 
 	const char	*driver_load_path;
@@ -29,6 +29,7 @@ struct unit_results;
 
 struct gk20a;
 struct nvgpu_posix_fault_inj_container;
+struct nvgpu_posix_io_reg_profile;
 
 /*
  * The core unit testing framework data structure. Keeps track of global state
@@ -59,6 +60,12 @@ struct unit_fw {
 				    (struct nvgpu_posix_fault_inj_container *c);
 		void		 (*nvgpu_posix_init_fault_injection_qnx)
 				    (struct nvgpu_posix_fault_inj_container *c);
+		/* Optional: only needed for --reg-profile. */
+		void		 (*nvgpu_posix_io_start_profile)(struct gk20a *g);
+		void		 (*nvgpu_posix_io_stop_profile)(struct gk20a *g);
+		unsigned int	 (*nvgpu_posix_io_get_profile)(struct gk20a *g,
+				    struct nvgpu_posix_io_reg_profile *hot,
+				    unsigned int max);
 	} nvgpu;
 	void			 *nvgpu_qnx_ut;
 };
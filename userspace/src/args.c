@@ -42,10 +42,11 @@ static struct option core_opts[] = {
 	{ "test-level",		1, NULL, 't' },
 	{ "debug",		0, NULL, 'd' },
 	{ "required",		0, NULL, 'r' },
+	{ "reg-profile",	1, NULL, 'p' },
 	{ NULL,			0, NULL,  0  }
 };
 
-static const char *core_opts_str = "hvqCnQL:K:j:t:dr:";
+static const char *core_opts_str = "hvqCnQL:K:j:t:dr:p:";
 
 void core_print_help(struct unit_fw *fw)
 {
@@ -80,6 +81,9 @@ void core_print_help(struct unit_fw *fw)
 "                         crashes.\n",
 "  -r, --required <FILE>  Path to a file with a list of required tests to\n"
 "                         check if all were executed.\n",
+"  -p, --reg-profile <COUNT>\n",
+"                         Count BAR0 register accesses and print the COUNT\n",
+"                         most accessed registers after each test.\n",
 "\n",
 "Note: mandatory arguments to long arguments are mandatory for short\n",
 "arguments as well.\n",
@@ -180,6 +184,14 @@ int core_parse_args(struct unit_fw *fw, int argc, char **argv)
 		case 'r':
 			args->required_tests_file = optarg;
 			break;
+		case 'p':
+			args->reg_profile = strtol(optarg, NULL, 10);
+			if (args->reg_profile == 0 ||
+			    args->reg_profile > REG_PROFILE_MAX) {
+				core_err(fw, "Invalid register profile count\n");
+				return -1;
+			}
+			break;
 		case '?':
 			args->help = true;
 			return -1;
@@ -36,6 +36,7 @@
 #include <unit/results.h>
 
 #include <nvgpu/posix/probe.h>
+#include <nvgpu/posix/io.h>
 #include <nvgpu/posix/posix-fault-injection.h>
 
 /*
@@ -50,6 +51,26 @@ sem_t unit_thread_semaphore;
 _Thread_local struct unit_module *thread_local_module;
 _Thread_local struct unit_module_test *thread_local_test;
 
+/*
+ * Print the registers the last test accessed most. Enabled with --reg-profile.
+ */
+static void core_print_reg_profile(struct unit_module *module,
+				   struct gk20a *g)
+{
+	struct nvgpu_posix_io_reg_profile hot[REG_PROFILE_MAX];
+	unsigned int i, n;
+
+	module->fw->nvgpu.nvgpu_posix_io_stop_profile(g);
+	n = module->fw->nvgpu.nvgpu_posix_io_get_profile(g, hot,
+			module->fw->args->reg_profile);
+
+	for (i = 0; i < n; i++) {
+		core_msg(module->fw, "    reg 0x%08x: %llu reads, %llu writes\n",
+			 hot[i].addr, (unsigned long long)hot[i].reads,
+			 (unsigned long long)hot[i].writes);
+	}
+}
+
 /*
  * Execute a module and all its subtests. This function builds a gk20a for the
  * test to use by executing nvgpu_posix_probe() and nvgpu_posix_cleanup();
@@ -114,8 +135,16 @@ static void *core_exec_module(void *module_param)
 		core_msg(module->fw, "Running %s.%s(%s)\n", module->name,
 			t->fn_name, t->case_name);
 
+		if (module->fw->args->reg_profile != 0U) {
+			module->fw->nvgpu.nvgpu_posix_io_start_profile(g);
+		}
+
 		test_status = t->fn(module, g, t->args);
 
+		if (module->fw->args->reg_profile != 0U) {
+			core_print_reg_profile(module, g);
+		}
+
 		if (test_status != UNIT_SUCCESS)
 			core_msg_color(module->fw, C_RED,
 				"  Unit error! Test %s.%s(%s) FAILED!\n",
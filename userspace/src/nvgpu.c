@@ -91,6 +91,23 @@ int core_load_nvgpu(struct unit_fw *fw)
 		return -1;
 	}
 
+	if (fw->args->reg_profile != 0U) {
+		fw->nvgpu.nvgpu_posix_io_start_profile = dlsym(fw->nvgpu_so,
+					"nvgpu_posix_io_start_profile");
+		fw->nvgpu.nvgpu_posix_io_stop_profile = dlsym(fw->nvgpu_so,
+					"nvgpu_posix_io_stop_profile");
+		fw->nvgpu.nvgpu_posix_io_get_profile = dlsym(fw->nvgpu_so,
+					"nvgpu_posix_io_get_profile");
+		if (fw->nvgpu.nvgpu_posix_io_start_profile == NULL ||
+		    fw->nvgpu.nvgpu_posix_io_stop_profile == NULL ||
+		    fw->nvgpu.nvgpu_posix_io_get_profile == NULL) {
+			msg = dlerror();
+			core_err(fw, "Failed to resolve register profile: %s\n",
+				 msg);
+			return -1;
+		}
+	}
+
 	if (fw->args->is_qnx != 0) {
 		fw->nvgpu_qnx_ut = dlopen("libnvgpu_ut_igpu.so", flag);
 		if (fw->nvgpu_qnx_ut == NULL) {
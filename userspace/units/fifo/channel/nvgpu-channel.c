@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <sched.h>
 
 #include <unit/io.h>
 #include <unit/unit.h>
@@ -36,7 +37,9 @@
 #include <nvgpu/runlist.h>
 #include <nvgpu/debug.h>
 #include <nvgpu/thread.h>
+#include <nvgpu/job.h>
 #include <nvgpu/channel_user_syncpt.h>
+#include <nvgpu/timers.h>
 
 #include <nvgpu/posix/posix-fault-injection.h>
 #include <nvgpu/posix/posix-nvhost.h>
@@ -1163,6 +1166,19 @@ int test_channel_from_inst(struct unit_module *m, struct gk20a *g, void *vargs)
 			unit_assert(ch == NULL, goto done);
 		}
 	}
+
+	/* closed channels drop out of the lookup */
+	inst_ptr = nvgpu_inst_block_addr(g, &chA->inst_block);
+	nvgpu_channel_close(chA);
+	chA = NULL;
+	ch = nvgpu_channel_refch_from_inst_ptr(g, inst_ptr);
+	unit_assert(ch == NULL, goto done);
+
+	inst_ptr = nvgpu_inst_block_addr(g, &chB->inst_block);
+	ch = nvgpu_channel_refch_from_inst_ptr(g, inst_ptr);
+	unit_assert(ch == chB, goto done);
+	nvgpu_channel_put(ch);
+
 	ret = UNIT_SUCCESS;
 
 done:
@@ -1881,6 +1897,308 @@ done:
 	return ret;
 }
 
+#define SEMA_BENCH_LOOPS	2000U
+#define SEMA_BENCH_BUSY_CHS	4U
+
+static s64 sema_bench_run(struct gk20a *g)
+{
+	s64 start;
+	u32 i;
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < SEMA_BENCH_LOOPS; i++) {
+		nvgpu_channel_semaphore_wakeup(g, false);
+	}
+
+	return (nvgpu_current_time_ns() - start) / (s64)SEMA_BENCH_LOOPS;
+}
+
+static u32 sema_bench_count_pending(struct nvgpu_fifo *f)
+{
+	unsigned long bit;
+	u32 count = 0U;
+
+	for_each_set_bit(bit, f->sema_wakeup_chs, f->num_channels) {
+		count++;
+	}
+
+	return count;
+}
+
+int test_channel_semaphore_wakeup_bench(struct unit_module *m,
+						struct gk20a *g, void *vargs)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_fifo fifo = g->fifo;
+	struct gpu_ops gops = g->ops;
+	const u32 num_channels[] = { 64U, 512U, 4096U };
+	struct nvgpu_channel *ch;
+	s64 busy_ns, all_ns;
+	u32 n, i;
+	int ret = UNIT_FAIL;
+
+	g->ops.mm.cache.fb_flush = stub_mm_fb_flush;
+
+	for (n = 0U; n < ARRAY_SIZE(num_channels); n++) {
+		f->num_channels = num_channels[n];
+		f->channel = nvgpu_kzalloc(g,
+				sizeof(*f->channel) * f->num_channels);
+		f->sema_wakeup_chs = nvgpu_kcalloc(g,
+				BITS_TO_LONGS(f->num_channels),
+				sizeof(*f->sema_wakeup_chs));
+		unit_assert(f->channel != NULL, goto done);
+		unit_assert(f->sema_wakeup_chs != NULL, goto done);
+
+		for (i = 0U; i < f->num_channels; i++) {
+			ch = &f->channel[i];
+			ch->g = g;
+			ch->chid = i;
+			ch->referenceable = true;
+			nvgpu_atomic_set(&ch->ref_count, 1);
+			nvgpu_atomic_set(&ch->bound, 1);
+			nvgpu_spinlock_init(&ch->ref_obtain_lock);
+			unit_assert(nvgpu_cond_init(&ch->semaphore_wq) == 0,
+					goto done);
+			unit_assert(nvgpu_cond_init(&ch->ref_count_dec_wq) == 0,
+					goto done);
+		}
+
+		/* a waiter keeps the channel in the set until it's done */
+		ch = &f->channel[1];
+		nvgpu_channel_semaphore_wait_begin(ch);
+		nvgpu_channel_semaphore_wakeup(g, false);
+		unit_assert(nvgpu_test_bit(ch->chid, f->sema_wakeup_chs),
+				goto done);
+		nvgpu_channel_semaphore_wait_end(ch);
+		nvgpu_channel_semaphore_wakeup(g, false);
+		unit_assert(sema_bench_count_pending(f) == 0U, goto done);
+
+		for (i = 0U; i < SEMA_BENCH_BUSY_CHS; i++) {
+			nvgpu_channel_semaphore_set_untracked(&f->channel[i *
+				(f->num_channels / SEMA_BENCH_BUSY_CHS)]);
+		}
+		busy_ns = sema_bench_run(g);
+		unit_assert(sema_bench_count_pending(f) == SEMA_BENCH_BUSY_CHS,
+				goto done);
+
+		/* every channel busy is what each wakeup used to cost */
+		for (i = 0U; i < f->num_channels; i++) {
+			nvgpu_channel_semaphore_set_untracked(&f->channel[i]);
+		}
+		all_ns = sema_bench_run(g);
+
+		unit_info(m, "%u channels: %lld ns per wakeup with %u busy, "
+			"%lld ns with all busy\n", f->num_channels,
+			(long long)busy_ns, SEMA_BENCH_BUSY_CHS,
+			(long long)all_ns);
+
+		for (i = 0U; i < f->num_channels; i++) {
+			nvgpu_cond_destroy(&f->channel[i].semaphore_wq);
+			nvgpu_cond_destroy(&f->channel[i].ref_count_dec_wq);
+		}
+		nvgpu_kfree(g, f->channel);
+		f->channel = NULL;
+		nvgpu_kfree(g, f->sema_wakeup_chs);
+		f->sema_wakeup_chs = NULL;
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	nvgpu_kfree(g, f->channel);
+	nvgpu_kfree(g, f->sema_wakeup_chs);
+	f->channel = fifo.channel;
+	f->num_channels = fifo.num_channels;
+	f->sema_wakeup_chs = fifo.sema_wakeup_chs;
+	g->ops = gops;
+
+	return ret;
+}
+
+#ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
+#define JOBLIST_BENCH_JOBS	1000000U
+#define JOBLIST_BENCH_DEPTH	1024U
+
+struct joblist_bench {
+	struct nvgpu_channel *ch;
+	/* serialize every joblist access, as the old joblist lock did */
+	struct nvgpu_mutex lock;
+	bool locked;
+	u32 out_of_order;
+};
+
+static void joblist_bench_lock(struct joblist_bench *b)
+{
+	if (b->locked) {
+		nvgpu_mutex_acquire(&b->lock);
+	}
+}
+
+static void joblist_bench_unlock(struct joblist_bench *b)
+{
+	if (b->locked) {
+		nvgpu_mutex_release(&b->lock);
+	}
+}
+
+static int joblist_bench_cleanup_thread(void *arg)
+{
+	struct joblist_bench *b = arg;
+	struct nvgpu_channel_job *job;
+	u32 seq = 0U;
+
+	while (seq < JOBLIST_BENCH_JOBS) {
+		joblist_bench_lock(b);
+		job = nvgpu_channel_joblist_peek(b->ch);
+		joblist_bench_unlock(b);
+		if (job == NULL) {
+			(void) sched_yield();
+			continue;
+		}
+
+		if (job->num_mapped_buffers != seq) {
+			b->out_of_order++;
+		}
+		seq++;
+
+		joblist_bench_lock(b);
+		nvgpu_channel_joblist_delete(b->ch, job);
+		joblist_bench_unlock(b);
+	}
+
+	return 0;
+}
+
+static int joblist_bench_run(struct unit_module *m, struct joblist_bench *b,
+		s64 *ns)
+{
+	struct nvgpu_thread cleanup;
+	struct nvgpu_channel_job *job;
+	s64 start;
+	u32 seq = 0U;
+	int err;
+
+	start = nvgpu_current_time_ns();
+	err = nvgpu_thread_create(&cleanup, b, joblist_bench_cleanup_thread,
+			"joblist_cleanup");
+	if (err != 0) {
+		unit_err(m, "failed to create cleanup thread\n");
+		return err;
+	}
+
+	while (seq < JOBLIST_BENCH_JOBS) {
+		joblist_bench_lock(b);
+		err = nvgpu_channel_alloc_job(b->ch, &job);
+		joblist_bench_unlock(b);
+		if (err == -EAGAIN) {
+			(void) sched_yield();
+			continue;
+		}
+		if (err != 0) {
+			break;
+		}
+
+		job->num_mapped_buffers = seq;
+		seq++;
+
+		joblist_bench_lock(b);
+		nvgpu_channel_joblist_add(b->ch, job);
+		joblist_bench_unlock(b);
+	}
+
+	/* the cleanup thread only returns once it has seen every job */
+	if (err != 0) {
+		unit_err(m, "job alloc failed: %d\n", err);
+		nvgpu_thread_stop(&cleanup);
+		return err;
+	}
+	nvgpu_thread_join(&cleanup);
+	*ns = nvgpu_current_time_ns() - start;
+
+	return 0;
+}
+
+int test_channel_joblist_stress(struct unit_module *m,
+		struct gk20a *g, void *vargs)
+{
+	struct joblist_bench b;
+	struct nvgpu_channel_job *job;
+	s64 lockfree_ns = 0, locked_ns = 0;
+	u32 i, num_chunks;
+	int ret = UNIT_FAIL;
+	int err;
+
+	(void) memset(&b, 0, sizeof(b));
+	nvgpu_mutex_init(&b.lock);
+	b.ch = nvgpu_kzalloc(g, sizeof(*b.ch));
+	unit_assert(b.ch != NULL, goto done);
+	b.ch->g = g;
+
+#ifdef CONFIG_NVGPU_DETERMINISTIC_CHANNELS
+	/* a deterministic channel has room for all its jobs up front */
+	b.ch->deterministic = true;
+	err = nvgpu_channel_joblist_init(b.ch, 100U);
+	unit_assert(err == 0, goto done);
+	num_chunks = b.ch->joblist.num_chunks;
+	for (i = 0U; i < 100U; i++) {
+		unit_assert(nvgpu_channel_alloc_job(b.ch, &job) == 0,
+				goto done);
+		nvgpu_channel_joblist_add(b.ch, job);
+	}
+	unit_assert(nvgpu_channel_alloc_job(b.ch, &job) == -EAGAIN,
+			goto done);
+	for (i = 0U; i < 1000U; i++) {
+		job = nvgpu_channel_joblist_peek(b.ch);
+		unit_assert(job != NULL, goto done);
+		nvgpu_channel_joblist_delete(b.ch, job);
+		unit_assert(nvgpu_channel_alloc_job(b.ch, &job) == 0,
+				goto done);
+		nvgpu_channel_joblist_add(b.ch, job);
+	}
+	unit_assert(b.ch->joblist.num_chunks == num_chunks, goto done);
+	nvgpu_channel_joblist_deinit(b.ch);
+	b.ch->deterministic = false;
+#endif
+
+	/* others start small and grow only as far as jobs pile up */
+	err = nvgpu_channel_joblist_init(b.ch, JOBLIST_BENCH_DEPTH);
+	unit_assert(err == 0, goto done);
+	unit_assert(b.ch->joblist.num_chunks == 1U, goto done);
+	unit_assert(nvgpu_channel_joblist_is_empty(b.ch), goto done);
+	unit_assert(nvgpu_channel_joblist_peek(b.ch) == NULL, goto done);
+
+	err = joblist_bench_run(m, &b, &lockfree_ns);
+	unit_assert(err == 0, goto done);
+	unit_assert(b.out_of_order == 0U, goto done);
+	unit_assert(nvgpu_channel_joblist_is_empty(b.ch), goto done);
+	num_chunks = b.ch->joblist.num_chunks;
+	nvgpu_channel_joblist_deinit(b.ch);
+
+	err = nvgpu_channel_joblist_init(b.ch, JOBLIST_BENCH_DEPTH);
+	unit_assert(err == 0, goto done);
+	b.locked = true;
+	err = joblist_bench_run(m, &b, &locked_ns);
+	unit_assert(err == 0, goto done);
+	unit_assert(b.out_of_order == 0U, goto done);
+
+	unit_info(m, "%u jobs through a %u deep joblist: lock-free %lld ns "
+		"(grew to %u chunks), locked %lld ns\n", JOBLIST_BENCH_JOBS,
+		JOBLIST_BENCH_DEPTH, (long long)lockfree_ns, num_chunks,
+		(long long)locked_ns);
+
+	ret = UNIT_SUCCESS;
+
+done:
+	if (b.ch != NULL) {
+		nvgpu_channel_joblist_deinit(b.ch);
+		nvgpu_kfree(g, b.ch);
+	}
+	nvgpu_mutex_destroy(&b.lock);
+
+	return ret;
+}
+#endif
+
 int test_channel_from_invalid_id(struct unit_module *m, struct gk20a *g,
 								void *args)
 {
@@ -2175,6 +2493,10 @@ struct unit_module_test nvgpu_channel_tests[] = {
 	UNIT_TEST(suspend_resume, test_channel_suspend_resume_serviceable_chs, &unit_ctx, 0),
 	UNIT_TEST(debug_dump, test_channel_debug_dump, &unit_ctx, 0),
 	UNIT_TEST(semaphore_wakeup, test_channel_semaphore_wakeup, &unit_ctx, 0),
+	UNIT_TEST(semaphore_wakeup_bench, test_channel_semaphore_wakeup_bench, &unit_ctx, 1),
+#ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
+	UNIT_TEST(joblist_stress, test_channel_joblist_stress, &unit_ctx, 1),
+#endif
 	UNIT_TEST(channel_from_invalid_id, test_channel_from_invalid_id, &unit_ctx, 0),
 	UNIT_TEST(nvgpu_channel_from_chid_bvec, test_nvgpu_channel_from_id_bvec, &unit_ctx, 0),
 	UNIT_TEST(channel_put_warn, test_channel_put_warn, &unit_ctx, 0),
@@ -217,7 +217,8 @@ int test_channel_alloc_inst(struct unit_module *m,
  *
  * Test Type: Feature
  *
- * Targets: nvgpu_channel_refch_from_inst_ptr, nvgpu_inst_block_addr
+ * Targets: nvgpu_channel_refch_from_inst_ptr, nvgpu_inst_block_addr,
+ *          nvgpu_channel_alloc_inst, nvgpu_channel_free_inst
  *
  * Input: test_fifo_init_support() run for this GPU
  *
@@ -229,6 +230,8 @@ int test_channel_alloc_inst(struct unit_module *m,
  *   - Check that refcount is incremented for channel.
  * - Check invalid cases for nvgpu_channel_refch_from_inst_ptr:
  *   - Pass invalid inst_ptr and check that no channel is found.
+ * - Close chA and check that its inst_ptr no longer finds a channel, while
+ *   chB is still found.
  *
  * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
  */
@@ -402,6 +405,70 @@ int test_channel_debug_dump(struct unit_module *m,
 int test_channel_semaphore_wakeup(struct unit_module *m,
 						struct gk20a *g, void *vargs);
 
+/**
+ * Test specification for: test_channel_semaphore_wakeup_bench
+ *
+ * Description: Measure semaphore wakeup cost as the channel count grows.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_channel_semaphore_wakeup,
+ *          nvgpu_channel_semaphore_set_untracked,
+ *          nvgpu_channel_semaphore_wait_begin,
+ *          nvgpu_channel_semaphore_wait_end
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For 64, 512 and 4096 channels, set up a fake channel array where all
+ *   channels are referenceable and bound.
+ * - Register a semaphore waiter on one channel, and check that the channel
+ *   stays in the wakeup set across a wakeup. Unregister the waiter and check
+ *   that the next wakeup empties the set.
+ * - Mark a few channels as having untracked work, time the wakeups, and
+ *   check that only those channels are in the wakeup set.
+ * - Mark all channels, which is what every wakeup used to cost, and time
+ *   the wakeups again.
+ *
+ * Output: Returns PASS if the wakeup set was as expected. FAIL otherwise.
+ */
+int test_channel_semaphore_wakeup_bench(struct unit_module *m,
+						struct gk20a *g, void *vargs);
+
+#ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
+/**
+ * Test specification for: test_channel_joblist_stress
+ *
+ * Description: Stress the joblist with a submit thread against a cleanup
+ * thread and measure its throughput.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_channel_joblist_init, nvgpu_channel_joblist_deinit,
+ *          nvgpu_channel_alloc_job, nvgpu_channel_joblist_add,
+ *          nvgpu_channel_joblist_peek, nvgpu_channel_joblist_delete,
+ *          nvgpu_channel_joblist_is_empty
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Init the joblist of a deterministic channel for 100 jobs. Check that 100
+ *   jobs can be added, that one more fails with -EAGAIN, and that cycling
+ *   jobs through the full joblist does not allocate more chunks.
+ * - Init the joblist of a non-deterministic channel and check that it starts
+ *   empty with one chunk.
+ * - Add 1000000 sequence-numbered jobs from this thread while a cleanup
+ *   thread peeks and deletes them, and check that the cleanup thread sees
+ *   them all in order and that the joblist ends up empty.
+ * - Run the same with every joblist call serialized by a mutex, as the
+ *   joblist used to be, and report both times.
+ *
+ * Output: Returns PASS if all jobs were seen in order. FAIL otherwise.
+ */
+int test_channel_joblist_stress(struct unit_module *m,
+		struct gk20a *g, void *vargs);
+#endif
+
 /**
  * Test specification for: test_channel_from_invalid_id
  *
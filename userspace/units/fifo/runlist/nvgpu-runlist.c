@@ -20,14 +20,470 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdlib.h>
+
+#include <unit/io.h>
 #include <unit/unit.h>
 #include <unit/utils.h>
 
+#include <nvgpu/channel.h>
+#include <nvgpu/tsg.h>
+#include <nvgpu/gk20a.h>
+#include <nvgpu/runlist.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/string.h>
+
+#include "hal/fifo/runlist_ram_gv11b.h"
+
+#include <nvgpu/hw/gv11b/hw_ram_gv11b.h>
+
+#include "nvgpu-runlist.h"
+
+#define RL_TEST_NUM_TSGS	64U
+#define RL_TEST_CHS_PER_TSG	4U
+#define RL_TEST_NUM_CHANNELS	(RL_TEST_NUM_TSGS * RL_TEST_CHS_PER_TSG)
+#define RL_TEST_NUM_STEPS	2000U
+#define RL_TEST_BENCH_LOOPS	20000U
+#define RL_TEST_CACHE_LOOPS	2000U
+
+struct rl_test_ctx {
+	struct nvgpu_mem userd_mem;
+	struct nvgpu_runlist *rl;
+	struct nvgpu_runlist_domain *domain;
+};
+
+static void stub_runlist_hw_submit(struct gk20a *g, struct nvgpu_runlist *rl)
+{
+}
+
+static int stub_runlist_wait_pending(struct gk20a *g, struct nvgpu_runlist *rl)
+{
+	return 0;
+}
+
+static void rl_test_free_tsg_caches(struct gk20a *g)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	u32 i;
+
+	for (i = 0U; i < f->num_channels; i++) {
+		nvgpu_runlist_free_tsg_cache(g, &f->tsg[i]);
+	}
+}
+
+static void rl_test_free_fifo(struct gk20a *g)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+
+	if (f->tsg != NULL) {
+		rl_test_free_tsg_caches(g);
+	}
+	nvgpu_runlist_cleanup_sw(g);
+	nvgpu_kfree(g, f->tsg_ch_bitmaps);
+	f->tsg_ch_bitmaps = NULL;
+	nvgpu_kfree(g, f->channel);
+	f->channel = NULL;
+	nvgpu_kfree(g, f->tsg);
+	f->tsg = NULL;
+}
+
+/*
+ * Build a fake fifo with one runlist and a number of TSGs with a few
+ * channels each. Nothing here touches the registers; only the runlist
+ * buffer rendering in sysmem is exercised.
+ */
+static int rl_test_setup(struct unit_module *m, struct gk20a *g,
+			 struct rl_test_ctx *ctx)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_runlist *rl;
+	u32 i;
+	int err;
+
+	g->ops.runlist.get_tsg_entry = gv11b_runlist_get_tsg_entry;
+	g->ops.runlist.get_ch_entry = gv11b_runlist_get_ch_entry;
+	g->ops.runlist.hw_submit = stub_runlist_hw_submit;
+	g->ops.runlist.wait_pending = stub_runlist_wait_pending;
+	g->ptimer_src_freq = 31250000U;
+	g->runlist_interleave = false;
+
+	f->g = g;
+	f->num_channels = RL_TEST_NUM_CHANNELS;
+	f->runlist_entry_size = ram_rl_entry_size_v();
+	f->num_runlist_entries = RL_TEST_NUM_TSGS * (RL_TEST_CHS_PER_TSG + 1U);
+	f->runlist_incremental = true;
+
+	f->tsg = nvgpu_kzalloc(g, sizeof(*f->tsg) * f->num_channels);
+	f->channel = nvgpu_kzalloc(g, sizeof(*f->channel) * f->num_channels);
+	f->tsg_ch_bitmaps = nvgpu_kzalloc(g, sizeof(unsigned long) *
+			f->num_channels * BITS_TO_LONGS(f->num_channels));
+	if ((f->tsg == NULL) || (f->channel == NULL) ||
+	    (f->tsg_ch_bitmaps == NULL)) {
+		goto fail;
+	}
+
+	ctx->userd_mem.aperture = APERTURE_SYSMEM;
+
+	for (i = 0U; i < f->num_channels; i++) {
+		struct nvgpu_tsg *tsg = &f->tsg[i];
+
+		tsg->g = g;
+		tsg->tsgid = i;
+		tsg->timeslice_us = 1024U;
+		tsg->interleave_level = (u32)rand() %
+			NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS;
+		tsg->ch_bitmap = &f->tsg_ch_bitmaps[i *
+				BITS_TO_LONGS(f->num_channels)];
+		nvgpu_init_list_node(&tsg->ch_list);
+		nvgpu_rwsem_init(&tsg->ch_list_lock);
+	}
+
+	for (i = 0U; i < f->num_channels; i++) {
+		struct nvgpu_channel *ch = &f->channel[i];
+		struct nvgpu_tsg *tsg = &f->tsg[i / RL_TEST_CHS_PER_TSG];
+
+		ch->g = g;
+		ch->chid = i;
+		ch->tsgid = tsg->tsgid;
+		ch->userd_mem = &ctx->userd_mem;
+		ch->userd_iova = (u64)(i + 1U) << 9U;
+		ch->inst_block.aperture = APERTURE_SYSMEM;
+		nvgpu_list_add_tail(&ch->ch_entry, &tsg->ch_list);
+		nvgpu_set_bit(ch->chid, tsg->ch_bitmap);
+	}
+
+	f->max_runlists = 1U;
+	f->num_runlists = 1U;
+	f->runlists = nvgpu_kzalloc(g, sizeof(*f->runlists));
+	f->active_runlists = nvgpu_kzalloc(g, sizeof(*f->active_runlists));
+	if ((f->runlists == NULL) || (f->active_runlists == NULL)) {
+		goto fail;
+	}
+
+	rl = &f->active_runlists[0];
+	rl->id = 0U;
+	f->runlists[0] = rl;
+	nvgpu_init_list_node(&rl->domains);
+	nvgpu_mutex_init(&rl->runlist_lock);
+
+	err = nvgpu_rl_domain_alloc(g, "rl-test");
+	if (err != 0) {
+		unit_err(m, "domain alloc failed: %d\n", err);
+		goto fail;
+	}
+
+	ctx->rl = rl;
+	ctx->domain = nvgpu_list_first_entry(&rl->domains,
+			nvgpu_runlist_domain, domains_list);
+	rl->domain = ctx->domain;
+
+	return 0;
+
+fail:
+	rl_test_free_fifo(g);
+	return -ENOMEM;
+}
+
 /*
- * Place holder for runlist unit tests. These will be written once the new
- * runlist code is in place.
+ * Compare the buffer submitted last with what a full rebuild from the
+ * active bitmaps produces. The rebuild goes to the spare buffer which gets
+ * overwritten on the next update anyway.
  */
+static bool rl_test_check_hw_buffer(struct unit_module *m, struct gk20a *g,
+				    struct rl_test_ctx *ctx)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_runlist_domain *domain = ctx->domain;
+	u32 count;
+
+	count = nvgpu_runlist_construct_locked(f, domain,
+			f->num_runlist_entries);
+	if (count != domain->mem_hw->count) {
+		unit_err(m, "count mismatch: %u != %u\n",
+				domain->mem_hw->count, count);
+		return false;
+	}
+
+	if (memcmp(domain->mem->mem.cpu_va, domain->mem_hw->mem.cpu_va,
+			(size_t)count * f->runlist_entry_size) != 0) {
+		unit_err(m, "runlist content mismatch\n");
+		return false;
+	}
+
+	return true;
+}
+
+int test_runlist_incremental_update(struct unit_module *m, struct gk20a *g,
+				    void *args)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct rl_test_ctx ctx = { };
+	u32 i;
+	int ret = UNIT_FAIL;
+	int err;
+
+	srand(0);
+
+	err = rl_test_setup(m, g, &ctx);
+	unit_assert(err == 0, return UNIT_FAIL);
+
+	for (i = 0U; i < RL_TEST_NUM_STEPS; i++) {
+		struct nvgpu_channel *ch =
+			&f->channel[(u32)rand() % f->num_channels];
+		bool add = ((u32)rand() % 3U) != 0U;
+
+		err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+				ch, add, false);
+		unit_assert(err == 0, goto done);
+		unit_assert(rl_test_check_hw_buffer(m, g, &ctx), goto done);
+
+		/*
+		 * Some TSGs change priority now and then. Like tsg.c does,
+		 * the level gets set first and the runlist is then reloaded.
+		 */
+		if (((u32)rand() % 16U) == 0U) {
+			f->tsg[ch->tsgid].interleave_level = (u32)rand() %
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS;
+			err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+					NULL, true, false);
+			unit_assert(err == 0, goto done);
+			unit_assert(rl_test_check_hw_buffer(m, g, &ctx),
+					goto done);
+		}
+	}
+
+	/* the full rebuild path clears and refills it the same way */
+	err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+			NULL, false, false);
+	unit_assert(err == 0, goto done);
+	unit_assert(ctx.domain->mem_hw->count == 0U, goto done);
+	err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+			NULL, true, false);
+	unit_assert(err == 0, goto done);
+	unit_assert(rl_test_check_hw_buffer(m, g, &ctx), goto done);
+
+	/*
+	 * A failed update leaves the active bitmaps changed but the buffers
+	 * not; the next single channel update must rebuild, not patch.
+	 */
+	for (i = 0U; i < 2U; i++) {
+		err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+				&f->channel[i], true, false);
+		unit_assert(err == 0, goto done);
+	}
+	i = f->num_runlist_entries;
+	f->num_runlist_entries = 1U;
+	f->runlist_incremental = false;
+	err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+			&f->channel[0], false, false);
+	f->runlist_incremental = true;
+	f->num_runlist_entries = i;
+	unit_assert(err == -E2BIG, goto done);
+	unit_assert(!ctx.domain->mem_hw->in_sync, goto done);
+	err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+			&f->channel[1], false, false);
+	unit_assert(err == 0, goto done);
+	unit_assert(rl_test_check_hw_buffer(m, g, &ctx), goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	rl_test_free_fifo(g);
+	return ret;
+}
+
+static s64 rl_test_bench_toggles(struct gk20a *g, struct rl_test_ctx *ctx,
+				 bool incremental)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	s64 start;
+	u32 i;
+
+	f->runlist_incremental = incremental;
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < RL_TEST_BENCH_LOOPS; i++) {
+		struct nvgpu_channel *ch = &f->channel[i % f->num_channels];
+
+		(void)nvgpu_runlist_update_locked(g, ctx->rl, ctx->domain,
+				ch, false, false);
+		(void)nvgpu_runlist_update_locked(g, ctx->rl, ctx->domain,
+				ch, true, false);
+	}
+
+	return nvgpu_current_time_ns() - start;
+}
+
+int test_runlist_update_bench(struct unit_module *m, struct gk20a *g,
+			      void *args)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct rl_test_ctx ctx = { };
+	s64 full_ns, incr_ns;
+	u32 i;
+	int ret = UNIT_FAIL;
+	int err;
+
+	srand(0);
+
+	err = rl_test_setup(m, g, &ctx);
+	unit_assert(err == 0, return UNIT_FAIL);
+
+	/* every channel active: the worst case for a full rebuild */
+	for (i = 0U; i < f->num_channels; i++) {
+		err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+				&f->channel[i], true, false);
+		unit_assert(err == 0, goto done);
+	}
+
+	full_ns = rl_test_bench_toggles(g, &ctx, false);
+	unit_assert(rl_test_check_hw_buffer(m, g, &ctx), goto done);
+	incr_ns = rl_test_bench_toggles(g, &ctx, true);
+	unit_assert(rl_test_check_hw_buffer(m, g, &ctx), goto done);
+
+	unit_info(m, "%u channel toggles over %u TSGs: full %lld ns, "
+			"incremental %lld ns\n", RL_TEST_BENCH_LOOPS,
+			RL_TEST_NUM_TSGS, (long long)full_ns,
+			(long long)incr_ns);
+
+	ret = UNIT_SUCCESS;
+done:
+	rl_test_free_fifo(g);
+	return ret;
+}
+
+/*
+ * Build the runlist with whatever the TSG caches hold and again with no
+ * caches, and compare.
+ */
+static bool rl_test_check_tsg_cache(struct unit_module *m, struct gk20a *g,
+				    struct rl_test_ctx *ctx, u32 *cold)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_runlist_domain *domain = ctx->domain;
+	u32 warm_count, cold_count;
+
+	warm_count = nvgpu_runlist_construct_locked(f, domain,
+			f->num_runlist_entries);
+	(void) memcpy(cold, domain->mem->mem.cpu_va,
+			(size_t)warm_count * f->runlist_entry_size);
+
+	rl_test_free_tsg_caches(g);
+	cold_count = nvgpu_runlist_construct_locked(f, domain,
+			f->num_runlist_entries);
+
+	if (warm_count != cold_count) {
+		unit_err(m, "count mismatch: %u != %u\n",
+				warm_count, cold_count);
+		return false;
+	}
+
+	if (memcmp(cold, domain->mem->mem.cpu_va,
+			(size_t)cold_count * f->runlist_entry_size) != 0) {
+		unit_err(m, "cached entries differ\n");
+		return false;
+	}
+
+	return true;
+}
+
+static s64 rl_test_bench_construct(struct gk20a *g, struct rl_test_ctx *ctx,
+				   bool cached)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	s64 start;
+	u32 i;
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < RL_TEST_BENCH_LOOPS / 10U; i++) {
+		if (!cached) {
+			rl_test_free_tsg_caches(g);
+		}
+		(void)nvgpu_runlist_construct_locked(f, ctx->domain,
+				f->num_runlist_entries);
+	}
+
+	return nvgpu_current_time_ns() - start;
+}
+
+int test_runlist_tsg_cache(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct rl_test_ctx ctx = { };
+	u32 *cold = NULL;
+	s64 cold_ns, warm_ns;
+	u32 i;
+	int ret = UNIT_FAIL;
+	int err;
+
+	srand(0);
+
+	err = rl_test_setup(m, g, &ctx);
+	unit_assert(err == 0, return UNIT_FAIL);
+
+	cold = nvgpu_kzalloc(g, (size_t)f->num_runlist_entries *
+			f->runlist_entry_size);
+	unit_assert(cold != NULL, goto done);
+
+	for (i = 0U; i < RL_TEST_CACHE_LOOPS; i++) {
+		struct nvgpu_channel *ch =
+			&f->channel[(u32)rand() % f->num_channels];
+		struct nvgpu_tsg *tsg = &f->tsg[ch->tsgid];
+		u32 op = (u32)rand() % 8U;
+
+		if (op == 0U) {
+			tsg->timeslice_us = 1024U << ((u32)rand() % 4U);
+		} else if ((op == 1U) && !nvgpu_test_bit(ch->chid,
+					ctx.domain->active_channels)) {
+			/* an idle channel gets unbound or bound again */
+			if (nvgpu_test_bit(ch->chid, tsg->ch_bitmap)) {
+				nvgpu_clear_bit(ch->chid, tsg->ch_bitmap);
+			} else {
+				nvgpu_set_bit(ch->chid, tsg->ch_bitmap);
+			}
+			tsg->ch_gen++;
+		} else if (nvgpu_test_bit(ch->chid, tsg->ch_bitmap)) {
+			err = nvgpu_runlist_update_locked(g, ctx.rl,
+					ctx.domain, ch, (op % 2U) == 0U, false);
+			unit_assert(err == 0, goto done);
+		}
+
+		unit_assert(rl_test_check_tsg_cache(m, g, &ctx, cold),
+				goto done);
+	}
+
+	/* all channels bound and active */
+	for (i = 0U; i < f->num_channels; i++) {
+		struct nvgpu_channel *ch = &f->channel[i];
+
+		nvgpu_set_bit(ch->chid, f->tsg[ch->tsgid].ch_bitmap);
+		f->tsg[ch->tsgid].ch_gen++;
+		err = nvgpu_runlist_update_locked(g, ctx.rl, ctx.domain,
+				ch, true, false);
+		unit_assert(err == 0, goto done);
+	}
+	unit_assert(rl_test_check_tsg_cache(m, g, &ctx, cold), goto done);
+
+	cold_ns = rl_test_bench_construct(g, &ctx, false);
+	warm_ns = rl_test_bench_construct(g, &ctx, true);
+	unit_assert(rl_test_check_tsg_cache(m, g, &ctx, cold), goto done);
+
+	unit_info(m, "%u runlist builds over %u TSGs: uncached %lld ns, "
+			"cached %lld ns\n", RL_TEST_BENCH_LOOPS / 10U,
+			RL_TEST_NUM_TSGS, (long long)cold_ns,
+			(long long)warm_ns);
+
+	ret = UNIT_SUCCESS;
+done:
+	nvgpu_kfree(g, cold);
+	rl_test_free_fifo(g);
+	return ret;
+}
+
 struct unit_module_test nvgpu_runlist_tests[] = {
+	UNIT_TEST(incremental_update, test_runlist_incremental_update, NULL, 0),
+	UNIT_TEST(update_bench, test_runlist_update_bench, NULL, 1),
+	UNIT_TEST(tsg_cache, test_runlist_tsg_cache, NULL, 1),
 };
 
 UNIT_MODULE(nvgpu_runlist, nvgpu_runlist_tests, UNIT_PRIO_NVGPU_TEST);
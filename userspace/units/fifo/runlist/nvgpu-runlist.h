@@ -391,4 +391,88 @@ int test_interleave_dual(struct unit_module *m, struct gk20a *g, void *args);
 int test_interleaving_levels(struct unit_module *m, struct gk20a *g,
 								void *args);
 
+/**
+ * Test specification for: test_runlist_incremental_update
+ *
+ * Description: Check that patching the runlist for a single channel gives
+ * the same buffer as a full rebuild.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_runlist_update_locked, nvgpu_runlist_construct_locked
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a fake fifo with one runlist, 64 TSGs with four channels each
+ *   and random interleave levels. Interleaving is disabled.
+ * - Add and remove random channels with nvgpu_runlist_update_locked, also
+ *   changing the interleave level of a TSG and reloading the runlist now
+ *   and then.
+ * - After each update, rebuild the runlist from the active bitmaps with
+ *   nvgpu_runlist_construct_locked and check that entry count and contents
+ *   match the submitted buffer.
+ * - Clear and reload the whole runlist and check it again.
+ * - Add channels 0 and 1, then make the removal of channel 0 fail with
+ *   -E2BIG by shrinking the runlist to one entry with patching off. Check
+ *   the submitted buffer is marked out of sync, then remove channel 1 with
+ *   patching on and check the buffer against a full rebuild.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_runlist_incremental_update(struct unit_module *m, struct gk20a *g,
+								void *args);
+
+/**
+ * Test specification for: test_runlist_update_bench
+ *
+ * Description: Compare the time spent in runlist updates with and without
+ * incremental patching.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_runlist_update_locked
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create the same fake fifo as test_runlist_incremental_update and make
+ *   all channels active.
+ * - Remove and add back channels one at a time, first with full rebuilds
+ *   and then with incremental patching, and check the resulting buffer.
+ * - Report the time taken by both.
+ *
+ * Output: Returns PASS if the runlist buffers are correct. FAIL otherwise.
+ */
+int test_runlist_update_bench(struct unit_module *m, struct gk20a *g,
+								void *args);
+
+/**
+ * Test specification for: test_runlist_tsg_cache
+ *
+ * Description: Check that runlist entries reused from the per-TSG cache are
+ * the same as freshly rendered ones, and compare the time of both.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_runlist_construct_locked, nvgpu_runlist_update_locked,
+ *          nvgpu_runlist_free_tsg_cache
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create the same fake fifo as test_runlist_incremental_update.
+ * - Randomly change TSG timeslices, bind or unbind idle channels by
+ *   updating the TSG channel bitmap and generation, and add or remove
+ *   bound channels from the runlist.
+ * - After each step, build the runlist with the caches as they are, then
+ *   free all caches and build it again; check that count and contents
+ *   match.
+ * - Make all channels active and report the time of repeated builds with
+ *   and without the caches.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_runlist_tsg_cache(struct unit_module *m, struct gk20a *g, void *args);
+
 #endif /* UNIT_NVGPU_RUNLIST_H */
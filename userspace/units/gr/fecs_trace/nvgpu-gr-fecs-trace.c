@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/dma.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/list.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/gr/global_ctx.h>
+#include <nvgpu/gr/fecs_trace.h>
+#include <nvgpu/hw/gm20b/hw_ctxsw_prog_gm20b.h>
+
+#include "common/gr/gr_priv.h"
+#include "common/gr/global_ctx_priv.h"
+#include "hal/gr/ctxsw_prog/ctxsw_prog_gm20b.h"
+
+#include "nvgpu-gr-fecs-trace.h"
+
+#define FECS_TRACE_MAX_CONTEXTS		1024U
+/* context_ptr of context i, an instance block address >> 12 */
+#define FECS_TRACE_CONTEXT_PTR(i)	(0x00100000U + (i))
+#define FECS_TRACE_PID(i)		(1000 + (pid_t)(i))
+
+#define FECS_TRACE_LOOKUPS		(1U << 20)
+#define FECS_TRACE_POLL_ROUNDS		50U
+
+static int fecs_read_index;
+static int fecs_write_index;
+static bool fecs_bound[FECS_TRACE_MAX_CONTEXTS];
+static u32 fecs_entries;
+static u32 fecs_bad_entries;
+
+static int stub_get_read_index(struct gk20a *g)
+{
+	return fecs_read_index;
+}
+
+static int stub_get_write_index(struct gk20a *g)
+{
+	return fecs_write_index;
+}
+
+static int stub_set_read_index(struct gk20a *g, int index)
+{
+	fecs_read_index = index;
+	return 0;
+}
+
+static int stub_fb_flush(struct gk20a *g)
+{
+	return 0;
+}
+
+/* the read index without the FEATURE_CONTROL enable bit */
+static int fecs_read_ptr(void)
+{
+	return (int)((u32)fecs_read_index &
+		~BIT32(NVGPU_FECS_TRACE_FEATURE_CONTROL_BIT));
+}
+
+/*
+ * context_id is the context index + 1, check that its pid and vmid were
+ * resolved, unbound contexts carry the vmid of a failed lookup
+ */
+static void stub_vm_dev_write(struct gk20a *g, u8 vmid, u32 *vm_update_mask,
+			      struct nvgpu_gpu_ctxsw_trace_entry *entry)
+{
+	u32 ctx = entry->context_id - 1U;
+	u64 pid = fecs_bound[ctx] ? (u64)FECS_TRACE_PID(ctx) : 0ULL;
+	u8 ctx_vmid = fecs_bound[ctx] ? 0U : (u8)0xffU;
+
+	fecs_entries++;
+	if ((entry->pid != pid) || (vmid != ctx_vmid)) {
+		fecs_bad_entries++;
+	}
+}
+
+static int fecs_trace_setup(struct unit_module *m, struct gk20a *g)
+{
+	struct nvgpu_gr_global_ctx_buffer_desc *desc;
+	int err;
+
+	g->ops.gr.ctxsw_prog.hw_get_ts_tag = gm20b_ctxsw_prog_hw_get_ts_tag;
+	g->ops.gr.ctxsw_prog.hw_record_ts_timestamp =
+		gm20b_ctxsw_prog_hw_record_ts_timestamp;
+	g->ops.gr.ctxsw_prog.hw_get_ts_record_size_in_bytes =
+		gm20b_ctxsw_prog_hw_get_ts_record_size_in_bytes;
+	g->ops.gr.ctxsw_prog.is_ts_valid_record =
+		gm20b_ctxsw_prog_is_ts_valid_record;
+	g->ops.gr.fecs_trace.get_read_index = stub_get_read_index;
+	g->ops.gr.fecs_trace.get_write_index = stub_get_write_index;
+	g->ops.gr.fecs_trace.set_read_index = stub_set_read_index;
+	g->ops.gr.fecs_trace.vm_dev_write = stub_vm_dev_write;
+	g->ops.gr.fecs_trace.vm_dev_update = NULL;
+	g->ops.mm.cache.fb_flush = stub_fb_flush;
+
+	g->num_gr_instances = 1U;
+	g->gr = nvgpu_kzalloc(g, sizeof(*g->gr));
+	if (g->gr == NULL) {
+		unit_return_fail(m, "failed to allocate gr\n");
+	}
+
+	desc = nvgpu_gr_global_ctx_desc_alloc(g);
+	if (desc == NULL) {
+		unit_return_fail(m, "failed to allocate global ctx desc\n");
+	}
+	g->gr->global_ctx_buffer = desc;
+
+	err = nvgpu_dma_alloc_sys(g, nvgpu_gr_fecs_trace_buffer_size(g),
+			&desc[NVGPU_GR_GLOBAL_CTX_FECS_TRACE_BUFFER].mem);
+	if (err != 0) {
+		unit_return_fail(m, "failed to allocate trace buffer\n");
+	}
+
+	err = nvgpu_gr_fecs_trace_init(g);
+	if (err != 0) {
+		unit_return_fail(m, "nvgpu_gr_fecs_trace_init failed\n");
+	}
+
+	/* polled by hand, the periodic timer is never started */
+	g->fecs_trace->enable_count = 1U;
+
+	return UNIT_SUCCESS;
+}
+
+static void fecs_trace_teardown(struct gk20a *g)
+{
+	struct nvgpu_gr_global_ctx_buffer_desc *desc;
+
+	if (g->fecs_trace != NULL) {
+		g->fecs_trace->enable_count = 0U;
+		nvgpu_gr_fecs_trace_deinit(g);
+	}
+
+	if (g->gr != NULL) {
+		desc = g->gr->global_ctx_buffer;
+		if (desc != NULL) {
+			nvgpu_dma_free(g,
+				&desc[NVGPU_GR_GLOBAL_CTX_FECS_TRACE_BUFFER].mem);
+			nvgpu_gr_global_ctx_desc_free(g, desc);
+		}
+		nvgpu_kfree(g, g->gr);
+		g->gr = NULL;
+	}
+
+	(void) memset(fecs_bound, 0, sizeof(fecs_bound));
+}
+
+static int fecs_trace_bind(struct gk20a *g, u32 num_contexts)
+{
+	u32 i;
+	int err;
+
+	for (i = 0U; i < num_contexts; i++) {
+		err = nvgpu_gr_fecs_trace_add_context(g,
+				FECS_TRACE_CONTEXT_PTR(i), FECS_TRACE_PID(i), 0U);
+		if (err != 0) {
+			return err;
+		}
+		fecs_bound[i] = true;
+	}
+
+	return 0;
+}
+
+static void fecs_trace_unbind(struct gk20a *g)
+{
+	nvgpu_gr_fecs_trace_remove_contexts(g);
+	(void) memset(fecs_bound, 0, sizeof(fecs_bound));
+}
+
+/*
+ * Write num_records records starting at index 0. Record k switches from
+ * context k to context k + 1 (mod num_contexts), as back to back context
+ * switches do, with a SAVE_END and a CONTEXT_START timestamp.
+ */
+static void fecs_trace_fill(struct gk20a *g, u32 num_records,
+			    u32 num_contexts)
+{
+	u32 size = g->ops.gr.ctxsw_prog.hw_get_ts_record_size_in_bytes();
+	struct nvgpu_fecs_trace_record *r;
+	u32 k, cur, next;
+
+	for (k = 0U; k < num_records; k++) {
+		r = nvgpu_gr_fecs_trace_get_record(g, (int)k);
+		(void) memset(r, 0, size);
+
+		cur = k % num_contexts;
+		next = (k + 1U) % num_contexts;
+
+		r->magic_hi =
+			ctxsw_prog_record_timestamp_magic_value_hi_v_value_v();
+		r->context_id = cur + 1U;
+		r->context_ptr = FECS_TRACE_CONTEXT_PTR(cur);
+		r->new_context_id = next + 1U;
+		r->new_context_ptr = FECS_TRACE_CONTEXT_PTR(next);
+		r->ts[0] = ((u64)NVGPU_GPU_CTXSW_TAG_SAVE_END << 56) | k;
+		r->ts[1] = ((u64)NVGPU_GPU_CTXSW_TAG_CONTEXT_START << 56) | k;
+	}
+
+	fecs_read_index = 0;
+	fecs_write_index = (int)num_records;
+	fecs_entries = 0U;
+	fecs_bad_entries = 0U;
+}
+
+int test_fecs_trace_context_hash(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	struct nvgpu_gr_fecs_trace *trace;
+	pid_t pid;
+	u32 vmid;
+	u32 i;
+	int ret = UNIT_FAIL;
+
+	if (fecs_trace_setup(m, g) != UNIT_SUCCESS) {
+		goto done;
+	}
+	trace = g->fecs_trace;
+
+	unit_assert(fecs_trace_bind(g, FECS_TRACE_MAX_CONTEXTS) == 0,
+		    goto done);
+
+	/* drop every other context */
+	for (i = 0U; i < FECS_TRACE_MAX_CONTEXTS; i += 2U) {
+		nvgpu_gr_fecs_trace_remove_context(g,
+				FECS_TRACE_CONTEXT_PTR(i));
+		fecs_bound[i] = false;
+	}
+	/* removing an unknown context is harmless */
+	nvgpu_gr_fecs_trace_remove_context(g,
+			FECS_TRACE_CONTEXT_PTR(FECS_TRACE_MAX_CONTEXTS));
+
+	nvgpu_mutex_acquire(&trace->poll_lock);
+	for (i = 0U; i <= FECS_TRACE_MAX_CONTEXTS; i++) {
+		nvgpu_gr_fecs_trace_find_pid(g, FECS_TRACE_CONTEXT_PTR(i),
+					     &pid, &vmid);
+		if ((i < FECS_TRACE_MAX_CONTEXTS) && fecs_bound[i]) {
+			unit_assert(pid == FECS_TRACE_PID(i), break);
+			unit_assert(vmid == 0U, break);
+		} else {
+			unit_assert(pid == 0, break);
+			unit_assert(vmid == 0xffffffffU, break);
+		}
+	}
+	nvgpu_mutex_release(&trace->poll_lock);
+	if (i <= FECS_TRACE_MAX_CONTEXTS) {
+		unit_err(m, "wrong pid for context %u\n", i);
+		goto done;
+	}
+
+	fecs_trace_unbind(g);
+	nvgpu_mutex_acquire(&trace->poll_lock);
+	nvgpu_gr_fecs_trace_find_pid(g, FECS_TRACE_CONTEXT_PTR(1U),
+				     &pid, &vmid);
+	nvgpu_mutex_release(&trace->poll_lock);
+	unit_assert(pid == 0, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	fecs_trace_teardown(g);
+	return ret;
+}
+
+int test_fecs_trace_poll(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_fecs_trace_record *r;
+	u32 num_records = (u32)GK20A_FECS_TRACE_NUM_RECORDS - 1U;
+	u32 num_contexts = 64U;
+	int ret = UNIT_FAIL;
+
+	if (fecs_trace_setup(m, g) != UNIT_SUCCESS) {
+		goto done;
+	}
+
+	unit_assert(fecs_trace_bind(g, num_contexts) == 0, goto done);
+	/* records of an unbound context resolve to pid 0 */
+	nvgpu_gr_fecs_trace_remove_context(g, FECS_TRACE_CONTEXT_PTR(5U));
+	fecs_bound[5] = false;
+
+	fecs_trace_fill(g, num_records, num_contexts);
+	unit_assert(nvgpu_gr_fecs_trace_poll(g) == 0, goto done);
+
+	unit_assert(fecs_read_ptr() == (int)num_records, goto done);
+	unit_assert(fecs_entries == 2U * num_records, goto done);
+	unit_assert(fecs_bad_entries == 0U, goto done);
+	r = nvgpu_gr_fecs_trace_get_record(g, 0);
+	unit_assert(r->magic_hi == 0U, goto done);
+
+	/* an invalid record stops the poll before it */
+	fecs_trace_fill(g, 16U, num_contexts);
+	nvgpu_gr_fecs_trace_get_record(g, 10)->magic_hi = 0U;
+	unit_assert(nvgpu_gr_fecs_trace_poll(g) == 0, goto done);
+	unit_assert(fecs_read_ptr() == 10, goto done);
+	unit_assert(fecs_entries == 20U, goto done);
+	unit_assert(fecs_bad_entries == 0U, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	fecs_trace_teardown(g);
+	return ret;
+}
+
+/* the context list and lookup nvgpu_gr_fecs_trace_find_pid() replaced */
+struct fecs_trace_list_entry {
+	u32 context_ptr;
+	pid_t pid;
+	u32 vmid;
+	struct nvgpu_list_node entry;
+};
+
+static inline struct fecs_trace_list_entry *
+fecs_trace_list_entry_from_entry(struct nvgpu_list_node *node)
+{
+	return (struct fecs_trace_list_entry *)
+		((uintptr_t)node -
+		offsetof(struct fecs_trace_list_entry, entry));
+}
+
+static void fecs_trace_list_find_pid(struct nvgpu_mutex *lock,
+				     struct nvgpu_list_node *list,
+				     u32 context_ptr, pid_t *pid, u32 *vmid)
+{
+	struct fecs_trace_list_entry *entry;
+
+	nvgpu_mutex_acquire(lock);
+	nvgpu_list_for_each_entry(entry, list, fecs_trace_list_entry, entry) {
+		if (entry->context_ptr == context_ptr) {
+			*pid = entry->pid;
+			*vmid = entry->vmid;
+			nvgpu_mutex_release(lock);
+			return;
+		}
+	}
+	nvgpu_mutex_release(lock);
+
+	*pid = 0;
+	*vmid = 0xffffffffU;
+}
+
+static int fecs_trace_time_lookups(struct unit_module *m, struct gk20a *g,
+				   u32 num_contexts)
+{
+	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
+	struct fecs_trace_list_entry *list_entries;
+	struct nvgpu_list_node list;
+	struct nvgpu_mutex list_lock;
+	s64 hash_ns, list_ns, start;
+	pid_t pid;
+	u32 vmid;
+	u32 i, hits = 0U;
+
+	list_entries = calloc(num_contexts, sizeof(*list_entries));
+	if (list_entries == NULL) {
+		return -ENOMEM;
+	}
+	nvgpu_init_list_node(&list);
+	nvgpu_mutex_init(&list_lock);
+	for (i = 0U; i < num_contexts; i++) {
+		list_entries[i].context_ptr = FECS_TRACE_CONTEXT_PTR(i);
+		list_entries[i].pid = FECS_TRACE_PID(i);
+		nvgpu_list_add_tail(&list_entries[i].entry, &list);
+	}
+
+	if (fecs_trace_bind(g, num_contexts) != 0) {
+		free(list_entries);
+		return -ENOMEM;
+	}
+
+	/* a different context each time, as in the worst case poll */
+	nvgpu_mutex_acquire(&trace->poll_lock);
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < FECS_TRACE_LOOKUPS; i++) {
+		nvgpu_gr_fecs_trace_find_pid(g, FECS_TRACE_CONTEXT_PTR(
+				(i * 7U) % num_contexts), &pid, &vmid);
+		hits += (pid != 0) ? 1U : 0U;
+	}
+	hash_ns = nvgpu_current_time_ns() - start;
+	nvgpu_mutex_release(&trace->poll_lock);
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < FECS_TRACE_LOOKUPS; i++) {
+		fecs_trace_list_find_pid(&list_lock, &list,
+				FECS_TRACE_CONTEXT_PTR((i * 7U) % num_contexts),
+				&pid, &vmid);
+		hits += (pid != 0) ? 1U : 0U;
+	}
+	list_ns = nvgpu_current_time_ns() - start;
+
+	fecs_trace_unbind(g);
+	nvgpu_mutex_destroy(&list_lock);
+	free(list_entries);
+
+	if (hits != 2U * FECS_TRACE_LOOKUPS) {
+		unit_err(m, "lookups missed bound contexts\n");
+		return -EINVAL;
+	}
+
+	unit_info(m, "%4u contexts: hash %lld ns, list %lld ns per %u lookups\n",
+		  num_contexts, hash_ns, list_ns, FECS_TRACE_LOOKUPS);
+	return 0;
+}
+
+int test_fecs_trace_timing(struct unit_module *m, struct gk20a *g,
+			   void *args)
+{
+	struct nvgpu_gr_fecs_trace *trace;
+	u32 num_records = (u32)GK20A_FECS_TRACE_NUM_RECORDS - 1U;
+	u32 num_contexts[] = { 16U, 256U, 1024U };
+	s64 poll_ns = 0, ring_read_ns = 0, start;
+	u32 vm_update_mask = 0U;
+	u32 i, k;
+	int ret = UNIT_FAIL;
+
+	if (fecs_trace_setup(m, g) != UNIT_SUCCESS) {
+		goto done;
+	}
+	trace = g->fecs_trace;
+
+	for (i = 0U; i < ARRAY_SIZE(num_contexts); i++) {
+		unit_assert(fecs_trace_time_lookups(m, g, num_contexts[i]) == 0,
+			    goto done);
+	}
+
+	/*
+	 * A full ring decoded by one poll, against resolving and waking up
+	 * readers record by record through nvgpu_gr_fecs_trace_ring_read().
+	 */
+	unit_assert(fecs_trace_bind(g, 256U) == 0, goto done);
+	for (i = 0U; i < FECS_TRACE_POLL_ROUNDS; i++) {
+		fecs_trace_fill(g, num_records, 256U);
+		start = nvgpu_current_time_ns();
+		unit_assert(nvgpu_gr_fecs_trace_poll(g) == 0, goto done);
+		poll_ns += nvgpu_current_time_ns() - start;
+		unit_assert(fecs_entries == 2U * num_records, goto done);
+
+		fecs_trace_fill(g, num_records, 256U);
+		nvgpu_mutex_acquire(&trace->poll_lock);
+		start = nvgpu_current_time_ns();
+		for (k = 0U; k < num_records; k++) {
+			if (nvgpu_gr_fecs_trace_ring_read(g, (int)k,
+					&vm_update_mask) <= 0) {
+				break;
+			}
+		}
+		ring_read_ns += nvgpu_current_time_ns() - start;
+		nvgpu_mutex_release(&trace->poll_lock);
+		unit_assert(fecs_entries == 2U * num_records, goto done);
+		unit_assert(fecs_bad_entries == 0U, goto done);
+	}
+
+	unit_info(m, "%u polls of %u records: batch %lld ns, "
+		  "per record %lld ns\n", FECS_TRACE_POLL_ROUNDS, num_records,
+		  poll_ns, ring_read_ns);
+
+	ret = UNIT_SUCCESS;
+done:
+	fecs_trace_teardown(g);
+	return ret;
+}
+
+struct unit_module_test nvgpu_gr_fecs_trace_tests[] = {
+	UNIT_TEST(fecs_trace_context_hash, test_fecs_trace_context_hash,
+		  NULL, 0),
+	UNIT_TEST(fecs_trace_poll, test_fecs_trace_poll, NULL, 0),
+	UNIT_TEST(fecs_trace_timing, test_fecs_trace_timing, NULL, 1),
+};
+
+UNIT_MODULE(nvgpu_gr_fecs_trace, nvgpu_gr_fecs_trace_tests,
+	    UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UNIT_NVGPU_GR_FECS_TRACE_H
+#define UNIT_NVGPU_GR_FECS_TRACE_H
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-gr-fecs-trace
+ *  @{
+ *
+ * Software Unit Test Specification for common.gr.fecs_trace
+ */
+
+/**
+ * Test specification for: test_fecs_trace_context_hash
+ *
+ * Description: Bound contexts resolve to their pid through the context hash.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gr_fecs_trace_init, nvgpu_gr_fecs_trace_add_context,
+ *          nvgpu_gr_fecs_trace_remove_context,
+ *          nvgpu_gr_fecs_trace_remove_contexts,
+ *          nvgpu_gr_fecs_trace_find_pid, nvgpu_gr_fecs_trace_deinit
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up a FECS trace buffer and call nvgpu_gr_fecs_trace_init().
+ * - Bind 1024 contexts, then remove every other one and a context that was
+ *   never bound.
+ * - With poll_lock held, look up every context and one more, and check
+ *   that bound ones return their pid and vmid and the others pid 0 and
+ *   vmid 0xffffffff.
+ * - Remove all contexts and check that a formerly bound one is not found.
+ *
+ * Output: Returns PASS if all lookups return the expected pid. FAIL
+ * otherwise.
+ */
+int test_fecs_trace_context_hash(struct unit_module *m, struct gk20a *g,
+				 void *args);
+
+/**
+ * Test specification for: test_fecs_trace_poll
+ *
+ * Description: A poll decodes all pending records with the right pids.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gr_fecs_trace_poll
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up a FECS trace buffer, stub the read and write index HALs and
+ *   record the decoded entries through gops_gr_fecs_trace.vm_dev_write.
+ * - Bind 64 contexts and unbind one of them.
+ * - Fill the ring with records switching from one context to the next,
+ *   each with a SAVE_END and a CONTEXT_START timestamp, and poll.
+ * - Check that the read index, less the FEATURE_CONTROL enable bit,
+ *   reached the write index, that every record gave two entries carrying
+ *   the pid and vmid of the context they belong to, or pid 0 and vmid 0xff
+ *   for the unbound one, and that the records were consumed.
+ * - Fill 16 records, invalidate the 11th and poll. Check that the poll
+ *   stopped at the invalid record.
+ *
+ * Output: Returns PASS if the above checks pass. FAIL otherwise.
+ */
+int test_fecs_trace_poll(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_fecs_trace_timing
+ *
+ * Description: Time context lookups and ring polls.
+ *
+ * Test Type: Performance
+ *
+ * Targets: nvgpu_gr_fecs_trace_find_pid, nvgpu_gr_fecs_trace_poll,
+ *          nvgpu_gr_fecs_trace_ring_read
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For 16, 256 and 1024 bound contexts, time 1M lookups through
+ *   nvgpu_gr_fecs_trace_find_pid() and through a mutex protected list
+ *   walk, the lookup it replaced. Check that every lookup hit.
+ * - With 256 bound contexts, repeatedly fill the ring and time decoding it
+ *   with one nvgpu_gr_fecs_trace_poll() and record by record with
+ *   nvgpu_gr_fecs_trace_ring_read(). Check that both decoded every record
+ *   with the right pids.
+ * - Report all times.
+ *
+ * Output: Returns PASS if all lookups and decodes succeeded. FAIL
+ * otherwise.
+ */
+int test_fecs_trace_timing(struct unit_module *m, struct gk20a *g,
+			   void *args);
+
+/** @} */
+#endif /* UNIT_NVGPU_GR_FECS_TRACE_H */
@@ -0,0 +1,481 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/posix/io.h>
+#include <nvgpu/gk20a.h>
+#include <nvgpu/hal_init.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/netlist.h>
+#include <nvgpu/netlist_defs.h>
+#include <nvgpu/boot_cache.h>
+#include <nvgpu/gr/global_ctx.h>
+#include <nvgpu/gr/hwpm_map.h>
+#include <nvgpu/hw/gm20b/hw_mc_gm20b.h>
+#include <nvgpu/hw/gm20b/hw_ctxsw_prog_gm20b.h>
+
+#include "common/gr/gr_priv.h"
+#include "common/gr/gr_config_priv.h"
+#include "common/gr/obj_ctx_priv.h"
+#include "common/gr/global_ctx_priv.h"
+#include "common/netlist/netlist_priv.h"
+#include "hal/gr/gr/gr_gk20a.h"
+
+#include "nvgpu-gr-hwpm-map.h"
+
+#define NV_PMC_BOOT_0_ARCHITECTURE_GV110	(0x00000015 << \
+					NVGPU_GPU_ARCHITECTURE_SHIFT)
+#define NV_PMC_BOOT_0_IMPLEMENTATION_B		0xB
+
+/*
+ * Synthetic gv11b netlist: SYS and TPC context switched registers, each at
+ * the next word of its segment, and the one PPC register the PES check
+ * needs.
+ */
+#define HWPM_MAP_SYS_REGS	1024U
+#define HWPM_MAP_TPC_REGS	256U
+#define HWPM_MAP_REGIONS	4U
+#define HWPM_MAP_SYS_ADDR(i)	(0x00404000U + ((i) * 4U))
+/* gpcs_tpcs broadcast and gpc0/tpc t unicast address of TPC register r */
+#define HWPM_MAP_TPCS_ADDR(r)	(0x00419800U + ((r) * 4U))
+#define HWPM_MAP_TPC_ADDR(t, r)	(0x00504000U + ((t) * 0x800U) + ((r) * 4U))
+
+/* one GPC with four TPCs of two SMs */
+#define HWPM_MAP_NUM_TPCS	4U
+#define HWPM_MAP_MAX_OFFSETS	(HWPM_MAP_NUM_TPCS * 2U)
+
+/* FECS and GPCCS priv register segments, in 256 byte units */
+#define HWPM_MAP_SYS_SEGMENT	1U
+#define HWPM_MAP_GPC_SEGMENT	2U
+#define HWPM_MAP_GOLDEN_SIZE	(64U * 1024U)
+
+#define HWPM_MAP_ROUNDS		64U
+
+struct hwpm_map_netlist {
+	struct netlist_image_header header;
+	struct netlist_region regions[HWPM_MAP_REGIONS];
+	struct netlist_aiv sys[HWPM_MAP_SYS_REGS];
+	struct netlist_aiv tpc[HWPM_MAP_TPC_REGS];
+	struct netlist_aiv ppc[1];
+	u32 major_v;
+};
+
+static struct hwpm_map_netlist hwpm_map_netlist;
+static struct nvgpu_gr_ctx_offset_map *hwpm_map_ctx_offset_map;
+
+static void writel_access_reg_fn(struct gk20a *g,
+				 struct nvgpu_reg_access *access)
+{
+	nvgpu_posix_io_writel_reg_space(g, access->addr, access->value);
+}
+
+static void readl_access_reg_fn(struct gk20a *g,
+				struct nvgpu_reg_access *access)
+{
+	access->value = nvgpu_posix_io_readl_reg_space(g, access->addr);
+}
+
+static struct nvgpu_posix_io_callbacks hwpm_map_reg_callbacks = {
+	.writel          = writel_access_reg_fn,
+	.writel_check    = writel_access_reg_fn,
+	.bar1_writel     = writel_access_reg_fn,
+	.usermode_writel = writel_access_reg_fn,
+	.__readl         = readl_access_reg_fn,
+	.readl           = readl_access_reg_fn,
+	.bar1_readl      = readl_access_reg_fn,
+};
+
+/* No firmware file, so the synthetic netlist in the boot cache is used. */
+static int hwpm_map_netlist_name(struct gk20a *g, int index, char *name)
+{
+	(void)strcpy(name, "hwpm_map_test_netlist.bin");
+
+	return 0;
+}
+
+static void hwpm_map_netlist_region(struct hwpm_map_netlist *img, u32 i,
+				    u32 region_id, void *data, u32 size)
+{
+	img->regions[i].region_id = region_id;
+	img->regions[i].data_size = size;
+	img->regions[i].data_offset = (u32)((u8 *)data - (u8 *)img);
+}
+
+static void hwpm_map_build_netlist(struct hwpm_map_netlist *img)
+{
+	u32 i;
+
+	(void) memset(img, 0, sizeof(*img));
+	img->header.regions = HWPM_MAP_REGIONS;
+	for (i = 0U; i < HWPM_MAP_SYS_REGS; i++) {
+		img->sys[i].addr = HWPM_MAP_SYS_ADDR(i);
+		img->sys[i].index = i * 4U;
+	}
+	for (i = 0U; i < HWPM_MAP_TPC_REGS; i++) {
+		img->tpc[i].addr = HWPM_MAP_TPC_ADDR(0U, i);
+		img->tpc[i].index = i * 4U;
+	}
+	img->major_v = 0x1U;
+
+	hwpm_map_netlist_region(img, 0U, NETLIST_REGIONID_CTXREG_SYS,
+		img->sys, sizeof(img->sys));
+	hwpm_map_netlist_region(img, 1U, NETLIST_REGIONID_CTXREG_TPC,
+		img->tpc, sizeof(img->tpc));
+	hwpm_map_netlist_region(img, 2U, NETLIST_REGIONID_CTXREG_PPC,
+		img->ppc, sizeof(img->ppc));
+	hwpm_map_netlist_region(img, 3U, NETLIST_REGIONID_MAJORV,
+		&img->major_v, sizeof(img->major_v));
+}
+
+/* main, FECS and GPCCS headers of a one GPC golden context image */
+static void hwpm_map_build_golden(u32 *context)
+{
+	u32 *fecs = context + (ctxsw_prog_fecs_header_v() >> 2);
+	u32 *gpccs = fecs + (ctxsw_prog_gpccs_header_stride_v() >> 2);
+
+	context[ctxsw_prog_main_image_magic_value_o() >> 2] =
+		ctxsw_prog_main_image_magic_value_v_value_v();
+	context[ctxsw_prog_main_image_num_gpcs_o() >> 2] = 1U;
+
+	fecs[ctxsw_prog_local_magic_value_o() >> 2] =
+		ctxsw_prog_local_magic_value_v_value_v();
+	fecs[ctxsw_prog_local_priv_register_ctl_o() >> 2] =
+		HWPM_MAP_SYS_SEGMENT;
+
+	gpccs[ctxsw_prog_local_magic_value_o() >> 2] =
+		ctxsw_prog_local_magic_value_v_value_v();
+	gpccs[ctxsw_prog_local_priv_register_ctl_o() >> 2] =
+		HWPM_MAP_GPC_SEGMENT;
+	gpccs[ctxsw_prog_local_image_num_tpcs_o() >> 2] = HWPM_MAP_NUM_TPCS;
+}
+
+static int hwpm_map_setup_gr(struct unit_module *m, struct gk20a *g)
+{
+	struct nvgpu_gr *gr;
+	struct nvgpu_gr_config *config;
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image;
+	struct nvgpu_gr_global_ctx_local_golden_image *local_golden_image;
+
+	g->num_gr_instances = 1U;
+	gr = nvgpu_kzalloc(g, sizeof(*gr));
+	if (gr == NULL) {
+		unit_return_fail(m, "failed to allocate gr\n");
+	}
+	g->gr = gr;
+
+	config = nvgpu_kzalloc(g, sizeof(*config));
+	if (config == NULL) {
+		unit_return_fail(m, "failed to allocate gr config\n");
+	}
+	gr->config = config;
+	config->max_gpc_count = 1U;
+	config->gpc_count = 1U;
+	config->max_tpc_per_gpc_count = HWPM_MAP_NUM_TPCS;
+	config->sm_count_per_tpc = 2U;
+	config->gpc_tpc_count = nvgpu_kzalloc(g, sizeof(u32));
+	if (config->gpc_tpc_count == NULL) {
+		unit_return_fail(m, "failed to allocate gpc_tpc_count\n");
+	}
+	config->gpc_tpc_count[0] = HWPM_MAP_NUM_TPCS;
+
+	golden_image = nvgpu_kzalloc(g, sizeof(*golden_image));
+	if (golden_image == NULL) {
+		unit_return_fail(m, "failed to allocate golden image\n");
+	}
+	gr->golden_image = golden_image;
+	nvgpu_mutex_init(&golden_image->ctx_mutex);
+	golden_image->size = HWPM_MAP_GOLDEN_SIZE;
+
+	local_golden_image = nvgpu_kzalloc(g, sizeof(*local_golden_image));
+	if (local_golden_image == NULL) {
+		unit_return_fail(m, "failed to allocate local golden image\n");
+	}
+	golden_image->local_golden_image = local_golden_image;
+	local_golden_image->size = HWPM_MAP_GOLDEN_SIZE;
+	local_golden_image->context = nvgpu_kzalloc(g, HWPM_MAP_GOLDEN_SIZE);
+	if (local_golden_image->context == NULL) {
+		unit_return_fail(m, "failed to allocate golden context\n");
+	}
+	hwpm_map_build_golden(local_golden_image->context);
+	golden_image->ready = true;
+
+	if (nvgpu_gr_ctx_offset_map_init(g, &gr->ctx_offset_map) != 0) {
+		unit_return_fail(m, "nvgpu_gr_ctx_offset_map_init failed\n");
+	}
+	hwpm_map_ctx_offset_map = gr->ctx_offset_map;
+
+	return UNIT_SUCCESS;
+}
+
+static int hwpm_map_setup(struct unit_module *m, struct gk20a *g)
+{
+	int err;
+
+	if (nvgpu_posix_io_add_reg_space(g, mc_boot_0_r(), 0xfff) != 0) {
+		unit_return_fail(m, "failed to create register space\n");
+	}
+	(void)nvgpu_posix_register_io(g, &hwpm_map_reg_callbacks);
+
+	g->params.gpu_arch = NV_PMC_BOOT_0_ARCHITECTURE_GV110;
+	g->params.gpu_impl = NV_PMC_BOOT_0_IMPLEMENTATION_B;
+	err = nvgpu_init_hal(g);
+	if (err != 0) {
+		unit_return_fail(m, "nvgpu_init_hal failed\n");
+	}
+
+	err = nvgpu_boot_cache_init(g);
+	if (err != 0) {
+		unit_return_fail(m, "nvgpu_boot_cache_init failed\n");
+	}
+	hwpm_map_build_netlist(&hwpm_map_netlist);
+	nvgpu_boot_cache_set_netlist(g, NETLIST_FINAL,
+		(u8 *)&hwpm_map_netlist, sizeof(hwpm_map_netlist));
+	g->ops.netlist.get_netlist_name = hwpm_map_netlist_name;
+
+	nvgpu_netlist_deinit_ctx_vars(g);
+	err = nvgpu_netlist_init_ctx_vars(g);
+	if (err != 0) {
+		unit_return_fail(m, "netlist init failed\n");
+	}
+	if (nvgpu_netlist_get_sys_ctxsw_regs(g)->count != HWPM_MAP_SYS_REGS) {
+		unit_return_fail(m, "synthetic netlist not loaded\n");
+	}
+
+	return hwpm_map_setup_gr(m, g);
+}
+
+static void hwpm_map_teardown(struct gk20a *g)
+{
+	struct nvgpu_gr *gr = g->gr;
+
+	if (gr != NULL) {
+		nvgpu_gr_ctx_offset_map_deinit(g, hwpm_map_ctx_offset_map);
+		hwpm_map_ctx_offset_map = NULL;
+		if (gr->golden_image != NULL) {
+			if (gr->golden_image->local_golden_image != NULL) {
+				nvgpu_kfree(g,
+				    gr->golden_image->local_golden_image->context);
+				nvgpu_kfree(g,
+				    gr->golden_image->local_golden_image);
+			}
+			nvgpu_mutex_destroy(&gr->golden_image->ctx_mutex);
+			nvgpu_kfree(g, gr->golden_image);
+		}
+		if (gr->config != NULL) {
+			nvgpu_kfree(g, gr->config->gpc_tpc_count);
+			nvgpu_kfree(g, gr->config);
+		}
+		nvgpu_kfree(g, gr);
+		g->gr = NULL;
+	}
+
+	nvgpu_netlist_deinit_ctx_vars(g);
+	nvgpu_boot_cache_deinit(g);
+	nvgpu_posix_io_delete_reg_space(g, mc_boot_0_r());
+}
+
+/*
+ * Look addr up with and without the cache and check both give the same
+ * num expected offsets, offsets[i] for unicast register addrs[i].
+ */
+static int hwpm_map_check(struct unit_module *m, struct gk20a *g, u32 addr,
+			  u32 max_offsets, int err, u32 num,
+			  const u32 *offsets, const u32 *addrs)
+{
+	struct nvgpu_gr *gr = g->gr;
+	u32 out_offsets[HWPM_MAP_MAX_OFFSETS];
+	u32 out_addrs[HWPM_MAP_MAX_OFFSETS];
+	u32 pass, i, num_offsets;
+	int ret;
+
+	/* uncached, then filling the cache, then from the cache */
+	for (pass = 0U; pass < 3U; pass++) {
+		gr->ctx_offset_map = (pass == 0U) ? NULL :
+			hwpm_map_ctx_offset_map;
+		num_offsets = 0U;
+		ret = gr_gk20a_get_ctx_buffer_offsets(g, addr, max_offsets,
+				out_offsets, out_addrs, &num_offsets);
+		if (ret != err) {
+			unit_err(m, "addr 0x%x pass %u: err %d, expected %d\n",
+				 addr, pass, ret, err);
+			return -EINVAL;
+		}
+		if (err != 0) {
+			continue;
+		}
+		if (num_offsets != num) {
+			unit_err(m, "addr 0x%x pass %u: %u offsets, expected %u\n",
+				 addr, pass, num_offsets, num);
+			return -EINVAL;
+		}
+		for (i = 0U; i < num; i++) {
+			if ((out_offsets[i] != offsets[i]) ||
+			    (out_addrs[i] != addrs[i])) {
+				unit_err(m, "addr 0x%x pass %u: offset %u is "
+					 "0x%x of 0x%x, expected 0x%x of 0x%x\n",
+					 addr, pass, i, out_offsets[i],
+					 out_addrs[i], offsets[i], addrs[i]);
+				return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* TPC data is interleaved in the GPCCS segment, word by word */
+static u32 hwpm_map_tpc_offset(u32 tpc, u32 reg)
+{
+	return (HWPM_MAP_GPC_SEGMENT * 256U) +
+		(reg * 4U * HWPM_MAP_NUM_TPCS) + (tpc * 4U);
+}
+
+int test_gr_ctx_offset_map(struct unit_module *m, struct gk20a *g, void *args)
+{
+	u32 offsets[HWPM_MAP_NUM_TPCS];
+	u32 addrs[HWPM_MAP_NUM_TPCS];
+	u32 i, t, r;
+	int ret = UNIT_FAIL;
+
+	if (hwpm_map_setup(m, g) != UNIT_SUCCESS) {
+		goto done;
+	}
+
+	for (i = 0U; i < HWPM_MAP_SYS_REGS; i += 7U) {
+		offsets[0] = (HWPM_MAP_SYS_SEGMENT * 256U) + (i * 4U);
+		addrs[0] = HWPM_MAP_SYS_ADDR(i);
+		unit_assert(hwpm_map_check(m, g, addrs[0], 1U, 0, 1U,
+				offsets, addrs) == 0, goto done);
+	}
+
+	for (r = 0U; r < HWPM_MAP_TPC_REGS; r += 5U) {
+		for (t = 0U; t < HWPM_MAP_NUM_TPCS; t++) {
+			offsets[t] = hwpm_map_tpc_offset(t, r);
+			addrs[t] = HWPM_MAP_TPC_ADDR(t, r);
+			unit_assert(hwpm_map_check(m, g, addrs[t], 1U, 0, 1U,
+				&offsets[t], &addrs[t]) == 0, goto done);
+		}
+		/* broadcast to all TPCs, or just the first */
+		unit_assert(hwpm_map_check(m, g, HWPM_MAP_TPCS_ADDR(r),
+				HWPM_MAP_MAX_OFFSETS, 0, HWPM_MAP_NUM_TPCS,
+				offsets, addrs) == 0, goto done);
+		unit_assert(hwpm_map_check(m, g, HWPM_MAP_TPCS_ADDR(r), 1U, 0,
+				1U, offsets, addrs) == 0, goto done);
+	}
+
+	/* too few offsets for the broadcast, from the cache too */
+	unit_assert(hwpm_map_check(m, g, HWPM_MAP_TPCS_ADDR(0U), 2U, -EINVAL,
+			0U, NULL, NULL) == 0, goto done);
+
+	/* registers not in the context image fail, cached or not */
+	unit_assert(hwpm_map_check(m, g, HWPM_MAP_SYS_ADDR(HWPM_MAP_SYS_REGS),
+			1U, -EINVAL, 0U, NULL, NULL) == 0, goto done);
+	unit_assert(hwpm_map_check(m, g, HWPM_MAP_TPCS_ADDR(HWPM_MAP_TPC_REGS),
+			HWPM_MAP_MAX_OFFSETS, -EINVAL, 0U, NULL, NULL) == 0,
+			goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	hwpm_map_teardown(g);
+	return ret;
+}
+
+/* Look every register up HWPM_MAP_ROUNDS times, return the time taken. */
+static s64 hwpm_map_time_lookups(struct gk20a *g, bool broadcast,
+				 u32 *failed)
+{
+	u32 offsets[HWPM_MAP_MAX_OFFSETS];
+	u32 addrs[HWPM_MAP_MAX_OFFSETS];
+	u32 count = broadcast ? HWPM_MAP_TPC_REGS : HWPM_MAP_SYS_REGS;
+	u32 round, i, num_offsets;
+	s64 start;
+
+	start = nvgpu_current_time_ns();
+	for (round = 0U; round < HWPM_MAP_ROUNDS; round++) {
+		for (i = 0U; i < count; i++) {
+			if (gr_gk20a_get_ctx_buffer_offsets(g,
+					broadcast ? HWPM_MAP_TPCS_ADDR(i) :
+						HWPM_MAP_SYS_ADDR(i),
+					HWPM_MAP_MAX_OFFSETS, offsets, addrs,
+					&num_offsets) != 0) {
+				*failed += 1U;
+			}
+		}
+	}
+
+	return nvgpu_current_time_ns() - start;
+}
+
+int test_gr_ctx_offset_map_timing(struct unit_module *m, struct gk20a *g,
+				  void *args)
+{
+	struct nvgpu_gr *gr;
+	s64 sys_ns, sys_cached_ns, tpcs_ns, tpcs_cached_ns;
+	u32 failed = 0U;
+	int ret = UNIT_FAIL;
+
+	if (hwpm_map_setup(m, g) != UNIT_SUCCESS) {
+		goto done;
+	}
+	gr = g->gr;
+
+	gr->ctx_offset_map = NULL;
+	sys_ns = hwpm_map_time_lookups(g, false, &failed);
+	tpcs_ns = hwpm_map_time_lookups(g, true, &failed);
+
+	/* the first round fills the cache */
+	gr->ctx_offset_map = hwpm_map_ctx_offset_map;
+	sys_cached_ns = hwpm_map_time_lookups(g, false, &failed);
+	tpcs_cached_ns = hwpm_map_time_lookups(g, true, &failed);
+
+	unit_assert(failed == 0U, goto done);
+	unit_assert(hwpm_map_ctx_offset_map->count ==
+		HWPM_MAP_SYS_REGS + HWPM_MAP_TPC_REGS, goto done);
+
+	unit_info(m, "%u x %u SYS registers: uncached %lld ns, "
+		  "cached %lld ns\n", HWPM_MAP_ROUNDS, HWPM_MAP_SYS_REGS,
+		  sys_ns, sys_cached_ns);
+	unit_info(m, "%u x %u TPC broadcast registers: uncached %lld ns, "
+		  "cached %lld ns\n", HWPM_MAP_ROUNDS, HWPM_MAP_TPC_REGS,
+		  tpcs_ns, tpcs_cached_ns);
+
+	ret = UNIT_SUCCESS;
+done:
+	hwpm_map_teardown(g);
+	return ret;
+}
+
+struct unit_module_test nvgpu_gr_hwpm_map_tests[] = {
+	UNIT_TEST(ctx_offset_map, test_gr_ctx_offset_map, NULL, 0),
+	UNIT_TEST(ctx_offset_map_timing, test_gr_ctx_offset_map_timing,
+		  NULL, 1),
+};
+
+UNIT_MODULE(nvgpu_gr_hwpm_map, nvgpu_gr_hwpm_map_tests,
+	    UNIT_PRIO_NVGPU_TEST);
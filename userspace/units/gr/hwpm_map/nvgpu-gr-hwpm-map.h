@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UNIT_NVGPU_GR_HWPM_MAP_H
+#define UNIT_NVGPU_GR_HWPM_MAP_H
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-gr-hwpm-map
+ *  @{
+ *
+ * Software Unit Test Specification for common.gr.hwpm_map
+ */
+
+/**
+ * Test specification for: test_gr_ctx_offset_map
+ *
+ * Description: Cached context buffer offsets match the uncached lookup.
+ *
+ * Test Type: Feature
+ *
+ * Targets: gr_gk20a_get_ctx_buffer_offsets, nvgpu_gr_ctx_offset_map_init,
+ *          nvgpu_gr_ctx_offset_map_find, nvgpu_gr_ctx_offset_map_add,
+ *          nvgpu_gr_ctx_offset_map_deinit
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up the gv11b HAL and load a synthetic netlist with 1024 SYS and
+ *   256 TPC context switched registers through the boot cache.
+ * - Set up a one GPC, four TPC gr config and a golden context image with
+ *   only the main, FECS and GPCCS headers.
+ * - Look up SYS registers, unicast TPC registers and TPC broadcast
+ *   registers with max_offsets of 1 and 8. Each address is looked up
+ *   without the cache, then with the cache twice, and all three must give
+ *   the offsets and unicast addresses the netlist places them at.
+ * - Check that a broadcast with max_offsets of 2, and SYS and TPC
+ *   registers that are not in the netlist fail with -EINVAL, also when
+ *   served from the cache.
+ *
+ * Output: Returns PASS if all lookups return the expected offsets. FAIL
+ * otherwise.
+ */
+int test_gr_ctx_offset_map(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_gr_ctx_offset_map_timing
+ *
+ * Description: Time cached and uncached context buffer offset lookups.
+ *
+ * Test Type: Performance
+ *
+ * Targets: gr_gk20a_get_ctx_buffer_offsets
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up the synthetic netlist, gr config and golden image as in
+ *   test_gr_ctx_offset_map.
+ * - Without the cache, time 64 lookups of every SYS register and of every
+ *   TPC broadcast register, which expands to four TPCs.
+ * - Time the same lookups with the cache, the first round filling it.
+ * - Check that all lookups succeeded and that every address was cached
+ *   once, and report the times.
+ *
+ * Output: Returns PASS if all lookups succeeded. FAIL otherwise.
+ */
+int test_gr_ctx_offset_map_timing(struct unit_module *m, struct gk20a *g,
+				  void *args);
+
+/** @} */
+#endif /* UNIT_NVGPU_GR_HWPM_MAP_H */
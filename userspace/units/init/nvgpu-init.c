@@ -32,6 +32,7 @@
 #include <nvgpu/posix/posix-fault-injection.h>
 #include <os/posix/os_posix.h>
 #include <nvgpu/dma.h>
+#include <nvgpu/timers.h>
 
 /* for get_litter testing */
 #include "hal/init/hal_gv11b_litter.h"
@@ -808,6 +809,153 @@ int test_quiesce(struct unit_module *m, struct gk20a *g, void *args)
 	return ret;
 }
 
+/*
+ * Stand-ins for the poweron stages with a fixed run time, so the per stage
+ * breakdown is measurable.
+ */
+#define TABLE_STAGE_MS		2U
+#define TABLE_FALCONS		2U
+#define TABLE_PMU		3U
+#define TABLE_MM		4U
+#define TABLE_THERM		6U
+#define TABLE_CBC		7U
+
+static nvgpu_init_func_t table_fail_func;
+
+static int table_stage(struct gk20a *g, nvgpu_init_func_t self)
+{
+	nvgpu_msleep(TABLE_STAGE_MS);
+
+	return (self == table_fail_func) ? -EIO : 0;
+}
+
+static int stub_bus_init_hw(struct gk20a *g)
+{
+	return table_stage(g, stub_bus_init_hw);
+}
+
+static int stub_pd_cache_init(struct gk20a *g)
+{
+	return table_stage(g, stub_pd_cache_init);
+}
+
+static int stub_falcons_sw_init(struct gk20a *g)
+{
+	return table_stage(g, stub_falcons_sw_init);
+}
+
+static int stub_netlist_init_ctx_vars(struct gk20a *g)
+{
+	return table_stage(g, stub_netlist_init_ctx_vars);
+}
+
+static int stub_pmu_early_init(struct gk20a *g)
+{
+	return table_stage(g, stub_pmu_early_init);
+}
+
+static int stub_init_mm_support(struct gk20a *g)
+{
+	return table_stage(g, stub_init_mm_support);
+}
+
+static int stub_init_therm_support(struct gk20a *g)
+{
+	return table_stage(g, stub_init_therm_support);
+}
+
+static int stub_cbc_init_support(struct gk20a *g)
+{
+	return table_stage(g, stub_cbc_init_support);
+}
+
+/* Same order as in nvgpu_finalize_poweron(). */
+static const struct nvgpu_init_table_t stage_table[] = {
+	NVGPU_INIT_TABLE_ENTRY(&stub_bus_init_hw, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_pd_cache_init, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_falcons_sw_init, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_pmu_early_init, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_init_mm_support, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_netlist_init_ctx_vars, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_init_therm_support, 0U),
+	NVGPU_INIT_TABLE_ENTRY(&stub_cbc_init_support,
+			       NVGPU_SUPPORT_COMPRESSION),
+};
+
+static s64 stage_end(const struct nvgpu_init_timing *t, u32 i)
+{
+	return t->stages[i].start_ns + t->stages[i].duration_ns;
+}
+
+static void timing_print(struct unit_module *m, const char *name,
+			 const struct nvgpu_init_timing *t)
+{
+	u32 i;
+
+	unit_info(m, "%s: %lld us\n", name, t->total_ns / 1000);
+	for (i = 0U; i < t->count; i++) {
+		if (t->stages[i].ran) {
+			unit_info(m, "  %-32s at %6lld us took %6lld us\n",
+				t->stages[i].name,
+				t->stages[i].start_ns / 1000,
+				t->stages[i].duration_ns / 1000);
+		}
+	}
+}
+
+int test_init_table_timing(struct unit_module *m, struct gk20a *g,
+			   void *args)
+{
+	struct nvgpu_init_timing *timing = NULL;
+	u32 count = (u32)ARRAY_SIZE(stage_table);
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	timing = malloc(sizeof(*timing));
+	if (timing == NULL) {
+		goto fail;
+	}
+
+	nvgpu_set_enabled(g, NVGPU_SUPPORT_COMPRESSION, true);
+	table_fail_func = NULL;
+
+	/* Entries run in table order. */
+	assert(nvgpu_init_run_table(g, stage_table, count, timing) == 0);
+	assert(timing->count == count);
+	assert(timing->stages[0].ran);
+	for (i = 1U; i < count; i++) {
+		assert(timing->stages[i].ran);
+		assert(timing->stages[i].start_ns >= stage_end(timing, i - 1U));
+	}
+	assert(timing->total_ns >= stage_end(timing, count - 1U));
+	timing_print(m, "poweron stages", timing);
+	nvgpu_init_timing_report(g, timing, "stage_table");
+	nvgpu_init_timing_report(g, NULL, "stage_table");
+
+	/* A failing stage stops the table. */
+	table_fail_func = stub_falcons_sw_init;
+	assert(nvgpu_init_run_table(g, stage_table, count, timing) == -EIO);
+	assert(timing->stages[TABLE_FALCONS].ran);
+	assert(!timing->stages[TABLE_PMU].ran);
+	assert(!timing->stages[TABLE_MM].ran);
+	table_fail_func = stub_cbc_init_support;
+	assert(nvgpu_init_run_table(g, stage_table, count, NULL) == -EIO);
+	table_fail_func = NULL;
+
+	/* Disabled entries are skipped. */
+	nvgpu_set_enabled(g, NVGPU_SUPPORT_COMPRESSION, false);
+	assert(nvgpu_init_run_table(g, stage_table, count, timing) == 0);
+	assert(timing->stages[TABLE_THERM].ran);
+	assert(!timing->stages[TABLE_CBC].ran);
+
+	ret = UNIT_SUCCESS;
+
+fail:
+	table_fail_func = NULL;
+	free(timing);
+	return ret;
+}
+
 struct unit_module_test init_tests[] = {
 	UNIT_TEST(init_setup_env,			init_test_setup_env,	NULL, 0),
 	UNIT_TEST(get_litter_value,			test_get_litter_value,	NULL, 0),
@@ -819,6 +967,7 @@ struct unit_module_test init_tests[] = {
 	UNIT_TEST(init_poweroff,			test_poweroff,		NULL, 2),
 	UNIT_TEST(init_check_gpu_state,			test_check_gpu_state,	NULL, 2),
 	UNIT_TEST(init_quiesce,				test_quiesce,		NULL, 2),
+	UNIT_TEST(init_table_timing,			test_init_table_timing,	NULL, 0),
 	UNIT_TEST(init_free_env,			init_test_free_env,	NULL, 0),
 };
 
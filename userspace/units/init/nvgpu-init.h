@@ -339,4 +339,35 @@ int test_poweroff(struct unit_module *m, struct gk20a *g, void *args);
  */
 int test_quiesce(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_init_table_timing
+ *
+ * Description: Run an init table and check the order of the entries and
+ * their wall clock breakdown.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_init_run_table, nvgpu_init_timing_report
+ *
+ * Input:
+ * - init_test_setup_env() must be called before.
+ *
+ * Steps:
+ * - Build a table of bus, PD cache, falcons, PMU, mm, netlist, therm and
+ *   cbc entries in the order of nvgpu_finalize_poweron() whose entries
+ *   each sleep for 2ms.
+ * - Run the table, check all entries ran in table order and the total time
+ *   covers them, and print and log the breakdown. Check logging without a
+ *   breakdown does nothing.
+ * - Let the falcons entry fail and check the error is returned and no later
+ *   entry ran. Let the last entry fail and check the error is returned.
+ * - Disable compression and check the cbc entry is skipped.
+ *
+ * Output:
+ * - UNIT_FAIL if any of the checks fail.
+ * - UNIT_SUCCESS otherwise
+ */
+int test_init_table_timing(struct unit_module *m, struct gk20a *g,
+			   void *args);
+
 #endif /* UNIT_NVGPU_INIT_H */
@@ -33,6 +33,12 @@
 #define USER_MODE_BASE (0x00810000U)
 #define NVGPU_READ_VAL (0xD007U)
 
+/* Unused by the default register spaces. */
+#define TEST_SPACE_BASE		(0x07000000U)
+#define TEST_SPACE_SIZE		(0x00010000U)
+#define TEST_INNER_BASE		(0x07004000U)
+#define TEST_INNER_SIZE		(0x00001000U)
+
 static void readl_access_reg_fn(struct gk20a *g,
 	struct nvgpu_reg_access *access)
 {
@@ -65,8 +71,113 @@ int test_writel_check(struct unit_module *m, struct gk20a *g, void *args)
 	return UNIT_SUCCESS;
 }
 
+int test_reg_space_lookup(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_posix_io_reg_space *outer, *inner = NULL;
+	int ret = UNIT_FAIL;
+
+	unit_assert(nvgpu_posix_io_add_reg_space(g, TEST_SPACE_BASE,
+		TEST_SPACE_SIZE) == 0, return UNIT_FAIL);
+	outer = nvgpu_posix_io_get_reg_space(g, TEST_SPACE_BASE);
+	unit_assert(outer != NULL, goto done);
+	unit_assert(outer->base == TEST_SPACE_BASE, goto done);
+
+	/* A newer, smaller space shadows the part of the older one it covers */
+	unit_assert(nvgpu_posix_io_add_reg_space(g, TEST_INNER_BASE,
+		TEST_INNER_SIZE) == 0, goto done);
+	inner = nvgpu_posix_io_get_reg_space(g, TEST_INNER_BASE);
+	unit_assert(inner != NULL, goto done);
+	unit_assert(inner->base == TEST_INNER_BASE, goto done);
+	unit_assert(nvgpu_posix_io_get_reg_space(g,
+		TEST_INNER_BASE + TEST_INNER_SIZE - 4U) == inner, goto done);
+	unit_assert(nvgpu_posix_io_get_reg_space(g,
+		TEST_INNER_BASE - 4U) == outer, goto done);
+	unit_assert(nvgpu_posix_io_get_reg_space(g,
+		TEST_INNER_BASE + TEST_INNER_SIZE) == outer, goto done);
+	unit_assert(nvgpu_posix_io_get_reg_space(g,
+		TEST_SPACE_BASE + TEST_SPACE_SIZE - 4U) == outer, goto done);
+
+	/* Accesses land in the right backing store */
+	nvgpu_posix_io_writel_reg_space(g, TEST_INNER_BASE + 8U, 0x1234U);
+	unit_assert(inner->data[2] == 0x1234U, goto done);
+	nvgpu_posix_io_writel_reg_space(g, TEST_SPACE_BASE + 8U, 0x5678U);
+	unit_assert(outer->data[2] == 0x5678U, goto done);
+	unit_assert(nvgpu_posix_io_readl_reg_space(g,
+		TEST_INNER_BASE + 8U) == 0x1234U, goto done);
+
+	/* Nothing is mapped right above the outer space */
+	nvgpu_posix_io_reset_error_code(g);
+	unit_assert(nvgpu_posix_io_get_reg_space(g,
+		TEST_SPACE_BASE + TEST_SPACE_SIZE) == NULL, goto done);
+	unit_assert(nvgpu_posix_io_get_error_code(g) == -EFAULT, goto done);
+	nvgpu_posix_io_reset_error_code(g);
+
+	/* Removing the inner space uncovers the outer one again */
+	nvgpu_posix_io_delete_reg_space(g, TEST_INNER_BASE);
+	inner = NULL;
+	unit_assert(nvgpu_posix_io_get_reg_space(g,
+		TEST_INNER_BASE) == outer, goto done);
+
+	/* Default spaces registered at probe are still reachable */
+	unit_assert(nvgpu_posix_io_get_reg_space(g, 0U) != NULL, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	/* Deleting by address removes whichever space covers it */
+	if (inner != NULL) {
+		nvgpu_posix_io_delete_reg_space(g, TEST_INNER_BASE);
+	}
+	nvgpu_posix_io_delete_reg_space(g, TEST_SPACE_BASE);
+	nvgpu_posix_io_reset_error_code(g);
+	return ret;
+}
+
+int test_reg_profile(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_posix_io_reg_profile hot[2];
+	u32 i, n;
+
+	nvgpu_posix_register_io(g, &ut_common_io_reg_callbacks);
+
+	nvgpu_posix_io_start_profile(g);
+	for (i = 0U; i < 10U; i++) {
+		(void)nvgpu_readl(g, USER_MODE_BASE);
+	}
+	for (i = 0U; i < 4U; i++) {
+		nvgpu_writel(g, USER_MODE_BASE + 4U, i);
+	}
+	/* Enough distinct registers to grow the profile table */
+	for (i = 0U; i < 4096U; i++) {
+		nvgpu_writel(g, TEST_SPACE_BASE + (i * 4U), i);
+	}
+	(void)nvgpu_readl(g, USER_MODE_BASE + 4U);
+	nvgpu_posix_io_stop_profile(g);
+
+	/* Not counted any more */
+	(void)nvgpu_readl(g, USER_MODE_BASE + 4U);
+
+	n = nvgpu_posix_io_get_profile(g, hot, 2U);
+	unit_assert(n == 2U, return UNIT_FAIL);
+	unit_assert(hot[0].addr == USER_MODE_BASE, return UNIT_FAIL);
+	unit_assert(hot[0].reads == 10ULL, return UNIT_FAIL);
+	unit_assert(hot[0].writes == 0ULL, return UNIT_FAIL);
+	unit_assert(hot[1].addr == USER_MODE_BASE + 4U, return UNIT_FAIL);
+	unit_assert(hot[1].reads == 1ULL, return UNIT_FAIL);
+	unit_assert(hot[1].writes == 4ULL, return UNIT_FAIL);
+
+	/* Restarting clears the previous counts */
+	nvgpu_posix_io_start_profile(g);
+	nvgpu_posix_io_stop_profile(g);
+	unit_assert(nvgpu_posix_io_get_profile(g, hot, 2U) == 0U,
+		return UNIT_FAIL);
+
+	return UNIT_SUCCESS;
+}
+
 struct unit_module_test io_tests[] = {
 	UNIT_TEST(writel_check, test_writel_check, NULL, 0),
+	UNIT_TEST(reg_space_lookup, test_reg_space_lookup, NULL, 0),
+	UNIT_TEST(reg_profile, test_reg_profile, NULL, 0),
 };
 
 UNIT_MODULE(io, io_tests, UNIT_PRIO_NVGPU_TEST);
@@ -55,4 +55,61 @@
  */
 int test_writel_check(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for test_reg_space_lookup
+ *
+ * Description: Look up emulated register spaces by address.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_posix_io_add_reg_space, nvgpu_posix_io_get_reg_space,
+ *          nvgpu_posix_io_delete_reg_space, nvgpu_posix_io_writel_reg_space,
+ *          nvgpu_posix_io_readl_reg_space
+ *
+ * Inputs: None
+ *
+ * Steps:
+ * - Add a register space in an unused address range and look it up.
+ * - Add a smaller space inside the first one. Check that addresses inside the
+ *   smaller space resolve to it and addresses right around it resolve to the
+ *   outer space.
+ * - Write and read registers through both spaces and check the backing data.
+ * - Look up the address right above the outer space and check that it is not
+ *   found and the error code is -EFAULT.
+ * - Delete the inner space and check that its addresses resolve to the outer
+ *   space again.
+ * - Check that the default spaces added at probe are still found.
+ *
+ * Output:
+ * The test returns PASS if all lookups return the expected space, FAIL
+ * otherwise.
+ */
+int test_reg_space_lookup(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for test_reg_profile
+ *
+ * Description: Count register accesses with the register access profile.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_posix_io_start_profile, nvgpu_posix_io_stop_profile,
+ *          nvgpu_posix_io_get_profile
+ *
+ * Inputs: None
+ *
+ * Steps:
+ * - Start the profile and read one register 10 times, write a second one
+ *   4 times, write 4096 other registers once and read the second register
+ *   once. Stop the profile and read the second register again.
+ * - Get the two hottest registers and check their addresses and read/write
+ *   counts; the access after stopping must not be counted.
+ * - Restart and stop the profile and check that no registers are reported.
+ *
+ * Output:
+ * The test returns PASS if the reported profile matches the accesses, FAIL
+ * otherwise.
+ */
+int test_reg_profile(struct unit_module *m, struct gk20a *g, void *args);
+
 #endif /* __UNIT_COMMON_IO_H__ */
@@ -25,6 +25,8 @@
 
 #include <nvgpu/sizes.h>
 #include <nvgpu/types.h>
+#include <nvgpu/bitops.h>
+#include <nvgpu/timers.h>
 #include <nvgpu/allocator.h>
 #include <nvgpu/posix/kmem.h>
 #include <nvgpu/posix/posix-fault-injection.h>
@@ -40,6 +42,11 @@
 #define SZ_16K			(SZ_4K << 2)
 #define SZ_32K			(SZ_64K >> 1)
 
+#define BA_BENCH_BLK_SIZE	SZ_4K
+#define BA_BENCH_BLKS		(1ULL << 20)
+#define BA_BENCH_HOLE_STRIDE	4096ULL
+#define BA_BENCH_SEARCHES	64U
+
 static struct nvgpu_allocator *na;
 
 int test_nvgpu_bitmap_allocator_critical(struct unit_module *m,
@@ -365,6 +372,15 @@ int test_nvgpu_bitmap_allocator_init(struct unit_module *m,
 	}
 	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
 
+	/* Fault injection at bitmap summary create */
+	nvgpu_posix_enable_fault_injection(kmem_fi, true, 3);
+	if (nvgpu_allocator_init(g, na, NULL, "test_bitmap", base, length,
+				blk_size, 0ULL, flags, BITMAP_ALLOCATOR) == 0) {
+		unit_return_fail(m, "bitmap inited despite "
+			"fault injection at bitmap summary create\n");
+	}
+	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
+
 	/*
 	 * Initialize bitmap allocator
 	 * This ba will be used for further tests.
@@ -377,6 +393,147 @@ int test_nvgpu_bitmap_allocator_init(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+/*
+ * Check that the summary bit of every bitmap word says whether that word is
+ * full. Bits past the end of the last word count as set.
+ */
+static bool ba_summary_consistent(struct nvgpu_bitmap_allocator *ba)
+{
+	struct nvgpu_hbitmap *hb = &ba->bitmap;
+	unsigned long tail = hb->nbits & (BITS_PER_LONG - 1UL);
+	unsigned long w, word;
+
+	for (w = 0; w < hb->nwords; w++) {
+		word = hb->map[w];
+		if ((w == (hb->nwords - 1UL)) && (tail != 0UL)) {
+			word |= ~0UL << tail;
+		}
+		if ((word == ~0UL) != nvgpu_test_bit((u32)w, hb->full)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int test_nvgpu_bitmap_allocator_search_bench(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	struct nvgpu_allocator *bench_na;
+	struct nvgpu_bitmap_allocator *ba;
+	u64 blk_size = BA_BENCH_BLK_SIZE;
+	u64 base = blk_size;
+	u64 length = BA_BENCH_BLKS * blk_size;
+	u64 used_blks = BA_BENCH_BLKS - (BA_BENCH_BLKS >> 4);
+	u64 addr, blk;
+	s64 start, plain_ns, summary_ns, alloc_ns;
+	unsigned long plain = 0UL, summary = 0UL;
+	u32 i;
+	int ret = UNIT_FAIL;
+
+	bench_na = (struct nvgpu_allocator *)
+			nvgpu_kzalloc(g, sizeof(struct nvgpu_allocator));
+	if (bench_na == NULL) {
+		unit_return_fail(m, "Could not allocate nvgpu_allocator\n");
+	}
+
+	if (nvgpu_allocator_init(g, bench_na, NULL, "test_bitmap_bench", base,
+				length, blk_size, 0ULL,
+				GPU_ALLOC_NO_ALLOC_PAGE,
+				BITMAP_ALLOCATOR) != 0) {
+		nvgpu_kfree(g, bench_na);
+		unit_return_fail(m, "bitmap_allocator init failed\n");
+	}
+	ba = bench_na->priv;
+
+	/*
+	 * Occupy the first 15/16 of the space and free one block every
+	 * BA_BENCH_HOLE_STRIDE blocks: a search for two blocks has to get past
+	 * all of the holes before finding the free tail.
+	 */
+	addr = bench_na->ops->alloc_fixed(bench_na, base,
+					  used_blks * blk_size, blk_size);
+	if (addr != base) {
+		unit_err(m, "alloc_fixed of the used region failed\n");
+		goto done;
+	}
+	for (blk = BA_BENCH_HOLE_STRIDE; blk < used_blks;
+	     blk += BA_BENCH_HOLE_STRIDE) {
+		bench_na->ops->free_fixed(bench_na, base + blk * blk_size,
+					  blk_size);
+	}
+
+	if (!ba_summary_consistent(ba)) {
+		unit_err(m, "bitmap summary out of sync after setup\n");
+		goto done;
+	}
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < BA_BENCH_SEARCHES; i++) {
+		plain = bitmap_find_next_zero_area(ba->bitmap.map,
+						   ba->num_bits, 0UL, 2U, 0UL);
+	}
+	plain_ns = nvgpu_current_time_ns() - start;
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < BA_BENCH_SEARCHES; i++) {
+		summary = nvgpu_hbitmap_find_next_zero_area(&ba->bitmap,
+						ba->num_bits, 0UL, 2U, 0UL);
+	}
+	summary_ns = nvgpu_current_time_ns() - start;
+
+	unit_info(m, "%u searches over %llu blocks: plain %lld ns, "
+		  "summary %lld ns\n", BA_BENCH_SEARCHES, BA_BENCH_BLKS,
+		  plain_ns, summary_ns);
+
+	if ((plain != used_blks) || (summary != plain)) {
+		unit_err(m, "search mismatch: plain %lu summary %lu\n",
+			 plain, summary);
+		goto done;
+	}
+
+	/*
+	 * The allocator itself: every allocation searches from the start of
+	 * the space and takes the next two blocks of the free tail.
+	 */
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < BA_BENCH_SEARCHES; i++) {
+		ba->next_blk = 0ULL;
+		addr = bench_na->ops->alloc(bench_na, 2ULL * blk_size);
+		if (addr != base + (used_blks + 2ULL * i) * blk_size) {
+			unit_err(m, "alloc %u returned 0x%llx\n", i, addr);
+			goto done;
+		}
+	}
+	alloc_ns = nvgpu_current_time_ns() - start;
+	unit_info(m, "%u allocs: %lld ns\n", BA_BENCH_SEARCHES, alloc_ns);
+
+	/* A single block fits the first hole. */
+	ba->next_blk = 0ULL;
+	addr = bench_na->ops->alloc(bench_na, blk_size);
+	if (addr != base + BA_BENCH_HOLE_STRIDE * blk_size) {
+		unit_err(m, "single block alloc returned 0x%llx\n", addr);
+		goto done;
+	}
+
+	bench_na->ops->free_fixed(bench_na, addr, blk_size);
+	bench_na->ops->free_fixed(bench_na, base + used_blks * blk_size,
+				  2ULL * BA_BENCH_SEARCHES * blk_size);
+
+	if (!ba_summary_consistent(ba)) {
+		unit_err(m, "bitmap summary out of sync after frees\n");
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	bench_na->ops->fini(bench_na);
+	nvgpu_kfree(g, bench_na);
+
+	return ret;
+}
+
 struct unit_module_test bitmap_allocator_tests[] = {
 
 	/* BA initialized in this test is used by next tests */
@@ -389,6 +546,10 @@ struct unit_module_test bitmap_allocator_tests[] = {
 
 	/* Tests GPU_ALLOC_NO_ALLOC_PAGE operations by bitmap allocator */
 	UNIT_TEST(critical, test_nvgpu_bitmap_allocator_critical, NULL, 0),
+
+	/* Free space search over a large, mostly full bitmap */
+	UNIT_TEST(search_bench, test_nvgpu_bitmap_allocator_search_bench,
+		  NULL, 0),
 };
 
 UNIT_MODULE(bitmap_allocator, bitmap_allocator_tests, UNIT_PRIO_NVGPU_TEST);
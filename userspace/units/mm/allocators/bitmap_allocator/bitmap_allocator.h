@@ -40,6 +40,7 @@ struct unit_module;
  * Test Type: Feature, Error injection
  *
  * Targets: nvgpu_bitmap_allocator_init, nvgpu_bitmap_check_argument_limits,
+ *          nvgpu_hbitmap_init,
  *          nvgpu_allocator.ops.fini, nvgpu_alloc_to_gpu
  *
  * Input: None
@@ -165,4 +166,42 @@ int test_nvgpu_bitmap_allocator_destroy(struct unit_module *m,
 int test_nvgpu_bitmap_allocator_critical(struct unit_module *m,
 						struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_nvgpu_bitmap_allocator_search_bench
+ *
+ * Description: Benchmark the free space search of the bitmap allocator over a
+ * large, mostly full bitmap and check its full-word summary.
+ *
+ * Test Type: Feature, Performance
+ *
+ * Targets: nvgpu_allocator.ops.alloc, nvgpu_allocator.ops.alloc_fixed,
+ *          nvgpu_allocator.ops.free_fixed, nvgpu_hbitmap_find_next_zero_area,
+ *          nvgpu_hbitmap_set, nvgpu_hbitmap_clear
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Initialize an allocator of 1M blocks of 4K with the
+ *   GPU_ALLOC_NO_ALLOC_PAGE flag.
+ * - Allocate the first 15/16 of the space with alloc_fixed and free one block
+ *   every 4096 blocks of it.
+ * - Check that the summary bit of every bitmap word matches whether the word
+ *   is full.
+ * - Search 64 times from block 0 for two free blocks, once with
+ *   bitmap_find_next_zero_area() and once with
+ *   nvgpu_hbitmap_find_next_zero_area(), and print the time of both.
+ *   - Confirm both return the first block of the free tail.
+ * - Allocate two blocks 64 times, restarting the search from block 0 each
+ *   time, and print the time taken.
+ *   - Confirm the allocations are consecutive blocks of the free tail.
+ * - Allocate one block and confirm it is the first hole.
+ * - Free the allocations and check the summary again.
+ * - Free the allocator.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_bitmap_allocator_search_bench(struct unit_module *m,
+						struct gk20a *g, void *args);
+
 #endif /* UNIT_BITMAP_ALLOCATOR_H */
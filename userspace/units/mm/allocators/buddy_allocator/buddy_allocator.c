@@ -628,6 +628,109 @@ cleanup:
 	return result;
 }
 
+/*
+ * Check that every bit of the free-order mask matches a non-empty order list.
+ */
+static bool buddy_list_mask_valid(struct nvgpu_buddy_allocator *ba)
+{
+	u64 i;
+
+	for (i = 0ULL; i <= ba->max_order; i++) {
+		bool set = (ba->buddy_list_mask & BIT64(i)) != 0ULL;
+
+		if (set != (ba->buddy_list_len[i] != 0ULL)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int test_nvgpu_buddy_allocator_fragmented(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	u64 base = SZ_4K;
+	u64 size = SZ_1M;
+	u64 blk_size = SZ_4K;
+	u64 nr_blks = size / blk_size;
+	u64 addr, i;
+	struct nvgpu_buddy_allocator *ba;
+	int result = UNIT_FAIL;
+
+	na = (struct nvgpu_allocator *)
+			nvgpu_kzalloc(g, sizeof(struct nvgpu_allocator));
+	if (na == NULL) {
+		unit_return_fail(m, "Could not allocate nvgpu_allocator\n");
+	}
+
+	if (nvgpu_allocator_init(g, na, NULL, "test_frag", base, size,
+			blk_size, 0ULL, 0ULL, BUDDY_ALLOCATOR) != 0) {
+		nvgpu_kfree(g, na);
+		unit_return_fail(m, "ba init for fragmented test failed\n");
+	}
+
+	ba = na->priv;
+	unit_assert(buddy_list_mask_valid(ba), goto cleanup);
+
+	/*
+	 * Fixed allocate every other block so that the space is split down
+	 * to order 0 across its whole length.
+	 */
+	for (i = 0ULL; i < nr_blks; i += 2ULL) {
+		addr = na->ops->alloc_fixed(na, base + i * blk_size,
+					blk_size, SZ_4K);
+		if (addr == 0ULL) {
+			unit_err(m, "%d: fixed alloc of block %llu failed\n",
+				__LINE__, i);
+			goto cleanup;
+		}
+	}
+	unit_assert(buddy_list_mask_valid(ba), goto cleanup);
+
+	/*
+	 * Every allocated block and every range straddling one must be
+	 * rejected; every hole must still be available.
+	 */
+	for (i = 0ULL; i < nr_blks; i += 2ULL) {
+		addr = na->ops->alloc_fixed(na, base + i * blk_size,
+					blk_size, SZ_4K);
+		unit_assert(addr == 0ULL, goto cleanup);
+		if (i + 2ULL < nr_blks) {
+			addr = na->ops->alloc_fixed(na,
+					base + (i + 1ULL) * blk_size,
+					blk_size * 2ULL, SZ_4K);
+			unit_assert(addr == 0ULL, goto cleanup);
+		}
+	}
+	unit_assert(buddy_list_mask_valid(ba), goto cleanup);
+
+	/* Only order 0 holes are left: a larger request must fail. */
+	addr = na->ops->alloc(na, blk_size * 2ULL);
+	unit_assert(addr == 0ULL, goto cleanup);
+
+	for (i = 1ULL; i < nr_blks; i += 2ULL) {
+		addr = na->ops->alloc(na, blk_size);
+		unit_assert(addr != 0ULL, goto cleanup);
+	}
+	unit_assert(ba->buddy_list_mask == 0ULL, goto cleanup);
+	unit_assert(na->ops->alloc(na, blk_size) == 0ULL, goto cleanup);
+
+	/* Freeing everything must coalesce back to the top order. */
+	for (i = 0ULL; i < nr_blks; i++) {
+		na->ops->free_alloc(na, base + i * blk_size);
+	}
+	unit_assert(buddy_list_mask_valid(ba), goto cleanup);
+	unit_assert(ba->buddy_list_mask == BIT64(ba->max_order),
+		goto cleanup);
+
+	result = UNIT_SUCCESS;
+
+cleanup:
+	na->ops->fini(na);
+	nvgpu_kfree(g, na);
+	return result;
+}
+
 /*
  * Tests buddy_allocator carveouts
  */
@@ -1043,6 +1146,8 @@ struct unit_module_test buddy_allocator_tests[] = {
 	/* Independent tests */
 	/* Tests allocations by buddy allocator */
 	UNIT_TEST(alloc, test_nvgpu_buddy_allocator_alloc, NULL, 0),
+	/* Tests free-order mask and range checks on a fragmented space */
+	UNIT_TEST(fragmented, test_nvgpu_buddy_allocator_fragmented, NULL, 0),
 	/* Tests buddy allocator - GVA_space enabled and big_pages disabled */
 	UNIT_TEST(ops_small_pages, test_buddy_allocator_with_small_pages, NULL, 0),
 	/* Tests buddy allocator - GVA_space enabled and big_pages enabled */
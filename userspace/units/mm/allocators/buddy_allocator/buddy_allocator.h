@@ -199,6 +199,35 @@ int test_nvgpu_buddy_allocator_destroy(struct unit_module *m,
 int test_nvgpu_buddy_allocator_alloc(struct unit_module *m,
 						struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_nvgpu_buddy_allocator_fragmented
+ *
+ * Description: Test the free-order mask and fixed-range overlap checks on a
+ * fully fragmented address space.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_allocator.ops.alloc, nvgpu_allocator.ops.alloc_fixed,
+ *          nvgpu_allocator.ops.free_alloc
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Initialize a buddy allocator with 4K base, 1M size and 4K blocks.
+ * - Fixed allocate every other block and check the free-order mask matches
+ *   the non-empty order lists.
+ * - Fixed allocate each allocated block, and each range straddling an
+ *   allocated block, and check all of them fail.
+ * - Check an 8K allocation fails and that every 4K hole can be allocated.
+ * - Check the free-order mask is empty once the space is exhausted.
+ * - Free all blocks and check the mask only has the top order set.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_buddy_allocator_fragmented(struct unit_module *m,
+						struct gk20a *g, void *args);
+
 /**
  * Test specification for: test_buddy_allocator_with_small_pages
  *
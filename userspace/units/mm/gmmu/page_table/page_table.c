@@ -33,6 +33,8 @@
 #include <nvgpu/mm.h>
 #include <nvgpu/vm.h>
 #include <nvgpu/nvgpu_sgt.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/thread.h>
 #include <os/posix/os_posix.h>
 #include <nvgpu/posix/posix-fault-injection.h>
 
@@ -74,6 +76,14 @@
 #define REQ_C1_IDX_4K_ALIGN	1
 #define REQ_C1_IDX_MIXED	2
 
+/* Consts for parallel page table fill testing */
+#define PT_FILL_PA_ADDRESS	0x100000000000ULL
+#define PT_FILL_CHUNK_SIZE	(256ULL * SZ_1M)
+#define PT_FILL_WORKERS		4U
+#define PT_FILL_SAMPLES		1024ULL
+#define PT_FILL_SHARED_VA	(32ULL * SZ_1G)
+#define PT_FILL_SHARED_ITERS	8U
+
 /* Check if address is aligned at the requested boundary */
 #define IS_ALIGNED(addr, align)	((addr & (align - 1U)) == 0U)
 
@@ -1174,6 +1184,340 @@ int test_nvgpu_page_table_c2_full(struct unit_module *m, struct gk20a *g,
 	return UNIT_SUCCESS;
 }
 
+/*
+ * Physical address the synthetic SGT of pt_fill_map() backs GPU VA offset
+ * @off with: chunks are laid out in reverse order, with a hole after each.
+ */
+static u64 pt_fill_expected_pa(u64 size, u64 off)
+{
+	u64 nr_chunks = size / PT_FILL_CHUNK_SIZE;
+	u64 chunk = off / PT_FILL_CHUNK_SIZE;
+
+	return PT_FILL_PA_ADDRESS +
+		(nr_chunks - 1ULL - chunk) * (PT_FILL_CHUNK_SIZE + SZ_64K) +
+		(off % PT_FILL_CHUNK_SIZE);
+}
+
+/*
+ * Map @size bytes of a synthetic, physically discontiguous SGT with big
+ * pages and return the GPU VA, or 0 on failure. *@ns is set to the time
+ * spent in the map call.
+ */
+static u64 pt_fill_map(struct unit_module *m, struct gk20a *g,
+		       struct vm_gk20a *vm, u64 size,
+		       struct vm_gk20a_mapping_batch *batch, s64 *ns)
+{
+	u64 nr_chunks = size / PT_FILL_CHUNK_SIZE;
+	struct nvgpu_mem_sgl *sgl_list;
+	struct nvgpu_mem mem = { };
+	struct nvgpu_sgt *sgt;
+	u64 vaddr = 0ULL;
+	s64 start;
+	u64 i;
+
+	sgl_list = (struct nvgpu_mem_sgl *)
+		calloc(nr_chunks, sizeof(struct nvgpu_mem_sgl));
+	if (sgl_list == NULL) {
+		unit_err(m, "Failed to allocate SGL list\n");
+		return 0ULL;
+	}
+
+	for (i = 0ULL; i < nr_chunks; i++) {
+		sgl_list[i].length = PT_FILL_CHUNK_SIZE;
+		sgl_list[i].phys = pt_fill_expected_pa(size,
+					i * PT_FILL_CHUNK_SIZE);
+	}
+
+	if (nvgpu_mem_posix_create_from_list(g, &mem, sgl_list,
+					     (u32)nr_chunks) != 0) {
+		unit_err(m, "Failed to create mem from SGL list\n");
+		goto done;
+	}
+	sgt = nvgpu_sgt_create_from_mem(g, &mem);
+	if (sgt == NULL) {
+		unit_err(m, "Failed to create SGT\n");
+		goto done;
+	}
+
+	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+	start = nvgpu_current_time_ns();
+	vaddr = g->ops.mm.gmmu.map(vm, 0ULL, sgt, 0ULL, size,
+				   GMMU_PAGE_SIZE_BIG, 0, 0, 0,
+				   gk20a_mem_flag_none, false, false, false,
+				   batch, APERTURE_SYSMEM);
+	*ns = nvgpu_current_time_ns() - start;
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+	nvgpu_sgt_free(g, sgt);
+done:
+	free(sgl_list);
+	return vaddr;
+}
+
+static void pt_fill_unmap(struct gk20a *g, struct vm_gk20a *vm,
+			  u64 vaddr, u64 size)
+{
+	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+	g->ops.mm.gmmu.unmap(vm, vaddr, size, GMMU_PAGE_SIZE_BIG, true,
+			     gk20a_mem_flag_none, false, NULL);
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+}
+
+/*
+ * Check PTEs spread evenly across the mapping, plus the last one, point at
+ * the right physical pages.
+ */
+static int pt_fill_check(struct unit_module *m, struct gk20a *g,
+			 struct vm_gk20a *vm, u64 vaddr, u64 size)
+{
+	u64 step = size / PT_FILL_SAMPLES;
+	u32 pte[TEST_PTE_SIZE];
+	u64 off;
+
+	for (off = 0ULL; off < size; off += step) {
+		u64 addr = (off + step >= size) ? size - SZ_64K : off;
+
+		if (nvgpu_get_pte(g, vm, vaddr + addr, &pte[0]) != 0) {
+			unit_return_fail(m, "PTE lookup failed at %llx\n",
+					 vaddr + addr);
+		}
+		if (!pte_is_valid(pte) ||
+		    pte_get_phys_addr(pte) != pt_fill_expected_pa(size, addr)) {
+			unit_return_fail(m, "Bad PTE %08x %08x at %llx\n",
+					 pte[1], pte[0], vaddr + addr);
+		}
+	}
+
+	return UNIT_SUCCESS;
+}
+
+/* A 128GB VM with a big page capable user region for large mappings. */
+static struct vm_gk20a *pt_fill_init_vm(struct gk20a *g)
+{
+	u64 low_hole = 64ULL * SZ_1M;
+	u64 aperture_size = 128ULL * SZ_1G;
+	u64 kernel_reserved = 4ULL * SZ_1G;
+	u64 user_reserved = aperture_size - kernel_reserved - low_hole;
+
+	return nvgpu_vm_init(g, g->ops.mm.gmmu.get_default_big_page_size(),
+			     low_hole, user_reserved, kernel_reserved,
+			     nvgpu_gmmu_va_small_page_limit(),
+			     true, true, true, "pt_fill");
+}
+
+int test_nvgpu_gmmu_map_parallel_fill(struct unit_module *m,
+				      struct gk20a *g, void *args)
+{
+	static const u64 sizes[] = { SZ_1G, 4ULL * SZ_1G, 16ULL * SZ_1G,
+				     64ULL * SZ_1G };
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	struct vm_gk20a_mapping_batch batch = { };
+	struct vm_gk20a *vm;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	vm = pt_fill_init_vm(g);
+	if (vm == NULL) {
+		unit_return_fail(m, "nvgpu_vm_init failed\n");
+	}
+
+	/* Physically discontiguous SGT: exercise the per-SGL walk. */
+	p->mm_is_iommuable = false;
+	p->mm_sgt_is_iommuable = false;
+
+	if (nvgpu_gmmu_pt_fill_init(g, 0U, SZ_1G) != -EINVAL) {
+		unit_err(m, "pt fill pool started without workers\n");
+		goto done;
+	}
+
+	for (i = 0U; i < ARRAY_SIZE(sizes); i++) {
+		u64 size = sizes[i];
+		s64 serial_ns = 0, parallel_ns = 0;
+		u64 vaddr;
+
+		vaddr = pt_fill_map(m, g, vm, size, NULL, &serial_ns);
+		unit_assert(vaddr != 0ULL, goto done);
+		unit_assert(pt_fill_check(m, g, vm, vaddr, size) ==
+			    UNIT_SUCCESS, goto done);
+		pt_fill_unmap(g, vm, vaddr, size);
+
+		unit_assert(nvgpu_gmmu_pt_fill_init(g, PT_FILL_WORKERS,
+						    SZ_1G) == 0, goto done);
+
+		batch.need_tlb_invalidate = false;
+		vaddr = pt_fill_map(m, g, vm, size, &batch, &parallel_ns);
+		unit_assert(vaddr != 0ULL, goto fill_done);
+		/* The TLB invalidate is still only deferred to the batch. */
+		unit_assert(batch.need_tlb_invalidate, goto fill_done);
+		unit_assert(pt_fill_check(m, g, vm, vaddr, size) ==
+			    UNIT_SUCCESS, goto fill_done);
+		pt_fill_unmap(g, vm, vaddr, size);
+		nvgpu_gmmu_pt_fill_deinit(g);
+
+		unit_info(m, "map %3llu GB: serial %lld us, %u workers %lld us\n",
+			  size / SZ_1G, serial_ns / 1000, PT_FILL_WORKERS,
+			  parallel_ns / 1000);
+	}
+
+	ret = UNIT_SUCCESS;
+	goto done;
+
+fill_done:
+	nvgpu_gmmu_pt_fill_deinit(g);
+done:
+	p->mm_is_iommuable = true;
+	p->mm_sgt_is_iommuable = true;
+	nvgpu_vm_put(vm);
+	return ret;
+}
+
+/* One of the threads of test_nvgpu_gmmu_map_parallel_fill_shared_pde(). */
+struct pt_fill_shared_map {
+	struct nvgpu_thread thread;
+	struct gk20a *g;
+	struct vm_gk20a *vm;
+	struct nvgpu_mem mem;
+	struct nvgpu_mem_sgl sgl;
+	struct nvgpu_sgt *sgt;
+	u64 vaddr;
+	u64 size;
+	u32 iters;
+	u32 errors;
+};
+
+/* Check sampled PTEs of a contiguous mapping made by pt_fill_shared_fn(). */
+static bool pt_fill_shared_check(struct pt_fill_shared_map *t)
+{
+	u64 step = max(round_down(t->size / PT_FILL_SAMPLES, (u64)SZ_64K),
+		       (u64)SZ_64K);
+	u32 pte[TEST_PTE_SIZE];
+	u64 off;
+
+	for (off = 0ULL; off < t->size; off += step) {
+		u64 addr = (off + step >= t->size) ? t->size - SZ_64K : off;
+
+		if ((nvgpu_get_pte(t->g, t->vm, t->vaddr + addr,
+				   &pte[0]) != 0) || !pte_is_valid(pte) ||
+		    (pte_get_phys_addr(pte) != t->sgl.phys + addr)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Map the range of @arg at its fixed GPU VA @iters times, unmapping it again
+ * in between, and check its PTEs after every map.
+ */
+static int pt_fill_shared_fn(void *arg)
+{
+	struct pt_fill_shared_map *t = arg;
+	struct vm_gk20a_mapping_batch batch = { };
+	u32 i;
+
+	for (i = 0U; i < t->iters; i++) {
+		u64 vaddr;
+
+		vaddr = t->g->ops.mm.gmmu.map(t->vm, t->vaddr, t->sgt, 0ULL,
+					      t->size, GMMU_PAGE_SIZE_BIG, 0, 0,
+					      0, gk20a_mem_flag_none, false,
+					      false, false, &batch,
+					      APERTURE_SYSMEM);
+		if ((vaddr != t->vaddr) || !pt_fill_shared_check(t)) {
+			t->errors++;
+		}
+		if (i + 1U < t->iters) {
+			t->g->ops.mm.gmmu.unmap(t->vm, t->vaddr, t->size,
+						GMMU_PAGE_SIZE_BIG, false,
+						gk20a_mem_flag_none, false,
+						&batch);
+		}
+	}
+
+	return 0;
+}
+
+int test_nvgpu_gmmu_map_parallel_fill_shared_pde(struct unit_module *m,
+						 struct gk20a *g, void *args)
+{
+	struct pt_fill_shared_map t[2];
+	struct vm_gk20a *vm;
+	int ret = UNIT_FAIL;
+	u32 round, n, i;
+
+	(void) memset(t, 0, sizeof(t));
+
+	vm = pt_fill_init_vm(g);
+	if (vm == NULL) {
+		unit_return_fail(m, "nvgpu_vm_init failed\n");
+	}
+	unit_assert(vm->pd_lock_lvl != U32_MAX, goto done);
+
+	/*
+	 * The first range is filled in by the workers and ends in the middle
+	 * of a last level PDE. The second range covers the rest of that PDE
+	 * and is small enough to be mapped directly.
+	 */
+	t[0].vaddr = PT_FILL_SHARED_VA;
+	t[0].size = SZ_1G + SZ_1M;
+	t[0].sgl.phys = PT_FILL_PA_ADDRESS;
+	t[0].iters = 1U;
+	t[1].vaddr = PT_FILL_SHARED_VA + SZ_1G + SZ_1M;
+	t[1].size = SZ_1M;
+	t[1].sgl.phys = PT_FILL_PA_ADDRESS + 2ULL * SZ_1G;
+	t[1].iters = PT_FILL_SHARED_ITERS;
+
+	for (n = 0U; n < ARRAY_SIZE(t); n++) {
+		t[n].g = g;
+		t[n].vm = vm;
+		t[n].sgl.length = t[n].size;
+		unit_assert(nvgpu_mem_posix_create_from_list(g, &t[n].mem,
+					&t[n].sgl, 1U) == 0, goto done);
+		t[n].sgt = nvgpu_sgt_create_from_mem(g, &t[n].mem);
+		unit_assert(t[n].sgt != NULL, goto done);
+	}
+
+	unit_assert(nvgpu_gmmu_pt_fill_init(g, PT_FILL_WORKERS, SZ_1G) == 0,
+		goto done);
+
+	for (round = 0U; round < PT_FILL_SHARED_ITERS; round++) {
+		for (n = 0U; n < ARRAY_SIZE(t); n++) {
+			if (nvgpu_thread_create(&t[n].thread, &t[n],
+					pt_fill_shared_fn, "pt_fill_shared") != 0) {
+				unit_err(m, "failed to create map thread\n");
+				break;
+			}
+		}
+		for (i = 0U; i < n; i++) {
+			nvgpu_thread_join(&t[i].thread);
+		}
+		unit_assert(n == ARRAY_SIZE(t), goto fill_done);
+
+		/* Both ranges, including the PDE they share, must be intact. */
+		for (n = 0U; n < ARRAY_SIZE(t); n++) {
+			unit_assert(t[n].errors == 0U, goto fill_done);
+			unit_assert(pt_fill_shared_check(&t[n]), goto fill_done);
+			g->ops.mm.gmmu.unmap(vm, t[n].vaddr, t[n].size,
+					     GMMU_PAGE_SIZE_BIG, false,
+					     gk20a_mem_flag_none, false, NULL);
+		}
+	}
+
+	ret = UNIT_SUCCESS;
+
+fill_done:
+	nvgpu_gmmu_pt_fill_deinit(g);
+done:
+	for (n = 0U; n < ARRAY_SIZE(t); n++) {
+		if (t[n].sgt != NULL) {
+			nvgpu_sgt_free(g, t[n].sgt);
+		}
+	}
+	nvgpu_vm_put(vm);
+	return ret;
+}
+
 int test_nvgpu_gmmu_perm_str(struct unit_module *m, struct gk20a *g, void *args)
 {
 	int ret = UNIT_FAIL;
@@ -1307,6 +1651,10 @@ struct unit_module_test nvgpu_gmmu_tests[] = {
 			NULL, 0),
 
 	UNIT_TEST(gmmu_perm_str, test_nvgpu_gmmu_perm_str, NULL, 0),
+	UNIT_TEST(gmmu_map_parallel_fill, test_nvgpu_gmmu_map_parallel_fill,
+		NULL, 1),
+	UNIT_TEST(gmmu_map_parallel_fill_shared_pde,
+		test_nvgpu_gmmu_map_parallel_fill_shared_pde, NULL, 0),
 	UNIT_TEST(gmmu_clean, test_nvgpu_gmmu_clean, NULL, 0),
 };
 
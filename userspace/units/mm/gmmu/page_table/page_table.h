@@ -314,6 +314,73 @@ int test_nvgpu_gmmu_init(struct unit_module *m, struct gk20a *g, void *args);
  */
 int test_nvgpu_gmmu_clean(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_nvgpu_gmmu_map_parallel_fill
+ *
+ * Description: Benchmark and check parallel page table population of very
+ * large mappings.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gmmu_pt_fill_init, nvgpu_gmmu_pt_fill_deinit,
+ * gops_mm_gmmu.map, gops_mm_gmmu.unmap, nvgpu_get_pte
+ *
+ * Input: test_nvgpu_gmmu_init
+ *
+ * Steps:
+ * - Create a 128 GB test VM with a big page capable user region.
+ * - Check that starting the fill pool without workers fails.
+ * - For mapping sizes of 1, 4, 16 and 64 GB:
+ *   - Build a synthetic SGT of 256 MB physically discontiguous chunks.
+ *   - Map it with big pages without the fill pool, check sampled PTEs point
+ *     at the expected physical pages and unmap.
+ *   - Start the fill pool with 4 workers, map the same SGT with a mapping
+ *     batch and check the batch still has the TLB invalidate pending.
+ *   - Check the sampled PTEs again, unmap and stop the pool.
+ *   - Report the serial and parallel map times.
+ * - Free the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_gmmu_map_parallel_fill(struct unit_module *m,
+	struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_nvgpu_gmmu_map_parallel_fill_shared_pde
+ *
+ * Description: Map two ranges that share a last level PDE from two threads at
+ * once, one of them with its PTEs filled in by the parallel fill workers.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gmmu_pt_fill_init, nvgpu_gmmu_pt_fill_deinit,
+ * gops_mm_gmmu.map, gops_mm_gmmu.unmap, nvgpu_get_pte
+ *
+ * Input: test_nvgpu_gmmu_init
+ *
+ * Steps:
+ * - Create a 128 GB test VM with a big page capable user region and check it
+ *   has a page table level with subtree locks.
+ * - Build a contiguous 1 GB + 1 MB SGT and a contiguous 1 MB SGT. Their fixed
+ *   GPU VAs are such that the second range covers the part of the last 2 MB
+ *   PDE of the first range that the first range does not.
+ * - Start the fill pool with 4 workers and a 1 GB threshold.
+ * - 8 times:
+ *   - In one thread map the large range with big pages, so that the fill
+ *     workers fill in its PTEs. In a second thread map, check and unmap the
+ *     small range 8 times, leaving it mapped the last time.
+ *   - Check that no map failed and that sampled PTEs of both ranges, including
+ *     every PTE of the small range, point at the expected physical pages.
+ *   - Unmap both ranges.
+ * - Stop the pool and free the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_gmmu_map_parallel_fill_shared_pde(struct unit_module *m,
+	struct gk20a *g, void *args);
+
 /**
  * Test specification for: test_nvgpu_gmmu_perm_str
  *
@@ -39,6 +39,10 @@
 #include <nvgpu/preempt.h>
 #include <nvgpu/cic_mon.h>
 #include <nvgpu/nvgpu_init.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/dma.h>
+#include <nvgpu/gmmu.h>
+#include <nvgpu/timers.h>
 #include <nvgpu/hw/gv11b/hw_fb_gv11b.h>
 #include <nvgpu/hw/gv11b/hw_gmmu_gv11b.h>
 #include <nvgpu/posix/dma.h>
@@ -803,6 +807,266 @@ done:
 	return ret;
 }
 
+#ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+#define REPLAY_BENCH_CHANNELS	4U
+#define REPLAY_BENCH_PAGES	8U
+#define REPLAY_BENCH_REPEAT	4U
+#define REPLAY_BENCH_UNIQUE	(REPLAY_BENCH_CHANNELS * REPLAY_BENCH_PAGES)
+#define REPLAY_BENCH_FAULTS	(REPLAY_BENCH_UNIQUE * REPLAY_BENCH_REPEAT)
+
+static u32 replay_get_writes, replay_tlb_invalidates;
+static u32 replay_acks, replay_cancels;
+
+static u32 stub_replay_bench_channel_count(struct gk20a *g)
+{
+	return REPLAY_BENCH_FAULTS;
+}
+
+static u32 stub_replay_bench_buffer_size(struct gk20a *g, u32 index)
+{
+	return fb_mmu_fault_buffer_size_val_f(REPLAY_BENCH_FAULTS + 1U);
+}
+
+static void stub_replay_bench_write_get(struct gk20a *g, u32 index,
+								u32 reg_val)
+{
+	get_idx = fb_mmu_fault_buffer_get_ptr_v(reg_val);
+	replay_get_writes++;
+}
+
+static int stub_replay_bench_tlb_invalidate(struct gk20a *g,
+						struct nvgpu_mem *pdb)
+{
+	replay_tlb_invalidates++;
+	return 0;
+}
+
+static int stub_replay_bench_invalidate_replay(struct gk20a *g, u32 val)
+{
+	if ((val & fb_mmu_invalidate_replay_cancel_global_f()) != 0U) {
+		replay_cancels++;
+	} else {
+		replay_acks++;
+	}
+	return 0;
+}
+
+static void replay_bench_write_fault(struct gk20a *g, struct nvgpu_mem *mem,
+					u32 indx, u64 inst_ptr, u64 addr)
+{
+	u32 offset = indx * gmmu_fault_buf_size_v() / U32(sizeof(u32));
+
+	nvgpu_mem_wr32(g, mem, offset + gmmu_fault_buf_entry_inst_lo_w(),
+		gmmu_fault_buf_entry_inst_lo_f(u64_lo32(inst_ptr) >>
+					gmmu_fault_buf_entry_inst_lo_b()));
+	nvgpu_mem_wr32(g, mem, offset + gmmu_fault_buf_entry_inst_hi_w(),
+		u64_hi32(inst_ptr));
+	nvgpu_mem_wr32(g, mem, offset + gmmu_fault_buf_entry_addr_lo_w(),
+		gmmu_fault_buf_entry_addr_lo_f(u64_lo32(addr) >>
+					gmmu_fault_buf_entry_addr_lo_b()));
+	nvgpu_mem_wr32(g, mem, offset + gmmu_fault_buf_entry_addr_hi_w(),
+		u64_hi32(addr));
+	nvgpu_mem_wr32(g, mem, offset + gmmu_fault_buf_entry_fault_type_w(),
+		gmmu_fault_type_pte_v() |
+		gmmu_fault_buf_entry_replayable_fault_true_f() |
+		gmmu_fault_buf_entry_valid_true_f());
+}
+
+/* Fault address of the n-th storm entry: every page faults once per pass. */
+static u64 replay_bench_addr(u64 gpu_va, u32 n)
+{
+	return gpu_va + (u64)(n % REPLAY_BENCH_UNIQUE) * SZ_4K;
+}
+
+/* Make all pages of the storm fault again. */
+static int replay_bench_set_ptes(struct gk20a *g, struct vm_gk20a *vm,
+					u64 gpu_va, bool valid)
+{
+	u32 pte[2];
+	u32 i;
+	int err;
+
+	for (i = 0U; i < REPLAY_BENCH_UNIQUE; i++) {
+		err = nvgpu_get_pte(g, vm, gpu_va + (u64)i * SZ_4K, pte);
+		if (err != 0) {
+			return err;
+		}
+		if (valid) {
+			pte[0] |= gmmu_new_pte_valid_true_f();
+		} else {
+			pte[0] &= ~gmmu_new_pte_valid_true_f();
+		}
+		err = nvgpu_set_pte(g, vm, gpu_va + (u64)i * SZ_4K, pte);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static bool replay_bench_ptes_valid(struct gk20a *g, struct vm_gk20a *vm,
+					u64 gpu_va)
+{
+	u32 pte[2];
+	u32 i;
+
+	for (i = 0U; i < REPLAY_BENCH_UNIQUE; i++) {
+		if (nvgpu_get_pte(g, vm, gpu_va + (u64)i * SZ_4K, pte) != 0 ||
+		    (pte[0] & gmmu_new_pte_valid_true_f()) == 0U) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void replay_bench_reset_counts(void)
+{
+	replay_get_writes = 0U;
+	replay_tlb_invalidates = 0U;
+	replay_acks = 0U;
+	replay_cancels = 0U;
+}
+
+int test_handle_replay_fault_batch_bench(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	int ret = UNIT_FAIL;
+	int err;
+	u32 c, n;
+	s64 start, per_entry_ns, batch_ns;
+	struct gpu_ops gops = g->ops;
+	struct vm_gk20a *vm = g->mm.pmu.vm;
+	struct nvgpu_mem buf = { };
+	struct nvgpu_mem *mem;
+	struct nvgpu_channel *chs = NULL;
+	u8 *inst_pages = NULL;
+	uintptr_t inst_base;
+	u64 inst_ptr[REPLAY_BENCH_CHANNELS];
+
+	g->ops.channel.count = stub_replay_bench_channel_count;
+	g->ops.fb.read_mmu_fault_buffer_get =
+					stub_fb_read_mmu_fault_buffer_get;
+	g->ops.fb.read_mmu_fault_buffer_put =
+					stub_fb_read_mmu_fault_buffer_put;
+	g->ops.fb.read_mmu_fault_buffer_size = stub_replay_bench_buffer_size;
+	g->ops.fb.write_mmu_fault_buffer_get = stub_replay_bench_write_get;
+	g->ops.fb.tlb_invalidate = stub_replay_bench_tlb_invalidate;
+	g->ops.fb.mmu_invalidate_replay = stub_replay_bench_invalidate_replay;
+	g->ops.fifo.mmu_fault_id_to_pbdma_id =
+					stub_fifo_mmu_fault_id_to_pbdma_id;
+	g->ops.top.get_num_lce = stub_top_get_num_lce;
+	ret_num_lce = 0U;
+
+	err = gv11b_mm_mmu_fault_setup_sw(g);
+	unit_assert(err == 0, goto done);
+	unit_assert(g->mm.replay_faults_len > REPLAY_BENCH_FAULTS,
+								goto done);
+	mem = &g->mm.hw_fault_buf[NVGPU_MMU_FAULT_REPLAY_INDX];
+
+	/* Channels with 4K aligned instance blocks, all bound to one VM */
+	chs = nvgpu_kzalloc(g, sizeof(*chs) * REPLAY_BENCH_CHANNELS);
+	unit_assert(chs != NULL, goto done);
+	inst_pages = nvgpu_kzalloc(g, (REPLAY_BENCH_CHANNELS + 1U) * SZ_4K);
+	unit_assert(inst_pages != NULL, goto done);
+	inst_base = ((uintptr_t)inst_pages + SZ_4K - 1U) &
+						~(uintptr_t)(SZ_4K - 1U);
+	for (c = 0U; c < REPLAY_BENCH_CHANNELS; c++) {
+		chs[c].g = g;
+		chs[c].chid = c;
+		chs[c].referenceable = true;
+		/* Reference held by an open channel */
+		nvgpu_atomic_set(&chs[c].ref_count, 1);
+		chs[c].vm = vm;
+		chs[c].inst_block.cpu_va = (void *)(inst_base + c * SZ_4K);
+		chs[c].inst_block.size = SZ_4K;
+		chs[c].inst_block.aperture = APERTURE_SYSMEM;
+		inst_ptr[c] = nvgpu_inst_block_addr(g, &chs[c].inst_block);
+	}
+	g->fifo.channel = chs;
+	g->fifo.num_channels = REPLAY_BENCH_CHANNELS;
+
+	/* Storm pages, each channel faulting on its own range of the VM */
+	err = nvgpu_dma_alloc_map_sys(vm, REPLAY_BENCH_UNIQUE * SZ_4K, &buf);
+	unit_assert(err == 0, goto done);
+
+	nvgpu_set_power_state(g, NVGPU_STATE_POWERED_ON);
+
+	/* One fault per interrupt: every entry is serviced on its own */
+	err = replay_bench_set_ptes(g, vm, buf.gpu_va, false);
+	unit_assert(err == 0, goto done);
+	replay_bench_reset_counts();
+	get_idx = 0U;
+	start = nvgpu_current_time_ns();
+	for (n = 0U; n < REPLAY_BENCH_FAULTS; n++) {
+		c = (n / REPLAY_BENCH_PAGES) % REPLAY_BENCH_CHANNELS;
+		replay_bench_write_fault(g, mem, get_idx, inst_ptr[c],
+				replay_bench_addr(buf.gpu_va, n));
+		put_idx = get_idx + 1U;
+		gv11b_mm_mmu_fault_handle_nonreplay_replay_fault(g, 0U,
+				NVGPU_MMU_FAULT_REPLAY_REG_INDX);
+	}
+	per_entry_ns = nvgpu_current_time_ns() - start;
+	unit_assert(replay_bench_ptes_valid(g, vm, buf.gpu_va), goto done);
+	unit_info(m, "per entry: %u faults, %u GET writes, %u TLB "
+		"invalidates, %u replays, %u cancels, %lld ns\n",
+		REPLAY_BENCH_FAULTS, replay_get_writes,
+		replay_tlb_invalidates, replay_acks, replay_cancels,
+		per_entry_ns);
+
+	/* The whole storm in the buffer at once, serviced as one batch */
+	err = replay_bench_set_ptes(g, vm, buf.gpu_va, false);
+	unit_assert(err == 0, goto done);
+	replay_bench_reset_counts();
+	for (n = 0U; n < REPLAY_BENCH_FAULTS; n++) {
+		c = (n / REPLAY_BENCH_PAGES) % REPLAY_BENCH_CHANNELS;
+		replay_bench_write_fault(g, mem, n, inst_ptr[c],
+				replay_bench_addr(buf.gpu_va, n));
+	}
+	get_idx = 0U;
+	put_idx = REPLAY_BENCH_FAULTS;
+	start = nvgpu_current_time_ns();
+	gv11b_mm_mmu_fault_handle_nonreplay_replay_fault(g, 0U,
+			NVGPU_MMU_FAULT_REPLAY_REG_INDX);
+	batch_ns = nvgpu_current_time_ns() - start;
+	unit_info(m, "batched:   %u faults, %u GET writes, %u TLB "
+		"invalidates, %u replays, %u cancels, %lld ns\n",
+		REPLAY_BENCH_FAULTS, replay_get_writes,
+		replay_tlb_invalidates, replay_acks, replay_cancels,
+		batch_ns);
+
+	unit_assert(replay_bench_ptes_valid(g, vm, buf.gpu_va), goto done);
+	unit_assert(get_idx == REPLAY_BENCH_FAULTS, goto done);
+	unit_assert(replay_get_writes == 1U, goto done);
+	unit_assert(replay_tlb_invalidates == 1U, goto done);
+	unit_assert(replay_acks == 1U, goto done);
+	unit_assert(replay_cancels == 0U, goto done);
+	for (c = 0U; c < REPLAY_BENCH_CHANNELS; c++) {
+		unit_assert(nvgpu_atomic_read(&chs[c].ref_count) == 1,
+								goto done);
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	if (ret != UNIT_SUCCESS) {
+		unit_err(m, "%s failed\n", __func__);
+	}
+	nvgpu_set_power_state(g, NVGPU_STATE_POWERED_OFF);
+	if (nvgpu_mem_is_valid(&buf)) {
+		nvgpu_dma_unmap_free(vm, &buf);
+	}
+	g->fifo.channel = NULL;
+	g->fifo.num_channels = 0U;
+	nvgpu_kfree(g, inst_pages);
+	nvgpu_kfree(g, chs);
+	gv11b_mm_mmu_fault_info_mem_destroy(g);
+	g->ops = gops;
+	return ret;
+}
+#endif
+
 int test_env_clean_mm_mmu_fault_gv11b_fusa(struct unit_module *m,
 						struct gk20a *g, void *args)
 {
@@ -846,6 +1110,9 @@ struct unit_module_test mm_mmu_fault_gv11b_fusa_tests[] = {
 	UNIT_TEST(handle_nonreplay_s1, test_handle_nonreplay_replay_fault, (void *)F_HANDLE_NON_RPLYBLE_INVALID_BUF_ENTRY, 0),
 	UNIT_TEST(handle_nonreplay_s2, test_handle_nonreplay_replay_fault, (void *)F_HANDLE_NON_RPLYBLE_VALID_BUF_ENTRY, 0),
 	UNIT_TEST(handle_nonreplay_s3, test_handle_nonreplay_replay_fault, (void *)F_HANDLE_NON_RPLYBLE_VALID_BUF_CH, 0),
+#ifdef CONFIG_NVGPU_REPLAYABLE_FAULT
+	UNIT_TEST(replay_batch_bench, test_handle_replay_fault_batch_bench, NULL, 0),
+#endif
 	UNIT_TEST(env_clean, test_env_clean_mm_mmu_fault_gv11b_fusa, NULL, 0),
 };
 
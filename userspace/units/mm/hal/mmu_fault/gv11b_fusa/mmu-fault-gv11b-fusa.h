@@ -203,6 +203,41 @@ int test_handle_mmu_fault_common(struct unit_module *m,
 int test_handle_nonreplay_replay_fault(struct unit_module *m, struct gk20a *g,
 					void *args);
 
+/**
+ * Test specification for: test_handle_replay_fault_batch_bench
+ *
+ * Description: Service a storm of replayable faults on a few pages and
+ * measure batched servicing against servicing one fault per interrupt.
+ *
+ * Test Type: Feature
+ *
+ * Targets: gv11b_mm_mmu_fault_handle_nonreplay_replay_fault,
+ *          gv11b_mm_mmu_fault_handle_replay_batch,
+ *          gv11b_fb_fix_page_fault
+ *
+ * Input: test_env_init
+ *
+ * Steps:
+ * - Stub the fault buffer GET/PUT/size registers, the TLB invalidate and the
+ *   replay HALs to count GET writes, TLB invalidates, replays and cancels.
+ * - Create four channels with 4K aligned instance blocks bound to the system
+ *   VM, and map 32 pages that each channel faults 8 of.
+ * - Clear the valid bit of the PTEs of all pages.
+ * - Write the storm one entry at a time to the replay fault buffer, each page
+ *   faulting 4 times in interleaved order, and call the handler after each
+ *   entry. Check that all PTEs are valid again.
+ * - Clear the PTE valid bits again, write the whole storm to the buffer and
+ *   call the handler once.
+ * - Check that all PTEs are valid, that GET was written once, that the TLB
+ *   was invalidated once, that one replay and no cancel was issued and that
+ *   no channel reference taken by the handler is left.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_handle_replay_fault_batch_bench(struct unit_module *m,
+					struct gk20a *g, void *args);
+
 /**
  * Test specification for: test_env_clean_mm_mmu_fault_gv11b_fusa
  *
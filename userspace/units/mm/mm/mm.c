@@ -347,11 +347,17 @@ int test_nvgpu_init_mm(struct unit_module *m, struct gk20a *g, void *args)
 	g->ops.mm.mmu_fault.setup_sw = NULL;
 	g->ops.mm.setup_hw = NULL;
 	g->mm.sw_ready = false;
+	/* The platform opted in to the parallel PTE fill. */
+	g->mm.pt_fill_workers = 2U;
 	err = nvgpu_init_mm_support(g);
+	g->mm.pt_fill_workers = 0U;
 	if (err != 0) {
 		unit_return_fail(m, "nvgpu_init_mm_support failed (3) err=%d\n",
 				err);
 	}
+	if (g->mm.pt_fill == NULL) {
+		unit_return_fail(m, "PTE fill pool not started\n");
+	}
 	g->ops.mm.mmu_fault.setup_sw = int_empty_hal;
 	g->ops.mm.setup_hw = int_empty_hal;
 
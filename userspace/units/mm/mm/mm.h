@@ -83,6 +83,9 @@ int test_mm_init_hal(struct unit_module *m, struct gk20a *g, void *args);
  * - nvgpu_init_mm_support is then called and expected to succeed.
  * - Call nvgpu_init_mm_support again to test the case where initialization
  *   already succeeded.
+ * - Clear sw_ready, set mm.pt_fill_workers as a platform would and call
+ *   nvgpu_init_mm_support again. Check that the parallel PTE fill pool was
+ *   started; nvgpu_remove_mm_support stops it later.
  *
  * Output: Returns PASS if the steps above were executed successfully. FAIL
  * otherwise.
@@ -22,6 +22,7 @@
 
 #include "vm.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <unit/unit.h>
 #include <unit/io.h>
@@ -34,6 +35,8 @@
 #include <nvgpu/nvgpu_sgt.h>
 #include <nvgpu/vm_area.h>
 #include <nvgpu/pd_cache.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/thread.h>
 
 #include <hal/mm/cache/flush_gk20a.h>
 #include <hal/mm/cache/flush_gv11b.h>
@@ -2374,6 +2377,410 @@ done:
 	return ret;
 }
 
+#define REVERSE_BENCH_LOOKUPS	2000U
+
+static void stub_gmmu_unmap(struct vm_gk20a *vm, u64 vaddr, u64 size,
+			    u32 pgsz_idx, bool va_allocated,
+			    enum gk20a_mem_rw_flag rw_flag, bool sparse,
+			    struct vm_gk20a_mapping_batch *batch)
+{
+}
+
+/* Look up random buffers, half of them with a kind they are not mapped with */
+static s64 reverse_bench_run(struct vm_gk20a *vm,
+			     struct nvgpu_mapped_buf **bufs, u32 num_bufs,
+			     u32 *misses)
+{
+	struct nvgpu_os_buffer os_buf = { };
+	struct nvgpu_mapped_buf *found;
+	s64 start;
+	u32 i, n;
+	s16 kind;
+
+	*misses = 0U;
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < REVERSE_BENCH_LOOKUPS; i++) {
+		n = (u32)rand() % num_bufs;
+		kind = bufs[n]->kind + (s16)(i & 1U);
+		os_buf.buf = (void *)bufs[n]->os_buf_id;
+		found = nvgpu_vm_find_mapped_buf_reverse(vm, &os_buf, kind);
+		if (found != (((i & 1U) == 0U) ? bufs[n] : NULL)) {
+			(*misses)++;
+		}
+	}
+
+	return nvgpu_current_time_ns() - start;
+}
+
+int test_vm_find_mapped_buf_reverse_bench(struct unit_module *m,
+	struct gk20a *g, void *args)
+{
+	const u32 num_bufs[] = { 1000U, 10000U, 50000U };
+	struct gpu_ops gops = g->ops;
+	struct vm_gk20a *vm = NULL;
+	struct nvgpu_mapped_buf **bufs = NULL;
+	struct nvgpu_mapped_buf **hash;
+	struct nvgpu_mapped_buf *found;
+	struct nvgpu_os_buffer os_buf = { };
+	u8 *ids = NULL;
+	s64 hash_ns, walk_ns;
+	u32 n, i, misses;
+	int ret = UNIT_FAIL;
+
+	g->ops.mm.gmmu.unmap = stub_gmmu_unmap;
+
+	for (n = 0U; n < ARRAY_SIZE(num_bufs); n++) {
+		vm = create_test_vm(m, g);
+		bufs = nvgpu_big_zalloc(g, sizeof(*bufs) * num_bufs[n]);
+		/* distinct, 16 byte aligned stand-ins for OS buffers */
+		ids = nvgpu_big_zalloc(g, (size_t)num_bufs[n] * 16U);
+		unit_assert(vm != NULL && bufs != NULL && ids != NULL,
+				goto done);
+
+		for (i = 0U; i < num_bufs[n]; i++) {
+			bufs[i] = nvgpu_kzalloc(g, sizeof(*bufs[i]));
+			unit_assert(bufs[i] != NULL, goto done);
+			bufs[i]->addr = BUF_CPU_PA + (u64)i * SZ_64K;
+			bufs[i]->size = SZ_64K;
+			bufs[i]->vm = vm;
+			bufs[i]->kind = (s16)(i % 4U) * 2;
+			bufs[i]->os_buf_id = &ids[(size_t)i * 16U];
+			nvgpu_init_list_node(&bufs[i]->buffer_list);
+			nvgpu_ref_init(&bufs[i]->ref);
+			nvgpu_insert_mapped_buf(vm, bufs[i]);
+		}
+		unit_assert(vm->mapped_buf_hash_size >= num_bufs[n],
+				goto done);
+
+		hash_ns = reverse_bench_run(vm, bufs, num_bufs[n], &misses);
+		unit_assert(misses == 0U, goto done);
+
+		/* without the table, lookups walk the whole rbtree */
+		hash = vm->mapped_buf_hash;
+		vm->mapped_buf_hash = NULL;
+		walk_ns = reverse_bench_run(vm, bufs, num_bufs[n], &misses);
+		vm->mapped_buf_hash = hash;
+		unit_assert(misses == 0U, goto done);
+
+		unit_info(m, "%u mappings: %lld ns per lookup hashed, "
+			"%lld ns walking the tree\n", num_bufs[n],
+			(long long)(hash_ns / (s64)REVERSE_BENCH_LOOKUPS),
+			(long long)(walk_ns / (s64)REVERSE_BENCH_LOOKUPS));
+
+		/* unmapping keeps the index in sync */
+		for (i = 0U; i < num_bufs[n]; i += 2U) {
+			nvgpu_vm_unmap(vm, bufs[i]->addr, NULL);
+		}
+		for (i = 0U; i < num_bufs[n]; i++) {
+			os_buf.buf = &ids[(size_t)i * 16U];
+			found = nvgpu_vm_find_mapped_buf_reverse(vm, &os_buf,
+					(s16)(i % 4U) * 2);
+			unit_assert(found == (((i & 1U) == 0U) ? NULL : bufs[i]),
+				goto done);
+		}
+
+		nvgpu_vm_put(vm);
+		vm = NULL;
+		nvgpu_big_free(g, bufs);
+		bufs = NULL;
+		nvgpu_big_free(g, ids);
+		ids = NULL;
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	if (vm != NULL) {
+		nvgpu_vm_put(vm);
+	}
+	nvgpu_big_free(g, bufs);
+	nvgpu_big_free(g, ids);
+	g->ops = gops;
+
+	return ret;
+}
+
+#define MT_BENCH_THREADS	4U
+#define MT_BENCH_ITERS		2000U
+#define MT_BENCH_BUF_SIZE	(SZ_64K * 4U)
+
+struct mt_bench_thread {
+	struct unit_module *m;
+	struct gk20a *g;
+	struct vm_gk20a *vm;
+	/* If set, each map and unmap is done under it, as with one VM lock */
+	struct nvgpu_mutex *big_lock;
+	struct nvgpu_thread thread;
+	struct nvgpu_os_buffer os_buf;
+	struct nvgpu_mem mem;
+	struct nvgpu_sgt *sgt;
+	u32 errors;
+};
+
+static int stub_fb_tlb_invalidate(struct gk20a *g, struct nvgpu_mem *pdb)
+{
+	return 0;
+}
+
+static int stub_mm_l2_flush(struct gk20a *g, bool invalidate)
+{
+	return 0;
+}
+
+static int mt_bench_thread_fn(void *arg)
+{
+	struct mt_bench_thread *t = arg;
+	struct vm_gk20a_mapping_batch batch;
+	struct nvgpu_mapped_buf *mapped_buf;
+	u32 pte[2];
+	u32 i;
+	int err;
+
+	nvgpu_vm_mapping_batch_start(&batch);
+	for (i = 0U; i < MT_BENCH_ITERS; i++) {
+		if (t->big_lock != NULL) {
+			nvgpu_mutex_acquire(t->big_lock);
+		}
+		err = nvgpu_vm_map(t->vm, &t->os_buf, t->sgt, 0ULL,
+				   MT_BENCH_BUF_SIZE, 0ULL,
+				   gk20a_mem_flag_none,
+				   NVGPU_VM_MAP_ACCESS_READ_WRITE,
+				   NVGPU_VM_MAP_CACHEABLE, NV_KIND_INVALID, 0,
+				   &batch, APERTURE_SYSMEM, &mapped_buf);
+		if (t->big_lock != NULL) {
+			nvgpu_mutex_release(t->big_lock);
+		}
+		if (err != 0) {
+			t->errors++;
+			continue;
+		}
+
+		/* The last page must be mapped while the buffer is */
+		err = nvgpu_get_pte(t->g, t->vm, mapped_buf->addr +
+				    MT_BENCH_BUF_SIZE - SZ_64K, pte);
+		if ((err != 0) ||
+		    ((pte[0] & gmmu_new_pte_valid_true_f()) == 0U)) {
+			t->errors++;
+		}
+
+		if (t->big_lock != NULL) {
+			nvgpu_mutex_acquire(t->big_lock);
+		}
+		nvgpu_vm_unmap(t->vm, mapped_buf->addr, &batch);
+		if (t->big_lock != NULL) {
+			nvgpu_mutex_release(t->big_lock);
+		}
+	}
+	nvgpu_vm_mapping_batch_finish(t->vm, &batch);
+
+	return 0;
+}
+
+static int mt_bench_run(struct unit_module *m, struct mt_bench_thread *t,
+			struct nvgpu_mutex *big_lock, s64 *ns)
+{
+	s64 start;
+	u32 i, n;
+	int err = 0;
+
+	start = nvgpu_current_time_ns();
+	for (n = 0U; n < MT_BENCH_THREADS; n++) {
+		t[n].big_lock = big_lock;
+		t[n].errors = 0U;
+		err = nvgpu_thread_create(&t[n].thread, &t[n],
+				mt_bench_thread_fn, "vm_mt_bench");
+		if (err != 0) {
+			unit_err(m, "failed to create bench thread\n");
+			break;
+		}
+	}
+	for (i = 0U; i < n; i++) {
+		nvgpu_thread_join(&t[i].thread);
+		if (t[i].errors != 0U) {
+			unit_err(m, "thread %u: %u failed maps\n", i,
+				 t[i].errors);
+			err = -EINVAL;
+		}
+	}
+	*ns = nvgpu_current_time_ns() - start;
+
+	return err;
+}
+
+int test_vm_map_unmap_mt_bench(struct unit_module *m, struct gk20a *g,
+			       void *args)
+{
+	struct gpu_ops gops = g->ops;
+	struct mt_bench_thread t[MT_BENCH_THREADS];
+	struct nvgpu_mem_sgl sgl_list[MT_BENCH_THREADS];
+	struct nvgpu_mutex big_lock;
+	struct vm_gk20a *vm;
+	s64 locked_ns = 0, concurrent_ns = 0;
+	u64 ops = (u64)MT_BENCH_THREADS * MT_BENCH_ITERS;
+	u32 n;
+	int ret = UNIT_FAIL;
+
+	/* Only the page table work is measured */
+	g->ops.fb.tlb_invalidate = stub_fb_tlb_invalidate;
+	g->ops.mm.cache.l2_flush = stub_mm_l2_flush;
+
+	(void) memset(t, 0, sizeof(t));
+	nvgpu_mutex_init(&big_lock);
+	vm = create_test_vm(m, g);
+	unit_assert(vm != NULL, goto free_bufs);
+	unit_assert(vm->pd_lock_lvl != U32_MAX, goto free_bufs);
+
+	for (n = 0U; n < MT_BENCH_THREADS; n++) {
+		t[n].m = m;
+		t[n].g = g;
+		t[n].vm = vm;
+		t[n].os_buf.buf = nvgpu_kzalloc(g, MT_BENCH_BUF_SIZE);
+		t[n].os_buf.size = MT_BENCH_BUF_SIZE;
+		unit_assert(t[n].os_buf.buf != NULL, goto free_bufs);
+
+		(void) memset(&sgl_list[n], 0, sizeof(sgl_list[n]));
+		sgl_list[n].phys = BUF_CPU_PA + (u64)n * SZ_1M;
+		sgl_list[n].length = MT_BENCH_BUF_SIZE;
+		t[n].mem.size = MT_BENCH_BUF_SIZE;
+		t[n].mem.cpu_va = t[n].os_buf.buf;
+		t[n].sgt = custom_sgt_create(m, g, &t[n].mem, &sgl_list[n], 1);
+		unit_assert(t[n].sgt != NULL, goto free_bufs);
+	}
+
+	unit_assert(mt_bench_run(m, t, &big_lock, &locked_ns) == 0,
+		goto free_bufs);
+	unit_assert(vm->mapped_buffers == NULL, goto free_bufs);
+
+	unit_assert(mt_bench_run(m, t, NULL, &concurrent_ns) == 0,
+		goto free_bufs);
+	unit_assert(vm->mapped_buffers == NULL, goto free_bufs);
+
+	unit_info(m, "%u threads, %llu map+unmap: %lld ns each with one "
+		"VM lock, %lld ns each with range locks\n", MT_BENCH_THREADS,
+		(unsigned long long)ops, (long long)(locked_ns / (s64)ops),
+		(long long)(concurrent_ns / (s64)ops));
+
+	ret = UNIT_SUCCESS;
+
+free_bufs:
+	for (n = 0U; n < MT_BENCH_THREADS; n++) {
+		if (t[n].sgt != NULL) {
+			nvgpu_sgt_free(g, t[n].sgt);
+		}
+		if (t[n].os_buf.buf != NULL) {
+			nvgpu_kfree(g, t[n].os_buf.buf);
+		}
+	}
+	if (vm != NULL) {
+		nvgpu_vm_put(vm);
+	}
+	nvgpu_mutex_destroy(&big_lock);
+	g->ops = gops;
+
+	return ret;
+}
+
+/* Dummy HAL for gmmu.map that always fails */
+static u64 hal_gmmu_map_error(struct vm_gk20a *vm, u64 map_offset,
+			      struct nvgpu_sgt *sgt, u64 buffer_offset,
+			      u64 size, u32 pgsz_idx, u8 kind_v,
+			      u32 ctag_offset, u32 flags,
+			      enum gk20a_mem_rw_flag rw_flag, bool clear_ctags,
+			      bool sparse, bool priv,
+			      struct vm_gk20a_mapping_batch *batch,
+			      enum nvgpu_aperture aperture)
+{
+	return 0ULL;
+}
+
+#define FIXED_MAP_ADDR	(SZ_1G * 2ULL)
+
+int test_map_fixed_userspace_managed(struct unit_module *m, struct gk20a *g,
+				     void *args)
+{
+	struct gpu_ops gops = g->ops;
+	struct nvgpu_os_buffer os_buf = {0};
+	struct nvgpu_mem_sgl sgl_list[1];
+	struct nvgpu_mem mem = {0};
+	struct nvgpu_sgt *sgt = NULL;
+	struct nvgpu_mapped_buf *mapped_buf = NULL;
+	struct vm_gk20a *vm;
+	size_t buf_size = SZ_64K;
+	int ret = UNIT_FAIL;
+	int err;
+
+	vm = create_test_vm(m, g);
+	unit_assert(vm != NULL, goto done);
+	vm->userspace_managed = true;
+
+	os_buf.buf = nvgpu_kzalloc(g, buf_size);
+	unit_assert(os_buf.buf != NULL, goto done);
+	os_buf.size = buf_size;
+
+	(void) memset(&sgl_list[0], 0, sizeof(sgl_list[0]));
+	sgl_list[0].phys = BUF_CPU_PA;
+	sgl_list[0].length = buf_size;
+	mem.size = buf_size;
+	mem.cpu_va = os_buf.buf;
+	sgt = custom_sgt_create(m, g, &mem, sgl_list, 1);
+	unit_assert(sgt != NULL, goto done);
+
+	/* No VM area backs this address, which is fine on this VM */
+	unit_assert(nvgpu_vm_area_find(vm, FIXED_MAP_ADDR) == NULL, goto done);
+
+	err = nvgpu_vm_map(vm, &os_buf, sgt, FIXED_MAP_ADDR, buf_size, 0ULL,
+			   gk20a_mem_flag_none,
+			   NVGPU_VM_MAP_ACCESS_READ_WRITE,
+			   NVGPU_VM_MAP_CACHEABLE | NVGPU_VM_MAP_FIXED_OFFSET,
+			   NV_KIND_INVALID, 0, NULL, APERTURE_SYSMEM,
+			   &mapped_buf);
+	unit_assert(err == 0, goto done);
+	unit_assert(mapped_buf != NULL, goto done);
+	unit_assert(mapped_buf->addr == FIXED_MAP_ADDR, goto done);
+	unit_assert(mapped_buf->vm_area == NULL, goto done);
+
+	/* The map must have dropped the update_gmmu_lock again */
+	unit_assert(nvgpu_mutex_tryacquire(&vm->update_gmmu_lock) != 0,
+		goto done);
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+	nvgpu_vm_unmap(vm, FIXED_MAP_ADDR, NULL);
+	unit_assert(vm->mapped_buffers == NULL, goto done);
+
+	/* A failing GMMU map must release the lock too */
+	g->ops.mm.gmmu.map = hal_gmmu_map_error;
+	mapped_buf = NULL;
+	err = nvgpu_vm_map(vm, &os_buf, sgt, FIXED_MAP_ADDR, buf_size, 0ULL,
+			   gk20a_mem_flag_none,
+			   NVGPU_VM_MAP_ACCESS_READ_WRITE,
+			   NVGPU_VM_MAP_CACHEABLE | NVGPU_VM_MAP_FIXED_OFFSET,
+			   NV_KIND_INVALID, 0, NULL, APERTURE_SYSMEM,
+			   &mapped_buf);
+	g->ops.mm.gmmu.map = gops.mm.gmmu.map;
+	unit_assert(err == -ENOMEM, goto done);
+	unit_assert(vm->mapped_buffers == NULL, goto done);
+	unit_assert(nvgpu_mutex_tryacquire(&vm->update_gmmu_lock) != 0,
+		goto done);
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+	ret = UNIT_SUCCESS;
+
+done:
+	if (sgt != NULL) {
+		nvgpu_sgt_free(g, sgt);
+	}
+	if (os_buf.buf != NULL) {
+		nvgpu_kfree(g, os_buf.buf);
+	}
+	if (vm != NULL) {
+		vm->userspace_managed = false;
+		nvgpu_vm_put(vm);
+	}
+	g->ops = gops;
+
+	return ret;
+}
+
 int test_vm_pde_coverage_bit_count(struct unit_module *m, struct gk20a *g,
 	void *args)
 {
@@ -2433,6 +2840,11 @@ struct unit_module_test vm_tests[] = {
 	UNIT_TEST(gk20a_from_vm, test_gk20a_from_vm, NULL, 0),
 	UNIT_TEST(nvgpu_insert_mapped_buf, test_nvgpu_insert_mapped_buf, NULL,
 		0),
+	UNIT_TEST(find_mapped_buf_reverse_bench,
+		  test_vm_find_mapped_buf_reverse_bench, NULL, 1),
+	UNIT_TEST(map_unmap_mt_bench, test_vm_map_unmap_mt_bench, NULL, 1),
+	UNIT_TEST(map_fixed_userspace_managed,
+		  test_map_fixed_userspace_managed, NULL, 0),
 	UNIT_TEST(vm_pde_coverage_bit_count, test_vm_pde_coverage_bit_count,
 		NULL, 0),
 };
@@ -515,6 +515,101 @@ int test_gk20a_from_vm(struct unit_module *m, struct gk20a *g, void *args);
 int test_nvgpu_insert_mapped_buf(struct unit_module *m, struct gk20a *g,
 	void *args);
 
+/**
+ * Test specification for: test_vm_find_mapped_buf_reverse_bench
+ *
+ * Description: Check the (buffer, kind) index of mapped buffers and measure
+ * reverse lookups against walking all mappings.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_vm_find_mapped_buf_reverse, nvgpu_insert_mapped_buf,
+ * nvgpu_vm_unmap
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For 1000, 10000 and 50000 mappings:
+ *   - Create a test VM and insert that many mapped buffers, each with its
+ *     own OS buffer identity and one of four kinds.
+ *   - Check that the hash table grew to at least one bucket per mapping.
+ *   - Look up random buffers with their own kind and with another kind, and
+ *     check that only the former are found. Time the lookups.
+ *   - Time the same lookups with the hash table hidden, which walks all
+ *     mappings as reverse lookups used to.
+ *   - Unmap every other buffer and check that exactly the remaining ones
+ *     are still found.
+ *   - Uninitialize the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_vm_find_mapped_buf_reverse_bench(struct unit_module *m,
+	struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_vm_map_unmap_mt_bench
+ *
+ * Description: Map and unmap buffers of one VM from several threads at once
+ * and measure it against doing the same under a single VM wide lock.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_vm_map, nvgpu_vm_unmap, nvgpu_gmmu_map_locked,
+ * nvgpu_gmmu_unmap_locked
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Stub the TLB invalidate and L2 flush HALs so only SW work is measured.
+ * - Create a test VM and check that it has a page table level to lock
+ *   subtrees at.
+ * - Create one 256KB buffer per thread.
+ * - Start four threads that each map and unmap their buffer 2000 times in a
+ *   batch, checking after each map that the last page of the buffer has a
+ *   valid PTE. Serialize every map and unmap with one test lock, as a single
+ *   VM lock would, and time the run.
+ * - Check that no map failed and that no mapped buffers are left.
+ * - Repeat the run without the test lock.
+ * - Uninitialize the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_vm_map_unmap_mt_bench(struct unit_module *m, struct gk20a *g,
+	void *args);
+
+/**
+ * Test specification for: test_map_fixed_userspace_managed
+ *
+ * Description: Map a buffer at a fixed offset in a userspace managed VM that
+ * has no VM area at that offset, once successfully and once with the GMMU
+ * map failing.
+ *
+ * Test Type: Feature, Error injection
+ *
+ * Targets: nvgpu_vm_map, nvgpu_vm_area_validate_buffer
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a test VM and mark it userspace managed.
+ * - Create a 64KB buffer and check that no VM area covers the fixed offset.
+ * - Map the buffer at the fixed offset and ensure the mapping succeeded at
+ *   that offset without a VM area.
+ * - Ensure the update_gmmu_lock of the VM is not held anymore.
+ * - Unmap the buffer.
+ * - Make g->ops.mm.gmmu.map fail and map the buffer at the fixed offset again.
+ *   Ensure it returns -ENOMEM, leaves no mapped buffer and does not hold the
+ *   update_gmmu_lock.
+ * - Uninitialize the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_map_fixed_userspace_managed(struct unit_module *m, struct gk20a *g,
+	void *args);
+
 /**
  * Test specification for: test_vm_pde_coverage_bit_count
  *
@@ -33,11 +33,18 @@
 #include <nvgpu/enabled.h>
 #include <nvgpu/hw/gm20b/hw_mc_gm20b.h>
 #include <nvgpu/netlist.h>
+#include <nvgpu/netlist_defs.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/string.h>
+#include <nvgpu/boot_cache.h>
 
 #include "hal/init/hal_gv11b.h"
 #include "hal/netlist/netlist_gv11b.h"
 #include "hal/gr/falcon/gr_falcon_gm20b.h"
 
+#include "common/netlist/netlist_priv.h"
+
 #include "nvgpu-netlist.h"
 
 #define NV_PMC_BOOT_0_ARCHITECTURE_GV110	(0x00000015 << \
@@ -271,6 +278,288 @@ int test_netlist_negative_tests(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+#define BOOT_CACHE_GOLDEN_SIZE	(64U * 1024U)
+
+/* Offset of the checksum in the blob header. */
+#define BOOT_CACHE_CHECKSUM_OFFSET	12U
+
+/* Synthetic netlist: FECS/GPCCS ucode and major version regions. */
+#define TEST_NETLIST_REGIONS		5U
+#define TEST_NETLIST_FECS_INST_WORDS	64U
+#define TEST_NETLIST_DATA_WORDS		16U
+
+struct test_netlist_image {
+	struct netlist_image_header header;
+	struct netlist_region regions[TEST_NETLIST_REGIONS];
+	u32 fecs_inst[TEST_NETLIST_FECS_INST_WORDS];
+	u32 fecs_data[TEST_NETLIST_DATA_WORDS];
+	u32 gpccs_inst[TEST_NETLIST_DATA_WORDS];
+	u32 gpccs_data[TEST_NETLIST_DATA_WORDS];
+	u32 major_v;
+};
+
+static void test_netlist_region(struct test_netlist_image *img, u32 i,
+		u32 region_id, void *data, u32 size)
+{
+	img->regions[i].region_id = region_id;
+	img->regions[i].data_size = size;
+	img->regions[i].data_offset = (u32)((u8 *)data - (u8 *)img);
+}
+
+static void test_netlist_build_image(struct test_netlist_image *img)
+{
+	u32 i;
+
+	memset(img, 0, sizeof(*img));
+	img->header.regions = TEST_NETLIST_REGIONS;
+	for (i = 0U; i < TEST_NETLIST_FECS_INST_WORDS; i++) {
+		img->fecs_inst[i] = i;
+	}
+	img->major_v = 0x1U;
+
+	test_netlist_region(img, 0U, NETLIST_REGIONID_FECS_UCODE_INST,
+		img->fecs_inst, sizeof(img->fecs_inst));
+	test_netlist_region(img, 1U, NETLIST_REGIONID_FECS_UCODE_DATA,
+		img->fecs_data, sizeof(img->fecs_data));
+	test_netlist_region(img, 2U, NETLIST_REGIONID_GPCCS_UCODE_INST,
+		img->gpccs_inst, sizeof(img->gpccs_inst));
+	test_netlist_region(img, 3U, NETLIST_REGIONID_GPCCS_UCODE_DATA,
+		img->gpccs_data, sizeof(img->gpccs_data));
+	test_netlist_region(img, 4U, NETLIST_REGIONID_MAJORV,
+		&img->major_v, sizeof(img->major_v));
+}
+
+/* No firmware file, so the cached netlist is the only copy. */
+static int test_netlist_no_fw_name(struct gk20a *g, int index, char *name)
+{
+	(void)strcpy(name, "boot_cache_test_netlist.bin");
+
+	return 0;
+}
+
+static s64 test_netlist_timed_init(struct gk20a *g, int *err)
+{
+	s64 start;
+
+	nvgpu_netlist_deinit_ctx_vars(g);
+	start = nvgpu_current_time_ns();
+	*err = nvgpu_netlist_init_ctx_vars(g);
+
+	return nvgpu_current_time_ns() - start;
+}
+
+static int test_boot_cache_corrupt(struct unit_module *m, struct gk20a *g,
+		const u8 *blob, size_t size)
+{
+	u8 *bad = malloc(size);
+	int ret = UNIT_FAIL;
+
+	if (bad == NULL) {
+		unit_return_fail(m, "out of memory\n");
+	}
+
+	/* bad magic */
+	memcpy(bad, blob, size);
+	bad[0] ^= 0xffU;
+	unit_assert(nvgpu_boot_cache_load(g, bad, size) == -EINVAL, goto done);
+
+	/* payload corruption caught by the checksum */
+	memcpy(bad, blob, size);
+	bad[size - 1U] ^= 0x1U;
+	unit_assert(nvgpu_boot_cache_load(g, bad, size) == -EINVAL, goto done);
+
+	/* checksum corruption */
+	memcpy(bad, blob, size);
+	bad[BOOT_CACHE_CHECKSUM_OFFSET] ^= 0x1U;
+	unit_assert(nvgpu_boot_cache_load(g, bad, size) == -EINVAL, goto done);
+
+	/* truncated blob */
+	unit_assert(nvgpu_boot_cache_load(g, blob, size - 8U) == -EINVAL,
+		goto done);
+	unit_assert(nvgpu_boot_cache_load(g, blob, 8U) == -EINVAL, goto done);
+
+	/* blob of another chip */
+	g->params.gpu_impl += 1U;
+	unit_assert(nvgpu_boot_cache_load(g, blob, size) == -ENODEV,
+		g->params.gpu_impl -= 1U; goto done);
+	g->params.gpu_impl -= 1U;
+
+	ret = UNIT_SUCCESS;
+done:
+	free(bad);
+	return ret;
+}
+
+int test_netlist_boot_cache(struct unit_module *m,
+		struct gk20a *g, void *args)
+{
+	int (*get_netlist_name)(struct gk20a *g, int index, char *name) =
+		g->ops.netlist.get_netlist_name;
+	struct nvgpu_boot_cache_gr_key key = { 0 };
+	struct test_netlist_image netlist;
+	u32 regs[4] = { 0x1U, 0x2U, 0x3U, 0x4U };
+	u32 regs_out[4] = { 0U };
+	u8 *golden = NULL, *golden_out = NULL, *blob = NULL, *image;
+	s64 fw_ns, cached_ns;
+	size_t size;
+	u32 image_size = 0U;
+	int ret = UNIT_FAIL;
+	int net = -1;
+	int err;
+	u32 i;
+
+	golden = malloc(BOOT_CACHE_GOLDEN_SIZE);
+	golden_out = malloc(BOOT_CACHE_GOLDEN_SIZE);
+	if ((golden == NULL) || (golden_out == NULL)) {
+		goto done;
+	}
+	for (i = 0U; i < BOOT_CACHE_GOLDEN_SIZE; i++) {
+		golden[i] = (u8)(i * 7U);
+	}
+	key.gpc_count = 1U;
+	key.tpc_count = 4U;
+	key.gpc_tpc_mask[0] = 0xfU;
+	test_netlist_build_image(&netlist);
+
+	/* Without the cache nothing is captured or loaded. */
+	unit_assert(nvgpu_boot_cache_save_size(g) == 0U, goto done);
+	unit_assert(nvgpu_boot_cache_load(g, golden, 64U) == -EINVAL,
+		goto done);
+
+	/* Cold boot: netlist from the firmware files, if there are any. */
+	fw_ns = test_netlist_timed_init(g, &err);
+	if (err != 0) {
+		fw_ns = -1;
+	}
+
+	err = nvgpu_boot_cache_init(g);
+	unit_assert(err == 0, goto done);
+
+	/* No golden image yet, so nothing to save. */
+	unit_assert(nvgpu_boot_cache_save_size(g) == 0U, goto done);
+	unit_assert(nvgpu_boot_cache_save(g, golden, 64U) == -EAGAIN,
+		goto done);
+
+	nvgpu_boot_cache_set_netlist(g, NETLIST_FINAL, (u8 *)&netlist,
+		sizeof(netlist));
+	nvgpu_boot_cache_set_golden(g, &key, regs, sizeof(regs), golden,
+		BOOT_CACHE_GOLDEN_SIZE);
+
+	size = nvgpu_boot_cache_save_size(g);
+	unit_assert(size > BOOT_CACHE_GOLDEN_SIZE + sizeof(netlist),
+		goto done);
+	blob = malloc(size);
+	unit_assert(blob != NULL, goto done);
+	unit_assert(nvgpu_boot_cache_save(g, blob, size - 1U) == -ENOSPC,
+		goto done);
+	unit_assert(nvgpu_boot_cache_save(g, blob, size) == 0, goto done);
+
+	/* Warm boot: start from an empty cache and hand in the blob. */
+	nvgpu_boot_cache_deinit(g);
+	unit_assert(nvgpu_boot_cache_init(g) == 0, goto done);
+
+	if (test_boot_cache_corrupt(m, g, blob, size) != UNIT_SUCCESS) {
+		unit_err(m, "corrupted blob accepted\n");
+		goto done;
+	}
+
+	unit_assert(nvgpu_boot_cache_load(g, blob, size) == 0, goto done);
+
+	/* The cache hands out a copy of the netlist image. */
+	image = nvgpu_boot_cache_get_netlist(g, &net, &image_size);
+	unit_assert(image != NULL, goto done);
+	err = ((net == NETLIST_FINAL) && (image_size == sizeof(netlist)) &&
+		(memcmp(image, &netlist, sizeof(netlist)) == 0)) ? 0 : -EINVAL;
+	nvgpu_vfree(g, image);
+	unit_assert(err == 0, goto done);
+
+	g->ops.netlist.get_netlist_name = test_netlist_no_fw_name;
+	cached_ns = test_netlist_timed_init(g, &err);
+	unit_assert(err == 0, goto done);
+	unit_assert(nvgpu_netlist_get_fecs_inst_count(g) ==
+		TEST_NETLIST_FECS_INST_WORDS, goto done);
+	unit_assert(nvgpu_netlist_get_fecs_inst_list(g)[3] == 3U, goto done);
+	unit_info(m, "netlist init: firmware %lld ns, boot cache %lld ns\n",
+		(long long)fw_ns, (long long)cached_ns);
+
+	/* Golden image only for the config and size it was captured with. */
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE) == 0,
+		goto done);
+	unit_assert(memcmp(regs, regs_out, sizeof(regs)) == 0, goto done);
+	unit_assert(memcmp(golden, golden_out, BOOT_CACHE_GOLDEN_SIZE) == 0,
+		goto done);
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE / 2U) ==
+		-ENOENT, goto done);
+	key.gpc_tpc_mask[0] = 0x7U;
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE) ==
+		-ENOENT, goto done);
+
+	/* A cached netlist that does not match the HW is not used. */
+	g->ops.netlist.is_fw_defined = test_netlist_fw_not_defined;
+	g->ops.gr.falcon.get_fecs_ctx_state_store_major_rev_id =
+		test_gr_falcon_get_fecs_ctx_state_store_major_rev_id;
+	(void)test_netlist_timed_init(g, &err);
+	g->ops.netlist.is_fw_defined = gv11b_netlist_is_firmware_defined;
+	g->ops.gr.falcon.get_fecs_ctx_state_store_major_rev_id =
+			gm20b_gr_falcon_get_fecs_ctx_state_store_major_rev_id;
+	unit_assert(err != 0, goto done);
+
+	/* Nor is one with regions outside of the image. */
+	netlist.regions[0].data_offset = sizeof(netlist);
+	nvgpu_boot_cache_set_netlist(g, NETLIST_FINAL, (u8 *)&netlist,
+		sizeof(netlist));
+	(void)test_netlist_timed_init(g, &err);
+	unit_assert((err != 0) || (nvgpu_netlist_get_fecs_inst_count(g) !=
+		TEST_NETLIST_FECS_INST_WORDS), goto done);
+
+	/* A golden image goes with the netlist it was built from. */
+	test_netlist_build_image(&netlist);
+	key.gpc_tpc_mask[0] = 0xfU;
+	nvgpu_boot_cache_set_golden(g, &key, regs, sizeof(regs), golden,
+		BOOT_CACHE_GOLDEN_SIZE);
+	nvgpu_boot_cache_set_netlist(g, NETLIST_FINAL, (u8 *)&netlist,
+		sizeof(netlist));
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE) ==
+		-ENOENT, goto done);
+	nvgpu_boot_cache_set_golden(g, &key, regs, sizeof(regs), golden,
+		BOOT_CACHE_GOLDEN_SIZE);
+	nvgpu_boot_cache_set_netlist(g, NETLIST_FINAL, (u8 *)&netlist,
+		sizeof(netlist));
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE) == 0,
+		goto done);
+
+	/* An unchanged netlist firmware file keeps both. */
+	unit_assert(nvgpu_boot_cache_check_netlist(g, (u8 *)&netlist,
+		sizeof(netlist)), goto done);
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE) == 0,
+		goto done);
+
+	/* An updated netlist firmware file drops both. */
+	netlist.major_v = 0x2U;
+	unit_assert(!nvgpu_boot_cache_check_netlist(g, (u8 *)&netlist,
+		sizeof(netlist)), goto done);
+	unit_assert(nvgpu_boot_cache_get_golden(g, &key, regs_out,
+		sizeof(regs_out), golden_out, BOOT_CACHE_GOLDEN_SIZE) ==
+		-ENOENT, goto done);
+	unit_assert(nvgpu_boot_cache_get_netlist(g, &net, &image_size) ==
+		NULL, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	g->ops.netlist.get_netlist_name = get_netlist_name;
+	nvgpu_boot_cache_deinit(g);
+	free(blob);
+	free(golden_out);
+	free(golden);
+	return ret;
+}
+
 int test_netlist_remove_support(struct unit_module *m,
 		struct gk20a *g, void *args)
 {
@@ -283,6 +572,7 @@ struct unit_module_test nvgpu_netlist_tests[] = {
 	UNIT_TEST(netlist_init_support, test_netlist_init_support, NULL, 0),
 	UNIT_TEST(netlist_query_tests, test_netlist_query_tests, NULL, 0),
 	UNIT_TEST(netlist_negative_tests, test_netlist_negative_tests, NULL, 0),
+	UNIT_TEST(netlist_boot_cache, test_netlist_boot_cache, NULL, 0),
 	UNIT_TEST(netlist_remove_support, test_netlist_remove_support, NULL, 0),
 };
 
@@ -138,6 +138,52 @@ int test_netlist_query_tests(struct unit_module *m,
 int test_netlist_negative_tests(struct unit_module *m,
 		struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_netlist_boot_cache
+ *
+ * Description: The netlist image and golden context image kept in the boot
+ * cache are saved to a blob, loaded back at the next boot with validation,
+ * and used instead of the netlist firmware files.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_boot_cache_init, nvgpu_boot_cache_deinit,
+ *          nvgpu_boot_cache_load, nvgpu_boot_cache_save,
+ *          nvgpu_boot_cache_save_size, nvgpu_boot_cache_get_golden,
+ *          nvgpu_boot_cache_set_golden, nvgpu_boot_cache_set_netlist,
+ *          nvgpu_boot_cache_get_netlist, nvgpu_boot_cache_check_netlist,
+ *          nvgpu_netlist_init_ctx_vars
+ *
+ * Input: test_netlist_init_support
+ *
+ * Steps:
+ * - Check that nothing can be saved or loaded before nvgpu_boot_cache_init.
+ * - Time a netlist load from the firmware files, if they exist.
+ * - Enable the cache and check no blob can be saved without a golden image.
+ * - Record a synthetic netlist image and golden image and save a blob.
+ * - Re-enable an empty cache and check that blobs with a bad magic, bad
+ *   checksum, corrupted payload, truncated size or other chip are rejected.
+ * - Load the blob and check the cache hands out a copy of the synthetic
+ *   netlist image.
+ * - Without a netlist firmware file, load the netlist from the cache,
+ *   timing it, and check the FECS ucode matches the synthetic image.
+ * - Check the golden image is returned only for the same floorsweeping
+ *   config and size.
+ * - Set HALs for a dynamic netlist of another major revision and check the
+ *   cached netlist is not used and init fails.
+ * - Record a netlist image with a region outside the image and check it is
+ *   not used.
+ * - Check a golden image is dropped when another netlist image is recorded
+ *   and kept when the same one is.
+ * - Check the netlist and golden image are kept for an unchanged netlist
+ *   firmware file and dropped for an updated one.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_netlist_boot_cache(struct unit_module *m,
+		struct gk20a *g, void *args);
+
 /**
  * Test specification for: test_netlist_remove_support
  *
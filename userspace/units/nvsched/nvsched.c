@@ -0,0 +1,487 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/sort.h>
+#include <nvgpu/timers.h>
+
+#include <nvs/log.h>
+#include <nvs/sched.h>
+#include <nvs/domain.h>
+
+#include "nvsched.h"
+
+#define MS(x)	((u64)(x) * 1000000ULL)
+
+static struct nvs_sched_ops nvs_test_ops = {
+	.preempt = NULL,
+	.recover = NULL,
+};
+
+static struct nvs_sched *nvs_test_sched_create(struct unit_module *m,
+		struct gk20a *g)
+{
+	struct nvs_sched *sched = nvgpu_kzalloc(g, sizeof(*sched));
+
+	if (sched == NULL) {
+		unit_err(m, "failed to allocate sched\n");
+		return NULL;
+	}
+
+	if (nvs_sched_create(sched, &nvs_test_ops, g) != 0) {
+		unit_err(m, "nvs_sched_create failed\n");
+		nvgpu_kfree(g, sched);
+		return NULL;
+	}
+
+	return sched;
+}
+
+static void nvs_test_sched_destroy(struct gk20a *g, struct nvs_sched *sched)
+{
+	if (sched != NULL) {
+		nvs_sched_close(sched);
+		nvgpu_kfree(g, sched);
+	}
+}
+
+int test_nvs_algo_rr(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvs_sched *sched;
+	struct nvs_domain *dom[3];
+	const char *names[3] = { "a", "b", "c" };
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	unit_assert(nvs_algo_by_name("rr") == &nvs_algo_round_robin,
+		goto out_noclose);
+	unit_assert(nvs_algo_by_name("wfq") == &nvs_algo_wfq,
+		goto out_noclose);
+	unit_assert(nvs_algo_by_name("edf") == &nvs_algo_edf,
+		goto out_noclose);
+	unit_assert(nvs_algo_by_name("lottery") == NULL, goto out_noclose);
+
+	sched = nvs_test_sched_create(m, g);
+	if (sched == NULL) {
+		return UNIT_FAIL;
+	}
+
+	unit_assert(sched->algorithm == &nvs_algo_round_robin, goto out);
+
+	for (i = 0U; i < 3U; i++) {
+		dom[i] = nvs_domain_create(sched, names[i], MS(1), 0ULL, NULL);
+		unit_assert(dom[i] != NULL, goto out);
+	}
+
+	/* runnability doesn't matter; everyone gets a turn */
+	for (i = 0U; i < 4U; i++) {
+		struct nvs_domain *expected = dom[i % 3U];
+
+		unit_assert(nvs_sched_schedule(sched, MS(i)) == expected,
+			goto out);
+	}
+
+	/* current is a; dropping it starts over from the beginning */
+	nvs_domain_destroy(sched, dom[0]);
+	unit_assert(sched->current == NULL, goto out);
+	unit_assert(nvs_sched_schedule(sched, MS(4)) == dom[1], goto out);
+	unit_assert(nvs_sched_schedule(sched, MS(5)) == dom[2], goto out);
+	unit_assert(nvs_sched_schedule(sched, MS(6)) == dom[1], goto out);
+
+	ret = UNIT_SUCCESS;
+out:
+	nvs_test_sched_destroy(g, sched);
+out_noclose:
+	return ret;
+}
+
+int test_nvs_algo_wfq(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvs_sched *sched;
+	struct nvs_domain *a, *b, *c, *next;
+	u32 count_a = 0U, count_b = 0U, count_c = 0U;
+	u64 now = 0ULL;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	sched = nvs_test_sched_create(m, g);
+	if (sched == NULL) {
+		return UNIT_FAIL;
+	}
+
+	a = nvs_domain_create(sched, "a", MS(1), 0ULL, NULL);
+	b = nvs_domain_create(sched, "b", MS(1), 0ULL, NULL);
+	c = nvs_domain_create(sched, "c", MS(1), 0ULL, NULL);
+	unit_assert((a != NULL) && (b != NULL) && (c != NULL), goto out);
+	b->weight = 3U;
+
+	nvs_sched_set_algo(sched, &nvs_algo_wfq);
+	nvs_domain_set_runnable(sched, a, true, now);
+	nvs_domain_set_runnable(sched, b, true, now);
+
+	for (i = 0U; i < 400U; i++) {
+		next = nvs_sched_schedule(sched, now);
+		count_a += (next == a) ? 1U : 0U;
+		count_b += (next == b) ? 1U : 0U;
+		count_c += (next == c) ? 1U : 0U;
+		now += MS(1);
+	}
+
+	unit_info(m, "wfq 1:3 split: %u/%u\n", count_a, count_b);
+	unit_assert((count_a >= 99U) && (count_a <= 101U), goto out);
+	unit_assert((count_b >= 299U) && (count_b <= 301U), goto out);
+	unit_assert(count_c == 0U, goto out);
+
+	/* c slept the whole time but must not catch up on that */
+	nvs_domain_set_runnable(sched, c, true, now);
+	next = nvs_sched_schedule(sched, now);
+	now += MS(1);
+	if (next != c) {
+		next = nvs_sched_schedule(sched, now);
+		now += MS(1);
+	}
+	unit_assert(next == c, goto out);
+
+	count_c = 0U;
+	for (i = 0U; i < 50U; i++) {
+		next = nvs_sched_schedule(sched, now);
+		count_c += (next == c) ? 1U : 0U;
+		now += MS(1);
+	}
+	unit_info(m, "wfq woken domain share: %u/50\n", count_c);
+	unit_assert((count_c >= 8U) && (count_c <= 12U), goto out);
+
+	nvs_domain_set_runnable(sched, a, false, now);
+	nvs_domain_set_runnable(sched, b, false, now);
+	nvs_domain_set_runnable(sched, c, false, now);
+	unit_assert(nvs_sched_schedule(sched, now) == NULL, goto out);
+
+	ret = UNIT_SUCCESS;
+out:
+	nvs_test_sched_destroy(g, sched);
+	return ret;
+}
+
+int test_nvs_algo_edf(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvs_sched *sched;
+	struct nvs_domain *a, *b, *c;
+	int ret = UNIT_FAIL;
+
+	sched = nvs_test_sched_create(m, g);
+	if (sched == NULL) {
+		return UNIT_FAIL;
+	}
+
+	a = nvs_domain_create(sched, "a", MS(1), 0ULL, NULL);
+	b = nvs_domain_create(sched, "b", MS(1), 0ULL, NULL);
+	c = nvs_domain_create(sched, "c", MS(1), 0ULL, NULL);
+	unit_assert((a != NULL) && (b != NULL) && (c != NULL), goto out);
+	b->deadline_ns = MS(5);
+	c->deadline_ns = MS(2);
+
+	nvs_sched_set_algo(sched, &nvs_algo_edf);
+
+	nvs_domain_set_runnable(sched, a, true, 0ULL);
+	unit_assert(nvs_sched_schedule(sched, 0ULL) == a, goto out);
+
+	/* b is due at 5 ms, c at 3 ms */
+	nvs_domain_set_runnable(sched, b, true, 0ULL);
+	nvs_domain_set_runnable(sched, c, true, MS(1));
+	unit_assert(b->abs_deadline_ns == MS(5), goto out);
+	unit_assert(c->abs_deadline_ns == MS(3), goto out);
+	unit_assert(nvs_sched_schedule(sched, MS(1)) == c, goto out);
+
+	nvs_domain_set_runnable(sched, c, false, MS(2));
+	unit_assert(nvs_sched_schedule(sched, MS(2)) == b, goto out);
+
+	nvs_domain_set_runnable(sched, b, false, MS(3));
+	unit_assert(nvs_sched_schedule(sched, MS(3)) == a, goto out);
+
+	ret = UNIT_SUCCESS;
+out:
+	nvs_test_sched_destroy(g, sched);
+	return ret;
+}
+
+/*
+ * A simulated domain: a job of work_ns released every period_ns, or always
+ * busy if period_ns is 0. Jobs queue up in releases[] until they are done.
+ */
+struct nvs_sim_domain {
+	const char *name;
+	u64 timeslice_ns;
+	u64 period_ns;
+	u64 work_ns;
+	u64 deadline_ns;
+	u32 weight;
+
+	struct nvs_domain *dom;
+	u64 next_release;
+	u64 *releases;
+	u32 head;
+	u32 tail;
+	u64 head_left;
+	bool head_started;
+	u64 *latencies;
+	u32 nr_latencies;
+};
+
+#define NVS_SIM_CRITICAL	0U
+#define NVS_SIM_DOMAINS		5U
+#define NVS_SIM_LENGTH		MS(20000)
+
+static const struct nvs_sim_domain nvs_sim_workload[NVS_SIM_DOMAINS] = {
+	{ "critical", MS(2), 16666667ULL, 1500000ULL, MS(4), 1U },
+	{ "burst", MS(5), MS(50), MS(20), 0ULL, 1U },
+	{ "bg0", MS(8), 0ULL, 0ULL, 0ULL, 1U },
+	{ "bg1", MS(8), 0ULL, 0ULL, 0ULL, 1U },
+	{ "bg2", MS(8), 0ULL, 0ULL, 0ULL, 2U },
+};
+
+static int nvs_sim_cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a;
+	u64 y = *(const u64 *)b;
+
+	return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+static u32 nvs_sim_max_jobs(const struct nvs_sim_domain *sd)
+{
+	return (u32)(NVS_SIM_LENGTH / sd->period_ns) + 2U;
+}
+
+static void nvs_sim_release(struct nvs_sched *sched,
+		struct nvs_sim_domain *sd, u64 now)
+{
+	while (sd->next_release <= now) {
+		if (sd->head == sd->tail) {
+			sd->head_left = sd->work_ns;
+			sd->head_started = false;
+			nvs_domain_set_runnable(sched, sd->dom, true,
+					sd->next_release);
+		}
+		sd->releases[sd->tail++] = sd->next_release;
+		sd->next_release += sd->period_ns;
+	}
+}
+
+/*
+ * Let a periodic domain work through its queued jobs for up to a timeslice
+ * starting at now; it yields early when it runs out of work. Returns the time
+ * it ran.
+ */
+static u64 nvs_sim_dispatch(struct nvs_sched *sched,
+		struct nvs_sim_domain *sd, u64 now)
+{
+	u64 budget = sd->timeslice_ns;
+	u64 run = 0ULL;
+
+	while ((budget > 0ULL) && (sd->head != sd->tail)) {
+		u64 step = min(budget, sd->head_left);
+
+		if (!sd->head_started) {
+			sd->head_started = true;
+			if (sd->latencies != NULL) {
+				sd->latencies[sd->nr_latencies++] =
+					now + run - sd->releases[sd->head];
+			}
+		}
+
+		run += step;
+		budget -= step;
+		sd->head_left -= step;
+
+		if (sd->head_left == 0ULL) {
+			sd->head++;
+			sd->head_left = sd->work_ns;
+			sd->head_started = false;
+		}
+	}
+
+	if (sd->head == sd->tail) {
+		nvs_domain_set_runnable(sched, sd->dom, false, now + run);
+	}
+
+	return run;
+}
+
+static void nvs_sim_free(struct gk20a *g, struct nvs_sim_domain *sim)
+{
+	u32 i;
+
+	for (i = 0U; i < NVS_SIM_DOMAINS; i++) {
+		nvgpu_kfree(g, sim[i].releases);
+	}
+}
+
+/*
+ * Run the workload with algo; returns the sorted dispatch latencies of the
+ * critical domain in lat and their count in nr_lat.
+ */
+static int nvs_sim_run(struct unit_module *m, struct gk20a *g,
+		const struct nvs_domain_algo *algo, u64 *lat, u32 *nr_lat,
+		u64 *decision_ns)
+{
+	struct nvs_sim_domain sim[NVS_SIM_DOMAINS];
+	struct nvs_sched *sched;
+	u64 now = 0ULL;
+	u64 cpu_ns = 0ULL;
+	u64 decisions = 0ULL;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	sched = nvs_test_sched_create(m, g);
+	if (sched == NULL) {
+		return UNIT_FAIL;
+	}
+
+	for (i = 0U; i < NVS_SIM_DOMAINS; i++) {
+		sim[i] = nvs_sim_workload[i];
+	}
+
+	for (i = 0U; i < NVS_SIM_DOMAINS; i++) {
+		if (sim[i].period_ns != 0ULL) {
+			sim[i].releases = nvgpu_kzalloc(g,
+				nvs_sim_max_jobs(&sim[i]) * sizeof(u64));
+			unit_assert(sim[i].releases != NULL, goto out);
+		}
+		sim[i].dom = nvs_domain_create(sched, sim[i].name,
+				sim[i].timeslice_ns, 0ULL, &sim[i]);
+		unit_assert(sim[i].dom != NULL, goto out);
+		sim[i].dom->weight = sim[i].weight;
+		sim[i].dom->deadline_ns = sim[i].deadline_ns;
+	}
+	sim[NVS_SIM_CRITICAL].latencies = lat;
+
+	nvs_sched_set_algo(sched, algo);
+
+	for (i = 0U; i < NVS_SIM_DOMAINS; i++) {
+		if (sim[i].period_ns == 0ULL) {
+			nvs_domain_set_runnable(sched, sim[i].dom, true, now);
+		}
+	}
+
+	while (now < NVS_SIM_LENGTH) {
+		struct nvs_domain *dom;
+		struct nvs_sim_domain *sd;
+		u64 start;
+
+		for (i = 0U; i < NVS_SIM_DOMAINS; i++) {
+			if (sim[i].period_ns != 0ULL) {
+				nvs_sim_release(sched, &sim[i], now);
+			}
+		}
+
+		start = nvgpu_current_time_ns();
+		dom = nvs_sched_schedule(sched, now);
+		cpu_ns += nvgpu_current_time_ns() - start;
+		decisions++;
+
+		/* the background domains keep someone always runnable */
+		unit_assert(dom != NULL, goto out);
+		sd = dom->priv;
+
+		if (sd->period_ns == 0ULL) {
+			now += sd->timeslice_ns;
+		} else {
+			now += nvs_sim_dispatch(sched, sd, now);
+		}
+	}
+
+	*nr_lat = sim[NVS_SIM_CRITICAL].nr_latencies;
+	sort(lat, *nr_lat, sizeof(*lat), nvs_sim_cmp_u64, NULL);
+	*decision_ns = cpu_ns / decisions;
+
+	ret = UNIT_SUCCESS;
+out:
+	nvs_test_sched_destroy(g, sched);
+	nvs_sim_free(g, sim);
+	return ret;
+}
+
+int test_nvs_algo_sim(struct unit_module *m, struct gk20a *g, void *args)
+{
+	const struct nvs_domain_algo *algos[] = {
+		&nvs_algo_round_robin, &nvs_algo_wfq, &nvs_algo_edf,
+	};
+	u64 p99[3] = { 0ULL };
+	u64 worst[3] = { 0ULL };
+	u64 longest_slice = 0ULL;
+	u64 *lat;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	for (i = 0U; i < NVS_SIM_DOMAINS; i++) {
+		if (i != NVS_SIM_CRITICAL) {
+			longest_slice = max(longest_slice,
+					nvs_sim_workload[i].timeslice_ns);
+		}
+	}
+
+	lat = nvgpu_kzalloc(g, nvs_sim_max_jobs(
+			&nvs_sim_workload[NVS_SIM_CRITICAL]) * sizeof(*lat));
+	if (lat == NULL) {
+		unit_return_fail(m, "failed to allocate latency samples\n");
+	}
+
+	for (i = 0U; i < 3U; i++) {
+		u64 decision_ns = 0ULL;
+		u32 nr = 0U;
+
+		if (nvs_sim_run(m, g, algos[i], lat, &nr, &decision_ns) !=
+				UNIT_SUCCESS) {
+			goto out;
+		}
+		unit_assert(nr > 0U, goto out);
+
+		p99[i] = lat[(nr * 99U) / 100U];
+		worst[i] = lat[nr - 1U];
+
+		unit_info(m, "%-3s: %u jobs, dispatch latency p50 %llu us, "
+			"p99 %llu us, max %llu us; %llu ns per decision\n",
+			algos[i]->name, nr, lat[nr / 2U] / 1000ULL,
+			p99[i] / 1000ULL, worst[i] / 1000ULL, decision_ns);
+	}
+
+	unit_assert(worst[2] <= longest_slice, goto out);
+	unit_assert(p99[2] <= p99[0], goto out);
+
+	ret = UNIT_SUCCESS;
+out:
+	nvgpu_kfree(g, lat);
+	return ret;
+}
+
+struct unit_module_test nvsched_tests[] = {
+	UNIT_TEST(algo_rr,	test_nvs_algo_rr,	NULL, 0),
+	UNIT_TEST(algo_wfq,	test_nvs_algo_wfq,	NULL, 0),
+	UNIT_TEST(algo_edf,	test_nvs_algo_edf,	NULL, 0),
+	UNIT_TEST(algo_sim,	test_nvs_algo_sim,	NULL, 1),
+};
+
+UNIT_MODULE(nvsched, nvsched_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UNIT_NVSCHED_H
+#define UNIT_NVSCHED_H
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-nvsched
+ *  @{
+ *
+ * Software Unit Test Specification for the nvsched domain algorithms
+ */
+
+/**
+ * Test specification for: test_nvs_algo_rr
+ *
+ * Description: Verify that round-robin rotates through all domains.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_schedule, nvs_algo_by_name, nvs_domain_destroy
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Verify that nvs_algo_by_name() finds the built in algorithms and returns
+ *   NULL for an unknown name.
+ * - Create a scheduler with three domains, none of them runnable.
+ * - Call nvs_sched_schedule() four times and verify that the domains are
+ *   returned in list order, wrapping around to the first one.
+ * - Destroy the current domain and verify that the next call starts over
+ *   from the first domain.
+ *
+ * Output: Returns PASS if expected result is met, FAIL otherwise.
+ */
+int test_nvs_algo_rr(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_nvs_algo_wfq
+ *
+ * Description: Verify that weighted fair queuing shares time by weight and
+ * doesn't give credit for idle time.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_set_algo, nvs_sched_schedule, nvs_domain_set_runnable
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create domains A with weight 1, B with weight 3 and C with weight 1;
+ *   make A and B runnable and select the "wfq" algorithm.
+ * - Run 400 timeslices of 1 ms and verify that A gets 100 and B 300 of them,
+ *   give or take one, and that C never runs.
+ * - Make C runnable and verify that it is picked within the next two
+ *   timeslices, and that it gets its fair share of the next 50 timeslices
+ *   instead of running back to back to catch up.
+ * - Make all domains non-runnable and verify that nothing is picked.
+ *
+ * Output: Returns PASS if expected result is met, FAIL otherwise.
+ */
+int test_nvs_algo_wfq(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_nvs_algo_edf
+ *
+ * Description: Verify that earliest deadline first picks runnable domains by
+ * deadline and falls back to fair queuing for the rest.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_set_algo, nvs_sched_schedule, nvs_domain_set_runnable
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a background domain A without a deadline, and domains B and C with
+ *   deadlines of 5 ms and 2 ms; select the "edf" algorithm.
+ * - Make A runnable; verify that A is picked.
+ * - Make B runnable at 0 ms and C at 1 ms; verify that C, with the earlier
+ *   absolute deadline, is picked before B.
+ * - Make C non-runnable; verify that B is picked, and after B is made
+ *   non-runnable, that A is picked again.
+ *
+ * Output: Returns PASS if expected result is met, FAIL otherwise.
+ */
+int test_nvs_algo_edf(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_nvs_algo_sim
+ *
+ * Description: Replay a mixed domain workload against each algorithm and
+ * report the dispatch latency of a latency critical domain.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_schedule, nvs_domain_set_runnable
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For each of "rr", "wfq" and "edf", simulate 20 s of virtual time with:
+ *   - a periodic critical domain (60 Hz, 3 ms of work, 2 ms timeslice and a
+ *     4 ms deadline),
+ *   - a bursty domain (20 Hz, 20 ms of work, 5 ms timeslice) and
+ *   - three always busy background domains with 8 ms timeslices.
+ *   Domains yield when they run out of work. Record the time from the release
+ *   of each critical job to the first dispatch of the critical domain.
+ * - Report the median, 99th percentile and maximum latency and the average
+ *   CPU cost of a scheduling decision.
+ * - Verify that the maximum latency under "edf" is bounded by the longest
+ *   timeslice of the other domains, and that its 99th percentile is not worse
+ *   than with "rr".
+ *
+ * Output: Returns PASS if expected result is met, FAIL otherwise.
+ */
+int test_nvs_algo_sim(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * @}
+ */
+
+#endif /* UNIT_NVSCHED_H */
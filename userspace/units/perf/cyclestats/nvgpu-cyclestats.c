@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/channel.h>
+#include <nvgpu/cyclestats_snapshot.h>
+
+#include "nvgpu-cyclestats.h"
+
+/* HW buffer of the stubbed css HAL, in entries */
+#define CSS_TEST_HW_ENTRIES	64U
+/* entries in the buffer of a copy client */
+#define CSS_TEST_COPY_ENTRIES	16U
+
+#define CSS_TEST_ENTRY_SIZE	\
+	U32(sizeof(struct gk20a_cs_snapshot_fifo_entry))
+#define CSS_TEST_HDR_SIZE	U32(sizeof(struct gk20a_cs_snapshot_fifo))
+#define CSS_TEST_OFFSET(n)	((n) * CSS_TEST_ENTRY_SIZE)
+
+/* first perfmon ID handed out by nvgpu_css_allocate_perfmon_ids() */
+#define CSS_TEST_FIRST_PERFMON	32U
+
+static struct gk20a_cs_snapshot_fifo_entry *css_test_hw;
+/* entries completed by "HW" and entries handed back to it */
+static u32 css_test_written;
+static u32 css_test_handled;
+/* make enable_snapshot leave the HW buffer unset, as in the virtual case */
+static bool css_test_no_hw;
+
+static struct nvgpu_channel css_test_ch;
+
+static int css_test_enable_snapshot(struct nvgpu_channel *ch,
+				struct gk20a_cs_snapshot_client *client)
+{
+	struct gk20a_cs_snapshot *data = ch->g->cs_data;
+
+	(void)client;
+
+	if (data->hw_snapshot != NULL || css_test_no_hw) {
+		return 0;
+	}
+
+	(void) memset(css_test_hw, 0xff,
+		CSS_TEST_HW_ENTRIES * sizeof(*css_test_hw));
+	data->hw_snapshot = css_test_hw;
+	data->hw_end = css_test_hw + CSS_TEST_HW_ENTRIES;
+	data->hw_get = css_test_hw;
+	data->hw_scan = css_test_hw;
+	css_test_written = 0U;
+	css_test_handled = 0U;
+
+	return 0;
+}
+
+static void css_test_disable_snapshot(struct gk20a *g)
+{
+	g->cs_data->hw_snapshot = NULL;
+}
+
+static int css_test_check_data_available(struct nvgpu_channel *ch,
+				u32 *pending, bool *hw_overflow)
+{
+	if (ch->g->cs_data->hw_snapshot == NULL) {
+		return -EINVAL;
+	}
+
+	*pending = css_test_written - css_test_handled;
+	*hw_overflow = false;
+
+	return 0;
+}
+
+static void css_test_set_handled_snapshots(struct gk20a *g, u32 num)
+{
+	(void)g;
+
+	css_test_handled += num;
+}
+
+/* complete the next HW entry for perfmon pm */
+static void css_test_complete(u32 pm)
+{
+	struct gk20a_cs_snapshot_fifo_entry *e =
+		&css_test_hw[css_test_written % CSS_TEST_HW_ENTRIES];
+
+	(void) memset(e, 0, sizeof(*e));
+	e->perfmon_id = pm;
+	e->event_cnt = css_test_written;
+	css_test_written++;
+}
+
+static int css_test_setup(struct unit_module *m, struct gk20a *g)
+{
+	css_test_hw = malloc(CSS_TEST_HW_ENTRIES * sizeof(*css_test_hw));
+	if (css_test_hw == NULL) {
+		unit_err(m, "failed to allocate the HW buffer\n");
+		return UNIT_FAIL;
+	}
+
+	g->ops.css.enable_snapshot = css_test_enable_snapshot;
+	g->ops.css.disable_snapshot = css_test_disable_snapshot;
+	g->ops.css.check_data_available = css_test_check_data_available;
+	g->ops.css.set_handled_snapshots = css_test_set_handled_snapshots;
+	g->ops.css.allocate_perfmon_ids = nvgpu_css_allocate_perfmon_ids;
+	g->ops.css.release_perfmon_ids = nvgpu_css_release_perfmon_ids;
+	g->ops.css.detach_snapshot = NULL;
+
+	nvgpu_mutex_init(&g->cs_lock);
+	css_test_ch.g = g;
+	css_test_no_hw = false;
+
+	return UNIT_SUCCESS;
+}
+
+static void css_test_teardown(struct gk20a *g)
+{
+	nvgpu_mutex_destroy(&g->cs_lock);
+	free(css_test_hw);
+	css_test_hw = NULL;
+}
+
+static int css_test_alloc_client(struct gk20a_cs_snapshot_client *client,
+				u32 entries)
+{
+	(void) memset(client, 0, sizeof(*client));
+	client->snapshot_size = CSS_TEST_HDR_SIZE +
+				CSS_TEST_OFFSET(entries);
+	client->snapshot = malloc(client->snapshot_size);
+
+	return client->snapshot != NULL ? 0 : -ENOMEM;
+}
+
+int test_css_attach(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct gk20a_cs_snapshot_client copy = { };
+	struct gk20a_cs_snapshot_client cursor = { };
+	struct gk20a_cs_snapshot_fifo *hdr;
+	u32 start = 0U;
+	int ret = UNIT_FAIL;
+	int err;
+
+	if (css_test_setup(m, g) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	unit_assert(css_test_alloc_client(&copy,
+			CSS_TEST_COPY_ENTRIES) == 0, goto done);
+	unit_assert(css_test_alloc_client(&cursor, 0U) == 0, goto done);
+
+	err = nvgpu_css_attach(&css_test_ch, 1U, &start, 0U, &copy);
+	unit_assert(err == 0, goto done);
+	unit_assert(start == CSS_TEST_FIRST_PERFMON, goto done);
+	unit_assert(!copy.hw_cursor, goto done);
+	hdr = copy.snapshot;
+	unit_assert(hdr->start == CSS_TEST_HDR_SIZE, goto done);
+	unit_assert(hdr->end == CSS_TEST_HDR_SIZE +
+			CSS_TEST_OFFSET(CSS_TEST_COPY_ENTRIES), goto done);
+	unit_assert(hdr->put == hdr->start && hdr->get == hdr->start,
+			goto done);
+
+	err = nvgpu_css_attach(&css_test_ch, 1U, &start,
+			NVGPU_CSS_ATTACH_HW_CURSOR, &cursor);
+	unit_assert(err == 0, goto done);
+	unit_assert(start == CSS_TEST_FIRST_PERFMON + 1U, goto done);
+	unit_assert(cursor.hw_cursor, goto done);
+	unit_assert(g->cs_data->cursor_clients == 1U, goto done);
+	hdr = cursor.snapshot;
+	unit_assert(hdr->start == 0U, goto done);
+	unit_assert(hdr->end == CSS_TEST_OFFSET(CSS_TEST_HW_ENTRIES),
+			goto done);
+	unit_assert(hdr->put == 0U && hdr->get == 0U, goto done);
+
+	unit_assert(nvgpu_css_detach(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(g->cs_data->cursor_clients == 0U, goto done);
+	unit_assert(nvgpu_css_detach(&css_test_ch, &copy) == 0, goto done);
+	unit_assert(g->cs_data == NULL, goto done);
+
+	/* no HW buffer to point into */
+	css_test_no_hw = true;
+	err = nvgpu_css_attach(&css_test_ch, 1U, &start,
+			NVGPU_CSS_ATTACH_HW_CURSOR, &cursor);
+	unit_assert(err == -EINVAL, goto done);
+	unit_assert(start == 0U, goto done);
+	unit_assert(g->cs_data == NULL, goto done);
+	css_test_no_hw = false;
+
+	/* the same client without the flag copies again */
+	err = nvgpu_css_attach(&css_test_ch, 1U, &start, 0U, &cursor);
+	unit_assert(err == 0, goto done);
+	unit_assert(start == CSS_TEST_FIRST_PERFMON, goto done);
+	unit_assert(!cursor.hw_cursor, goto done);
+	unit_assert(g->cs_data->cursor_clients == 0U, goto done);
+	unit_assert(cursor.snapshot->start == CSS_TEST_HDR_SIZE, goto done);
+	unit_assert(nvgpu_css_detach(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(g->cs_data == NULL, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	if (g->cs_data != NULL) {
+		(void) nvgpu_css_detach(&css_test_ch, &cursor);
+		(void) nvgpu_css_detach(&css_test_ch, &copy);
+	}
+	free(copy.snapshot);
+	free(cursor.snapshot);
+	css_test_teardown(g);
+	return ret;
+}
+
+int test_css_hw_cursor(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct gk20a_cs_snapshot_client copy = { };
+	struct gk20a_cs_snapshot_client cursor = { };
+	struct gk20a_cs_snapshot_fifo_entry *e;
+	struct gk20a_cs_snapshot *data;
+	u32 copy_pm, cursor_pm;
+	u32 i;
+	int ret = UNIT_FAIL;
+
+	if (css_test_setup(m, g) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	unit_assert(css_test_alloc_client(&copy,
+			CSS_TEST_COPY_ENTRIES) == 0, goto done);
+	unit_assert(css_test_alloc_client(&cursor, 0U) == 0, goto done);
+	unit_assert(nvgpu_css_attach(&css_test_ch, 1U, &copy_pm, 0U,
+			&copy) == 0, goto done);
+	unit_assert(nvgpu_css_attach(&css_test_ch, 1U, &cursor_pm,
+			NVGPU_CSS_ATTACH_HW_CURSOR, &cursor) == 0, goto done);
+	data = g->cs_data;
+
+	/* 8 entries, every other one for the copy client */
+	for (i = 0U; i < 8U; i++) {
+		css_test_complete((i & 1U) != 0U ? cursor_pm : copy_pm);
+	}
+	unit_assert(nvgpu_css_flush(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(copy.snapshot->put == CSS_TEST_HDR_SIZE +
+			CSS_TEST_OFFSET(4U), goto done);
+	for (i = 0U; i < 4U; i++) {
+		e = (struct gk20a_cs_snapshot_fifo_entry *)
+			((char *)copy.snapshot + CSS_TEST_HDR_SIZE +
+				CSS_TEST_OFFSET(i));
+		unit_assert(e->perfmon_id == copy_pm, goto done);
+		unit_assert(e->event_cnt == i * 2U, goto done);
+	}
+	unit_assert(cursor.snapshot->put == CSS_TEST_OFFSET(8U), goto done);
+	unit_assert(cursor.snapshot->get == 0U, goto done);
+	unit_assert(css_test_handled == 0U, goto done);
+	unit_assert(css_test_hw[0].zero0 == 0U, goto done);
+
+	/* the cursor read 4 entries, exactly those go back to HW */
+	cursor.snapshot->get = CSS_TEST_OFFSET(4U);
+	unit_assert(nvgpu_css_flush(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(css_test_handled == 4U, goto done);
+	unit_assert(data->hw_get == &css_test_hw[4], goto done);
+	unit_assert(css_test_hw[3].zero0 == 1U, goto done);
+	unit_assert(css_test_hw[4].zero0 == 0U, goto done);
+	unit_assert(copy.snapshot->put == CSS_TEST_HDR_SIZE +
+			CSS_TEST_OFFSET(4U), goto done);
+
+	/* lag by 37 entries, more than half of the HW buffer */
+	for (i = 0U; i < 33U; i++) {
+		css_test_complete(cursor_pm);
+	}
+	unit_assert(nvgpu_css_flush(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(cursor.snapshot->put == CSS_TEST_OFFSET(41U), goto done);
+	unit_assert(cursor.snapshot->get == CSS_TEST_OFFSET(9U), goto done);
+	unit_assert(cursor.snapshot->sw_overflow_events_occured == 1U,
+			goto done);
+	unit_assert(css_test_handled == 9U, goto done);
+	unit_assert(data->hw_get == &css_test_hw[9], goto done);
+
+	/* a cursor outside of the held entries restarts at put */
+	cursor.snapshot->get = CSS_TEST_OFFSET(9U) + 3U;
+	unit_assert(nvgpu_css_flush(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(cursor.snapshot->get == CSS_TEST_OFFSET(41U), goto done);
+	unit_assert(cursor.snapshot->sw_overflow_events_occured == 2U,
+			goto done);
+	unit_assert(css_test_handled == 41U, goto done);
+	unit_assert(data->hw_get == data->hw_scan, goto done);
+
+	/* 30 entries across the end of the HW buffer */
+	for (i = 0U; i < 30U; i++) {
+		css_test_complete(cursor_pm);
+	}
+	unit_assert(nvgpu_css_flush(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(cursor.snapshot->put == CSS_TEST_OFFSET(7U), goto done);
+	unit_assert(css_test_handled == 41U, goto done);
+
+	cursor.snapshot->get = cursor.snapshot->put;
+	unit_assert(nvgpu_css_flush(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(css_test_handled == 71U, goto done);
+	unit_assert(data->hw_get == &css_test_hw[7], goto done);
+	unit_assert(data->hw_scan == &css_test_hw[7], goto done);
+	for (i = 0U; i < CSS_TEST_HW_ENTRIES; i++) {
+		unit_assert(css_test_hw[i].zero0 == 1U, goto done);
+	}
+	unit_assert(cursor.snapshot->sw_overflow_events_occured == 2U,
+			goto done);
+
+	/* without cursors entries go back to HW as they are copied */
+	unit_assert(nvgpu_css_detach(&css_test_ch, &cursor) == 0, goto done);
+	unit_assert(data->cursor_clients == 0U, goto done);
+	css_test_complete(copy_pm);
+	css_test_complete(copy_pm);
+	unit_assert(nvgpu_css_flush(&css_test_ch, &copy) == 0, goto done);
+	unit_assert(copy.snapshot->put == CSS_TEST_HDR_SIZE +
+			CSS_TEST_OFFSET(6U), goto done);
+	unit_assert(css_test_handled == 73U, goto done);
+	unit_assert(data->hw_get == data->hw_scan, goto done);
+
+	unit_assert(nvgpu_css_detach(&css_test_ch, &copy) == 0, goto done);
+	unit_assert(g->cs_data == NULL, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	if (g->cs_data != NULL) {
+		(void) nvgpu_css_detach(&css_test_ch, &cursor);
+		(void) nvgpu_css_detach(&css_test_ch, &copy);
+	}
+	free(copy.snapshot);
+	free(cursor.snapshot);
+	css_test_teardown(g);
+	return ret;
+}
+
+struct unit_module_test nvgpu_cyclestats_tests[] = {
+	UNIT_TEST(attach, test_css_attach, NULL, 0),
+	UNIT_TEST(hw_cursor, test_css_hw_cursor, NULL, 0),
+};
+
+UNIT_MODULE(nvgpu_cyclestats, nvgpu_cyclestats_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UNIT_NVGPU_CYCLESTATS_H
+#define UNIT_NVGPU_CYCLESTATS_H
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-cyclestats
+ *  @{
+ *
+ * Software Unit Test Specification for common.perf.cyclestats_snapshot
+ */
+
+/**
+ * Test specification for: test_css_attach
+ *
+ * Description: Attach flags select the client mode.
+ *
+ * Test Type: Feature, Error injection
+ *
+ * Targets: nvgpu_css_attach, nvgpu_css_detach
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Stub the css HAL with a 64 entry HW buffer in system memory.
+ * - Attach a client without flags and check that its fifo header describes
+ *   its own buffer.
+ * - Attach a client with NVGPU_CSS_ATTACH_HW_CURSOR and check that its fifo
+ *   header describes the HW buffer with put and get at the next entry.
+ * - Detach both, make enable_snapshot leave the HW buffer unset and check
+ *   that a cursor attach fails with -EINVAL, releases its perfmon IDs and
+ *   frees the shared data.
+ *
+ * Output: Returns PASS if each attach sets up the expected header. FAIL
+ * otherwise.
+ */
+int test_css_attach(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_css_hw_cursor
+ *
+ * Description: HW entries are held until every cursor client read them.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_css_attach, nvgpu_css_flush, nvgpu_css_detach
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Stub the css HAL with a 64 entry HW buffer and attach a copy client
+ *   and a cursor client.
+ * - Complete 8 HW entries for the two clients in turn and flush. Check that
+ *   the copy client got its 4 entries, that the cursor put moved past all 8
+ *   and that nothing was handed back to HW.
+ * - Move the cursor get by 4 entries and flush. Check that exactly those 4
+ *   entries are handed back and reset.
+ * - Complete 33 cursor entries so that the cursor lags by more than half
+ *   the buffer and flush. Check that the cursor get is moved to half a
+ *   buffer behind put, a sw overflow is counted and the rest is released.
+ * - Set an unaligned cursor get and flush. Check that the cursor restarts
+ *   at put with another sw overflow and that all entries are released.
+ * - Complete 30 entries across the end of the HW buffer, flush, read them
+ *   all and flush again. Check that put wraps and all entries are released
+ *   and reset.
+ * - Detach the cursor client and check that new entries are handed back in
+ *   the flush that copies them.
+ *
+ * Output: Returns PASS if the cursor and copy clients see the expected
+ * entries and HW gets back the expected counts. FAIL otherwise.
+ */
+int test_css_hw_cursor(struct unit_module *m, struct gk20a *g, void *args);
+
+/** @} */
+#endif /* UNIT_NVGPU_CYCLESTATS_H */
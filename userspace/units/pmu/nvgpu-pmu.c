@@ -43,6 +43,23 @@
 #include <nvgpu/hw/gv11b/hw_pwr_gv11b.h>
 #include <nvgpu/hw/gv11b/hw_pwr_gv11b.h>
 
+#ifdef CONFIG_NVGPU_LS_PMU
+#include <nvgpu/atomic.h>
+#include <nvgpu/enabled.h>
+#include <nvgpu/engine_queue.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/string.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/pmu/allocator.h>
+#include <nvgpu/pmu/cmd.h>
+#include <nvgpu/pmu/fw.h>
+#include <nvgpu/pmu/msg.h>
+#include <nvgpu/pmu/pmu_perfmon.h>
+#include <nvgpu/pmu/queue.h>
+#include <nvgpu/pmu/seq.h>
+#include <nvgpu/pmu/pmuif/perfmon.h>
+#endif
+
 #include "hal/pmu/pmu_gk20a.h"
 
 #include "../falcon/falcon_utf.h"
@@ -726,6 +743,438 @@ int test_is_pmu_supported(struct unit_module *m,
 	return UNIT_SUCCESS;
 
 }
+#ifdef CONFIG_NVGPU_LS_PMU
+/* APP_VERSION_GV11B, selects the fw ops of the stand-in PMU. */
+#define PMU_RPC_TEST_APP_VERSION	25005711U
+/* DMEM layout the stand-in PMU reports in its init message. */
+#define PMU_RPC_TEST_QUEUE_OFFSET	0x100U
+#define PMU_RPC_TEST_QUEUE_SIZE		0x100U
+#define PMU_RPC_TEST_HEAP_OFFSET	0x1000U
+#define PMU_RPC_TEST_HEAP_SIZE		0x4000U
+/* RPCs posted before the stand-in PMU serves them, fits in the queues. */
+#define PMU_RPC_TEST_BATCH		8U
+#define PMU_RPC_TEST_ROUNDS		64U
+/* Round trip the stand-in PMU takes to serve its queue in the benchmark. */
+#define PMU_RPC_TEST_LATENCY_US		50U
+#define PMU_RPC_TEST_BENCH_RPCS		1024U
+
+static struct nvgpu_pmu rpc_test_pmu;
+static struct pmu_rtos_fw rpc_test_fw;
+static struct nvgpu_pmu_perfmon rpc_test_perfmon;
+/* flcn_status the stand-in PMU puts in the RPCs it serves */
+static u32 rpc_test_flcn_status;
+
+struct rpc_test_done {
+	u32 count;
+	u32 errors;
+	int last_status;
+};
+
+static void rpc_test_done_cb(struct gk20a *g, struct nv_pmu_rpc_header *rpc,
+	void *param, int status)
+{
+	struct rpc_test_done *done = param;
+
+	done->count++;
+	if (status != 0) {
+		done->errors++;
+	}
+	done->last_status = status;
+}
+
+static void rpc_test_dmem_read(u32 offset, void *data, u32 size)
+{
+	nvgpu_memcpy((u8 *)data, (u8 *)pmu_flcn->dmem + offset, size);
+}
+
+static void rpc_test_dmem_write(u32 offset, void *data, u32 size)
+{
+	nvgpu_memcpy((u8 *)pmu_flcn->dmem + offset, (u8 *)data, size);
+}
+
+/*
+ * Queue layout of the init message: HPQ, LPQ and message queue are placed
+ * back to back from PMU_RPC_TEST_QUEUE_OFFSET.
+ */
+static u32 rpc_test_queue_offset(u32 idx)
+{
+	return PMU_RPC_TEST_QUEUE_OFFSET + (idx * PMU_RPC_TEST_QUEUE_SIZE);
+}
+
+/*
+ * Stand-in for the PMU firmware: serve every command queued on the LPQ the
+ * way the RTOS does. The RPC in DMEM gets rpc_test_flcn_status and a reply
+ * is posted on the message queue, rewinding both queues when they wrap.
+ * Returns the number of RPCs served.
+ */
+static u32 rpc_test_serve(struct gk20a *g)
+{
+	u32 cmdq_start = rpc_test_queue_offset(PMU_QUEUE_LPQ_IDX_FOR_V3);
+	u32 msgq_start = rpc_test_queue_offset(PMU_QUEUE_MSG_IDX_FOR_V3);
+	u32 msgq_end = msgq_start + PMU_RPC_TEST_QUEUE_SIZE;
+	u32 head = 0U, tail = 0U, msgq_head = 0U;
+	struct nv_pmu_rpc_header rpc;
+	struct pmu_cmd cmd;
+	struct pmu_msg msg;
+	u32 served = 0U;
+	u32 size;
+
+	g->ops.pmu.pmu_queue_head(g, PMU_COMMAND_QUEUE_LPQ,
+		PMU_QUEUE_LPQ_IDX_FOR_V3, &head, QUEUE_GET);
+	g->ops.pmu.pmu_queue_tail(g, PMU_COMMAND_QUEUE_LPQ,
+		PMU_QUEUE_LPQ_IDX_FOR_V3, &tail, QUEUE_GET);
+	g->ops.pmu.pmu_queue_head(g, PMU_MESSAGE_QUEUE, 0U, &msgq_head,
+		QUEUE_GET);
+
+	while (tail != head) {
+		rpc_test_dmem_read(tail, &cmd.hdr, PMU_CMD_HDR_SIZE);
+		if (cmd.hdr.unit_id == PMU_UNIT_REWIND) {
+			tail = cmdq_start;
+			continue;
+		}
+		rpc_test_dmem_read(tail, &cmd, cmd.hdr.size);
+		tail += NVGPU_ALIGN(U32(cmd.hdr.size), QUEUE_ALIGNMENT);
+
+		rpc_test_dmem_read(cmd.cmd.rpc.rpc_dmem_ptr, &rpc, sizeof(rpc));
+		rpc.flcn_status = (falcon_status)rpc_test_flcn_status;
+		rpc_test_dmem_write(cmd.cmd.rpc.rpc_dmem_ptr, &rpc, sizeof(rpc));
+
+		(void) memset(&msg, 0, sizeof(msg));
+		msg.hdr.unit_id = cmd.hdr.unit_id;
+		msg.hdr.seq_id = cmd.hdr.seq_id;
+		msg.hdr.size = (u8)(PMU_MSG_HDR_SIZE +
+			sizeof(struct nv_pmu_rpc_msg));
+		msg.msg.rpc.msg_type = NV_PMU_RPC_MSG_ID;
+		msg.msg.rpc.rpc_dmem_size = cmd.cmd.rpc.rpc_dmem_size;
+		msg.msg.rpc.rpc_dmem_ptr = cmd.cmd.rpc.rpc_dmem_ptr;
+
+		size = NVGPU_ALIGN(U32(msg.hdr.size), QUEUE_ALIGNMENT);
+		if ((msgq_head + size + PMU_MSG_HDR_SIZE) > msgq_end) {
+			struct pmu_hdr rewind = { .unit_id = PMU_UNIT_REWIND,
+				.size = (u8)PMU_MSG_HDR_SIZE };
+
+			rpc_test_dmem_write(msgq_head, &rewind,
+				PMU_MSG_HDR_SIZE);
+			msgq_head = msgq_start;
+		}
+		rpc_test_dmem_write(msgq_head, &msg, msg.hdr.size);
+		msgq_head += size;
+		served++;
+	}
+
+	g->ops.pmu.pmu_queue_tail(g, PMU_COMMAND_QUEUE_LPQ,
+		PMU_QUEUE_LPQ_IDX_FOR_V3, &tail, QUEUE_SET);
+	g->ops.pmu.pmu_queue_head(g, PMU_MESSAGE_QUEUE, 0U, &msgq_head,
+		QUEUE_SET);
+
+	return served;
+}
+
+/* Serve the LPQ and let the driver handle the replies, as its ISR would. */
+static int rpc_test_respond(struct gk20a *g, u32 *served)
+{
+	*served = rpc_test_serve(g);
+
+	return nvgpu_pmu_process_message(g->pmu);
+}
+
+static int rpc_test_env_init(struct unit_module *m, struct gk20a *g)
+{
+	struct nvgpu_pmu *pmu = &rpc_test_pmu;
+	union pmu_init_msg_pmu init;
+	u32 i, offset;
+	int err;
+
+	utf_falcon_register_io(g);
+
+	if (nvgpu_posix_io_add_reg_space(g, fuse_opt_priv_sec_en_r(),
+			0x4) != 0) {
+		unit_return_fail(m, "Add reg space failed!\n");
+	}
+	if (nvgpu_posix_io_add_reg_space(g, pwr_pmu_queue_head_r(0),
+			0x40) != 0) {
+		unit_return_fail(m, "Add reg space failed!\n");
+	}
+	if (nvgpu_posix_io_add_reg_space(g, pwr_pmu_msgq_head_r(),
+			0x8) != 0) {
+		unit_return_fail(m, "Add reg space failed!\n");
+	}
+
+	err = nvgpu_init_hal(g);
+	if (err != 0) {
+		unit_return_fail(m, "HAL init failed\n");
+	}
+
+	if (pmu_flcn == NULL) {
+		pmu_flcn = nvgpu_utf_falcon_init(m, g, FALCON_ID_PMU);
+		if (pmu_flcn == NULL) {
+			unit_return_fail(m, "falcon init failed\n");
+		}
+	}
+
+	(void) memset(pmu, 0, sizeof(*pmu));
+	(void) memset(&rpc_test_fw, 0, sizeof(rpc_test_fw));
+	(void) memset(&rpc_test_perfmon, 0, sizeof(rpc_test_perfmon));
+	pmu->g = g;
+	pmu->flcn = pmu_flcn->flcn;
+	pmu->fw = &rpc_test_fw;
+	pmu->pmu_perfmon = &rpc_test_perfmon;
+	g->pmu = pmu;
+
+	err = nvgpu_pmu_init_fw_ver_ops(g, pmu, PMU_RPC_TEST_APP_VERSION);
+	if (err != 0) {
+		unit_return_fail(m, "fw ver ops init failed\n");
+	}
+
+	err = nvgpu_pmu_sequences_init(g, pmu, &pmu->sequences);
+	if (err != 0) {
+		unit_return_fail(m, "sequences init failed\n");
+	}
+	nvgpu_pmu_sequences_sw_setup(g, pmu, pmu->sequences);
+
+	err = nvgpu_pmu_rpc_pool_init(g, pmu);
+	if (err != 0) {
+		unit_return_fail(m, "RPC pool init failed\n");
+	}
+
+	/* what the PMU would report in its init message */
+	(void) memset(&init, 0, sizeof(init));
+	for (i = 0U; i < PMU_QUEUE_COUNT_FOR_V3; i++) {
+		init.v4.queue_index[i] = (u8)i;
+		init.v4.queue_size[i] = (u16)PMU_RPC_TEST_QUEUE_SIZE;
+	}
+	init.v4.queue_offset = (u16)PMU_RPC_TEST_QUEUE_OFFSET;
+	init.v4.sw_managed_area_offset = (u16)PMU_RPC_TEST_HEAP_OFFSET;
+	init.v4.sw_managed_area_size = (u16)PMU_RPC_TEST_HEAP_SIZE;
+
+	err = nvgpu_pmu_queues_init(g, &init, &pmu->queues, NULL);
+	if (err != 0) {
+		unit_return_fail(m, "queues init failed\n");
+	}
+	nvgpu_pmu_allocator_dmem_init(g, pmu, &pmu->dmem, &init);
+
+	/* queues start out empty */
+	offset = rpc_test_queue_offset(PMU_QUEUE_LPQ_IDX_FOR_V3);
+	g->ops.pmu.pmu_queue_head(g, PMU_COMMAND_QUEUE_LPQ,
+		PMU_QUEUE_LPQ_IDX_FOR_V3, &offset, QUEUE_SET);
+	g->ops.pmu.pmu_queue_tail(g, PMU_COMMAND_QUEUE_LPQ,
+		PMU_QUEUE_LPQ_IDX_FOR_V3, &offset, QUEUE_SET);
+	offset = rpc_test_queue_offset(PMU_QUEUE_MSG_IDX_FOR_V3);
+	g->ops.pmu.pmu_queue_head(g, PMU_MESSAGE_QUEUE, 0U, &offset,
+		QUEUE_SET);
+	g->ops.pmu.pmu_queue_tail(g, PMU_MESSAGE_QUEUE, 0U, &offset,
+		QUEUE_SET);
+
+	rpc_test_flcn_status = 0U;
+	nvgpu_pmu_set_fw_ready(g, pmu, true);
+
+	return UNIT_SUCCESS;
+}
+
+static void rpc_test_env_free(struct gk20a *g)
+{
+	struct nvgpu_pmu *pmu = &rpc_test_pmu;
+
+	nvgpu_pmu_rpc_pool_deinit(g, pmu);
+	nvgpu_pmu_allocator_dmem_destroy(&pmu->dmem);
+	nvgpu_pmu_queues_free(g, &pmu->queues);
+	nvgpu_pmu_sequences_deinit(g, pmu, pmu->sequences);
+	nvgpu_posix_io_delete_reg_space(g, pwr_pmu_msgq_head_r());
+	nvgpu_posix_io_delete_reg_space(g, pwr_pmu_queue_head_r(0));
+	nvgpu_posix_io_delete_reg_space(g, fuse_opt_priv_sec_en_r());
+	g->pmu = NULL;
+}
+
+static int rpc_test_post(struct nvgpu_pmu *pmu, struct rpc_test_done *done)
+{
+	struct nv_pmu_rpc_struct_perfmon_start rpc;
+	int status = 0;
+
+	(void) memset(&rpc, 0, sizeof(rpc));
+	PMU_RPC_EXECUTE_ASYNC(status, pmu, PERFMON_T18X, START, &rpc, 0,
+		rpc_test_done_cb, done);
+
+	return status;
+}
+
+int test_pmu_rpc_async(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_pmu *pmu = &rpc_test_pmu;
+	struct nvgpu_kmem_cache_stats stats;
+	struct rpc_test_done done;
+	u32 i, j, served;
+	int ret = UNIT_FAIL;
+	int err;
+
+	if (rpc_test_env_init(m, g) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	/* 1) batches in flight at once, enough rounds to wrap both queues */
+	(void) memset(&done, 0, sizeof(done));
+	for (i = 0U; i < PMU_RPC_TEST_ROUNDS; i++) {
+		for (j = 0U; j < PMU_RPC_TEST_BATCH; j++) {
+			err = rpc_test_post(pmu, &done);
+			unit_assert(err == 0, goto done);
+		}
+		unit_assert(nvgpu_atomic_read(&pmu->rpc_in_flight) ==
+			(int)PMU_RPC_TEST_BATCH, goto done);
+		unit_assert(done.count == (i * PMU_RPC_TEST_BATCH),
+			goto done);
+
+		err = rpc_test_respond(g, &served);
+		unit_assert(err == 0, goto done);
+		unit_assert(served == PMU_RPC_TEST_BATCH, goto done);
+		unit_assert(nvgpu_atomic_read(&pmu->rpc_in_flight) == 0,
+			goto done);
+	}
+	unit_assert(done.count == (PMU_RPC_TEST_ROUNDS * PMU_RPC_TEST_BATCH),
+		goto done);
+	unit_assert(done.errors == 0U, goto done);
+	nvgpu_kmem_cache_get_stats(pmu->rpc_payload_cache, &stats);
+	unit_assert(stats.in_use == 0ULL, goto done);
+	unit_assert(nvgpu_pmu_rpc_wait_idle(pmu, 0U) == 0, goto done);
+
+	/* 2) a failed RPC is reported to done */
+	(void) memset(&done, 0, sizeof(done));
+	rpc_test_flcn_status = 1U;
+	err = rpc_test_post(pmu, &done);
+	unit_assert(err == 0, goto done);
+	err = rpc_test_respond(g, &served);
+	unit_assert(err == 0, goto done);
+	rpc_test_flcn_status = 0U;
+	unit_assert((done.count == 1U) && (done.last_status == -EIO),
+		goto done);
+
+	/* 3) done is also called when the RPC cannot be posted */
+	(void) memset(&done, 0, sizeof(done));
+	nvgpu_pmu_set_fw_ready(g, pmu, false);
+	err = rpc_test_post(pmu, &done);
+	nvgpu_pmu_set_fw_ready(g, pmu, true);
+	unit_assert(err == -EINVAL, goto done);
+	unit_assert((done.count == 1U) && (done.last_status == -EINVAL),
+		goto done);
+
+	/* 4) and when the GPU is going away, though that is not an error */
+	(void) memset(&done, 0, sizeof(done));
+	nvgpu_set_enabled(g, NVGPU_DRIVER_IS_DYING, true);
+	err = rpc_test_post(pmu, &done);
+	nvgpu_set_enabled(g, NVGPU_DRIVER_IS_DYING, false);
+	unit_assert(err == 0, goto done);
+	unit_assert((done.count == 1U) && (done.last_status == -ENODEV),
+		goto done);
+	unit_assert(nvgpu_atomic_read(&pmu->rpc_in_flight) == 0, goto done);
+
+	/* 5) the perfmon sampling RPCs go through the same path */
+	nvgpu_set_enabled(g, NVGPU_PMU_PERFMON, true);
+	err = nvgpu_pmu_perfmon_start_sampling_rpc(pmu);
+	unit_assert(err == 0, goto done);
+	err = nvgpu_pmu_perfmon_stop_sampling_rpc(pmu);
+	unit_assert(err == 0, goto done);
+	unit_assert(nvgpu_atomic_read(&pmu->rpc_in_flight) == 2, goto done);
+	err = rpc_test_respond(g, &served);
+	unit_assert((err == 0) && (served == 2U), goto done);
+	unit_assert(nvgpu_atomic_read(&pmu->rpc_in_flight) == 0, goto done);
+
+	/*
+	 * 6) the payload pool is not freed under an outstanding RPC; once it
+	 * completes, the pool goes away.
+	 */
+	(void) memset(&done, 0, sizeof(done));
+	err = rpc_test_post(pmu, &done);
+	unit_assert(err == 0, goto done);
+	unit_assert(nvgpu_pmu_rpc_wait_idle(pmu, 10U) == -ETIMEDOUT,
+		goto done);
+	g->poll_timeout_default = 10U;
+	nvgpu_pmu_rpc_pool_deinit(g, pmu);
+	unit_assert(pmu->rpc_payload_cache != NULL, goto done);
+	err = rpc_test_respond(g, &served);
+	unit_assert((err == 0) && (served == 1U), goto done);
+	unit_assert((done.count == 1U) && (done.last_status == 0),
+		goto done);
+	nvgpu_pmu_rpc_pool_deinit(g, pmu);
+	unit_assert(pmu->rpc_payload_cache == NULL, goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	nvgpu_set_enabled(g, NVGPU_PMU_PERFMON, false);
+	rpc_test_flcn_status = 0U;
+	rpc_test_env_free(g);
+	return ret;
+}
+
+/* nvgpu_udelay() does not wait in the unit build, so spin instead. */
+static void rpc_test_pmu_latency(void)
+{
+	s64 end = nvgpu_current_time_ns() +
+		((s64)PMU_RPC_TEST_LATENCY_US * 1000);
+
+	while (nvgpu_current_time_ns() < end) {
+	}
+}
+
+/*
+ * Post PMU_RPC_TEST_BENCH_RPCS RPCs, batch at a time, and let the stand-in
+ * PMU serve them with a fixed round trip per doorbell. Returns the time
+ * taken in ns or 0 on error.
+ */
+static u64 rpc_test_bench(struct gk20a *g, u32 batch)
+{
+	struct rpc_test_done done;
+	s64 start;
+	u32 i, j, served;
+
+	(void) memset(&done, 0, sizeof(done));
+	start = nvgpu_current_time_ns();
+
+	for (i = 0U; i < PMU_RPC_TEST_BENCH_RPCS; i += batch) {
+		for (j = 0U; j < batch; j++) {
+			if (rpc_test_post(g->pmu, &done) != 0) {
+				return 0ULL;
+			}
+		}
+		rpc_test_pmu_latency();
+		if (rpc_test_respond(g, &served) != 0) {
+			return 0ULL;
+		}
+	}
+
+	if ((done.count != PMU_RPC_TEST_BENCH_RPCS) || (done.errors != 0U)) {
+		return 0ULL;
+	}
+
+	return (u64)(nvgpu_current_time_ns() - start);
+}
+
+int test_pmu_rpc_async_bench(struct unit_module *m, struct gk20a *g,
+	void *args)
+{
+	u64 serial_ns, batch_ns;
+	int ret = UNIT_FAIL;
+
+	if (rpc_test_env_init(m, g) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	/* one RPC in flight at a time, like a blocking caller */
+	serial_ns = rpc_test_bench(g, 1U);
+	batch_ns = rpc_test_bench(g, PMU_RPC_TEST_BATCH);
+	unit_assert((serial_ns != 0ULL) && (batch_ns != 0ULL), goto done);
+
+	unit_info(m, "%u RPCs, %u us round trip: one in flight %llu ns/RPC, "
+		"%u in flight %llu ns/RPC\n", PMU_RPC_TEST_BENCH_RPCS,
+		PMU_RPC_TEST_LATENCY_US,
+		(unsigned long long)(serial_ns / PMU_RPC_TEST_BENCH_RPCS),
+		PMU_RPC_TEST_BATCH,
+		(unsigned long long)(batch_ns / PMU_RPC_TEST_BENCH_RPCS));
+
+	ret = UNIT_SUCCESS;
+done:
+	rpc_test_env_free(g);
+	return ret;
+}
+#endif
+
 static int free_falcon_test_env(struct unit_module *m, struct gk20a *g,
 					void *__args)
 {
@@ -746,6 +1195,10 @@ struct unit_module_test nvgpu_pmu_tests[] = {
 	UNIT_TEST(pmu_remove_support, test_pmu_remove_support, NULL, 0),
 	UNIT_TEST(pmu_reset, test_pmu_reset, NULL, 0),
 	UNIT_TEST(pmu_isr, test_pmu_isr, NULL, 0),
+#ifdef CONFIG_NVGPU_LS_PMU
+	UNIT_TEST(pmu_rpc_async, test_pmu_rpc_async, NULL, 0),
+	UNIT_TEST(pmu_rpc_async_bench, test_pmu_rpc_async_bench, NULL, 1),
+#endif
 
 	UNIT_TEST(falcon_free_test_env, free_falcon_test_env, NULL, 0),
 };
@@ -176,3 +176,65 @@ int test_pmu_reset(struct unit_module *m, struct gk20a *g,
  */
 
 int test_pmu_isr(struct unit_module *m, struct gk20a *g, void *args);
+
+#ifdef CONFIG_NVGPU_LS_PMU
+/**
+ * Test specification for: test_pmu_rpc_async
+ *
+ * Description: Test async PMU RPCs end to end against a stand-in PMU that
+ * serves the command queue in DMEM and posts replies on the message queue.
+ *
+ * Test Type: Feature, Error guessing
+ *
+ * Targets: nvgpu_pmu_rpc_execute_async, nvgpu_pmu_rpc_wait_idle,
+ *	nvgpu_pmu_rpc_pool_init, nvgpu_pmu_rpc_pool_deinit,
+ *	nvgpu_pmu_rpc_handler, nvgpu_pmu_perfmon_start_sampling_rpc,
+ *	nvgpu_pmu_perfmon_stop_sampling_rpc
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up the fw ops, sequences, RPC payload pool, queues and DMEM heap of
+ *   a PMU as its init message would, and mark the PMU ready.
+ * - Post batches of async RPCs, check they are all in flight, let the
+ *   stand-in PMU serve them and check that done was called for each with
+ *   status 0 and nothing is left in flight. Repeat until both queues have
+ *   wrapped several times. Check that no payload is left allocated.
+ * - Have the stand-in PMU fail an RPC and check that done gets -EIO.
+ * - Post with the PMU not ready and check -EINVAL is returned and passed to
+ *   done.
+ * - Post with the driver dying and check 0 is returned and done gets
+ *   -ENODEV.
+ * - Start and stop perfmon sampling and check both RPCs complete.
+ * - Post an RPC, check nvgpu_pmu_rpc_wait_idle() times out and that
+ *   nvgpu_pmu_rpc_pool_deinit() keeps the pool. Serve the RPC and check
+ *   the pool is then destroyed.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_pmu_rpc_async(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_pmu_rpc_async_bench
+ *
+ * Description: Compare one RPC in flight at a time against batches of async
+ * RPCs, with the stand-in PMU taking a fixed round trip per doorbell.
+ *
+ * Test Type: Performance
+ *
+ * Targets: nvgpu_pmu_rpc_execute_async
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Post a fixed number of RPCs one at a time, serving each before posting
+ *   the next, and time it.
+ * - Post the same number in batches and time it.
+ * - Report the time per RPC of both.
+ *
+ * Output: Returns PASS if all RPCs complete without error, FAIL otherwise.
+ */
+int test_pmu_rpc_async_bench(struct unit_module *m, struct gk20a *g,
+	void *args);
+#endif
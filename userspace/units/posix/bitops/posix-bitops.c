@@ -21,16 +21,21 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <unit/io.h>
 #include <unit/unit.h>
 
 #include <nvgpu/bitops.h>
+#include <nvgpu/timers.h>
 
 #include "posix-bitops.h"
 
 #define NUM_WORDS 4
 
+#define BENCH_BITS	(1U << 20)
+#define BENCH_RANGES	256U
+
 static unsigned long single_ulong_maps[] = {
 	0UL,
 	~0UL,
@@ -658,6 +663,77 @@ int test_bitmap_setclear(struct unit_module *m, struct gk20a *g, void *__args)
 	return UNIT_SUCCESS;
 }
 
+static DECLARE_BITMAP(bench_map, BENCH_BITS);
+static DECLARE_BITMAP(bench_ref, BENCH_BITS);
+
+/*
+ * Range i of the benchmark: pseudo random starts and lengths of 1 to 8K bits
+ * so that most ranges cover several partial and full words.
+ */
+static void bench_range(unsigned int i, unsigned int *start,
+			unsigned int *len)
+{
+	*len = 1U + ((i * 104729U) % 8192U);
+	*start = (i * 7919U * 31U) % (BENCH_BITS - *len);
+}
+
+int test_bitmap_setclear_bench(struct unit_module *m, struct gk20a *g,
+			       void *__args)
+{
+	unsigned int i, b, start, len;
+	s64 t, ref_ns, word_ns;
+
+	memset(bench_map, 0, sizeof(bench_map));
+	memset(bench_ref, 0, sizeof(bench_ref));
+
+	t = nvgpu_current_time_ns();
+	for (i = 0; i < BENCH_RANGES; i++) {
+		bench_range(i, &start, &len);
+		for (b = start; b < start + len; b++)
+			nvgpu_set_bit(b, bench_ref);
+	}
+	ref_ns = nvgpu_current_time_ns() - t;
+
+	t = nvgpu_current_time_ns();
+	for (i = 0; i < BENCH_RANGES; i++) {
+		bench_range(i, &start, &len);
+		nvgpu_bitmap_set(bench_map, start, len);
+	}
+	word_ns = nvgpu_current_time_ns() - t;
+
+	unit_info(m, "set:   %u ranges, per bit %lld ns, per word %lld ns\n",
+		  BENCH_RANGES, ref_ns, word_ns);
+
+	if (memcmp(bench_map, bench_ref, sizeof(bench_map)) != 0)
+		unit_return_fail(m, "bitmap_set differs from set_bit\n");
+
+	/*
+	 * Clear every other range again.
+	 */
+	t = nvgpu_current_time_ns();
+	for (i = 0; i < BENCH_RANGES; i += 2U) {
+		bench_range(i, &start, &len);
+		for (b = start; b < start + len; b++)
+			nvgpu_clear_bit(b, bench_ref);
+	}
+	ref_ns = nvgpu_current_time_ns() - t;
+
+	t = nvgpu_current_time_ns();
+	for (i = 0; i < BENCH_RANGES; i += 2U) {
+		bench_range(i, &start, &len);
+		nvgpu_bitmap_clear(bench_map, start, len);
+	}
+	word_ns = nvgpu_current_time_ns() - t;
+
+	unit_info(m, "clear: %u ranges, per bit %lld ns, per word %lld ns\n",
+		  BENCH_RANGES / 2U, ref_ns, word_ns);
+
+	if (memcmp(bench_map, bench_ref, sizeof(bench_map)) != 0)
+		unit_return_fail(m, "bitmap_clear differs from clear_bit\n");
+
+	return UNIT_SUCCESS;
+}
+
 int test_bitops_misc(struct unit_module *m, struct gk20a *g, void *__args)
 {
 	uint32_t i, idx, bits, numlong;
@@ -737,6 +813,7 @@ struct unit_module_test posix_bitops_tests[] = {
 	UNIT_TEST(test_and_clear_bit,  test_test_and_setclear_bit, &clear_args, 0),
 	UNIT_TEST(bitmap_set,          test_bitmap_setclear, &set_args, 0),
 	UNIT_TEST(bitmap_clear,        test_bitmap_setclear, &clear_args, 0),
+	UNIT_TEST(bitmap_setclear_bench, test_bitmap_setclear_bench, NULL, 0),
 	UNIT_TEST(bitops_misc,         test_bitops_misc, NULL, 0),
 };
 
@@ -402,6 +402,33 @@ int test_test_and_setclear_bit(struct unit_module *m, struct gk20a *g,
  */
 int test_bitmap_setclear(struct unit_module *m, struct gk20a *g, void *__args);
 
+/**
+ * Test specification for: test_bitmap_setclear_bench
+ *
+ * Description: Benchmark nvgpu_bitmap_set() and nvgpu_bitmap_clear() against
+ * setting and clearing the same ranges one bit at a time.
+ *
+ * Test Type: Feature, Performance
+ *
+ * Targets: nvgpu_bitmap_set, nvgpu_bitmap_clear
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Clear two 1M bit maps.
+ * - Set 256 pseudo random ranges of 1 to 8K bits in the reference map with
+ *   nvgpu_set_bit() and in the other map with nvgpu_bitmap_set(), timing both.
+ * - Verify both maps are equal.
+ * - Clear every other range in the reference map with nvgpu_clear_bit() and
+ *   in the other map with nvgpu_bitmap_clear(), timing both.
+ * - Verify both maps are equal.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_bitmap_setclear_bench(struct unit_module *m, struct gk20a *g,
+			       void *__args);
+
 /**
  * Test specification for: test_bitops_misc
  *
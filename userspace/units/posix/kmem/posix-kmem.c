@@ -21,18 +21,30 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include <unit/io.h>
 #include <unit/unit.h>
 
 #include <nvgpu/kmem.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/posix/posix-fault-injection.h>
 #include "posix-kmem.h"
 
 #define KMEM_TEST_CACHE_SIZE 512
 #define KMEM_TEST_ALLOC_SIZE 256
 #define KMEM_TEST_CALLOC_COUNT 4
 
+#define KMEM_TEST_SLAB_OBJ_SIZE 24
+#define KMEM_TEST_SLAB_OBJS 1000U
+#define KMEM_TEST_THREADS 4U
+#define KMEM_TEST_THREAD_LOOPS 2000U
+#define KMEM_TEST_THREAD_BATCH 48U
+#define KMEM_TEST_BENCH_LOOPS 20000U
+#define KMEM_TEST_BENCH_BATCH 64U
+
 struct nvgpu_kmem_cache {
 	struct gk20a *g;
 	size_t size;
@@ -244,6 +256,277 @@ int test_kmem_big_alloc(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+int test_kmem_cache_slab(struct unit_module *m,
+				struct gk20a *g, void *args)
+{
+	struct nvgpu_kmem_cache *test_cache;
+	struct nvgpu_kmem_cache_stats stats;
+	u32 *objs[KMEM_TEST_SLAB_OBJS];
+	u64 allocs = 0ULL;
+	u64 slabs;
+	u32 i;
+	int ret = UNIT_FAIL;
+
+	test_cache = nvgpu_kmem_cache_create(g, KMEM_TEST_SLAB_OBJ_SIZE);
+	if (test_cache == NULL) {
+		unit_return_fail(m, "Kmem slab cache create failed\n");
+	}
+
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		objs[i] = nvgpu_kmem_cache_alloc(test_cache);
+		unit_assert(objs[i] != NULL, goto done);
+		unit_assert((((uintptr_t)objs[i]) & 0xfUL) == 0UL, goto done);
+		memset(objs[i], 0xa5, KMEM_TEST_SLAB_OBJ_SIZE);
+		objs[i][0] = i;
+		allocs++;
+	}
+
+	/* Objects must not overlap: every tag is still intact. */
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		unit_assert(objs[i][0] == i, goto done);
+	}
+
+	nvgpu_kmem_cache_get_stats(test_cache, &stats);
+	unit_assert(stats.obj_size == 32ULL, goto done);
+	unit_assert(stats.slabs * stats.objs_per_slab >= KMEM_TEST_SLAB_OBJS,
+		goto done);
+	unit_assert(stats.misses > 0ULL, goto done);
+	unit_assert(stats.hits + stats.misses == allocs, goto done);
+	unit_assert(stats.in_use == KMEM_TEST_SLAB_OBJS, goto done);
+	slabs = stats.slabs;
+
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		nvgpu_kmem_cache_free(test_cache, objs[i]);
+	}
+	nvgpu_kmem_cache_free(test_cache, NULL);
+
+	/* Alloc/free pairs are served from this thread's magazine. */
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		objs[0] = nvgpu_kmem_cache_alloc(test_cache);
+		unit_assert(objs[0] != NULL, goto done);
+		nvgpu_kmem_cache_free(test_cache, objs[0]);
+		allocs++;
+	}
+
+	nvgpu_kmem_cache_get_stats(test_cache, &stats);
+	unit_assert(stats.hits + stats.misses == allocs, goto done);
+	unit_assert(stats.hits >= KMEM_TEST_SLAB_OBJS, goto done);
+	unit_assert(stats.slabs == slabs, goto done);
+	unit_assert(stats.in_use == 0ULL, goto done);
+
+	unit_info(m, "slab cache: %llu hits, %llu misses, %llu slabs\n",
+		(unsigned long long)stats.hits,
+		(unsigned long long)stats.misses,
+		(unsigned long long)stats.slabs);
+
+	ret = UNIT_SUCCESS;
+done:
+	nvgpu_kmem_cache_destroy(test_cache);
+	return ret;
+}
+
+int test_kmem_cache_destroy_in_use(struct unit_module *m,
+				struct gk20a *g, void *args)
+{
+	struct nvgpu_kmem_cache *test_cache;
+	u32 *obj;
+
+	test_cache = nvgpu_kmem_cache_create(g, KMEM_TEST_SLAB_OBJ_SIZE);
+	if (test_cache == NULL) {
+		unit_return_fail(m, "Kmem cache create failed\n");
+	}
+
+	obj = nvgpu_kmem_cache_alloc(test_cache);
+	if (obj == NULL) {
+		nvgpu_kmem_cache_destroy(test_cache);
+		unit_return_fail(m, "Kmem cache alloc failed\n");
+	}
+	obj[0] = 0xcafeU;
+
+	/*
+	 * Destroying the cache with an object still in use must not free the
+	 * memory under it; the object is leaked instead.
+	 */
+	nvgpu_kmem_cache_destroy(test_cache);
+
+	obj[1] = 0xbeefU;
+	if ((obj[0] != 0xcafeU) || (obj[1] != 0xbeefU)) {
+		unit_return_fail(m, "object changed after cache destroy\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct kmem_thread_args {
+	struct nvgpu_kmem_cache *cache;
+	struct nvgpu_posix_fault_inj_container *fi;
+	/* Objects handed over from the previous thread, freed by this one. */
+	void *handover[KMEM_TEST_THREAD_BATCH];
+	bool failed;
+};
+
+static void *kmem_cache_thread(void *data)
+{
+	struct kmem_thread_args *args = data;
+	void *objs[KMEM_TEST_THREAD_BATCH];
+	u32 i, j;
+
+	nvgpu_posix_init_fault_injection(args->fi);
+
+	for (i = 0U; i < KMEM_TEST_THREAD_LOOPS; i++) {
+		for (j = 0U; j < KMEM_TEST_THREAD_BATCH; j++) {
+			objs[j] = nvgpu_kmem_cache_alloc(args->cache);
+			if (objs[j] == NULL) {
+				args->failed = true;
+				return NULL;
+			}
+			*(u64 *)objs[j] = (u64)(uintptr_t)objs[j];
+		}
+		for (j = 0U; j < KMEM_TEST_THREAD_BATCH; j++) {
+			if (*(u64 *)objs[j] != (u64)(uintptr_t)objs[j]) {
+				args->failed = true;
+			}
+			nvgpu_kmem_cache_free(args->cache, objs[j]);
+		}
+	}
+
+	for (j = 0U; j < KMEM_TEST_THREAD_BATCH; j++) {
+		nvgpu_kmem_cache_free(args->cache, args->handover[j]);
+	}
+
+	return NULL;
+}
+
+int test_kmem_cache_threads(struct unit_module *m,
+				struct gk20a *g, void *args)
+{
+	struct nvgpu_kmem_cache *test_cache;
+	struct nvgpu_kmem_cache_stats stats;
+	struct kmem_thread_args targs[KMEM_TEST_THREADS];
+	pthread_t threads[KMEM_TEST_THREADS];
+	u64 allocs;
+	u32 i, j;
+	int ret = UNIT_FAIL;
+
+	test_cache = nvgpu_kmem_cache_create(g, KMEM_TEST_CACHE_SIZE);
+	if (test_cache == NULL) {
+		unit_return_fail(m, "Kmem thread cache create failed\n");
+	}
+
+	/* Objects allocated here are freed by the worker threads. */
+	memset(targs, 0, sizeof(targs));
+	for (i = 0U; i < KMEM_TEST_THREADS; i++) {
+		targs[i].cache = test_cache;
+		targs[i].fi = nvgpu_posix_fault_injection_get_container();
+		for (j = 0U; j < KMEM_TEST_THREAD_BATCH; j++) {
+			targs[i].handover[j] =
+				nvgpu_kmem_cache_alloc(test_cache);
+			unit_assert(targs[i].handover[j] != NULL, goto done);
+		}
+	}
+
+	for (i = 0U; i < KMEM_TEST_THREADS; i++) {
+		unit_assert(pthread_create(&threads[i], NULL,
+			kmem_cache_thread, &targs[i]) == 0, goto done);
+	}
+	for (i = 0U; i < KMEM_TEST_THREADS; i++) {
+		(void)pthread_join(threads[i], NULL);
+		unit_assert(!targs[i].failed, goto done);
+	}
+
+	/* Exited threads have folded their hits back into the cache. */
+	allocs = (u64)KMEM_TEST_THREADS * KMEM_TEST_THREAD_BATCH *
+		(KMEM_TEST_THREAD_LOOPS + 1U);
+	nvgpu_kmem_cache_get_stats(test_cache, &stats);
+	unit_assert(stats.hits + stats.misses == allocs, goto done);
+	unit_assert(stats.hits > stats.misses, goto done);
+
+	unit_info(m, "threaded slab cache: %llu hits, %llu misses, "
+		"%llu slabs\n",
+		(unsigned long long)stats.hits,
+		(unsigned long long)stats.misses,
+		(unsigned long long)stats.slabs);
+
+	ret = UNIT_SUCCESS;
+done:
+	nvgpu_kmem_cache_destroy(test_cache);
+	return ret;
+}
+
+static u64 kmem_bench_malloc(size_t size)
+{
+	void *objs[KMEM_TEST_BENCH_BATCH];
+	s64 start = nvgpu_current_time_ns();
+	u32 i, j;
+
+	for (i = 0U; i < KMEM_TEST_BENCH_LOOPS; i++) {
+		for (j = 0U; j < KMEM_TEST_BENCH_BATCH; j++) {
+			objs[j] = malloc(size);
+			*(volatile char *)objs[j] = 0;
+		}
+		for (j = 0U; j < KMEM_TEST_BENCH_BATCH; j++) {
+			free(objs[j]);
+		}
+	}
+
+	return (u64)(nvgpu_current_time_ns() - start);
+}
+
+static u64 kmem_bench_cache(struct nvgpu_kmem_cache *cache)
+{
+	void *objs[KMEM_TEST_BENCH_BATCH];
+	s64 start = nvgpu_current_time_ns();
+	u32 i, j;
+
+	for (i = 0U; i < KMEM_TEST_BENCH_LOOPS; i++) {
+		for (j = 0U; j < KMEM_TEST_BENCH_BATCH; j++) {
+			objs[j] = nvgpu_kmem_cache_alloc(cache);
+			*(volatile char *)objs[j] = 0;
+		}
+		for (j = 0U; j < KMEM_TEST_BENCH_BATCH; j++) {
+			nvgpu_kmem_cache_free(cache, objs[j]);
+		}
+	}
+
+	return (u64)(nvgpu_current_time_ns() - start);
+}
+
+int test_kmem_cache_bench(struct unit_module *m,
+				struct gk20a *g, void *args)
+{
+	static const size_t sizes[] = { 32, 96, 256, 1024 };
+	struct nvgpu_kmem_cache *test_cache;
+	struct nvgpu_kmem_cache_stats stats;
+	const u64 ops = (u64)KMEM_TEST_BENCH_LOOPS * KMEM_TEST_BENCH_BATCH;
+	u64 malloc_ns, cache_ns;
+	u32 i;
+
+	for (i = 0U; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		test_cache = nvgpu_kmem_cache_create(g, sizes[i]);
+		if (test_cache == NULL) {
+			unit_return_fail(m, "Kmem bench cache create failed\n");
+		}
+
+		malloc_ns = kmem_bench_malloc(sizes[i]);
+		cache_ns = kmem_bench_cache(test_cache);
+		nvgpu_kmem_cache_get_stats(test_cache, &stats);
+		nvgpu_kmem_cache_destroy(test_cache);
+
+		unit_info(m, "size %4zu: malloc %3llu ns/op, kmem cache "
+			"%3llu ns/op, hit rate %llu/%llu\n", sizes[i],
+			(unsigned long long)(malloc_ns / ops),
+			(unsigned long long)(cache_ns / ops),
+			(unsigned long long)stats.hits,
+			(unsigned long long)(stats.hits + stats.misses));
+
+		if (stats.hits + stats.misses != ops) {
+			unit_return_fail(m, "Kmem bench stats mismatch\n");
+		}
+	}
+
+	return UNIT_SUCCESS;
+}
+
 struct unit_module_test posix_kmem_tests[] = {
 	UNIT_TEST(cache_create,   test_kmem_cache_create, NULL, 0),
 	UNIT_TEST(cache_alloc,    test_kmem_cache_alloc, NULL, 0),
@@ -252,6 +535,10 @@ struct unit_module_test posix_kmem_tests[] = {
 	UNIT_TEST(kcalloc_test,   test_kmem_kcalloc, NULL, 0),
 	UNIT_TEST(virtual_alloc,  test_kmem_virtual_alloc, NULL, 0),
 	UNIT_TEST(big_alloc,      test_kmem_big_alloc, NULL, 0),
+	UNIT_TEST(cache_slab,     test_kmem_cache_slab, NULL, 0),
+	UNIT_TEST(cache_destroy_in_use, test_kmem_cache_destroy_in_use, NULL, 0),
+	UNIT_TEST(cache_threads,  test_kmem_cache_threads, NULL, 0),
+	UNIT_TEST(cache_bench,    test_kmem_cache_bench, NULL, 1),
 };
 
 UNIT_MODULE(posix_kmem, posix_kmem_tests, UNIT_PRIO_POSIX_TEST);
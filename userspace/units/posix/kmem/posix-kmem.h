@@ -255,4 +255,116 @@ int test_kmem_virtual_alloc(struct unit_module *m,
  */
 int test_kmem_big_alloc(struct unit_module *m,
                                 struct gk20a *g, void *args);
+/**
+ * Test specification for test_kmem_cache_slab
+ *
+ * Description: Test the slab backing of the kmem cache.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_kmem_cache_create, nvgpu_kmem_cache_alloc,
+ *          nvgpu_kmem_cache_free, nvgpu_kmem_cache_get_stats,
+ *          nvgpu_kmem_cache_destroy
+ *
+ * Inputs:
+ * 1) GPU driver struct g.
+ *
+ * Steps:
+ * 1) Create a cache for an object size that is not a multiple of 16 bytes.
+ * 2) Allocate more objects than fit in one slab. Check that every object is
+ *    16 byte aligned, fill it and tag it with its index.
+ * 3) Check that all tags are intact, i.e. no two objects overlap.
+ * 4) Check that the rounded object size is reported, that enough slabs were
+ *    allocated, that hits plus misses equals the number of allocations and
+ *    that all objects are reported in use.
+ * 5) Free all objects and also free a NULL pointer.
+ * 6) Do alloc/free pairs and check that they are served from the magazine
+ *    (hits grow) without allocating a new set of slabs, and that no object
+ *    is reported in use.
+ * 7) Destroy the cache.
+ *
+ * Output:
+ * The test returns PASS if all the above checks pass, FAIL otherwise.
+ */
+int test_kmem_cache_slab(struct unit_module *m,
+                                struct gk20a *g, void *args);
+
+/**
+ * Test specification for test_kmem_cache_destroy_in_use
+ *
+ * Description: Test destroying a kmem cache with an object still in use.
+ *
+ * Test Type: Error guessing
+ *
+ * Targets: nvgpu_kmem_cache_destroy
+ *
+ * Inputs:
+ * 1) GPU driver struct g.
+ *
+ * Steps:
+ * 1) Create a cache, allocate one object and write to it.
+ * 2) Destroy the cache without freeing the object.
+ * 3) Write to the object again and check both values are intact, i.e. the
+ *    slab holding it was not released.
+ *
+ * Output:
+ * The test returns PASS if the object is intact, FAIL otherwise.
+ */
+int test_kmem_cache_destroy_in_use(struct unit_module *m,
+                                struct gk20a *g, void *args);
+
+/**
+ * Test specification for test_kmem_cache_threads
+ *
+ * Description: Test the per-thread magazines of the kmem cache.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_kmem_cache_alloc, nvgpu_kmem_cache_free,
+ *          nvgpu_kmem_cache_get_stats
+ *
+ * Inputs:
+ * 1) GPU driver struct g.
+ *
+ * Steps:
+ * 1) Create a cache and allocate a batch of objects for each worker thread
+ *    from the main thread.
+ * 2) Start the worker threads. Each thread repeatedly allocates a batch of
+ *    objects, checks that no other thread scribbled over them and frees them.
+ *    Finally it frees the batch handed over by the main thread.
+ * 3) Join the threads and check that none of them saw a failure.
+ * 4) Check that hits plus misses equals the number of allocations, which
+ *    requires the magazines of the exited threads to be flushed, and that
+ *    most allocations were hits.
+ * 5) Destroy the cache.
+ *
+ * Output:
+ * The test returns PASS if all the above checks pass, FAIL otherwise.
+ */
+int test_kmem_cache_threads(struct unit_module *m,
+                                struct gk20a *g, void *args);
+
+/**
+ * Test specification for test_kmem_cache_bench
+ *
+ * Description: Microbenchmark of the kmem cache against malloc.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_kmem_cache_alloc, nvgpu_kmem_cache_free
+ *
+ * Inputs:
+ * 1) GPU driver struct g.
+ *
+ * Steps:
+ * 1) For a few object sizes, time batches of malloc()/free() and batches of
+ *    nvgpu_kmem_cache_alloc()/nvgpu_kmem_cache_free() of the same size.
+ * 2) Report the cost per operation of both and the magazine hit rate.
+ * 3) Check that the statistics account for every allocation.
+ *
+ * Output:
+ * The test returns PASS if the statistics match, FAIL otherwise.
+ */
+int test_kmem_cache_bench(struct unit_module *m,
+                                struct gk20a *g, void *args);
 #endif /* __UNIT_POSIX_KMEM_H__ */
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/regops.h>
+#include <nvgpu/posix/posix-fault-injection.h>
+
+#include "hal/regops/regops_gv11b.h"
+#ifdef CONFIG_NVGPU_HAL_NON_FUSA
+#include "hal/regops/regops_ga10b.h"
+#include "hal/regops/regops_tu104.h"
+#endif
+#ifdef CONFIG_NVGPU_DGPU
+#include "hal/regops/regops_ga100.h"
+#endif
+
+#include "nvgpu-regops.h"
+
+/* passes over the whitelisted offsets in the timing test */
+#define REGOPS_TIMING_ROUNDS	20U
+
+struct regops_chip {
+	const char *name;
+	const struct regop_offset_range *(*global)(void);
+	u64 (*global_count)(void);
+	const struct regop_offset_range *(*context)(void);
+	u64 (*context_count)(void);
+	const u32 *(*runcontrol)(void);
+	u64 (*runcontrol_count)(void);
+};
+
+static const struct regops_chip regops_chips[] = {
+	{
+		"gv11b",
+		gv11b_get_global_whitelist_ranges,
+		gv11b_get_global_whitelist_ranges_count,
+		gv11b_get_context_whitelist_ranges,
+		gv11b_get_context_whitelist_ranges_count,
+		gv11b_get_runcontrol_whitelist,
+		gv11b_get_runcontrol_whitelist_count,
+	},
+#ifdef CONFIG_NVGPU_HAL_NON_FUSA
+	{
+		"ga10b",
+		ga10b_get_global_whitelist_ranges,
+		ga10b_get_global_whitelist_ranges_count,
+		ga10b_get_context_whitelist_ranges,
+		ga10b_get_context_whitelist_ranges_count,
+		ga10b_get_runcontrol_whitelist,
+		ga10b_get_runcontrol_whitelist_count,
+	},
+	{
+		"tu104",
+		tu104_get_global_whitelist_ranges,
+		tu104_get_global_whitelist_ranges_count,
+		tu104_get_context_whitelist_ranges,
+		tu104_get_context_whitelist_ranges_count,
+		tu104_get_runcontrol_whitelist,
+		tu104_get_runcontrol_whitelist_count,
+	},
+#endif
+#ifdef CONFIG_NVGPU_DGPU
+	{
+		"ga100",
+		ga100_get_global_whitelist_ranges,
+		ga100_get_global_whitelist_ranges_count,
+		ga100_get_context_whitelist_ranges,
+		ga100_get_context_whitelist_ranges_count,
+		ga100_get_runcontrol_whitelist,
+		ga100_get_runcontrol_whitelist_count,
+	},
+#endif
+};
+
+static void regops_set_chip(struct gk20a *g, const struct regops_chip *chip)
+{
+	g->ops.regops.get_global_whitelist_ranges = chip->global;
+	g->ops.regops.get_global_whitelist_ranges_count = chip->global_count;
+	g->ops.regops.get_context_whitelist_ranges = chip->context;
+	g->ops.regops.get_context_whitelist_ranges_count = chip->context_count;
+	g->ops.regops.get_runcontrol_whitelist = chip->runcontrol;
+	g->ops.regops.get_runcontrol_whitelist_count = chip->runcontrol_count;
+}
+
+static bool ref_in_ranges(const struct regop_offset_range *ranges, u64 count,
+			  u32 offset)
+{
+	u64 i;
+
+	for (i = 0ULL; i < count; i++) {
+		if ((offset >= U32(ranges[i].base)) &&
+		    (offset < U32(ranges[i].base) + U32(ranges[i].count) * 4U)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool ref_in_list(const u32 *list, u64 count, u32 offset)
+{
+	u64 i;
+
+	for (i = 0ULL; i < count; i++) {
+		if (list[i] == offset) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Check one offset for both op types, with and without a bound context,
+ * against a plain linear search of the three whitelists. The lookup is done
+ * with the compiled table and with the table hidden, which is the search
+ * regops used before the table existed.
+ */
+static bool regops_check_offset(struct unit_module *m, struct gk20a *g,
+				const struct regops_chip *chip, u32 offset)
+{
+	struct nvgpu_regops_allowlist *table = g->regops_allowlist;
+	bool in_global = ref_in_ranges(chip->global(), chip->global_count(),
+				       offset);
+	bool in_context = ref_in_ranges(chip->context(), chip->context_count(),
+					offset);
+	bool in_runcontrol = ref_in_list(chip->runcontrol(),
+					 chip->runcontrol_count(), offset);
+	u32 pass, ctx;
+	bool expect, got;
+	u8 type;
+
+	for (pass = 0U; pass < 2U; pass++) {
+		g->regops_allowlist = (pass == 0U) ? table : NULL;
+
+		for (ctx = 0U; ctx < 2U; ctx++) {
+			type = REGOP(TYPE_GLOBAL);
+			expect = in_global ||
+				((ctx != 0U) && (in_context || in_runcontrol));
+			got = nvgpu_regops_offset_whitelisted(g, type, offset,
+							      ctx != 0U);
+			if (got != expect) {
+				goto mismatch;
+			}
+
+			type = REGOP(TYPE_GR_CTX);
+			expect = in_context || ((ctx != 0U) && in_runcontrol);
+			got = nvgpu_regops_offset_whitelisted(g, type, offset,
+							      ctx != 0U);
+			if (got != expect) {
+				goto mismatch;
+			}
+		}
+	}
+
+	g->regops_allowlist = table;
+	return true;
+
+mismatch:
+	unit_err(m, "%s: offset 0x%08x type %u ctx %u %s: got %d expected %d\n",
+		 chip->name, offset, type, ctx,
+		 (pass == 0U) ? "table" : "search", got, expect);
+	g->regops_allowlist = table;
+	return false;
+}
+
+/* every register of each range, plus the ones right before and after it */
+static bool regops_check_ranges(struct unit_module *m, struct gk20a *g,
+				const struct regops_chip *chip,
+				const struct regop_offset_range *ranges,
+				u64 count)
+{
+	u64 i;
+	u32 j;
+
+	for (i = 0ULL; i < count; i++) {
+		for (j = 0U; j <= U32(ranges[i].count) + 1U; j++) {
+			if (!regops_check_offset(m, g, chip,
+					U32(ranges[i].base) + j * 4U - 4U)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool regops_check_chip(struct unit_module *m, struct gk20a *g,
+			      const struct regops_chip *chip)
+{
+	const u32 *runcontrol = chip->runcontrol();
+	u64 i;
+	u32 j;
+
+	if (!regops_check_ranges(m, g, chip, chip->global(),
+				 chip->global_count()) ||
+	    !regops_check_ranges(m, g, chip, chip->context(),
+				 chip->context_count())) {
+		return false;
+	}
+
+	for (i = 0ULL; i < chip->runcontrol_count(); i++) {
+		for (j = 0U; j < 3U; j++) {
+			if (!regops_check_offset(m, g, chip,
+					runcontrol[i] + j * 4U - 4U)) {
+				return false;
+			}
+		}
+	}
+
+	/* offsets the table does not cover */
+	return regops_check_offset(m, g, chip, 0x00fffffcU) &&
+		regops_check_offset(m, g, chip, 0x01000000U) &&
+		regops_check_offset(m, g, chip, 0x00000002U);
+}
+
+int test_regops_allowlist(struct unit_module *m, struct gk20a *g, void *args)
+{
+	u32 i;
+
+	for (i = 0U; i < ARRAY_SIZE(regops_chips); i++) {
+		regops_set_chip(g, &regops_chips[i]);
+
+		nvgpu_regops_allowlist_init(g);
+		unit_assert(g->regops_allowlist != NULL, goto fail);
+
+		if (!regops_check_chip(m, g, &regops_chips[i])) {
+			goto fail;
+		}
+
+		nvgpu_regops_allowlist_deinit(g);
+		unit_assert(g->regops_allowlist == NULL, goto fail);
+	}
+
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_regops_allowlist_deinit(g);
+	return UNIT_FAIL;
+}
+
+int test_regops_allowlist_enomem(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	struct nvgpu_posix_fault_inj *kmem_fi =
+		nvgpu_kmem_get_fault_injection();
+	const struct regops_chip *chip = &regops_chips[0];
+	u32 i;
+
+	regops_set_chip(g, chip);
+
+	/* fail the table allocation, then the first few leaves */
+	for (i = 0U; i < 4U; i++) {
+		nvgpu_posix_enable_fault_injection(kmem_fi, true, i);
+		nvgpu_regops_allowlist_init(g);
+		nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
+
+		unit_assert(g->regops_allowlist == NULL, goto fail);
+
+		/* the whitelists are still enforced by searching them */
+		unit_assert(regops_check_offset(m, g, chip,
+				U32(chip->global()[0].base)), goto fail);
+		unit_assert(regops_check_offset(m, g, chip,
+				U32(chip->context()[0].base)), goto fail);
+		unit_assert(regops_check_offset(m, g, chip, 0x00000004U),
+			    goto fail);
+	}
+
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_regops_allowlist_deinit(g);
+	return UNIT_FAIL;
+}
+
+static u32 regops_collect_ranges(const struct regop_offset_range *ranges,
+				 u64 count, u32 *offsets, u32 n)
+{
+	u64 i;
+	u32 j;
+
+	for (i = 0ULL; i < count; i++) {
+		for (j = 0U; j < U32(ranges[i].count); j++) {
+			offsets[n++] = U32(ranges[i].base) + j * 4U;
+		}
+	}
+
+	return n;
+}
+
+static s64 regops_time_lookups(struct gk20a *g, const u32 *offsets, u32 n,
+			       u32 *hits)
+{
+	s64 start = nvgpu_current_time_ns();
+	u32 round, i;
+
+	*hits = 0U;
+	for (round = 0U; round < REGOPS_TIMING_ROUNDS; round++) {
+		for (i = 0U; i < n; i++) {
+			if (nvgpu_regops_offset_whitelisted(g,
+					REGOP(TYPE_GLOBAL), offsets[i], true)) {
+				(*hits)++;
+			}
+		}
+	}
+
+	return nvgpu_current_time_ns() - start;
+}
+
+int test_regops_allowlist_timing(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	const struct regops_chip *chip;
+	struct nvgpu_regops_allowlist *table;
+	u32 *offsets = NULL;
+	u32 i, n, max, table_hits, search_hits;
+	s64 table_ns, search_ns;
+	u64 j;
+
+	for (i = 0U; i < ARRAY_SIZE(regops_chips); i++) {
+		chip = &regops_chips[i];
+		regops_set_chip(g, chip);
+
+		/* each range holds at most 255 registers */
+		max = U32(chip->global_count() + chip->context_count()) * 255U +
+			U32(chip->runcontrol_count());
+		offsets = malloc(max * sizeof(*offsets));
+		unit_assert(offsets != NULL, goto fail);
+
+		n = regops_collect_ranges(chip->global(), chip->global_count(),
+					  offsets, 0U);
+		n = regops_collect_ranges(chip->context(),
+					  chip->context_count(), offsets, n);
+		for (j = 0ULL; j < chip->runcontrol_count(); j++) {
+			offsets[n++] = chip->runcontrol()[j];
+		}
+
+		nvgpu_regops_allowlist_init(g);
+		table = g->regops_allowlist;
+		unit_assert(table != NULL, goto fail);
+
+		table_ns = regops_time_lookups(g, offsets, n, &table_hits);
+		g->regops_allowlist = NULL;
+		search_ns = regops_time_lookups(g, offsets, n, &search_hits);
+		g->regops_allowlist = table;
+
+		/* every collected offset is on one of the lists */
+		unit_assert(table_hits == n * REGOPS_TIMING_ROUNDS, goto fail);
+		unit_assert(search_hits == table_hits, goto fail);
+
+		unit_info(m, "%s: %u offsets x %u: table %lld ns, "
+			  "search %lld ns\n", chip->name, n,
+			  REGOPS_TIMING_ROUNDS, table_ns, search_ns);
+
+		nvgpu_regops_allowlist_deinit(g);
+		free(offsets);
+		offsets = NULL;
+	}
+
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_regops_allowlist_deinit(g);
+	free(offsets);
+	return UNIT_FAIL;
+}
+
+struct unit_module_test regops_tests[] = {
+	UNIT_TEST(regops_allowlist, test_regops_allowlist, NULL, 0),
+	UNIT_TEST(regops_allowlist_enomem, test_regops_allowlist_enomem,
+		  NULL, 0),
+	UNIT_TEST(regops_allowlist_timing, test_regops_allowlist_timing,
+		  NULL, 1),
+};
+
+UNIT_MODULE(regops, regops_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UNIT_NVGPU_REGOPS_H
+#define UNIT_NVGPU_REGOPS_H
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-regops
+ *  @{
+ *
+ * Software Unit Test Specification for nvgpu.common.regops
+ */
+
+/**
+ * Test specification for: test_regops_allowlist
+ *
+ * Description: The compiled regops allowlist accepts exactly the offsets
+ * the register whitelists list.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_regops_allowlist_init, nvgpu_regops_allowlist_deinit,
+ *          nvgpu_regops_offset_whitelisted
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For the gv11b whitelists, and the ga10b, tu104 and ga100 ones where
+ *   those HALs are built:
+ *   - Install the whitelist getters in g->ops.regops.
+ *   - Call nvgpu_regops_allowlist_init() and check that the table was built.
+ *   - For every register of every global and context range, the registers
+ *     right before and after each range, each runcontrol register and its
+ *     neighbours, and a few offsets outside the table:
+ *     - Compute the expected result for global and context ops, with and
+ *       without a bound context, by a linear search of the whitelists.
+ *     - Check that nvgpu_regops_offset_whitelisted() returns it both with
+ *       the table and with g->regops_allowlist set to NULL, which makes it
+ *       search the whitelists.
+ *   - Call nvgpu_regops_allowlist_deinit() and check that the table is gone.
+ *
+ * Output: Returns PASS if the table and the search agree with the linear
+ * search for every offset. FAIL otherwise.
+ */
+int test_regops_allowlist(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_regops_allowlist_enomem
+ *
+ * Description: A failure to build the compiled allowlist is not fatal.
+ *
+ * Test Type: Error injection
+ *
+ * Targets: nvgpu_regops_allowlist_init, nvgpu_regops_offset_whitelisted
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Install the gv11b whitelist getters in g->ops.regops.
+ * - For the table allocation and the first three leaf allocations:
+ *   - Enable kmem fault injection for that allocation and call
+ *     nvgpu_regops_allowlist_init().
+ *   - Check that g->regops_allowlist is NULL.
+ *   - Check that a global register, a context register and an offset on
+ *     no list are still accepted and rejected as the whitelists say.
+ *
+ * Output: Returns PASS if the above checks pass. FAIL otherwise.
+ */
+int test_regops_allowlist_enomem(struct unit_module *m, struct gk20a *g,
+				 void *args);
+
+/**
+ * Test specification for: test_regops_allowlist_timing
+ *
+ * Description: Compare the lookup time of the compiled allowlist with the
+ * whitelist search.
+ *
+ * Test Type: Performance
+ *
+ * Targets: nvgpu_regops_offset_whitelisted
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For each chip whose whitelists are built:
+ *   - Collect every register of the global, context and runcontrol lists.
+ *   - Build the table and look all of them up as global ops with a bound
+ *     context several times, first with the table and then with
+ *     g->regops_allowlist set to NULL.
+ *   - Check that both accepted every register and report both times.
+ *
+ * Output: Returns PASS if all lookups succeeded. FAIL otherwise.
+ */
+int test_regops_allowlist_timing(struct unit_module *m, struct gk20a *g,
+				 void *args);
+
+/** @} */
+#endif /* UNIT_NVGPU_REGOPS_H */